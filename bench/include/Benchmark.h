@@ -0,0 +1,164 @@
+// File: bench/include/Benchmark.h
+// Purpose: Timing helpers and the result report shared by the benchmarks.
+
+#pragma once
+
+#include <chrono> // std::chrono
+#include <cstddef> // size_t
+#include <ostream> // std::ostream
+#include <string> // std::string
+#include <vector> // std::vector
+
+namespace bench
+{
+	/// <summary>
+	/// Layer shape (neurons x inputs, batch size samples) the kernels are benchmarked on.
+	/// </summary>
+	struct LayerShape
+	{
+		size_t neurons;
+		size_t inputs;
+		size_t batch_size;
+	};
+
+	/// <summary>
+	/// One measurement. The work counters are per call, 0 when they do not apply.
+	/// </summary>
+	struct Result
+	{
+		/// <summary>
+		/// Suite/benchmark name, for example "matrix/multiply 64x784x32".
+		/// </summary>
+		std::string name;
+
+		/// <summary>
+		/// Seconds per call.
+		/// </summary>
+		double seconds = 0.0;
+
+		/// <summary>
+		/// Floating point operations per call.
+		/// </summary>
+		double flop = 0.0;
+
+		/// <summary>
+		/// Bytes read and written per call (compulsory traffic, every operand once).
+		/// </summary>
+		double bytes = 0.0;
+
+		/// <summary>
+		/// Samples processed per call.
+		/// </summary>
+		double samples = 0.0;
+	};
+
+	/// <summary>
+	/// Collects the results of every suite, prints them as they come in and writes them as JSON.
+	/// </summary>
+	class Report
+	{
+	private:
+		std::vector<Result> results_;
+
+	public:
+		/// <summary>
+		/// Records a result (and prints it).
+		/// </summary>
+		void add(const Result& result);
+
+		/// <summary>
+		/// Records a result without printing it (for suites that print their own tables).
+		/// </summary>
+		void record(const Result& result);
+
+		[[nodiscard]] const std::vector<Result>& get_results() const;
+
+		/// <summary>
+		/// Writes { "isa": ..., "blas": ..., "results": [ { "name", "seconds", "gflops", "bytes_per_second",
+		/// "samples_per_second" }, ... ] } (rates that do not apply are omitted).
+		/// </summary>
+		void write_json(std::ostream& os) const;
+	};
+
+	/// <summary>
+	/// Layers of the example network (784-64-64-10) for single samples and mini-batches, and a wider layer.
+	/// </summary>
+	[[nodiscard]] const std::vector<LayerShape>& get_layer_shapes();
+
+	/// <summary>
+	/// Returns size uniformly distributed values in [-1, 1] (fixed seed).
+	/// </summary>
+	[[nodiscard]] std::vector<float> random_vector(size_t size);
+
+	/// <summary>
+	/// Minimum time every measurement runs for (--min-time).
+	/// </summary>
+	[[nodiscard]] double get_min_seconds();
+	void set_min_seconds(double min_seconds);
+
+	/// <summary>
+	/// Runs function repeatedly for at least get_min_seconds() (after one warm up call) and returns the seconds per call.
+	/// </summary>
+	template <typename Function>
+	double measure(Function&& function)
+	{
+		using clock = std::chrono::steady_clock;
+
+		function();
+
+		size_t iterations = 0;
+		const double min_seconds = get_min_seconds();
+		const auto start = clock::now();
+		double elapsed;
+		do
+		{
+			function();
+			++iterations;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		}
+		while (elapsed < min_seconds);
+
+		return elapsed / static_cast<double>(iterations);
+	}
+
+	/// <summary>
+	/// Benchmarks every kernel table level this CPU supports on the layer shapes and prints a table.
+	/// </summary>
+	void run_kernel_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks the BLAS backend (NN_BLAS_BACKEND) against the built-in kernels on the layer shapes.
+	/// </summary>
+	void run_blas_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks Matrix::multiply across shapes and the element wise matrix operations.
+	/// </summary>
+	void run_matrix_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks activate and derivative of every activation function.
+	/// </summary>
+	void run_activation_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks Layer::feed_forward, back_propagate and update_weights_and_biases on the layer shapes.
+	/// </summary>
+	void run_layer_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks Conv2D with both algorithms against the dense layer with the same input and output sizes, and Pool2D.
+	/// </summary>
+	void run_conv_benchmarks(Report& report);
+
+	/// <summary>
+	/// Benchmarks one training epoch of the example network on synthetic MNIST shaped data (samples samples).
+	/// </summary>
+	void run_training_benchmarks(Report& report, size_t samples);
+
+	/// <summary>
+	/// Benchmarks inference of the example network on threads of every NUMA node, reading one shared copy of the
+	/// weights and a copy per node, and prints the weight bytes read from another node.
+	/// </summary>
+	void run_numa_benchmarks(Report& report);
+}
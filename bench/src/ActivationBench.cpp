@@ -0,0 +1,71 @@
+// File: bench/src/ActivationBench.cpp
+// Purpose: Benchmarks of every activation function.
+
+#include <memory> // std::unique_ptr, std::make_unique
+#include <string> // std::string
+#include <utility> // std::pair
+#include <vector> // std::vector
+
+#include <NeuralNetwork/ActivationFunction.h>
+
+#include "Benchmark.h"
+
+void bench::run_activation_benchmarks(Report& report)
+{
+	std::vector<std::pair<std::string, std::unique_ptr<nn::activation_functions::ActivationFunction>>> functions;
+	functions.emplace_back("sigmoid", std::make_unique<nn::activation_functions::Sigmoid>());
+	functions.emplace_back("relu", std::make_unique<nn::activation_functions::ReLU>());
+	functions.emplace_back("leaky_relu", std::make_unique<nn::activation_functions::LeakyReLU>());
+	functions.emplace_back("tanh", std::make_unique<nn::activation_functions::Tanh>());
+	functions.emplace_back("softmax", std::make_unique<nn::activation_functions::SoftMax>());
+
+	// The hidden layers of the example network and the wide layer (neurons x batch size)
+	const std::pair<size_t, size_t> shapes[] = { { 64, 32 }, { 512, 64 } };
+
+	for (const auto& [rows, cols] : shapes)
+	{
+		const std::string shape = " " + std::to_string(rows) + "x" + std::to_string(cols);
+		const std::vector<float> values = random_vector(rows * cols);
+		const double size = static_cast<double>(rows * cols);
+
+		for (const auto& [name, function] : functions)
+		{
+			// Restored before every call: repeated activation would converge to a fixed point (or overflow for the derivatives)
+			nn::Matrix<float> original(rows, cols), matrix(rows, cols);
+			for (size_t i = 0; i < values.size(); ++i)
+			{
+				original[i] = values[i];
+			}
+
+			const double restore_seconds = measure([&]() { matrix = original; });
+			const double activate_seconds = measure([&]()
+			{
+				matrix = original;
+				function->activate(matrix);
+			});
+			const double derivative_seconds = measure([&]()
+			{
+				matrix = original;
+				function->derivative(matrix);
+			});
+
+			// In place: every element is read and written once
+			const double activate = activate_seconds > restore_seconds ? activate_seconds - restore_seconds : activate_seconds;
+			const double derivative = derivative_seconds > restore_seconds ? derivative_seconds - restore_seconds : derivative_seconds;
+			report.add({ "activation/" + name + shape, activate, 0.0, 8.0 * size, 0.0 });
+			report.add({ "activation/" + name + " derivative" + shape, derivative, 0.0, 8.0 * size, 0.0 });
+
+			// Back propagation from the sums, the activations and their deltas: the fused pass of the function against
+			// the default of the interface (copy, derivative, hadamard product)
+			nn::Matrix<float> activations = original, delta_activations = original, delta_sums(rows, cols);
+			function->activate(activations);
+			const double backward = measure([&]() { function->backward(original, activations, delta_activations, delta_sums); });
+			const double unfused = measure([&]()
+			{
+				function->ActivationFunction::backward(original, activations, delta_activations, delta_sums);
+			});
+			report.add({ "activation/" + name + " backward" + shape, backward, 0.0, 12.0 * size, 0.0 });
+			report.add({ "activation/" + name + " backward unfused" + shape, unfused, 0.0, 28.0 * size, 0.0 });
+		}
+	}
+}
@@ -0,0 +1,134 @@
+// File: bench/src/Benchmark.cpp
+// Purpose: Helpers and the result report shared by the benchmarks.
+
+#include "Benchmark.h"
+
+#include <iomanip> // std::setw, std::setprecision
+#include <iostream> // std::cout
+#include <random> // std::mt19937, std::uniform_real_distribution
+
+#include <NeuralNetwork/Kernels.h>
+
+namespace
+{
+	double min_seconds = 0.2;
+
+	/// <summary>
+	/// Writes value as a JSON string (names only contain printable ASCII).
+	/// </summary>
+	void write_json_string(std::ostream& os, const std::string& value)
+	{
+		os << '"';
+		for (const char character : value)
+		{
+			if (character == '"' || character == '\\')
+			{
+				os << '\\';
+			}
+			os << character;
+		}
+		os << '"';
+	}
+}
+
+void bench::Report::add(const Result& result)
+{
+	this->record(result);
+
+	std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(12) << result.seconds * 1e6 << " us";
+	if (result.flop > 0.0)
+	{
+		std::cout << std::setw(10) << std::setprecision(2) << result.flop / result.seconds * 1e-9 << " GFLOP/s";
+	}
+	if (result.bytes > 0.0)
+	{
+		std::cout << std::setw(10) << std::setprecision(2) << result.bytes / result.seconds * 1e-9 << " GB/s";
+	}
+	if (result.samples > 0.0)
+	{
+		std::cout << std::setw(12) << std::setprecision(0) << result.samples / result.seconds << " samples/s";
+	}
+	std::cout << "\n";
+}
+
+void bench::Report::record(const Result& result)
+{
+	this->results_.push_back(result);
+}
+
+const std::vector<bench::Result>& bench::Report::get_results() const
+{
+	return this->results_;
+}
+
+void bench::Report::write_json(std::ostream& os) const
+{
+	const nn::kernels::KernelTable& kernels = nn::kernels::get_kernels();
+
+	os << "{\n  \"isa\": ";
+	write_json_string(os, nn::kernels::get_isa_level_name(kernels.level));
+	os << ",\n  \"blas\": ";
+	if (kernels.blas != nullptr)
+	{
+		write_json_string(os, kernels.blas);
+	}
+	else
+	{
+		os << "null";
+	}
+	os << ",\n  \"results\": [";
+
+	os << std::setprecision(9) << std::defaultfloat;
+	for (size_t i = 0; i < this->results_.size(); ++i)
+	{
+		const Result& result = this->results_[i];
+		os << (i == 0 ? "\n" : ",\n") << "    { \"name\": ";
+		write_json_string(os, result.name);
+		os << ", \"seconds\": " << result.seconds;
+		if (result.flop > 0.0)
+		{
+			os << ", \"gflops\": " << result.flop / result.seconds * 1e-9;
+		}
+		if (result.bytes > 0.0)
+		{
+			os << ", \"bytes_per_second\": " << result.bytes / result.seconds;
+		}
+		if (result.samples > 0.0)
+		{
+			os << ", \"samples_per_second\": " << result.samples / result.seconds;
+		}
+		os << " }";
+	}
+	os << "\n  ]\n}\n";
+}
+
+const std::vector<bench::LayerShape>& bench::get_layer_shapes()
+{
+	static const std::vector<LayerShape> layer_shapes = {
+		{ 64, 784, 1 }, { 64, 784, 32 }, { 64, 64, 32 }, { 10, 64, 32 }, { 512, 784, 64 }
+	};
+	return layer_shapes;
+}
+
+std::vector<float> bench::random_vector(const size_t size)
+{
+	static std::mt19937 generator(42);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	std::vector<float> values(size);
+	for (float& value : values)
+	{
+		value = distribution(generator);
+	}
+	return values;
+}
+
+double bench::get_min_seconds()
+{
+	return min_seconds;
+}
+
+void bench::set_min_seconds(const double seconds)
+{
+	min_seconds = seconds;
+}
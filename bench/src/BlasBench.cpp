@@ -0,0 +1,113 @@
+// File: bench/src/BlasBench.cpp
+// Purpose: Benchmarks of the BLAS backend against the built-in kernels on the layer shapes.
+
+#include <iomanip> // std::setw
+#include <iostream> // std::cout
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <NeuralNetwork/Kernels.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	/// <summary>
+	/// Returns the transpose of the rows x cols matrix.
+	/// </summary>
+	void transpose(const float* source, float* destination, const size_t rows, const size_t cols)
+	{
+		for (size_t i = 0; i < rows; ++i)
+		{
+			for (size_t j = 0; j < cols; ++j)
+			{
+				destination[j * rows + i] = source[i * cols + j];
+			}
+		}
+	}
+
+	/// <summary>
+	/// Prints the rate of both backends and records them as "blas/built-in/name" and "blas/backend/name".
+	/// </summary>
+	void print_row(bench::Report& report, const std::string& name, const double flop, const double bytes,
+	               const double built_in_seconds, const double blas_seconds)
+	{
+		report.record({ "blas/built-in/" + name, built_in_seconds, flop, bytes });
+		report.record({ "blas/" + std::string(nn::kernels::get_blas_name()) + "/" + name, blas_seconds, flop, bytes });
+
+		std::cout << std::left << std::setw(40) << "  " + name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << flop / built_in_seconds * 1e-9 << std::setw(10) << flop / blas_seconds * 1e-9
+			<< std::setw(9) << built_in_seconds / blas_seconds << "x\n";
+	}
+}
+
+void bench::run_blas_benchmarks(Report& report)
+{
+	const char* blas_name = nn::kernels::get_blas_name();
+	if (blas_name == nullptr)
+	{
+		std::cout << "No BLAS backend (configure with -D NN_BLAS_BACKEND=Auto to compare one).\n";
+		return;
+	}
+
+	// Same level for both, the BLAS table only replaces the matrix products
+	const nn::kernels::KernelTable built_in = nn::kernels::create_kernel_table(nn::kernels::detect_isa_level(), false);
+	const nn::kernels::KernelTable blas = nn::kernels::create_kernel_table(nn::kernels::detect_isa_level(), true);
+
+	std::cout << std::left << std::setw(40) << "backends [GFLOP/s]" << std::right << std::setw(10)
+		<< nn::kernels::get_isa_level_name(built_in.level) << std::setw(10) << blas_name << std::setw(10) << "speedup" << "\n";
+
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		const size_t neurons = shape.neurons, inputs = shape.inputs, batch_size = shape.batch_size;
+		const std::string name = std::to_string(neurons) + "x" + std::to_string(inputs) + " batch " + std::to_string(batch_size);
+
+		const std::vector<float> weights = random_vector(neurons * inputs);
+		const std::vector<float> input = random_vector(inputs * batch_size);
+		const std::vector<float> delta_sums = random_vector(neurons * batch_size);
+		std::vector<float> sums(neurons * batch_size), delta_weights(neurons * inputs), delta_input(inputs * batch_size);
+		std::vector<float> delta_biases(neurons), transposed(neurons * inputs > inputs * batch_size ? neurons * inputs : inputs * batch_size);
+		const double product_flop = 2.0 * static_cast<double>(neurons * inputs * batch_size);
+		const double product_bytes = 4.0 * static_cast<double>(neurons * inputs + inputs * batch_size + neurons * batch_size);
+
+		// Forward: sums = weights * input
+		print_row(report, "forward " + name, product_flop, product_bytes,
+			measure([&]() { built_in.sgemm(weights.data(), input.data(), sums.data(), neurons, batch_size, inputs, inputs, batch_size, batch_size); }),
+			measure([&]() { blas.sgemm(weights.data(), input.data(), sums.data(), neurons, batch_size, inputs, inputs, batch_size, batch_size); }));
+
+		// Weight gradient: delta_weights = delta_sums * transpose(input) / batch_size (the built-in path transposes explicitly)
+		const float scale = 1.0f / static_cast<float>(batch_size);
+		print_row(report, "weight gradient " + name, product_flop, product_bytes,
+			measure([&]()
+			{
+				transpose(input.data(), transposed.data(), inputs, batch_size);
+				built_in.sgemm(delta_sums.data(), transposed.data(), delta_weights.data(), neurons, inputs, batch_size, batch_size, inputs, inputs);
+				for (float& value : delta_weights)
+				{
+					value *= scale;
+				}
+			}),
+			measure([&]()
+			{
+				blas.sgemm_nt(delta_sums.data(), input.data(), delta_weights.data(), neurons, inputs, batch_size, scale, 0.0f, batch_size, batch_size, inputs);
+			}));
+
+		// Input delta: delta_input = transpose(weights) * delta_sums
+		print_row(report, "input delta " + name, product_flop, product_bytes,
+			measure([&]()
+			{
+				transpose(weights.data(), transposed.data(), neurons, inputs);
+				built_in.sgemm(transposed.data(), delta_sums.data(), delta_input.data(), inputs, batch_size, neurons, neurons, batch_size, batch_size);
+			}),
+			measure([&]()
+			{
+				blas.sgemm_tn(weights.data(), delta_sums.data(), delta_input.data(), inputs, batch_size, neurons, 1.0f, 0.0f, inputs, batch_size, batch_size);
+			}));
+
+		// Bias gradient: delta_biases = row sums of delta_sums / batch_size
+		print_row(report, "bias gradient " + name, static_cast<double>(neurons * batch_size),
+			4.0 * static_cast<double>(neurons * batch_size + neurons),
+			measure([&]() { built_in.row_sums(delta_sums.data(), delta_biases.data(), neurons, batch_size, scale, batch_size); }),
+			measure([&]() { blas.row_sums(delta_sums.data(), delta_biases.data(), neurons, batch_size, scale, batch_size); }));
+	}
+}
@@ -0,0 +1,106 @@
+// File: bench/src/ConvBench.cpp
+// Purpose: Benchmarks of Conv2D (im2col and direct) against the dense layer with the same input and output sizes, and of
+//          Pool2D on the output of the convolution.
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Pool2D.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	struct ConvShape
+	{
+		size_t channels, height, width, kernels, kernel_size, padding, batch_size;
+	};
+
+	/// <summary>
+	/// 3x3 convolutions of the first two layers of a small MNIST network.
+	/// </summary>
+	const std::vector<ConvShape> conv_shapes = {
+		{ 1, 28, 28, 8, 3, 1, 32 },
+		{ 8, 14, 14, 16, 3, 1, 32 },
+	};
+
+	nn::Matrix<float> random_activations(const size_t rows, const size_t cols)
+	{
+		const std::vector<float> values = bench::random_vector(rows * cols);
+		nn::Matrix<float> matrix(rows, cols);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			matrix[i] = 0.5f * values[i] + 0.5f;
+		}
+		return matrix;
+	}
+}
+
+void bench::run_conv_benchmarks(Report& report)
+{
+	for (const ConvShape& shape : conv_shapes)
+	{
+		const size_t inputs = shape.channels * shape.height * shape.width, batch_size = shape.batch_size;
+		const std::string name = " " + std::to_string(shape.channels) + "x" + std::to_string(shape.height) + "x" + std::to_string(shape.width) +
+			" to " + std::to_string(shape.kernels) + " k" + std::to_string(shape.kernel_size) + " batch " + std::to_string(batch_size);
+		const double samples = static_cast<double>(batch_size);
+
+		nn::DenseLayer previous_layer(inputs, batch_size);
+		previous_layer.set_activations(random_activations(inputs, batch_size));
+		nn::Conv2D conv(shape.channels, shape.height, shape.width, shape.kernels, shape.kernel_size, batch_size, 1, shape.padding);
+		const size_t neurons = conv.get_neuron_count();
+		const nn::Matrix<float> expected = random_activations(neurons, batch_size);
+
+		// Multiply adds of the convolution (the zero padding included) and of the dense layer of the same size
+		const double conv_flop = 2.0 * static_cast<double>(neurons * shape.channels * shape.kernel_size * shape.kernel_size * batch_size);
+		const double dense_flop = 2.0 * static_cast<double>(neurons * inputs * batch_size);
+		const double conv_bytes = 4.0 * static_cast<double>(conv.get_weights().get_rows() * conv.get_weights().get_cols() + inputs * batch_size + 2 * neurons * batch_size);
+		const double dense_bytes = 4.0 * static_cast<double>(neurons * inputs + inputs * batch_size + 2 * neurons * batch_size);
+
+		for (const nn::ConvolutionAlgorithm algorithm : { nn::ConvolutionAlgorithm::Im2col, nn::ConvolutionAlgorithm::Direct })
+		{
+			conv.set_algorithm(algorithm);
+			const std::string algorithm_name = algorithm == nn::ConvolutionAlgorithm::Im2col ? " im2col" : " direct";
+			report.add({ "conv/feed_forward" + algorithm_name + name, measure([&]() { conv.feed_forward(previous_layer); }),
+				conv_flop, conv_bytes, samples });
+
+			// Weight gradient and the delta of the input (twice the work of the forward pass)
+			conv.feed_forward(previous_layer);
+			nn::Matrix<float> previous_delta(inputs, batch_size);
+			report.add({ "conv/back_propagate" + algorithm_name + name, measure([&]()
+			{
+				conv.back_propagate(expected, previous_layer);
+				conv.propagate_delta_to_previous_layer(previous_delta);
+			}), 2.0 * conv_flop, 2.0 * conv_bytes, samples });
+		}
+
+		// 2x2 pooling of the convolution output (its delta activations are whatever the last back propagation left)
+		conv.feed_forward(previous_layer);
+		for (const nn::PoolingMode mode : { nn::PoolingMode::Max, nn::PoolingMode::Average })
+		{
+			nn::Pool2D pool(mode, shape.kernels, conv.get_output_height(), conv.get_output_width(), 2, batch_size);
+			const std::string mode_name = mode == nn::PoolingMode::Max ? " max" : " average";
+			const double pool_bytes = 4.0 * static_cast<double>(neurons * batch_size + pool.get_neuron_count() * batch_size);
+			report.add({ "conv/pool" + mode_name + name, measure([&]() { pool.feed_forward(conv); }),
+				static_cast<double>(neurons * batch_size), pool_bytes, samples });
+			pool.feed_forward(conv);
+			nn::Matrix<float> conv_delta(neurons, batch_size);
+			report.add({ "conv/unpool" + mode_name + name, measure([&]() { pool.propagate_delta_to_previous_layer(conv_delta); }),
+				static_cast<double>(neurons * batch_size), pool_bytes + 4.0 * static_cast<double>(neurons * batch_size), samples });
+		}
+
+		// Dense baseline: every output connected to every input
+		nn::DenseLayer dense(neurons, batch_size, inputs);
+		report.add({ "conv/feed_forward dense" + name, measure([&]() { dense.feed_forward(previous_layer); }),
+			dense_flop, dense_bytes, samples });
+		dense.feed_forward(previous_layer);
+		nn::Matrix<float> previous_delta(inputs, batch_size);
+		report.add({ "conv/back_propagate dense" + name, measure([&]()
+		{
+			dense.back_propagate(expected, previous_layer);
+			dense.propagate_delta_to_previous_layer(previous_delta);
+		}), 2.0 * dense_flop, 2.0 * dense_bytes, samples });
+	}
+}
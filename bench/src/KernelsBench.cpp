@@ -0,0 +1,192 @@
+// File: bench/src/KernelsBench.cpp
+// Purpose: Benchmarks of the kernels of every instruction set level on the layer shapes.
+
+#include <algorithm> // std::find
+#include <iomanip> // std::setw
+#include <iostream> // std::cout
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <NeuralNetwork/Kernels.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	std::vector<nn::kernels::KernelTable> get_available_tables()
+	{
+		std::vector<nn::kernels::KernelTable> tables;
+		for (int level = 0; level <= static_cast<int>(nn::kernels::detect_isa_level()); ++level)
+		{
+			tables.push_back(nn::kernels::create_kernel_table(static_cast<nn::kernels::IsaLevel>(level), false));
+		}
+		return tables;
+	}
+
+	/// <summary>
+	/// Prints the rate of every level and the speedup of the last level over AVX2 (when both were measured).
+	/// </summary>
+	void print_row(const std::string& name, const std::vector<nn::kernels::KernelTable>& tables, const std::vector<double>& rates)
+	{
+		std::cout << std::left << std::setw(34) << name << std::right;
+		double avx2_rate = 0.0;
+		for (size_t i = 0; i < tables.size(); ++i)
+		{
+			std::cout << std::setw(10) << std::fixed << std::setprecision(2) << rates[i];
+			if (tables[i].level == nn::kernels::IsaLevel::AVX2)
+			{
+				avx2_rate = rates[i];
+			}
+		}
+		if (avx2_rate > 0.0 && tables.back().level == nn::kernels::IsaLevel::AVX512)
+		{
+			std::cout << std::setw(9) << std::setprecision(2) << rates.back() / avx2_rate << "x";
+		}
+		std::cout << "\n";
+	}
+
+	void print_header(const std::string& title, const std::vector<nn::kernels::KernelTable>& tables)
+	{
+		std::cout << std::left << std::setw(34) << title << std::right;
+		for (const nn::kernels::KernelTable& table : tables)
+		{
+			std::cout << std::setw(10) << nn::kernels::get_isa_level_name(table.level);
+		}
+		if (tables.back().level == nn::kernels::IsaLevel::AVX512)
+		{
+			std::cout << std::setw(10) << "vs avx2";
+		}
+		std::cout << "\n";
+	}
+
+	/// <summary>
+	/// GFLOP/s of c (m x n) = a (m x k) * b (k x n) for every level (recorded as "kernels/level/name").
+	/// </summary>
+	std::vector<double> benchmark_sgemm(bench::Report& report, const std::string& name, const std::vector<nn::kernels::KernelTable>& tables,
+	                                    const size_t m, const size_t n, const size_t k)
+	{
+		const std::vector<float> a = bench::random_vector(m * k);
+		const std::vector<float> b = bench::random_vector(k * n);
+		std::vector<float> c(m * n);
+
+		std::vector<double> rates;
+		for (const nn::kernels::KernelTable& table : tables)
+		{
+			const double seconds = bench::measure([&]()
+			{
+				table.sgemm(a.data(), b.data(), c.data(), m, n, k, k, n, n);
+			});
+			const double flop = 2.0 * static_cast<double>(m * n * k);
+			const double bytes = 4.0 * static_cast<double>(m * k + k * n + m * n);
+			report.record({ "kernels/" + std::string(nn::kernels::get_isa_level_name(table.level)) + "/" + name, seconds, flop, bytes });
+			rates.push_back(flop / seconds * 1e-9);
+		}
+		return rates;
+	}
+
+	/// <summary>
+	/// GFLOP/s of the fused weight and bias gradient, c (m x n) = a (m x k) * transpose(b) (b is n x k) and the row sums of
+	///	a, for every level (recorded as "kernels/level/name").
+	/// </summary>
+	std::vector<double> benchmark_sgemm_nt_row_sums(bench::Report& report, const std::string& name,
+	                                                const std::vector<nn::kernels::KernelTable>& tables, const size_t m,
+	                                                const size_t n, const size_t k)
+	{
+		const std::vector<float> a = bench::random_vector(m * k);
+		const std::vector<float> b = bench::random_vector(n * k);
+		std::vector<float> c(m * n), sums(m);
+
+		std::vector<double> rates;
+		for (const nn::kernels::KernelTable& table : tables)
+		{
+			const double seconds = bench::measure([&]()
+			{
+				table.sgemm_nt_row_sums(a.data(), b.data(), c.data(), sums.data(), m, n, k, 1.0f, 0.0f, k, k, n);
+			});
+			const double flop = 2.0 * static_cast<double>(m * n * k) + static_cast<double>(m * k);
+			const double bytes = 4.0 * static_cast<double>(m * k + n * k + m * n + m);
+			report.record({ "kernels/" + std::string(nn::kernels::get_isa_level_name(table.level)) + "/" + name, seconds, flop, bytes });
+			rates.push_back(flop / seconds * 1e-9);
+		}
+		return rates;
+	}
+
+	/// <summary>
+	/// Giga elements per second of an in place element wise kernel for every level (recorded as "kernels/level/name").
+	/// </summary>
+	template <typename Kernel>
+	std::vector<double> benchmark_element_wise(bench::Report& report, const std::string& name, const std::vector<nn::kernels::KernelTable>& tables,
+	                                           const size_t size, Kernel kernel)
+	{
+		std::vector<double> rates;
+		for (const nn::kernels::KernelTable& table : tables)
+		{
+			// Repeated application converges (or grows slowly for axpy) without reaching denormals or infinities
+			std::vector<float> x = bench::random_vector(size);
+			const double seconds = bench::measure([&]()
+			{
+				kernel(table, x.data(), size);
+			});
+			// Read and written once
+			report.record({ "kernels/" + std::string(nn::kernels::get_isa_level_name(table.level)) + "/" + name, seconds, 0.0,
+				8.0 * static_cast<double>(size) });
+			rates.push_back(static_cast<double>(size) / seconds * 1e-9);
+		}
+		return rates;
+	}
+}
+
+void bench::run_kernel_benchmarks(Report& report)
+{
+	const std::vector<nn::kernels::KernelTable> tables = get_available_tables();
+
+	// The three products of a dense layer: forward (weights * input), the weight gradient
+	// (delta_sums * input^T, from the transposed input and fused with the bias sums from the input)
+	// and the previous layer's delta (weights^T * delta_sums)
+	print_header("sgemm [GFLOP/s]", tables);
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		const std::string name = std::to_string(shape.neurons) + "x" + std::to_string(shape.inputs) + " batch " + std::to_string(shape.batch_size);
+		print_row("  forward " + name, tables, benchmark_sgemm(report, "forward " + name, tables, shape.neurons, shape.batch_size, shape.inputs));
+		print_row("  weight gradient " + name, tables, benchmark_sgemm(report, "weight gradient " + name, tables, shape.neurons, shape.inputs, shape.batch_size));
+		print_row("  weight and bias gradient " + name, tables, benchmark_sgemm_nt_row_sums(report, "weight and bias gradient " + name, tables, shape.neurons, shape.inputs, shape.batch_size));
+		print_row("  input delta " + name, tables, benchmark_sgemm(report, "input delta " + name, tables, shape.inputs, shape.batch_size, shape.neurons));
+	}
+	std::cout << "\n";
+
+	print_header("element wise [Gelement/s]", tables);
+	std::vector<size_t> sizes;
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		const size_t size = shape.neurons * shape.batch_size;
+		if (std::find(sizes.begin(), sizes.end(), size) != sizes.end())
+		{
+			continue;
+		}
+		sizes.push_back(size);
+
+		const std::string name = std::to_string(shape.neurons) + "x" + std::to_string(shape.batch_size);
+		const std::vector<float> y = random_vector(size);
+
+		print_row("  axpy " + name, tables, benchmark_element_wise(report, "axpy " + name, tables, size, [&y](const nn::kernels::KernelTable& table, float* x, const size_t count)
+		{
+			table.axpy(x, y.data(), 0.5f, count);
+		}));
+		print_row("  sigmoid " + name, tables, benchmark_element_wise(report, "sigmoid " + name, tables, size, [](const nn::kernels::KernelTable& table, float* x, const size_t count)
+		{
+			table.sigmoid(x, count);
+		}));
+		print_row("  sigmoid derivative " + name, tables, benchmark_element_wise(report, "sigmoid derivative " + name, tables, size, [](const nn::kernels::KernelTable& table, float* x, const size_t count)
+		{
+			table.sigmoid_derivative(x, count);
+		}));
+		print_row("  tanh " + name, tables, benchmark_element_wise(report, "tanh " + name, tables, size, [](const nn::kernels::KernelTable& table, float* x, const size_t count)
+		{
+			table.tanh(x, count);
+		}));
+		print_row("  relu " + name, tables, benchmark_element_wise(report, "relu " + name, tables, size, [](const nn::kernels::KernelTable& table, float* x, const size_t count)
+		{
+			table.leaky_relu(x, 0.0f, count);
+		}));
+	}
+}
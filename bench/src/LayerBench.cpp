@@ -0,0 +1,77 @@
+// File: bench/src/LayerBench.cpp
+// Purpose: Benchmarks of Layer::feed_forward, back_propagate and update_weights_and_biases on the layer shapes, and of
+//          dropout on the activations of the layer.
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Dropout.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	/// <summary>
+	/// Returns a rows x cols matrix with uniformly distributed values in [0, 1] (fixed seed).
+	/// </summary>
+	nn::Matrix<float> random_activations(const size_t rows, const size_t cols)
+	{
+		const std::vector<float> values = bench::random_vector(rows * cols);
+		nn::Matrix<float> matrix(rows, cols);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			matrix[i] = 0.5f * values[i] + 0.5f;
+		}
+		return matrix;
+	}
+}
+
+void bench::run_layer_benchmarks(Report& report)
+{
+	// Neurons of the layer after the benchmarked one (the output layer of the example network)
+	constexpr size_t next_neurons = 10;
+
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		const size_t neurons = shape.neurons, inputs = shape.inputs, batch_size = shape.batch_size;
+		const std::string name = " " + std::to_string(neurons) + "x" + std::to_string(inputs) + " batch " + std::to_string(batch_size);
+		const double samples = static_cast<double>(batch_size);
+		const double product_flop = 2.0 * static_cast<double>(neurons * inputs * batch_size);
+		const double sums_size = static_cast<double>(neurons * batch_size);
+
+		nn::DenseLayer previous_layer(inputs, batch_size);
+		previous_layer.set_activations(random_activations(inputs, batch_size));
+		nn::DenseLayer layer(neurons, batch_size, inputs);
+		nn::DenseLayer next_layer(next_neurons, batch_size, neurons);
+		const nn::Matrix<float> expected = random_activations(neurons, batch_size);
+		const nn::Matrix<float> next_expected = random_activations(next_neurons, batch_size);
+
+		// Weights * input, the biases and the activation function
+		report.add({ "layer/feed_forward" + name, measure([&]() { layer.feed_forward(previous_layer); }),
+			product_flop + sums_size, 4.0 * static_cast<double>(neurons * inputs + inputs * batch_size + 2 * neurons * batch_size + neurons), samples });
+
+		// Output layer: the delta from the expected activations, the weight gradient and the bias gradient
+		report.add({ "layer/back_propagate output" + name, measure([&]() { layer.back_propagate(expected, previous_layer); }),
+			product_flop + 4.0 * sums_size, 4.0 * static_cast<double>(neurons * inputs + inputs * batch_size + 4 * neurons * batch_size + neurons), samples });
+
+		// Hidden layer: the delta is propagated back from the next layer (which needs valid deltas itself)
+		next_layer.feed_forward(layer);
+		next_layer.back_propagate(next_expected, layer);
+		report.add({ "layer/back_propagate hidden" + name, measure([&]() { layer.back_propagate(next_layer, previous_layer); }),
+			product_flop + 2.0 * static_cast<double>(next_neurons) * sums_size + 3.0 * sums_size,
+			4.0 * static_cast<double>(neurons * inputs + inputs * batch_size + next_neurons * neurons + next_neurons * batch_size + 3 * neurons * batch_size + neurons),
+			samples });
+
+		// weights -= learning_rate * delta_weights (a tiny rate keeps the weights where they are)
+		report.add({ "layer/update_weights_and_biases" + name, measure([&]() { layer.update_weights_and_biases(1e-6f); }),
+			2.0 * static_cast<double>(neurons * inputs + neurons), 12.0 * static_cast<double>(neurons * inputs + neurons), 0.0 });
+
+		// Dropout of the activations: a new bitmask and the masked copy, against one scalar random number per element
+		nn::Dropout dropout(neurons, batch_size, 0.5f, 1);
+		report.add({ "layer/dropout" + name, measure([&]() { dropout.feed_forward(layer); }),
+			sums_size, 8.0 * sums_size + sums_size / 8.0, samples });
+		nn::Matrix<float> noise(neurons, batch_size);
+		report.add({ "layer/randomize" + name, measure([&]() { noise.randomize(0.0f, 1.0f); }), sums_size, 4.0 * sums_size, samples });
+	}
+}
@@ -0,0 +1,119 @@
+// File: bench/src/MatrixBench.cpp
+// Purpose: Benchmarks of Matrix::multiply across shapes and of the element wise matrix operations.
+
+#include <algorithm> // std::find
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include <NeuralNetwork/Matrix.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	/// <summary>
+	/// Returns a rows x cols matrix with uniformly distributed values in [-1, 1] (fixed seed).
+	/// </summary>
+	nn::Matrix<float> random_matrix(const size_t rows, const size_t cols)
+	{
+		const std::vector<float> values = bench::random_vector(rows * cols);
+		nn::Matrix<float> matrix(rows, cols);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			matrix[i] = values[i];
+		}
+		return matrix;
+	}
+
+	/// <summary>
+	/// Benchmarks result (m x n) = matrix1 (m x k) * matrix2 (k x n).
+	/// </summary>
+	void benchmark_multiply(bench::Report& report, const size_t m, const size_t n, const size_t k)
+	{
+		const nn::Matrix<float> matrix1 = random_matrix(m, k);
+		const nn::Matrix<float> matrix2 = random_matrix(k, n);
+		nn::Matrix<float> result(m, n);
+
+		const double seconds = bench::measure([&]()
+		{
+			nn::Matrix<float>::multiply(matrix1, matrix2, result);
+		});
+		report.add({ "matrix/multiply " + std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n), seconds,
+			2.0 * static_cast<double>(m * n * k), 4.0 * static_cast<double>(m * k + k * n + m * n) });
+	}
+
+	/// <summary>
+	/// Benchmarks the element wise operations on a rows x cols matrix.
+	/// </summary>
+	void benchmark_element_wise(bench::Report& report, const size_t rows, const size_t cols)
+	{
+		const std::string shape = " " + std::to_string(rows) + "x" + std::to_string(cols);
+		const double size = static_cast<double>(rows * cols);
+		const nn::Matrix<float> other = random_matrix(rows, cols);
+
+		// The in place operations read both operands and write the result (12 bytes per element); repeated
+		// application converges to 0 (hadamard_product) or grows slowly (add_scaled) without reaching denormals or infinities
+		nn::Matrix<float> matrix = random_matrix(rows, cols);
+		report.add({ "matrix/hadamard_product" + shape, bench::measure([&]() { matrix.hadamard_product(other); }), size, 12.0 * size });
+
+		matrix = random_matrix(rows, cols);
+		report.add({ "matrix/add_scaled" + shape, bench::measure([&]() { matrix.add_scaled(other, -0.01f); }), 2.0 * size, 12.0 * size });
+
+		matrix = random_matrix(rows, cols);
+		report.add({ "matrix/element_wise binary" + shape, bench::measure([&]()
+		{
+			matrix.perform_element_wise_operation(other, [](const float a, const float b) { return a - 0.01f * b; });
+		}), 2.0 * size, 12.0 * size });
+
+		matrix = random_matrix(rows, cols);
+		report.add({ "matrix/element_wise unary" + shape, bench::measure([&]()
+		{
+			matrix.perform_element_wise_operation([](const float a) { return 0.5f * a; });
+		}), size, 8.0 * size });
+
+		// matrix = 0.9 * matrix - 0.01 * other as two passes over the kernels and as one fused expression
+		matrix = random_matrix(rows, cols);
+		report.add({ "matrix/decayed update two passes" + shape, bench::measure([&]()
+		{
+			matrix.perform_element_wise_operation([](const float a) { return 0.9f * a; });
+			matrix.add_scaled(other, -0.01f);
+		}), 3.0 * size, 20.0 * size });
+
+		matrix = random_matrix(rows, cols);
+		report.add({ "matrix/decayed update expression" + shape, bench::measure([&]()
+		{
+			matrix = 0.9f * matrix - 0.01f * other;
+		}), 3.0 * size, 12.0 * size });
+
+		report.add({ "matrix/transpose" + shape, bench::measure([&]()
+		{
+			const nn::Matrix<float> transposed = other.transpose();
+			static_cast<void>(transposed);
+		}), 0.0, 8.0 * size });
+	}
+}
+
+void bench::run_matrix_benchmarks(Report& report)
+{
+	// The forward products of the layer shapes, then square matrices
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		benchmark_multiply(report, shape.neurons, shape.batch_size, shape.inputs);
+	}
+	for (const size_t size : { 128, 256, 512 })
+	{
+		benchmark_multiply(report, size, size, size);
+	}
+
+	std::vector<size_t> sizes;
+	for (const LayerShape& shape : get_layer_shapes())
+	{
+		const size_t size = shape.neurons * shape.batch_size;
+		if (std::find(sizes.begin(), sizes.end(), size) != sizes.end())
+		{
+			continue;
+		}
+		sizes.push_back(size);
+		benchmark_element_wise(report, shape.neurons, shape.batch_size);
+	}
+}
@@ -0,0 +1,137 @@
+// File: bench/src/NumaBench.cpp
+// Purpose: Benchmark of inference on threads of every NUMA node, with one shared copy of the weights and with a copy
+// per node.
+
+#include <algorithm> // std::max
+#include <iomanip> // std::setprecision
+#include <iostream> // std::cout
+#include <memory> // std::unique_ptr, std::make_unique
+#include <string> // std::string
+#include <thread> // std::thread
+#include <vector> // std::vector
+
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Numa.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	constexpr size_t batch_size = 32;
+	constexpr size_t batches_per_thread = 16;
+
+	/// <summary>
+	/// Layers of one inference thread and the node it runs on.
+	/// </summary>
+	struct ThreadLayers
+	{
+		std::vector<std::unique_ptr<nn::DenseLayer>> layers;
+		size_t node = 0;
+	};
+
+	/// <summary>
+	/// Runs function(thread) on thread_count threads pinned to the nodes in turn (Pinning::Scatter).
+	/// </summary>
+	template <typename Function>
+	void run_pinned(const size_t thread_count, Function function)
+	{
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back([&function, t]()
+			{
+				static_cast<void>(nn::numa::pin_current_thread({ nn::numa::get_worker_cpu(t, nn::numa::Pinning::Scatter) }));
+				function(t);
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	/// <summary>
+	/// Bytes of weights and biases one batch reads from the memory of another node than its thread's.
+	/// </summary>
+	double get_remote_bytes(const std::vector<ThreadLayers>& threads)
+	{
+		double bytes = 0.0;
+		for (const ThreadLayers& thread : threads)
+		{
+			for (const auto& layer : thread.layers)
+			{
+				for (const nn::Parameter& parameter : layer->get_parameters())
+				{
+					const size_t node = nn::numa::get_memory_node(parameter.value->get_data());
+					if (node != nn::numa::unknown_node && node != thread.node)
+					{
+						bytes += static_cast<double>(parameter.value->get_rows() * parameter.value->get_cols() * sizeof(float));
+					}
+				}
+			}
+		}
+		return bytes / static_cast<double>(threads.size());
+	}
+}
+
+void bench::run_numa_benchmarks(Report& report)
+{
+	const nn::numa::Topology& topology = nn::numa::get_topology();
+	const size_t thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+	std::cout << "NUMA nodes: " << topology.get_node_count() << ", inference threads: " << thread_count << " (scatter)\n";
+
+	// The example network, allocated and initialized by this thread: its weights are on this thread's node
+	const std::vector<size_t> layer_sizes = { 784, 64, 64, 10 };
+	std::vector<std::unique_ptr<nn::DenseLayer>> network;
+	std::vector<nn::Layer*> layers;
+	network.push_back(std::make_unique<nn::DenseLayer>(layer_sizes[0], batch_size));
+	for (size_t i = 1; i < layer_sizes.size(); ++i)
+	{
+		network.push_back(std::make_unique<nn::DenseLayer>(layer_sizes[i], batch_size, layer_sizes[i - 1]));
+	}
+	for (const auto& layer : network)
+	{
+		layers.push_back(layer.get());
+	}
+	const nn::numa::NodeReplicas replicas(layers);
+
+	nn::Matrix<float> input(layer_sizes[0], batch_size);
+	const std::vector<float> values = random_vector(layer_sizes[0] * batch_size);
+	std::copy(values.begin(), values.end(), input.get_data());
+	const double samples = static_cast<double>(thread_count * batches_per_thread * batch_size);
+
+	for (const bool per_node : { false, true })
+	{
+		// Every thread makes its layers on its own CPU: activations local, weights shared or of its node
+		std::vector<ThreadLayers> threads(thread_count);
+		run_pinned(thread_count, [&](const size_t t)
+		{
+			threads[t].node = nn::numa::get_current_node();
+			if (per_node)
+			{
+				threads[t].layers = replicas.create_thread_layers();
+				return;
+			}
+			for (const auto& layer : network)
+			{
+				threads[t].layers.push_back(layer->create_replica());
+			}
+		});
+
+		const double seconds = measure([&]()
+		{
+			run_pinned(thread_count, [&](const size_t t)
+			{
+				for (size_t batch = 0; batch < batches_per_thread; ++batch)
+				{
+					static_cast<void>(nn::numa::feed_forward(threads[t].layers, input));
+				}
+			});
+		});
+		const std::string name = std::string("numa/inference ") + (per_node ? "per node weights " : "shared weights ") +
+			std::to_string(thread_count) + " threads";
+		report.add({ name, seconds, 0.0, 0.0, samples });
+		std::cout << "  weights read across nodes per batch: " << std::fixed << std::setprecision(1)
+			<< get_remote_bytes(threads) / 1024.0 << " KiB\n";
+	}
+}
@@ -0,0 +1,220 @@
+// File: bench/src/TrainingBench.cpp
+// Purpose: Benchmark of one training epoch on synthetic MNIST shaped data.
+
+#include <algorithm> // std::max
+#include <filesystem> // std::filesystem::temp_directory_path
+#include <iomanip> // std::setprecision
+#include <iostream> // std::cout
+#include <memory> // std::unique_ptr, std::make_unique
+#include <random> // std::mt19937, std::uniform_real_distribution
+#include <string> // std::string
+#include <thread> // std::thread
+#include <vector> // std::vector
+
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	constexpr size_t input_size = 784;
+	constexpr size_t output_size = 10;
+	constexpr size_t batch_size = 32;
+
+	/// <summary>
+	/// Neurons of the layers of the example network.
+	/// </summary>
+	const std::vector<size_t> layer_sizes = { input_size, 64, 64, output_size };
+
+	/// <summary>
+	/// MNIST shaped data set (784 inputs in [0, 1], one-hot outputs for 10 classes) generated in memory, so the
+	/// benchmark needs no files.
+	/// </summary>
+	class SyntheticDataSet final : public nn::DataSet
+	{
+	private:
+		std::vector<std::unique_ptr<nn::Matrix<float>>> inputs_;
+		std::vector<std::unique_ptr<nn::Matrix<float>>> outputs_;
+		size_t samples_;
+		size_t batch_size_ = 0;
+
+	public:
+		explicit SyntheticDataSet(const size_t samples)
+			: samples_(samples)
+		{
+		}
+
+		void initialize(const size_t batch_size) override
+		{
+			this->batch_size_ = batch_size;
+			std::mt19937 engine(42);
+			std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+			std::uniform_int_distribution<size_t> label_distribution(0, output_size - 1);
+
+			for (size_t batch = 0; batch < this->samples_ / batch_size; ++batch)
+			{
+				auto input = std::make_unique<nn::Matrix<float>>(input_size, batch_size);
+				auto output = std::make_unique<nn::Matrix<float>>(output_size, batch_size);
+				for (size_t i = 0; i < input_size * batch_size; ++i)
+				{
+					(*input)[i] = distribution(engine);
+				}
+				for (size_t i = 0; i < output_size * batch_size; ++i)
+				{
+					(*output)[i] = 0.0f;
+				}
+				for (size_t j = 0; j < batch_size; ++j)
+				{
+					(*output)(label_distribution(engine), j) = 1.0f;
+				}
+				this->inputs_.push_back(std::move(input));
+				this->outputs_.push_back(std::move(output));
+			}
+		}
+
+		nn::Matrix<float>& get_batch_input() override { return *this->inputs_[current_index_]; }
+		nn::Matrix<float>& get_batch_output() override { return *this->outputs_[current_index_]; }
+		[[nodiscard]] bool is_end() const override { return current_index_ >= this->inputs_.size(); }
+		[[nodiscard]] bool is_ready() const override { return !this->inputs_.empty(); }
+		void reset() override { current_index_ = 0; }
+		[[nodiscard]] size_t get_input_size() const override { return input_size; }
+		[[nodiscard]] size_t get_output_size() const override { return output_size; }
+		[[nodiscard]] size_t get_total_size() const override { return this->inputs_.size() * this->batch_size_; }
+	};
+
+	/// <summary>
+	/// The example network on samples synthetic samples.
+	/// </summary>
+	std::unique_ptr<nn::NeuralNetwork> make_example_network(const size_t samples)
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.1f, batch_size);
+		network->add_layer(std::make_unique<nn::DenseLayer>(layer_sizes[0], batch_size));
+		for (size_t i = 1; i < layer_sizes.size(); ++i)
+		{
+			network->add_layer(std::make_unique<nn::DenseLayer>(layer_sizes[i], batch_size, layer_sizes[i - 1]));
+		}
+
+		auto data_set = std::make_unique<SyntheticDataSet>(samples);
+		data_set->initialize(batch_size);
+		network->set_data_set(std::move(data_set));
+		return network;
+	}
+
+	/// <summary>
+	/// Runs function(rank) on one thread per rank.
+	/// </summary>
+	template <typename Function>
+	void run_ranks(const size_t ranks, Function function)
+	{
+		std::vector<std::thread> threads;
+		for (size_t rank = 0; rank < ranks; ++rank)
+		{
+			threads.emplace_back(function, rank);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+void bench::run_training_benchmarks(Report& report, const size_t samples)
+{
+	const std::unique_ptr<nn::NeuralNetwork> example = make_example_network(samples);
+	nn::NeuralNetwork& network = *example;
+	double parameters = 0.0;
+	for (size_t i = 1; i < layer_sizes.size(); ++i)
+	{
+		parameters += static_cast<double>(layer_sizes[i] * layer_sizes[i - 1] + layer_sizes[i]);
+	}
+	const double total_samples = static_cast<double>(network.get_data_set()->get_total_size());
+
+	// Forward, weight gradient and input delta products: 3 multiply-adds per parameter and sample, plus the update per batch.
+	// Traffic: the parameters are read by both passes and updated once per batch, the data is read once per sample.
+	const double seconds = measure([&]() { network.train_one_epoch(); });
+	const std::string name = "training/epoch 784-64-64-10 batch " + std::to_string(batch_size) + " " +
+		std::to_string(static_cast<size_t>(total_samples)) + " samples";
+	report.add({ name, seconds, 6.0 * parameters * total_samples + 2.0 * parameters * total_samples / batch_size,
+		4.0 * parameters * 3.0 * total_samples / batch_size + 4.0 * static_cast<double>(input_size + output_size) * total_samples, total_samples });
+
+	// One stage per layer, 4 micro batches per step; the bubble is the share of the stage time spent waiting
+	constexpr size_t stage_count = 3, micro_batches = 4;
+	network.set_accumulation_steps(micro_batches);
+	for (const auto schedule : { nn::pipeline::Schedule::GPipe, nn::pipeline::Schedule::OneForwardOneBackward })
+	{
+		nn::pipeline::Report pipeline_report;
+		const double pipeline_seconds = measure([&]() { pipeline_report = network.train_pipelined(stage_count, schedule); });
+		const std::string pipeline_name = std::string("training/pipelined ") +
+			(schedule == nn::pipeline::Schedule::GPipe ? "gpipe" : "1f1b") + " " + std::to_string(stage_count) + " stages " +
+			std::to_string(micro_batches) + " micro batches";
+		report.add({ pipeline_name, pipeline_seconds, 0.0, 0.0, total_samples });
+		std::cout << "  bubble " << std::fixed << std::setprecision(2) << pipeline_report.get_bubble_fraction()
+			<< " (ideal " << pipeline_report.get_ideal_bubble_fraction() << ")\n";
+	}
+	network.set_accumulation_steps(1);
+
+	// Hogwild on every core against the synchronous epoch above, and the loss both reach from the same weights
+	const size_t thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+	const double hogwild_seconds = measure([&]() { static_cast<void>(network.train_hogwild(thread_count)); });
+	report.add({ "training/hogwild " + std::to_string(thread_count) + " threads", hogwild_seconds, 0.0, 0.0, total_samples });
+
+	std::vector<nn::Matrix<float>> weights;
+	for (auto it = std::next(network.get_layers().begin()); it != network.get_layers().end(); ++it)
+	{
+		for (const nn::Parameter& parameter : (*it)->get_parameters())
+		{
+			weights.push_back(*parameter.value);
+		}
+	}
+	float losses[2];
+	for (int hogwild = 0; hogwild < 2; ++hogwild)
+	{
+		size_t index = 0;
+		for (auto it = std::next(network.get_layers().begin()); it != network.get_layers().end(); ++it)
+		{
+			for (const nn::Parameter& parameter : (*it)->get_parameters())
+			{
+				*parameter.value = weights[index++];
+			}
+		}
+		for (int epoch = 0; epoch < 3; ++epoch)
+		{
+			if (hogwild != 0)
+			{
+				static_cast<void>(network.train_hogwild(thread_count));
+			}
+			else
+			{
+				network.train_one_epoch();
+			}
+		}
+		losses[hogwild] = network.get_loss();
+	}
+	std::cout << "  loss after 3 epochs: synchronous " << std::setprecision(4) << losses[0] << ", hogwild " << losses[1] << "\n";
+
+	// Data parallel over Unix sockets, every rank trains half of the samples: the all-reduce of a layer's gradients
+	// runs while the layer before it back propagates, the rest of it is waited for
+	constexpr size_t ranks = 2;
+	std::vector<std::unique_ptr<nn::NeuralNetwork>> rank_networks;
+	for (size_t rank = 0; rank < ranks; ++rank)
+	{
+		rank_networks.push_back(make_example_network(samples / ranks));
+	}
+	const std::vector<std::string> addresses = nn::distributed::get_local_addresses(nn::distributed::Transport::Unix,
+		(std::filesystem::temp_directory_path() / "nn_training_bench").string(), ranks);
+	std::vector<std::unique_ptr<nn::distributed::Communicator>> communicators(ranks);
+	run_ranks(ranks, [&](const size_t rank)
+	{
+		communicators[rank] = std::make_unique<nn::distributed::Communicator>(nn::distributed::Transport::Unix, addresses, rank);
+	});
+	std::vector<nn::distributed::Report> rank_reports(ranks);
+	const double distributed_seconds = measure([&]()
+	{
+		run_ranks(ranks, [&](const size_t rank) { rank_reports[rank] = rank_networks[rank]->train_distributed(*communicators[rank]); });
+	});
+	report.add({ "training/distributed " + std::to_string(ranks) + " ranks unix sockets", distributed_seconds, 0.0, 0.0, total_samples });
+	std::cout << "  all-reduce " << std::fixed << std::setprecision(2) << rank_reports[0].communication_seconds * 1e3
+		<< " ms, hidden " << rank_reports[0].get_overlap_fraction() << ", " << static_cast<double>(rank_reports[0].bytes_sent) / 1e6
+		<< " MB sent per rank\n";
+}
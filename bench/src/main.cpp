@@ -0,0 +1,145 @@
+// File: bench/src/main.cpp
+// Purpose: Entry point of the NeuralNetwork benchmarks.
+
+#include <cstdlib> // std::strtod, std::strtoul
+#include <cstring> // std::strcmp
+#include <fstream> // std::ofstream
+#include <iostream>
+#include <string> // std::string
+
+#include <NeuralNetwork/Kernels.h>
+#include <NeuralNetwork/Profiler.h>
+
+#include "Benchmark.h"
+
+namespace
+{
+	void print_usage()
+	{
+		std::cout << "Usage: NeuralNetworkBench [--filter <suite>] [--json <file>] [--min-time <seconds>] [--samples <count>]\n"
+			<< "                          [--trace <file>]\n"
+			<< "  --filter    run only the suites whose name contains <suite> (kernels, blas, matrix, activation, layer, conv, training,\n"
+			<< "              numa)\n"
+			<< "  --json      write the results to <file> as JSON\n"
+			<< "  --min-time  minimum time per measurement (default 0.2)\n"
+			<< "  --samples   samples of the synthetic training epoch (default 6000)\n"
+			<< "  --trace     write the profiler events to <file> as a Chrome trace, print a summary and a roofline report (NN_ENABLE_PROFILER)\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string filter, json_file, trace_file;
+	size_t samples = 6000;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			json_file = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			bench::set_min_seconds(std::strtod(argv[++i], nullptr));
+		}
+		else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			trace_file = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+		{
+			samples = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			print_usage();
+			return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	if (!trace_file.empty() && !nn::profiler::enabled)
+	{
+		std::cerr << "The profiler is not compiled in (configure with -D NN_ENABLE_PROFILER=ON)\n";
+		return 1;
+	}
+
+	const nn::kernels::KernelTable& kernels = nn::kernels::get_kernels();
+	std::cout << "Selected kernels: " << nn::kernels::get_isa_level_name(kernels.level);
+	if (kernels.blas != nullptr)
+	{
+		std::cout << " (matrix products: " << kernels.blas << ")";
+	}
+	std::cout << "\n\n";
+
+	bench::Report report;
+	const auto selected = [&filter](const char* suite) { return std::string(suite).find(filter) != std::string::npos; };
+
+	if (selected("kernels"))
+	{
+		bench::run_kernel_benchmarks(report);
+		std::cout << "\n";
+	}
+	if (selected("blas"))
+	{
+		bench::run_blas_benchmarks(report);
+		std::cout << "\n";
+	}
+	if (selected("matrix"))
+	{
+		bench::run_matrix_benchmarks(report);
+	}
+	if (selected("activation"))
+	{
+		bench::run_activation_benchmarks(report);
+	}
+	if (selected("layer"))
+	{
+		bench::run_layer_benchmarks(report);
+	}
+	if (selected("conv"))
+	{
+		bench::run_conv_benchmarks(report);
+	}
+	if (selected("training"))
+	{
+		bench::run_training_benchmarks(report, samples);
+	}
+	if (selected("numa"))
+	{
+		bench::run_numa_benchmarks(report);
+	}
+
+	if (!trace_file.empty())
+	{
+		std::ofstream file(trace_file);
+		if (!file)
+		{
+			std::cerr << "Cannot open " << trace_file << "\n";
+			return 1;
+		}
+		nn::profiler::write_chrome_trace(file);
+		std::cout << "\n";
+		nn::profiler::write_summary(std::cout);
+		std::cout << "\n";
+		nn::profiler::write_roofline(std::cout, nn::profiler::measure_machine_peaks());
+		std::cout << "\nTrace written to " << trace_file << "\n";
+	}
+
+	if (!json_file.empty())
+	{
+		std::ofstream file(json_file);
+		if (!file)
+		{
+			std::cerr << "Cannot open " << json_file << "\n";
+			return 1;
+		}
+		report.write_json(file);
+		std::cout << "\nResults written to " << json_file << "\n";
+	}
+
+	return 0;
+}
@@ -7,6 +7,8 @@
 
 #include "TrainSet.h"
 #include "NeuralNetwork/NeuralNetwork.h"
+#include "NeuralNetwork/DenseLayer.h"
+#include "NeuralNetwork/Quantization.h"
 
 inline void setup_network(const std::vector<int>& structure, nn::NeuralNetwork& net, const size_t batch_size)
 {
@@ -14,18 +16,18 @@ inline void setup_network(const std::vector<int>& structure, nn::NeuralNetwork&
 	{
 		if (i == 0)
 		{
-			auto layer = std::make_unique<nn::Layer>(structure[i], batch_size);
+			auto layer = std::make_unique<nn::DenseLayer>(structure[i], batch_size);
 			net.add_layer(std::move(layer));
 		}
 		else if (i == structure.size() - 1)
 		{
-			auto layer = std::make_unique<nn::Layer>(structure[i], batch_size, structure[i - 1]);
+			auto layer = std::make_unique<nn::DenseLayer>(structure[i], batch_size, structure[i - 1]);
 			layer->set_activation_function(std::make_unique<nn::activation_functions::Sigmoid>());
 			net.add_layer(std::move(layer));
 		}
 		else
 		{
-			auto layer = std::make_unique<nn::Layer>(structure[i], batch_size, structure[i - 1]);
+			auto layer = std::make_unique<nn::DenseLayer>(structure[i], batch_size, structure[i - 1]);
 			layer->set_activation_function(std::make_unique<nn::activation_functions::Sigmoid>());
 			net.add_layer(std::move(layer));
 		}
@@ -135,6 +137,49 @@ inline void train_and_test(const int batch_size, const int num_epochs, const flo
 	}
 }
 
+inline void quantization_report(const int batch_size, const int num_epochs, const float learning_rate,
+                                const std::vector<int>& structure)
+{
+	nn::NeuralNetwork nn(learning_rate, batch_size);
+
+	// Train the float network
+	auto train_set = std::make_unique<TrainSet>("dataset/train-images.idx3-ubyte", "dataset/train-labels.idx1-ubyte");
+	train_set->initialize(batch_size);
+	nn.set_data_set(std::move(train_set));
+	setup_network(structure, nn, batch_size);
+	if (!nn.is_ready())
+	{
+		std::cout << "Neural network is not ready.\n";
+		return;
+	}
+	nn.train(num_epochs);
+
+	// Calibrate the activation ranges on (part of) the training set and quantize
+	nn::quantization::Calibration calibration;
+	calibration.calibrate(nn, *nn.get_data_set(), 100);
+	nn::quantization::QuantizedNetwork quantized_nn;
+	quantized_nn.quantize(nn, calibration);
+
+	// Compare on the test set
+	auto test_set = std::make_unique<TrainSet>("dataset/t10k-images.idx3-ubyte", "dataset/t10k-labels.idx1-ubyte");
+	test_set->initialize(batch_size);
+	nn.set_data_set(std::move(test_set));
+
+	const auto float_start = std::chrono::high_resolution_clock::now();
+	const float float_accuracy = nn.calculate_accuracy();
+	const std::chrono::duration<double> float_time = std::chrono::high_resolution_clock::now() - float_start;
+
+	const auto int8_start = std::chrono::high_resolution_clock::now();
+	const float int8_accuracy = quantized_nn.calculate_accuracy(*nn.get_data_set());
+	const std::chrono::duration<double> int8_time = std::chrono::high_resolution_clock::now() - int8_start;
+
+	const auto samples = static_cast<double>(nn.get_data_set()->get_total_size());
+	std::cout << "Float accuracy: " << float_accuracy << " (" << samples / float_time.count() << " samples/s)\n";
+	std::cout << "Int8 accuracy: " << int8_accuracy << " (" << samples / int8_time.count() << " samples/s)\n";
+	std::cout << "Accuracy delta: " << int8_accuracy - float_accuracy << '\n';
+	std::cout << "Throughput gain: " << float_time.count() / int8_time.count() << "x\n";
+}
+
 inline int get_completed()
 {
 	std::ifstream file("completed.txt");
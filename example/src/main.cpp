@@ -2,12 +2,20 @@
 // Purpose: Example file for NeuralNetwork Library.
 
 #include <chrono>
+#include <string>
 
 #include "TrainSet.h"
 #include "Utils.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Compare the int8 quantized network against the float network
+	if (argc > 1 && std::string(argv[1]) == "--quantize")
+	{
+		quantization_report(32, 10, 0.1f, { 784, 64, 64, 10 });
+		return 0;
+	}
+
 	trainer();
 
 	return 0;
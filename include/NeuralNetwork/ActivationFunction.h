@@ -3,10 +3,26 @@
 
 #pragma once
 
+#include <memory> // std::unique_ptr
+
 #include "NeuralNetwork/Matrix.h" // nn::Matrix
 
 namespace nn::activation_functions
 {
+	/// <summary>
+	/// Identifies the built-in activation functions (for code that evaluates them without virtual dispatch)
+	/// </summary>
+	enum class ActivationType
+	{
+		Sigmoid,
+		ReLU,
+		LeakyReLU,
+		Tanh,
+		SoftMax,
+		Linear,
+		Custom
+	};
+
 	/// <summary>
 	/// Interface for activation functions
 	/// </summary>
@@ -29,6 +45,18 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		virtual void derivative(Matrix<float> &mat) = 0;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * f'(sums) for back propagation.
+		///	The default copies the sums, applies derivative and multiplies by the deltas, the built-in functions do it in
+		///	one pass and take the derivative from the activations where that avoids evaluating the function again.
+		/// </summary>
+		/// <param name="sums">Inputs of the activation function</param>
+		/// <param name="activations">Outputs of the activation function for the sums</param>
+		/// <param name="delta_activations">Deltas of the activations</param>
+		/// <param name="delta_sums">Deltas of the sums (same size as the sums)</param>
+		virtual void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		                      const Matrix<float>& delta_activations, Matrix<float>& delta_sums);
 	};
 
 
@@ -56,6 +84,12 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		void derivative(Matrix<float> &mat) override;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * a * (1 - a) from the activations a in one pass
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
 	};
 
 
@@ -73,6 +107,12 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		void derivative(Matrix<float> &mat) override;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * (a > 0 ? 1 : 0) from the activations a in one pass
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
 	};
 
 
@@ -90,6 +130,12 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		void derivative(Matrix<float> &mat) override;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * (a > 0 ? 1 : 0.01) from the activations a in one pass
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
 	};
 
 
@@ -107,6 +153,12 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		void derivative(Matrix<float> &mat) override;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * (1 - a^2) from the activations a in one pass
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
 	};
 
 	class SoftMax final : public ActivationFunction
@@ -123,5 +175,48 @@ namespace nn::activation_functions
 		/// </summary>
 		/// <param name="mat">Input matrix</param>
 		void derivative(Matrix<float>& mat) override;
+
+		/// <summary>
+		/// Computes delta_sums = delta_activations * derivative(sums) in one pass over each column, without a copy
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
+	};
+
+	/// <summary>
+	/// Identity activation function (for a layer followed by a BatchNorm)
+	/// </summary>
+	class Linear final : public ActivationFunction
+	{
+	public:
+		/// <summary>
+		/// Leaves the input matrix unchanged
+		/// </summary>
+		/// <param name="mat">Input matrix</param>
+		void activate(Matrix<float>& mat) override;
+
+		/// <summary>
+		/// Sets every element of the input matrix to 1
+		/// </summary>
+		/// <param name="mat">Input matrix</param>
+		void derivative(Matrix<float>& mat) override;
+
+		/// <summary>
+		/// Copies the deltas of the activations to the deltas of the sums (the derivative is 1)
+		/// </summary>
+		void backward(const Matrix<float>& sums, const Matrix<float>& activations,
+		              const Matrix<float>& delta_activations, Matrix<float>& delta_sums) override;
 	};
+
+	/// <summary>
+	/// Returns the type of the given activation function (Custom if it is not one of the built-in functions)
+	/// </summary>
+	/// <param name="activation_function">Activation function to identify</param>
+	[[nodiscard]] ActivationType get_activation_type(const ActivationFunction& activation_function);
+
+	/// <summary>
+	/// Creates a built-in activation function of the given type (throws for Custom)
+	/// </summary>
+	/// <param name="type">Type of the activation function</param>
+	[[nodiscard]] std::unique_ptr<ActivationFunction> create_activation_function(ActivationType type);
 }
@@ -5,6 +5,13 @@
 
 #include <stdexcept> // std::logic_error
 #include <iostream> // std::ostream
+#include <cstring> // memcpy
+#include <memory> // std::align
+#include <new> // operator new
+#include <utility> // std::move
+
+#include "NeuralNetwork/AllocationTracker.h" // nn::memory::record_allocation, nn::memory::record_deallocation
+#include "NeuralNetwork/Numa.h" // nn::numa::move_to_node
 
 namespace nn::utils
 {
@@ -57,9 +64,9 @@ namespace nn::utils
 		AlignedMemoryAllocator(const AlignedMemoryAllocator<T, Alignment>&) = delete;
 
 		/// <summary>
-		/// Delete the move constructor.
+		/// Takes the memory of other, which is left uninitialized.
 		/// </summary>
-		AlignedMemoryAllocator(AlignedMemoryAllocator<T, Alignment>&&) = delete;
+		AlignedMemoryAllocator(AlignedMemoryAllocator<T, Alignment>&& other) noexcept;
 
 		/// <summary>
 		/// Delete the copy assignment operator.
@@ -67,9 +74,9 @@ namespace nn::utils
 		AlignedMemoryAllocator& operator=(const AlignedMemoryAllocator<T, Alignment>&) = delete;
 
 		/// <summary>
-		/// Delete the move assignment operator.
+		/// Frees the memory and takes the memory of other, which is left uninitialized.
 		/// </summary>
-		AlignedMemoryAllocator& operator=(AlignedMemoryAllocator<T, Alignment>&&) = delete;
+		AlignedMemoryAllocator& operator=(AlignedMemoryAllocator<T, Alignment>&& other) noexcept;
 
 		/// <summary>
 		/// Frees the memory.
@@ -100,6 +107,13 @@ namespace nn::utils
 		static void copy_data_between_alignments(const AlignedMemoryAllocator<T, Alignment>& source,
 			AlignedMemoryAllocator<T, Alignment2>& destination);
 
+		/// <summary>
+		/// Moves the memory to a NUMA node. init does not write the memory, so without this every page lands on the
+		///	node of the thread that writes it first (first touch): initialize data on the thread that uses it.
+		/// </summary>
+		/// <returns>False where memory placement is not supported</returns>
+		bool place_on_node(size_t node);
+
 		/// <summary>
 		/// Returns if the memory is initialized.
 		/// </summary>
@@ -138,6 +152,36 @@ nn::utils::AlignedMemoryAllocator<T, Alignment>::AlignedMemoryAllocator(const si
 	this->init(size);
 }
 
+template <typename T, size_t Alignment>
+nn::utils::AlignedMemoryAllocator<T, Alignment>::AlignedMemoryAllocator(AlignedMemoryAllocator<T, Alignment>&& other) noexcept
+	: initialized_(other.initialized_), data_(other.data_), aligned_data_(other.aligned_data_), size_(other.size_)
+{
+	other.initialized_ = false;
+	other.data_ = nullptr;
+	other.aligned_data_ = nullptr;
+	other.size_ = 0;
+}
+
+template <typename T, size_t Alignment>
+nn::utils::AlignedMemoryAllocator<T, Alignment>& nn::utils::AlignedMemoryAllocator<T, Alignment>::operator=(
+	AlignedMemoryAllocator<T, Alignment>&& other) noexcept
+{
+	if (this != &other)
+	{
+		this->delete_data();
+		this->initialized_ = other.initialized_;
+		this->data_ = other.data_;
+		this->aligned_data_ = other.aligned_data_;
+		this->size_ = other.size_;
+		other.initialized_ = false;
+		other.data_ = nullptr;
+		other.aligned_data_ = nullptr;
+		other.size_ = 0;
+	}
+
+	return *this;
+}
+
 template <typename T, size_t Alignment>
 nn::utils::AlignedMemoryAllocator<T, Alignment>::~AlignedMemoryAllocator<T, Alignment>()
 {
@@ -153,6 +197,9 @@ void nn::utils::AlignedMemoryAllocator<T, Alignment>::init(const size_t size)
 		throw std::logic_error("Memory already initialized.");
 	}
 
+	// Throws inside a nn::memory::NoAllocationGuard
+	memory::record_allocation(size * sizeof(T));
+
 	this->initialized_ = true;
 	this->size_ = size;
 
@@ -160,28 +207,30 @@ void nn::utils::AlignedMemoryAllocator<T, Alignment>::init(const size_t size)
 	this->data_ = static_cast<T*>(_aligned_malloc(size * sizeof(T), Alignment));
 	this->aligned_data_ = this->data_;
 #else
-	this->data_ = new T[size];
-	this->aligned_data_ = this->data_;
+	// Over-allocate by Alignment bytes and move the start up to the next aligned address.
+	size_t space = size * sizeof(T) + Alignment;
+	void* memory = ::operator new(space);
+	this->data_ = static_cast<T*>(memory);
+	this->aligned_data_ = static_cast<T*>(std::align(Alignment, size * sizeof(T), memory, space));
 #endif
 }
 
 template <typename T, size_t Alignment>
 void nn::utils::AlignedMemoryAllocator<T, Alignment>::delete_data()
 {
-	this->initialized_ = false;
-	this->size_ = 0;
-
-
-
 	if (this->data_)
 	{
 #ifdef _WIN32
 		_aligned_free(this->data_);
 #else
-		delete[] this->data_;
+		::operator delete(this->data_);
 #endif
+		memory::record_deallocation(this->size_ * sizeof(T));
 	}
 
+	this->initialized_ = false;
+	this->size_ = 0;
+
 	this->data_ = nullptr;
 	this->aligned_data_ = nullptr;
 }
@@ -213,6 +262,12 @@ void nn::utils::AlignedMemoryAllocator<T, Alignment>::copy_data_between_alignmen
 		source.size_ * sizeof(T));
 }
 
+template <typename T, size_t Alignment>
+bool nn::utils::AlignedMemoryAllocator<T, Alignment>::place_on_node(const size_t node)
+{
+	return this->initialized_ && numa::move_to_node(this->aligned_data_, this->size_ * sizeof(T), node);
+}
+
 template <typename T, size_t Alignment>
 bool nn::utils::AlignedMemoryAllocator<T, Alignment>::is_initialized() const
 {
@@ -0,0 +1,126 @@
+// File: include/NeuralNetwork/AllocationTracker.h
+// Purpose: Header file for the allocation statistics of AlignedMemoryAllocator.
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <ostream> // std::ostream
+#include <vector> // std::vector
+
+namespace nn::memory
+{
+	/// <summary>
+	/// Totals of every AlignedMemoryAllocator of the process.
+	/// </summary>
+	struct AllocationStats
+	{
+		/// <summary>
+		/// Bytes currently allocated.
+		/// </summary>
+		size_t live_bytes;
+
+		/// <summary>
+		/// Highest live_bytes since the last reset.
+		/// </summary>
+		size_t peak_bytes;
+
+		/// <summary>
+		/// Number of allocations since the last reset.
+		/// </summary>
+		size_t allocations;
+
+		/// <summary>
+		/// Number of frees since the last reset.
+		/// </summary>
+		size_t deallocations;
+	};
+
+	/// <summary>
+	/// Allocations made under one tag (see ScopedTag).
+	/// </summary>
+	struct TagStats
+	{
+		/// <summary>
+		/// The tag (a string literal, not owned).
+		/// </summary>
+		const char* tag;
+
+		/// <summary>
+		/// Number of allocations since the last reset.
+		/// </summary>
+		size_t allocations;
+
+		/// <summary>
+		/// Bytes allocated since the last reset.
+		/// </summary>
+		size_t bytes;
+	};
+
+	/// <summary>
+	/// Tag of the allocations made outside of any ScopedTag.
+	/// </summary>
+	constexpr const char* untagged = "untagged";
+
+	/// <summary>
+	/// Attributes the allocations of this thread to tag (a string literal naming the call site) for the rest of the
+	/// enclosing scope. The innermost tag wins.
+	/// </summary>
+	class ScopedTag
+	{
+	private:
+		const char* previous_tag_;
+
+	public:
+		explicit ScopedTag(const char* tag);
+
+		ScopedTag(const ScopedTag&) = delete;
+		ScopedTag& operator=(const ScopedTag&) = delete;
+
+		~ScopedTag();
+	};
+
+	/// <summary>
+	/// Makes every allocation of this thread throw std::logic_error while it exists, e.g. around a training step
+	/// after the warm up step that allocated the buffers.
+	/// </summary>
+	class NoAllocationGuard
+	{
+	public:
+		NoAllocationGuard();
+
+		NoAllocationGuard(const NoAllocationGuard&) = delete;
+		NoAllocationGuard& operator=(const NoAllocationGuard&) = delete;
+
+		~NoAllocationGuard();
+	};
+
+	/// <summary>
+	/// Called by AlignedMemoryAllocator before it allocates bytes. Throws std::logic_error inside a NoAllocationGuard.
+	/// </summary>
+	void record_allocation(size_t bytes);
+
+	/// <summary>
+	/// Called by AlignedMemoryAllocator after it freed bytes.
+	/// </summary>
+	void record_deallocation(size_t bytes);
+
+	/// <summary>
+	/// Returns the totals.
+	/// </summary>
+	[[nodiscard]] AllocationStats get_stats();
+
+	/// <summary>
+	/// Returns the allocations per tag, in the order the tags first allocated.
+	/// </summary>
+	[[nodiscard]] std::vector<TagStats> get_tag_stats();
+
+	/// <summary>
+	/// Resets the counters and the tags, and the peak to the live bytes (which keep counting).
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Writes the totals and the allocations per tag.
+	/// </summary>
+	void write_report(std::ostream& os);
+}
@@ -0,0 +1,168 @@
+// File: include/NeuralNetwork/BatchNorm.h
+// Purpose: Header file for BatchNorm class, a batch normalization layer.
+
+#pragma once
+
+#include <memory> // std::unique_ptr
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationFunction
+
+namespace nn
+{
+	class DenseLayer;
+
+	/// <summary>
+	/// Batch normalization layer: normalizes every neuron of the previous layer over the batch (one sample per column),
+	///	then scales and shifts it (gamma * normalized + beta) before its own activation function. Training uses the
+	///	mean and variance of the batch and updates running statistics, inference uses the running statistics. After
+	///	a DenseLayer with a linear activation the whole layer is an affine map of the sums of that layer, so fold_into
+	///	moves it into the weights and biases for deployment.
+	/// </summary>
+	class BatchNorm : public Layer
+	{
+	private:
+		/// <summary>
+		/// Weight of the last batch in the running statistics
+		/// </summary>
+		float momentum_;
+
+		/// <summary>
+		/// Added to the variance before the square root
+		/// </summary>
+		float epsilon_;
+
+		/// <summary>
+		/// Batch statistics (training) or running statistics (inference)?
+		/// </summary>
+		bool training_ = true;
+
+		/// <summary>
+		/// Scale and shift of every neuron: neuron count x 1
+		/// </summary>
+		std::unique_ptr<Matrix<float>> gamma_;
+		std::unique_ptr<Matrix<float>> beta_;
+		std::unique_ptr<Matrix<float>> delta_gamma_;
+		std::unique_ptr<Matrix<float>> delta_beta_;
+
+		/// <summary>
+		/// Means over the last batch of delta sums and of delta sums * normalized: neuron count x 1 (the gradients of
+		///	beta and gamma of this batch, kept apart from the accumulated gradients for the delta of the previous layer)
+		/// </summary>
+		std::unique_ptr<Matrix<float>> delta_mean_;
+		std::unique_ptr<Matrix<float>> delta_projection_;
+
+		/// <summary>
+		/// Exponential moving averages of the batch means and (unbiased) variances: neuron count x 1
+		/// </summary>
+		std::unique_ptr<Matrix<float>> running_mean_;
+		std::unique_ptr<Matrix<float>> running_variance_;
+
+		/// <summary>
+		/// Mean and 1 / sqrt(variance + epsilon) used by the last feed_forward: neuron count x 1
+		/// </summary>
+		std::unique_ptr<Matrix<float>> mean_;
+		std::unique_ptr<Matrix<float>> inverse_std_;
+
+		/// <summary>
+		/// (input - mean) * inverse_std of the last feed_forward: neuron count x batch size
+		/// </summary>
+		std::unique_ptr<Matrix<float>> normalized_;
+
+		/// <summary>
+		/// gamma * normalized + beta before the activation function, and its delta
+		/// </summary>
+		std::unique_ptr<Matrix<float>> sums_;
+		std::unique_ptr<Matrix<float>> delta_sums_;
+
+		/// <summary>
+		/// Activation function of this layer
+		/// </summary>
+		std::unique_ptr<activation_functions::ActivationFunction> activation_function_;
+
+	public:
+		/// <summary>
+		/// Initializes the layer with gamma = 1, beta = 0, running mean 0 and running variance 1.
+		/// </summary>
+		/// <param name="neuron_count">Neuron count of this layer and of the previous layer</param>
+		/// <param name="batch_size">Batch size of the layer</param>
+		/// <param name="activation_function">Activation function (nullptr for Linear)</param>
+		/// <param name="momentum">Weight of every batch in the running statistics</param>
+		/// <param name="epsilon">Added to the variance before the square root</param>
+		BatchNorm(size_t neuron_count, size_t batch_size,
+			std::unique_ptr<activation_functions::ActivationFunction> activation_function = nullptr,
+			float momentum = 0.1f, float epsilon = 1e-5f);
+
+		[[nodiscard]] float get_momentum() const;
+		[[nodiscard]] float get_epsilon() const;
+		[[nodiscard]] bool is_training() const;
+		[[nodiscard]] const Matrix<float>& get_gamma() const;
+		[[nodiscard]] const Matrix<float>& get_beta() const;
+		[[nodiscard]] const Matrix<float>& get_delta_gamma() const;
+		[[nodiscard]] const Matrix<float>& get_delta_beta() const;
+		[[nodiscard]] const Matrix<float>& get_running_mean() const;
+		[[nodiscard]] const Matrix<float>& get_running_variance() const;
+		[[nodiscard]] const Matrix<float>& get_normalized() const;
+		[[nodiscard]] const activation_functions::ActivationFunction* get_activation_function() const;
+
+		void set_gamma(const Matrix<float>& gamma);
+		void set_beta(const Matrix<float>& beta);
+		void set_running_statistics(const Matrix<float>& mean, const Matrix<float>& variance);
+
+		/// <summary>
+		/// Uses the batch statistics (true) or the running statistics (false).
+		/// </summary>
+		void set_training(const bool training) override;
+
+		/// <summary>
+		/// activations = activation(gamma * (previous activations - mean) / sqrt(variance + epsilon) + beta)
+		/// </summary>
+		void feed_forward(const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Takes the delta activations from the next layer and calculates the gradients of gamma and beta.
+		/// </summary>
+		void back_propagate(const Layer& next_layer, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta activations from the expected activations and the gradients of gamma and beta.
+		/// </summary>
+		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta of the previous activations through the normalization (the batch mean and variance
+		///	depend on every sample while training).
+		/// </summary>
+		void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const override;
+
+		/// <summary>
+		/// Returns gamma and beta with their gradients.
+		/// </summary>
+		[[nodiscard]] std::vector<Parameter> get_parameters() override;
+
+		/// <summary>
+		/// Returns the memory of the matrices of this layer (the running statistics count as parameters).
+		/// </summary>
+		[[nodiscard]] MemoryRequirements get_memory_requirements() const override;
+
+		/// <summary>
+		/// False: feed_forward updates the running statistics while training.
+		/// </summary>
+		[[nodiscard]] bool is_recomputable() const override;
+
+		/// <summary>
+		/// Folds the inference transform of this layer into the previous layer: every row of the weights and its bias
+		///	are scaled by gamma / sqrt(running variance + epsilon), the bias becomes scale * (bias - running mean) + beta,
+		///	and the previous layer takes the activation function of this layer. The previous layer must have a linear
+		///	activation; this layer is empty afterwards and must be removed from the network.
+		/// </summary>
+		/// <param name="previous_layer">Dense layer whose sums this layer normalizes</param>
+		void fold_into(DenseLayer& previous_layer);
+
+	private:
+		/// <summary>
+		/// delta_sums = derivative(sums) * delta_activations, then the gradients of gamma and beta
+		/// </summary>
+		void calculate_gradients();
+	};
+}
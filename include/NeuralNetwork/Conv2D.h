@@ -0,0 +1,204 @@
+// File: include/NeuralNetwork/Conv2D.h
+// Purpose: Header file for Conv2D class, a 2d convolutional layer.
+
+#pragma once
+
+#include <memory> // std::unique_ptr
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationFunction
+
+namespace nn
+{
+	/// <summary>
+	/// How Conv2D computes the convolution.
+	/// </summary>
+	enum class ConvolutionAlgorithm
+	{
+		/// <summary>
+		/// Direct for 3x3 kernels with stride 1, im2col otherwise.
+		/// </summary>
+		Auto,
+
+		/// <summary>
+		/// Unfolds the receptive fields into a matrix (im2col) and convolves with one matrix product.
+		/// </summary>
+		Im2col,
+
+		/// <summary>
+		/// Accumulates every kernel weight times a shifted span of the input (stride 1 only), no extra memory.
+		/// </summary>
+		Direct
+	};
+
+	/// <summary>
+	/// 2d convolutional layer. Takes the place of a Layer in the chain of a NeuralNetwork: the activations of the
+	///	previous layer are input_channels x input_height x input_width images, one per column of the batch (channel,
+	///	then row, then column), and its activations are output_channels x output_height x output_width images.
+	///	Every output channel has one kernel_size x kernel_size kernel per input channel and one bias. Computes in float.
+	/// </summary>
+	class Conv2D : public Layer
+	{
+	private:
+		size_t input_channels_;
+		size_t input_height_;
+		size_t input_width_;
+		size_t output_channels_;
+		size_t output_height_;
+		size_t output_width_;
+		size_t kernel_size_;
+		size_t stride_;
+		size_t padding_;
+
+		/// <summary>
+		/// Kernels: output channels x (input channels * kernel_size^2), ordered by input channel, row, column
+		/// </summary>
+		std::unique_ptr<Matrix<float>> weights_;
+
+		/// <summary>
+		/// One bias per output channel: output channels x 1
+		/// </summary>
+		std::unique_ptr<Matrix<float>> biases_;
+
+		/// <summary>
+		/// Convolution plus bias prior to the activation function
+		/// </summary>
+		std::unique_ptr<Matrix<float>> sums_;
+
+		std::unique_ptr<Matrix<float>> delta_sums_;
+		std::unique_ptr<Matrix<float>> delta_weights_;
+		std::unique_ptr<Matrix<float>> delta_biases_;
+
+		/// <summary>
+		/// Activation function of this layer (owned)
+		/// </summary>
+		std::unique_ptr<activation_functions::ActivationFunction> activation_function_;
+
+		/// <summary>
+		/// Selected algorithm (Auto is resolved in the constructor).
+		/// </summary>
+		ConvolutionAlgorithm algorithm_;
+
+		/// <summary>
+		/// Receptive fields of the input (im2col): input_channels * kernel_size^2 x output positions * batch size
+		/// </summary>
+		std::unique_ptr<Matrix<float>> columns_;
+
+		/// <summary>
+		/// Delta of the receptive fields, folded back into the delta activations of the previous layer (col2im)
+		/// </summary>
+		mutable std::unique_ptr<Matrix<float>> delta_columns_;
+
+	public:
+		/// <summary>
+		/// Initializes the layer and randomizes the kernels and biases.
+		/// </summary>
+		/// <param name="input_channels">Channels of the input images</param>
+		/// <param name="input_height">Height of the input images</param>
+		/// <param name="input_width">Width of the input images</param>
+		/// <param name="output_channels">Number of kernels (channels of the output images)</param>
+		/// <param name="kernel_size">Width and height of the kernels</param>
+		/// <param name="batch_size">Batch size of the layer</param>
+		/// <param name="stride">Distance between two receptive fields</param>
+		/// <param name="padding">Zeros added around the input images</param>
+		/// <param name="activation_function">Activation function (sigmoid if null)</param>
+		/// <param name="algorithm">How the convolution is computed</param>
+		Conv2D(size_t input_channels, size_t input_height, size_t input_width, size_t output_channels, size_t kernel_size,
+			size_t batch_size, size_t stride = 1, size_t padding = 0,
+			std::unique_ptr<activation_functions::ActivationFunction> activation_function = nullptr,
+			ConvolutionAlgorithm algorithm = ConvolutionAlgorithm::Auto);
+
+		[[nodiscard]] size_t get_input_channels() const;
+		[[nodiscard]] size_t get_input_height() const;
+		[[nodiscard]] size_t get_input_width() const;
+		[[nodiscard]] size_t get_output_channels() const;
+		[[nodiscard]] size_t get_output_height() const;
+		[[nodiscard]] size_t get_output_width() const;
+		[[nodiscard]] size_t get_kernel_size() const;
+		[[nodiscard]] size_t get_stride() const;
+		[[nodiscard]] size_t get_padding() const;
+		[[nodiscard]] const Matrix<float>& get_weights() const;
+		[[nodiscard]] const Matrix<float>& get_biases() const;
+		[[nodiscard]] const Matrix<float>& get_sums() const;
+		[[nodiscard]] const Matrix<float>& get_delta_sums() const;
+		[[nodiscard]] const Matrix<float>& get_delta_weights() const;
+		[[nodiscard]] const Matrix<float>& get_delta_biases() const;
+		[[nodiscard]] const activation_functions::ActivationFunction* get_activation_function() const;
+
+		/// <summary>
+		/// Sets the kernels (copies, same size).
+		/// </summary>
+		void set_weights(const Matrix<float>& weights);
+
+		/// <summary>
+		/// Sets the biases (copies, same size).
+		/// </summary>
+		void set_biases(const Matrix<float>& biases);
+
+		/// <summary>
+		/// Returns the algorithm in use (never Auto).
+		/// </summary>
+		[[nodiscard]] ConvolutionAlgorithm get_algorithm() const;
+
+		/// <summary>
+		/// Selects the algorithm (Direct requires stride 1).
+		/// </summary>
+		void set_algorithm(ConvolutionAlgorithm algorithm);
+
+		/// <summary>
+		/// sums = convolution of the previous activations with the kernels + biases, activations = f(sums)
+		/// </summary>
+		void feed_forward(const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Runs back propagation with the delta propagated from the next layer.
+		/// </summary>
+		void back_propagate(const Layer& next_layer, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Runs back propagation with the given expected activations.
+		/// </summary>
+		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta activations of the previous layer (the transposed convolution of the delta sums).
+		/// </summary>
+		void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const override;
+
+		/// <summary>
+		/// Returns the kernels and biases with their gradients.
+		/// </summary>
+		[[nodiscard]] std::vector<Parameter> get_parameters() override;
+
+		/// <summary>
+		/// Returns the memory of the matrices of this layer (the receptive fields count as activations).
+		/// </summary>
+		[[nodiscard]] MemoryRequirements get_memory_requirements() const override;
+
+		/// <summary>
+		/// Frees the activations, the sums and the receptive fields.
+		/// </summary>
+		void release_activations() override;
+
+	private:
+		/// <summary>
+		/// Calculates the delta sums from the delta activations (delta_sums = derivative(sums) * delta_activations).
+		/// </summary>
+		void calculate_delta_sums();
+
+		/// <summary>
+		/// Calculates the delta weights and biases from the delta sums.
+		/// </summary>
+		void calculate_gradients(const Layer& previous_layer);
+
+		/// <summary>
+		/// Unfolds the receptive fields of input into columns_.
+		/// </summary>
+		void im2col(const Matrix<float>& input);
+
+		/// <summary>
+		/// Allocates matrix as rows x cols unless it already has that size.
+		/// </summary>
+		static void ensure_size(std::unique_ptr<Matrix<float>>& matrix, size_t rows, size_t cols);
+	};
+}
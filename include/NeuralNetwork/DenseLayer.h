@@ -0,0 +1,304 @@
+// File: include/NeuralNetwork/DenseLayer.h
+// Purpose: Header file for DenseLayer class, a fully connected layer.
+
+#pragma once
+
+#include <memory> // std::unique_ptr, std::shared_ptr
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationFunction
+#include "NeuralNetwork/HalfPrecision.h" // nn::Precision, nn::bfloat16, nn::float16
+
+namespace nn
+{
+	/// <summary>
+	/// Fully connected layer: every neuron is connected to every neuron of the previous layer. Constructed without
+	///	a previous layer it is an input layer (activations only).
+	/// </summary>
+	class DenseLayer : public Layer
+	{
+	private:
+		/// <summary>
+		/// Activation matrix produced by the sum of the weights and biases prior to the activation function
+		/// </summary>
+		std::unique_ptr<nn::Matrix<float>> sums_;
+
+		/// <summary>
+		/// Weights matrix of this layer (shared with the layers of share_parameters)
+		/// </summary>
+		std::shared_ptr<nn::Matrix<float>> weights_;
+
+		/// <summary>
+		/// Biases matrix of this layer (shared with the layers of share_parameters)
+		/// </summary>
+		std::shared_ptr<nn::Matrix<float>> biases_;
+
+		/// <summary>
+		/// Delta of the biases matrix of this layer
+		/// </summary>
+		std::unique_ptr<nn::Matrix<float>> delta_sums_;
+
+		/// <summary>
+		/// Delta of the weights matrix of this layer
+		/// </summary>
+		std::unique_ptr<nn::Matrix<float>> delta_weights_;
+
+		/// <summary>
+		/// Delta of the biases matrix of this layer
+		/// </summary>
+		std::unique_ptr<nn::Matrix<float>> delta_biases_;
+
+		/// <summary>
+		/// Weights matrix rounded to bfloat16, used by forward propagation when the weight precision is BFloat16
+		/// </summary>
+		std::unique_ptr<nn::Matrix<nn::bfloat16>> weights_bf16_;
+
+		/// <summary>
+		/// Weights matrix rounded to half precision, used by forward propagation when the weight precision is Float16
+		/// </summary>
+		std::unique_ptr<nn::Matrix<nn::float16>> weights_fp16_;
+
+		/// <summary>
+		/// Precision of the weights used by forward propagation (weights_ stays the float master copy)
+		/// </summary>
+		nn::Precision weight_precision_ = nn::Precision::Float32;
+
+		/// <summary>
+		/// Activation function of this layer (default is sigmoid) (owned)
+		/// </summary>
+		std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function_;
+
+	public:
+		/// <summary>
+		/// Default constructor
+		/// </summary>
+		DenseLayer();
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count and batch size
+		/// </summary>
+		/// <param name="neuron_count">Number of neurons in the layer</param>
+		/// <param name="batch_size">The batch size for the layer</param>
+		DenseLayer(const size_t neuron_count, const size_t batch_size);
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count, batch size and activation function
+		/// </summary>
+		/// <param name="neuron_count">Neuron count of this layer</param>
+		/// <param name="batch_size">Batch size of this layer</param>
+		/// <param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
+		DenseLayer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count);
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count, batch size and activation function
+		/// </summary>
+		/// <param name="neuron_count">Neuron count of this layer</param>
+		/// <param name="batch_size">Batch size of this layer</param>
+		/// <param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
+		/// <param name="activation_function">Activation function for this layer</param>
+		DenseLayer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count, std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
+
+		/// <summary>
+		/// Destructor
+		/// </summary>
+		~DenseLayer() override;
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count and batch size
+		/// </summary>
+		/// <param name="neuron_count">Number of neurons in the layer</param>
+		/// <param name="batch_size">The batch size for the layer</param>
+		void initialize(const size_t neuron_count, const size_t batch_size);
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count and batch size
+		/// </summary>
+		/// <param name="neuron_count">Number of neurons in the layer</param>
+		/// <param name="batch_size">The batch size for the layer</param>
+		/// <param name="previous_layer_neuron_count">Neuron count of previous layer</param>
+		void initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count);
+
+		/// <summary>
+		/// Initializes the layer with the given neuron count, batch size and activation function
+		/// </summary>
+		/// <param name="neuron_count">Number of neurons in the layer</param>
+		/// <param name="batch_size">The batch size for the layer</param>
+		///	<param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
+		/// <param name="activation_function">Activation function for this layer</param>
+		void initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count, std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
+
+		/// <summary>
+		/// Sets the activation function for this layer
+		/// </summary>
+		/// <param name="activation_function">Activation function for this layer</param>
+		void set_activation_function(std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
+
+		/// <summary>
+		/// Sets the weights matrix of this layer (does not copy, takes ownership)
+		/// </summary>
+		/// <param name="weights">Weights matrix to set in this layer</param>
+		void set_weights(std::unique_ptr<nn::Matrix<float>> weights);
+
+		/// <summary>
+		/// Sets the weights matrix of this layer (copies)
+		/// </summary>
+		/// <param name="weights">Weights matrix to set in this layer</param>
+		void set_weights(const Matrix<float>& weights);
+
+		/// <summary>
+		/// Sets the biases matrix of this layer (does not copy, takes ownership)
+		/// </summary>
+		/// <param name="biases">Biases matrix to set in this layer</param>
+		void set_biases(std::unique_ptr<nn::Matrix<float>> biases);
+
+		/// <summary>
+		/// Sets the biases matrix of this layer (copies)
+		/// </summary>
+		/// <param name="biases">Biases matrix to set in this layer</param>
+		void set_biases(const Matrix<float>& biases);
+
+		/// <summary>
+		/// Makes this layer use the weights and biases of source (no copy): an update through either layer changes
+		///	both. The gradients, activations and precision stay per layer, so replicas can train on their own batches
+		///	against one set of weights (Hogwild). Setting a std::unique_ptr of weights or biases gives the layer its own again.
+		/// </summary>
+		/// <param name="source">Layer of the same shape to take the weights and biases of</param>
+		void share_parameters(const DenseLayer& source);
+
+		/// <summary>
+		/// Returns a layer of the same shape and activation function that shares the weights and biases of this one
+		///	(see share_parameters) and has its own activations and gradients. Nothing is randomized, so replicas are
+		///	cheap to create. The activation function must be a built-in one.
+		/// </summary>
+		[[nodiscard]] std::unique_ptr<DenseLayer> create_replica() const;
+
+		/// <summary>
+		/// Sets the precision of the weights used by forward propagation.
+		///	The float weights are kept as the master copy: back propagation and weight updates run in float and the
+		///	reduced copy is refreshed after every update (mixed precision training).
+		/// </summary>
+		/// <param name="precision">Precision of the weights</param>
+		void set_weight_precision(const nn::Precision precision) override;
+
+		/// <summary>
+		/// Resets the batch size of this layer and re-initializes the affected matrices
+		/// </summary>
+		/// <param name="batch_size"></param>
+		void change_batch_size(const size_t batch_size);
+
+		/// <summary>
+		/// Returns the precision of the weights used by forward propagation
+		/// </summary>
+		[[nodiscard]] nn::Precision get_weight_precision() const;
+
+		/// <summary>
+		/// Returns the activation function of this layer
+		/// </summary>
+		[[nodiscard]] const nn::activation_functions::ActivationFunction* get_activation_function() const;
+
+		/// <summary>
+		/// Returns the sums matrix of this layer
+		/// </summary>
+		/// <returns></returns>
+		[[nodiscard]] const Matrix<float>& get_sums() const;
+
+		/// <summary>
+		/// Returns the weights matrix of this layer
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_weights() const;
+
+		/// <summary>
+		/// Returns the biases matrix of this layer
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_biases() const;
+
+		/// <summary>
+		/// Returns the delta sums matrix of this layer
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_delta_sums() const;
+
+		/// <summary>
+		/// Returns the delta weights matrix of this layer
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_delta_weights() const;
+
+		/// <summary>
+		/// Returns the delta biases matrix of this layer
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_delta_biases() const;
+
+		/// <summary>
+		/// Resets the layer to uninitialized state
+		/// </summary>
+		void reset();
+
+		/// <summary>
+		/// Runs forward propagation on this layer
+		/// </summary>
+		/// <param name="previous_layer">Previous Layer</param>
+		void feed_forward(const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Runs back propagation on this layer
+		/// </summary>
+		/// <param name="next_layer">Next layer</param>
+		/// <param name="previous_layer">Previous Layer</param>
+		void back_propagate(const Layer& next_layer, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Runs back propagation on this layer with the given expected activations
+		/// </summary>
+		/// <param name="expected_activations">Expected output of the network</param>
+		/// <param name="previous_layer">Previous Layer</param>
+		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta activations of the previous layer from the delta sums of this (back propagated) layer
+		///	delta_activations = transpose(weights) * delta_sums
+		/// </summary>
+		/// <param name="previous_delta_activations">Delta activations of the previous layer</param>
+		void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const override;
+
+		/// <summary>
+		/// Updates the weights and biases of this layer
+		/// </summary>
+		void update_weights_and_biases(const float learning_rate) override;
+
+		/// <summary>
+		/// Returns the weights and biases with their gradients (none for an input layer)
+		/// </summary>
+		[[nodiscard]] std::vector<Parameter> get_parameters() override;
+
+		/// <summary>
+		/// Returns the memory of the matrices of this layer
+		/// </summary>
+		[[nodiscard]] MemoryRequirements get_memory_requirements() const override;
+
+		/// <summary>
+		/// Frees the activations and sums (the input layer keeps its activations).
+		/// </summary>
+		void release_activations() override;
+
+	private:
+		/// <summary>
+		/// Calculates the delta sums from the delta activations (delta_sums = derivative(sums) * delta_activations)
+		/// </summary>
+		void calculate_delta_sums();
+
+		/// <summary>
+		/// Rounds the float weights into the reduced precision copy (if any)
+		/// </summary>
+		void update_reduced_precision_weights();
+	};
+
+	/// <summary>
+	/// Returns layer as a DenseLayer, throws if it is another type of layer (for the dense only features:
+	///	serialization, quantization and StaticNetwork).
+	/// </summary>
+	[[nodiscard]] DenseLayer& as_dense_layer(Layer& layer);
+
+	/// <summary>
+	/// Returns layer as a DenseLayer, throws if it is another type of layer.
+	/// </summary>
+	[[nodiscard]] const DenseLayer& as_dense_layer(const Layer& layer);
+}
\ No newline at end of file
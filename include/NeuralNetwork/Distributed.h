@@ -0,0 +1,180 @@
+// File: include/NeuralNetwork/Distributed.h
+// Purpose: Header file for distributed data parallel training: the ring of processes, the all-reduce and the report.
+
+#pragma once
+
+#include <chrono> // std::chrono::milliseconds
+#include <cstddef> // size_t
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/DataSet.h" // nn::DataSet
+
+namespace nn::distributed
+{
+	/// <summary>
+	/// Sockets the processes of a ring talk over.
+	/// </summary>
+	enum class Transport
+	{
+		/// <summary>
+		/// TCP, addresses are "host:port" (processes on any host).
+		/// </summary>
+		Tcp,
+
+		/// <summary>
+		/// Unix domain sockets, addresses are file system paths (processes on one host).
+		/// </summary>
+		Unix
+	};
+
+	/// <summary>
+	/// Returns the addresses of world_size processes on this host: "host:port" of base with the port plus the rank
+	///	(Tcp) or base followed by "." and the rank (Unix).
+	/// </summary>
+	[[nodiscard]] std::vector<std::string> get_local_addresses(Transport transport, const std::string& base, size_t world_size);
+
+	/// <summary>
+	/// Connection of one process (a rank) to its neighbours in a ring of processes: it sends to rank + 1 and receives
+	///	from rank - 1. Every rank constructs one with the same addresses (one per rank, the rank listens on its own);
+	///	the constructor returns once both connections are up. Any failure, including a neighbour that does not answer
+	///	within the timeout, throws std::runtime_error. Needs POSIX sockets.
+	/// </summary>
+	class Communicator
+	{
+	private:
+		size_t rank_;
+		size_t world_size_;
+		std::chrono::milliseconds timeout_;
+
+		/// <summary>
+		/// Socket to rank + 1 and socket from rank - 1 (-1 with a single rank).
+		/// </summary>
+		int send_socket_ = -1;
+		int receive_socket_ = -1;
+
+		/// <summary>
+		/// Chunk received from rank - 1 before it is added (sized for the largest all-reduce so far).
+		/// </summary>
+		std::vector<float> buffer_;
+
+		size_t bytes_sent_ = 0;
+
+		/// <summary>
+		/// Sends send_bytes to rank + 1 while receiving receive_bytes from rank - 1 (either may be 0).
+		/// </summary>
+		void exchange(const void* send_data, size_t send_bytes, void* receive_data, size_t receive_bytes);
+
+	public:
+		/// <summary>
+		/// Connects rank (of addresses.size() ranks) to its neighbours.
+		/// </summary>
+		/// <param name="transport">Sockets of the addresses</param>
+		/// <param name="addresses">Address every rank listens on, in rank order</param>
+		/// <param name="rank">Rank of this process</param>
+		/// <param name="timeout">How long to wait for a neighbour (connecting and every transfer)</param>
+		Communicator(Transport transport, const std::vector<std::string>& addresses, size_t rank,
+		             std::chrono::milliseconds timeout = std::chrono::milliseconds(30000));
+
+		/// <summary>
+		/// Closes the connections.
+		/// </summary>
+		~Communicator();
+
+		Communicator(const Communicator&) = delete;
+		Communicator& operator=(const Communicator&) = delete;
+
+		/// <summary>
+		/// Returns the rank of this process (0 to world size - 1).
+		/// </summary>
+		[[nodiscard]] size_t get_rank() const;
+
+		/// <summary>
+		/// Returns the number of ranks.
+		/// </summary>
+		[[nodiscard]] size_t get_world_size() const;
+
+		/// <summary>
+		/// Returns the bytes this rank sent so far.
+		/// </summary>
+		[[nodiscard]] size_t get_bytes_sent() const;
+
+		/// <summary>
+		/// Replaces data on every rank by the sum over the ranks (ring all-reduce). The data is split into one chunk
+		///	per rank; in world size - 1 steps every rank sends a chunk to rank + 1 and adds the chunk of rank - 1
+		///	(reduce-scatter), then in world size - 1 more steps the summed chunks travel once around the ring
+		///	(all-gather). Every rank sends 2 * (world size - 1) / world size of the data, independent of the world size,
+		///	and every rank ends with the same bits. All ranks must call it with the same size.
+		/// </summary>
+		void all_reduce(float* data, size_t size);
+
+		/// <summary>
+		/// Replaces data on every rank by the data of rank 0 (passed around the ring in pieces).
+		/// </summary>
+		void broadcast(float* data, size_t size);
+	};
+
+	/// <summary>
+	/// Measurements of one distributed epoch on one rank.
+	/// </summary>
+	struct Report
+	{
+		/// <summary>
+		/// Steps (batches per rank) of the epoch: the fewest batches of any rank.
+		/// </summary>
+		size_t steps = 0;
+
+		/// <summary>
+		/// Samples this rank trained.
+		/// </summary>
+		size_t samples = 0;
+
+		/// <summary>
+		/// Wall time of the epoch in seconds.
+		/// </summary>
+		double seconds = 0.0;
+
+		/// <summary>
+		/// Seconds the communication thread spent in all-reduce.
+		/// </summary>
+		double communication_seconds = 0.0;
+
+		/// <summary>
+		/// Seconds the training thread waited for the all-reduce after back propagation: the communication back
+		///	propagation did not hide.
+		/// </summary>
+		double exposed_communication_seconds = 0.0;
+
+		/// <summary>
+		/// Bytes this rank sent.
+		/// </summary>
+		size_t bytes_sent = 0;
+
+		/// <summary>
+		/// Returns the throughput of this rank in samples per second.
+		/// </summary>
+		[[nodiscard]] double get_samples_per_second() const;
+
+		/// <summary>
+		/// Returns the share of the communication hidden behind back propagation: 1 - exposed / communication.
+		/// </summary>
+		[[nodiscard]] double get_overlap_fraction() const;
+	};
+
+	/// <summary>
+	/// Replaces the parameters of the layers by those of rank 0, so replicas initialized differently train one model.
+	/// </summary>
+	void broadcast_parameters(const std::vector<nn::Layer*>& layers, Communicator& communicator);
+
+	/// <summary>
+	/// Trains one epoch of data_set, the shard of this rank, in step with the other ranks (data parallel): every step
+	///	back propagates a batch and updates with the mean of the gradients of all ranks, like
+	///	NeuralNetwork::train_one_epoch with the batches of all ranks accumulated. A communication thread all-reduces
+	///	the gradients of layer k while back propagation computes those of layer k - 1, so only the all-reduce of the
+	///	first layers is waited for. Every rank trains as many batches (get_total_size / batch size) as the smallest
+	///	shard has.
+	/// </summary>
+	nn::distributed::Report train_epoch(const std::vector<nn::Layer*>& layers, nn::DataSet& data_set, float learning_rate,
+	                                    Communicator& communicator);
+}
@@ -0,0 +1,113 @@
+// File: include/NeuralNetwork/Dropout.h
+// Purpose: Header file for Dropout class, a layer that drops random activations while training.
+
+#pragma once
+
+#include <cstdint> // uint32_t, uint64_t
+#include <memory> // std::unique_ptr
+#include <random> // std::random_device
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+
+namespace nn
+{
+	/// <summary>
+	/// Dropout layer: while training every activation of the previous layer is zeroed with probability rate and the
+	///	others are scaled by 1 / (1 - rate), so the expected activations are unchanged. The random bits come from a
+	///	counter based hash (kernels::random_mask) evaluated in vector registers and packed into a bitmask, one bit per
+	///	activation, that back propagation applies to the delta. In inference mode the layer does nothing: its activations
+	///	are the activations of the previous layer (no copy).
+	/// </summary>
+	class Dropout : public Layer
+	{
+	private:
+		/// <summary>
+		/// Probability of dropping an activation
+		/// </summary>
+		float rate_;
+
+		/// <summary>
+		/// Seed of the random bits (the same seed drops the same activations)
+		/// </summary>
+		uint32_t seed_;
+
+		/// <summary>
+		/// Random numbers used so far (the counter of the hash)
+		/// </summary>
+		uint64_t counter_ = 0;
+
+		/// <summary>
+		/// Drop activations (training) or pass them through (inference)?
+		/// </summary>
+		bool training_ = true;
+
+		/// <summary>
+		/// Kept activations of the last training feed_forward: bit i % 64 of element i / 64 for activation i
+		/// </summary>
+		std::unique_ptr<Matrix<uint64_t>> mask_;
+
+		/// <summary>
+		/// Activations of the previous layer in inference mode (nullptr while training)
+		/// </summary>
+		const Matrix<float>* pass_through_ = nullptr;
+
+	public:
+		/// <summary>
+		/// Initializes the layer in training mode.
+		/// </summary>
+		/// <param name="neuron_count">Neuron count of this layer and of the previous layer</param>
+		/// <param name="batch_size">Batch size of the layer</param>
+		/// <param name="rate">Probability of dropping an activation, in [0, 1)</param>
+		/// <param name="seed">Seed of the random bits</param>
+		Dropout(size_t neuron_count, size_t batch_size, float rate = 0.5f, uint32_t seed = std::random_device{}());
+
+		[[nodiscard]] float get_rate() const;
+		[[nodiscard]] bool is_training() const;
+
+		/// <summary>
+		/// Returns the bitmask of the kept activations of the last training feed_forward.
+		/// </summary>
+		[[nodiscard]] const Matrix<uint64_t>& get_mask() const;
+
+		/// <summary>
+		/// Returns the activations, the activations of the previous layer in inference mode.
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_activations() const override;
+
+		/// <summary>
+		/// Drops activations (true) or passes them through (false).
+		/// </summary>
+		void set_training(const bool training) override;
+
+		/// <summary>
+		/// activations = mask * previous activations / (1 - rate) with a new mask (training), or a reference to the
+		///	previous activations (inference)
+		/// </summary>
+		void feed_forward(const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Takes the delta activations from the next layer (nothing to learn).
+		/// </summary>
+		void back_propagate(const Layer& next_layer, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta activations from the expected activations (nothing to learn).
+		/// </summary>
+		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// previous delta activations = mask * delta activations / (1 - rate) (the delta as is in inference mode)
+		/// </summary>
+		void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const override;
+
+		/// <summary>
+		/// Returns the memory of the matrices of this layer (no parameters).
+		/// </summary>
+		[[nodiscard]] MemoryRequirements get_memory_requirements() const override;
+
+		/// <summary>
+		/// False: every training feed_forward draws a new mask.
+		/// </summary>
+		[[nodiscard]] bool is_recomputable() const override;
+	};
+}
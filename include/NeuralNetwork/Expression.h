@@ -0,0 +1,415 @@
+// File: include/NeuralNetwork/Expression.h
+// Purpose: Header file for the lazily evaluated element wise arithmetic on Matrix and MatrixView (expression templates).
+
+#pragma once
+
+#include <cmath> // std::exp, std::log, std::sqrt, std::abs, std::tanh
+#include <cstddef> // size_t
+#include <stdexcept> // std::runtime_error
+#include <type_traits> // std::enable_if_t, std::is_arithmetic_v, std::is_base_of_v, std::remove_const_t
+#include <utility> // std::declval
+
+#include "NeuralNetwork/MatrixView.h" // nn::MatrixView
+
+namespace nn
+{
+	// Defined in NeuralNetwork/Matrix.h (which includes this file).
+	template <typename T>
+	class Matrix;
+}
+
+// Arithmetic on matrices builds a tree of small expression objects instead of computing anything:
+//	weights = weights - learning_rate * delta_weights;
+// evaluates every element of the right hand side in one loop when it is assigned, without temporaries.
+// * and / are element wise (Matrix::multiply is the matrix product). Element i, j of the result only reads
+// element i, j of every operand, so the destination may be an operand.
+// The expressions refer to the data of their operands, so they are meant to be assigned in the same statement.
+namespace nn::expressions
+{
+	/// <summary>
+	/// Base of every expression (CRTP). Derived has value_type, get_rows(), get_cols() and operator()(row, col).
+	/// </summary>
+	template <typename Derived>
+	class Expression
+	{
+	public:
+		[[nodiscard]] const Derived& derived() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+	};
+
+	/// <summary>
+	/// Is X an expression?
+	/// </summary>
+	template <typename X>
+	constexpr bool is_expression_v = std::is_base_of_v<Expression<X>, X>;
+
+	/// <summary>
+	/// Elements of a matrix or view (read only).
+	/// </summary>
+	template <typename T>
+	class Terminal : public Expression<Terminal<T>>
+	{
+	private:
+		const T* data_;
+		size_t rows_;
+		size_t cols_;
+		size_t stride_;
+
+	public:
+		using value_type = T;
+
+		explicit Terminal(const MatrixView<const T>& view)
+			: data_(view.get_data()), rows_(view.get_rows()), cols_(view.get_cols()), stride_(view.get_stride())
+		{
+		}
+
+		[[nodiscard]] size_t get_rows() const { return this->rows_; }
+		[[nodiscard]] size_t get_cols() const { return this->cols_; }
+		[[nodiscard]] T operator()(const size_t row, const size_t col) const { return this->data_[row * this->stride_ + col]; }
+	};
+
+	/// <summary>
+	/// A column vector repeated for every column or a row vector repeated for every row (e.g. the biases of a layer
+	///	added to every sample of a batch).
+	/// </summary>
+	template <typename T>
+	class Broadcast : public Expression<Broadcast<T>>
+	{
+	private:
+		const T* data_;
+		size_t rows_;
+		size_t cols_;
+		size_t row_step_;
+		size_t col_step_;
+
+	public:
+		using value_type = T;
+
+		Broadcast(const MatrixView<const T>& view, const size_t rows, const size_t cols)
+			: data_(view.get_data()), rows_(rows), cols_(cols), row_step_(view.get_stride()), col_step_(1)
+		{
+			if (view.get_cols() == 1 && view.get_rows() == rows)
+			{
+				this->col_step_ = 0;
+			}
+			else if (view.get_rows() == 1 && view.get_cols() == cols)
+			{
+				this->row_step_ = 0;
+			}
+			else
+			{
+				throw std::runtime_error("Cannot broadcast matrix with incompatible dimensions.");
+			}
+		}
+
+		[[nodiscard]] size_t get_rows() const { return this->rows_; }
+		[[nodiscard]] size_t get_cols() const { return this->cols_; }
+		[[nodiscard]] T operator()(const size_t row, const size_t col) const
+		{
+			return this->data_[row * this->row_step_ + col * this->col_step_];
+		}
+	};
+
+	/// <summary>
+	/// The same value for every element. Has no size of its own (0 x 0), it takes the size of the other operand.
+	/// </summary>
+	template <typename T>
+	class Scalar : public Expression<Scalar<T>>
+	{
+	private:
+		T value_;
+
+	public:
+		using value_type = T;
+
+		explicit Scalar(const T value)
+			: value_(value)
+		{
+		}
+
+		[[nodiscard]] size_t get_rows() const { return 0; }
+		[[nodiscard]] size_t get_cols() const { return 0; }
+		[[nodiscard]] T operator()(size_t, size_t) const { return this->value_; }
+	};
+
+	/// <summary>
+	/// Op::apply(left(row, col), right(row, col))
+	/// </summary>
+	template <typename Op, typename L, typename R>
+	class BinaryExpression : public Expression<BinaryExpression<Op, L, R>>
+	{
+	private:
+		L left_;
+		R right_;
+
+	public:
+		using value_type = typename L::value_type;
+
+		BinaryExpression(const L& left, const R& right)
+			: left_(left), right_(right)
+		{
+			if (left.get_rows() != 0 && right.get_rows() != 0 &&
+				(left.get_rows() != right.get_rows() || left.get_cols() != right.get_cols()))
+			{
+				throw std::runtime_error("Cannot perform element wise operation on matrices with incompatible dimensions.");
+			}
+		}
+
+		[[nodiscard]] size_t get_rows() const { return this->left_.get_rows() != 0 ? this->left_.get_rows() : this->right_.get_rows(); }
+		[[nodiscard]] size_t get_cols() const { return this->left_.get_rows() != 0 ? this->left_.get_cols() : this->right_.get_cols(); }
+		[[nodiscard]] value_type operator()(const size_t row, const size_t col) const
+		{
+			return Op::apply(this->left_(row, col), this->right_(row, col));
+		}
+	};
+
+	/// <summary>
+	/// Op::apply(operand(row, col))
+	/// </summary>
+	template <typename Op, typename E>
+	class UnaryExpression : public Expression<UnaryExpression<Op, E>>
+	{
+	private:
+		E operand_;
+
+	public:
+		using value_type = typename E::value_type;
+
+		explicit UnaryExpression(const E& operand)
+			: operand_(operand)
+		{
+		}
+
+		[[nodiscard]] size_t get_rows() const { return this->operand_.get_rows(); }
+		[[nodiscard]] size_t get_cols() const { return this->operand_.get_cols(); }
+		[[nodiscard]] value_type operator()(const size_t row, const size_t col) const
+		{
+			return Op::apply(this->operand_(row, col));
+		}
+	};
+
+	namespace ops
+	{
+		struct Add { template <typename T> static T apply(const T a, const T b) { return a + b; } };
+		struct Subtract { template <typename T> static T apply(const T a, const T b) { return a - b; } };
+		struct Multiply { template <typename T> static T apply(const T a, const T b) { return a * b; } };
+		struct Divide { template <typename T> static T apply(const T a, const T b) { return a / b; } };
+		struct Maximum { template <typename T> static T apply(const T a, const T b) { return a > b ? a : b; } };
+		struct Minimum { template <typename T> static T apply(const T a, const T b) { return a < b ? a : b; } };
+		struct Negate { template <typename T> static T apply(const T a) { return -a; } };
+		struct Square { template <typename T> static T apply(const T a) { return a * a; } };
+		struct Exp { template <typename T> static T apply(const T a) { return std::exp(a); } };
+		struct Log { template <typename T> static T apply(const T a) { return std::log(a); } };
+		struct Sqrt { template <typename T> static T apply(const T a) { return std::sqrt(a); } };
+		struct Abs { template <typename T> static T apply(const T a) { return std::abs(a); } };
+		struct Tanh { template <typename T> static T apply(const T a) { return std::tanh(a); } };
+		struct Sigmoid { template <typename T> static T apply(const T a) { return T(1) / (T(1) + std::exp(-a)); } };
+	}
+
+	/// <summary>
+	/// Returns the expression itself.
+	/// </summary>
+	template <typename E, typename = std::enable_if_t<is_expression_v<E>>>
+	E as_expression(const E& expression)
+	{
+		return expression;
+	}
+
+	/// <summary>
+	/// Returns the elements of the matrix.
+	/// </summary>
+	template <typename T>
+	Terminal<T> as_expression(const Matrix<T>& matrix)
+	{
+		return Terminal<T>(matrix.view());
+	}
+
+	/// <summary>
+	/// Returns the elements of the view.
+	/// </summary>
+	template <typename T>
+	Terminal<std::remove_const_t<T>> as_expression(const MatrixView<T>& view)
+	{
+		return Terminal<std::remove_const_t<T>>(MatrixView<const std::remove_const_t<T>>(view));
+	}
+
+	/// <summary>
+	/// Expression type of an operand (expression, Matrix or MatrixView).
+	/// </summary>
+	template <typename X>
+	using expression_t = decltype(as_expression(std::declval<const X&>()));
+
+	template <typename X, typename = void>
+	constexpr bool is_operand_v = false;
+
+	/// <summary>
+	/// Is X an expression, a Matrix or a MatrixView?
+	/// </summary>
+	template <typename X>
+	constexpr bool is_operand_v<X, std::void_t<expression_t<X>>> = true;
+
+	/// <summary>
+	/// Combines two operands.
+	/// </summary>
+	template <typename Op, typename L, typename R>
+	BinaryExpression<Op, expression_t<L>, expression_t<R>> make_binary(const L& left, const R& right)
+	{
+		return BinaryExpression<Op, expression_t<L>, expression_t<R>>(as_expression(left), as_expression(right));
+	}
+
+	/// <summary>
+	/// Combines an operand with a scalar (converted to the element type of the operand) on the right.
+	/// </summary>
+	template <typename Op, typename L, typename S>
+	auto make_binary_scalar_right(const L& left, const S right)
+	{
+		using value_type = typename expression_t<L>::value_type;
+		return BinaryExpression<Op, expression_t<L>, Scalar<value_type>>(as_expression(left), Scalar<value_type>(static_cast<value_type>(right)));
+	}
+
+	/// <summary>
+	/// Combines a scalar (converted to the element type of the operand) on the left with an operand.
+	/// </summary>
+	template <typename Op, typename S, typename R>
+	auto make_binary_scalar_left(const S left, const R& right)
+	{
+		using value_type = typename expression_t<R>::value_type;
+		return BinaryExpression<Op, Scalar<value_type>, expression_t<R>>(Scalar<value_type>(static_cast<value_type>(left)), as_expression(right));
+	}
+
+	/// <summary>
+	/// Applies a function to every element of an operand.
+	/// </summary>
+	template <typename Op, typename E>
+	UnaryExpression<Op, expression_t<E>> make_unary(const E& operand)
+	{
+		return UnaryExpression<Op, expression_t<E>>(as_expression(operand));
+	}
+
+	/// <summary>
+	/// Repeats a column vector (rows x 1) for every column or a row vector (1 x cols) for every row of a rows x cols result.
+	/// </summary>
+	template <typename T>
+	Broadcast<T> broadcast(const Matrix<T>& vector, const size_t rows, const size_t cols)
+	{
+		return Broadcast<T>(vector.view(), rows, cols);
+	}
+
+	/// <summary>
+	/// Repeats a column vector (rows x 1) for every column or a row vector (1 x cols) for every row of a rows x cols result.
+	/// </summary>
+	template <typename T>
+	Broadcast<std::remove_const_t<T>> broadcast(const MatrixView<T>& vector, const size_t rows, const size_t cols)
+	{
+		return Broadcast<std::remove_const_t<T>>(MatrixView<const std::remove_const_t<T>>(vector), rows, cols);
+	}
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto exp(const E& x) { return make_unary<ops::Exp>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto log(const E& x) { return make_unary<ops::Log>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto sqrt(const E& x) { return make_unary<ops::Sqrt>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto abs(const E& x) { return make_unary<ops::Abs>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto tanh(const E& x) { return make_unary<ops::Tanh>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto sigmoid(const E& x) { return make_unary<ops::Sigmoid>(x); }
+
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	auto square(const E& x) { return make_unary<ops::Square>(x); }
+
+	/// <summary>
+	/// Element wise maximum with a scalar (max(x, 0) is ReLU).
+	/// </summary>
+	template <typename E, typename S, typename = std::enable_if_t<is_operand_v<E> && std::is_arithmetic_v<S>>>
+	auto max(const E& x, const S value) { return make_binary_scalar_right<ops::Maximum>(x, value); }
+
+	/// <summary>
+	/// Element wise minimum with a scalar.
+	/// </summary>
+	template <typename E, typename S, typename = std::enable_if_t<is_operand_v<E> && std::is_arithmetic_v<S>>>
+	auto min(const E& x, const S value) { return make_binary_scalar_right<ops::Minimum>(x, value); }
+
+	/// <summary>
+	/// Evaluates the expression into destination in one pass (row by row, the inner loop over the columns is free
+	///	of calls once inlined, so the compiler vectorizes it). A scalar expression fills the destination.
+	/// </summary>
+	template <typename T, typename E>
+	void evaluate(const Expression<E>& expression, const MatrixView<T>& destination)
+	{
+		const E& e = expression.derived();
+		if (e.get_rows() != 0 && (e.get_rows() != destination.get_rows() || e.get_cols() != destination.get_cols()))
+		{
+			throw std::runtime_error("Cannot assign expression to a matrix with incompatible dimensions.");
+		}
+
+		const size_t rows = destination.get_rows();
+		const size_t cols = destination.get_cols();
+		for (size_t i = 0; i < rows; ++i)
+		{
+			T* destination_row = &destination(i, 0);
+			for (size_t j = 0; j < cols; ++j)
+			{
+				destination_row[j] = static_cast<T>(e(i, j));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Returns the sum of all elements of an operand in one pass (e.g. sum(square(output - expected)) for a loss).
+	/// </summary>
+	template <typename E, typename = std::enable_if_t<is_operand_v<E>>>
+	typename expression_t<E>::value_type sum(const E& x)
+	{
+		const expression_t<E> e = as_expression(x);
+		typename expression_t<E>::value_type result{};
+		for (size_t i = 0; i < e.get_rows(); ++i)
+		{
+			for (size_t j = 0; j < e.get_cols(); ++j)
+			{
+				result += e(i, j);
+			}
+		}
+		return result;
+	}
+}
+
+// The operators are found by argument dependent lookup for Matrix, MatrixView (namespace nn) and the expressions.
+namespace nn
+{
+#define NN_EXPRESSION_BINARY_OPERATOR(op, Op) \
+	template <typename L, typename R, typename = std::enable_if_t<expressions::is_operand_v<L> && expressions::is_operand_v<R>>> \
+	auto operator op(const L& left, const R& right) { return expressions::make_binary<expressions::ops::Op>(left, right); } \
+	template <typename L, typename S, typename = std::enable_if_t<expressions::is_operand_v<L> && std::is_arithmetic_v<S>>, typename = void> \
+	auto operator op(const L& left, const S right) { return expressions::make_binary_scalar_right<expressions::ops::Op>(left, right); } \
+	template <typename S, typename R, typename = std::enable_if_t<std::is_arithmetic_v<S> && expressions::is_operand_v<R>>, typename = void, typename = void> \
+	auto operator op(const S left, const R& right) { return expressions::make_binary_scalar_left<expressions::ops::Op>(left, right); }
+
+	NN_EXPRESSION_BINARY_OPERATOR(+, Add)
+	NN_EXPRESSION_BINARY_OPERATOR(-, Subtract)
+	NN_EXPRESSION_BINARY_OPERATOR(*, Multiply)
+	NN_EXPRESSION_BINARY_OPERATOR(/, Divide)
+
+#undef NN_EXPRESSION_BINARY_OPERATOR
+
+	template <typename E, typename = std::enable_if_t<expressions::is_operand_v<E>>>
+	auto operator-(const E& x) { return expressions::make_unary<expressions::ops::Negate>(x); }
+}
+
+namespace nn::expressions
+{
+	// The operators for the expression types themselves (argument dependent lookup looks in this namespace).
+	using nn::operator+;
+	using nn::operator-;
+	using nn::operator*;
+	using nn::operator/;
+}
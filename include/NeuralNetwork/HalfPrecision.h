@@ -0,0 +1,137 @@
+// File: include/NeuralNetwork/HalfPrecision.h
+// Purpose: Header file for 16 bit floating point storage types (bfloat16 and IEEE half) and their kernels.
+
+#pragma once
+
+#include <cstdint> // uint16_t
+
+#include "NeuralNetwork/Matrix.h" // nn::Matrix
+
+namespace nn
+{
+	/// <summary>
+	/// Storage precision of a layer's weights.
+	/// </summary>
+	enum class Precision
+	{
+		/// <summary>
+		/// 32 bit IEEE float.
+		/// </summary>
+		Float32,
+
+		/// <summary>
+		/// bfloat16 (8 bit exponent, 7 bit mantissa), same range as float.
+		/// </summary>
+		BFloat16,
+
+		/// <summary>
+		/// IEEE 754 half precision (5 bit exponent, 10 bit mantissa).
+		/// </summary>
+		Float16
+	};
+
+	/// <summary>
+	/// bfloat16 storage type (upper 16 bits of a float). Arithmetic is done after converting to float.
+	/// </summary>
+	struct bfloat16
+	{
+		/// <summary>
+		/// Raw bits of the value.
+		/// </summary>
+		uint16_t bits;
+
+		bfloat16() = default;
+
+		/// <summary>
+		/// Converts from float (round to nearest even).
+		/// </summary>
+		explicit bfloat16(float value);
+
+		/// <summary>
+		/// Converts to float (exact).
+		/// </summary>
+		explicit operator float() const;
+	};
+
+	/// <summary>
+	/// IEEE 754 half precision storage type. Arithmetic is done after converting to float.
+	/// </summary>
+	struct float16
+	{
+		/// <summary>
+		/// Raw bits of the value.
+		/// </summary>
+		uint16_t bits;
+
+		float16() = default;
+
+		/// <summary>
+		/// Converts from float (round to nearest even, uses F16C when available).
+		/// </summary>
+		explicit float16(float value);
+
+		/// <summary>
+		/// Converts to float (exact, uses F16C when available).
+		/// </summary>
+		explicit operator float() const;
+	};
+
+	namespace half_precision
+	{
+		/// <summary>
+		/// Converts every element of a float matrix into a 16 bit matrix of the same size.
+		/// </summary>
+		void convert(const Matrix<float>& source, Matrix<bfloat16>& destination);
+
+		/// <summary>
+		/// Converts every element of a float matrix into a 16 bit matrix of the same size.
+		/// </summary>
+		void convert(const Matrix<float>& source, Matrix<float16>& destination);
+
+		/// <summary>
+		/// Converts every element of a 16 bit matrix into a float matrix of the same size.
+		/// </summary>
+		void convert(const Matrix<bfloat16>& source, Matrix<float>& destination);
+
+		/// <summary>
+		/// Converts every element of a 16 bit matrix into a float matrix of the same size.
+		/// </summary>
+		void convert(const Matrix<float16>& source, Matrix<float>& destination);
+
+		/// <summary>
+		/// Performs result = weights * input, converting the weights on the fly and accumulating in float.
+		/// </summary>
+		void multiply(const Matrix<bfloat16>& weights, const Matrix<float>& input, Matrix<float>& result);
+
+		/// <summary>
+		/// Performs result = weights * input, converting the weights on the fly and accumulating in float.
+		/// </summary>
+		void multiply(const Matrix<float16>& weights, const Matrix<float>& input, Matrix<float>& result);
+
+		/// <summary>
+		/// Calculates sums = weights * input + biases with 16 bit weights (see Matrix::calculate_sums_for_forward_propagation).
+		/// </summary>
+		template <typename Half>
+		void calculate_sums_for_forward_propagation(const Matrix<Half>& weights, const Matrix<float>& biases,
+		                                            const Matrix<float>& input, Matrix<float>& sums)
+		{
+			if (weights.get_rows() != sums.get_rows() || weights.get_cols() != input.get_rows() ||
+				input.get_cols() != sums.get_cols() || biases.get_rows() != sums.get_rows() || biases.get_cols() != 1)
+			{
+				throw std::runtime_error("Cannot calculate sums for forward propagation with incompatible dimensions.");
+			}
+
+			multiply(weights, input, sums);
+			NN_PROFILE_WORK(sums.get_rows() * sums.get_cols(), sizeof(float) * (2 * sums.get_rows() * sums.get_cols() + sums.get_rows()));
+			for (size_t i = 0; i < sums.get_rows(); i++)
+			{
+				const float bias = biases[i];
+				float* row = sums.get_data() + i * sums.get_cols();
+				for (size_t j = 0; j < sums.get_cols(); j++)
+				{
+					row[j] += bias;
+				}
+			}
+		}
+	}
+}
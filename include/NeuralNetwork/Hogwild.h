@@ -0,0 +1,59 @@
+// File: include/NeuralNetwork/Hogwild.h
+// Purpose: Header file for Hogwild training: threads that update shared weights without locks.
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <vector> // std::vector
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/DataSet.h" // nn::DataSet
+
+namespace nn::hogwild
+{
+	/// <summary>
+	/// Measurements of one Hogwild epoch.
+	/// </summary>
+	struct Report
+	{
+		/// <summary>
+		/// Batches every thread trained (the data set hands the next batch to the first thread that is free).
+		/// </summary>
+		std::vector<size_t> thread_batches;
+
+		/// <summary>
+		/// Samples trained.
+		/// </summary>
+		size_t samples = 0;
+
+		/// <summary>
+		/// Wall time of the epoch in seconds.
+		/// </summary>
+		double seconds = 0.0;
+
+		/// <summary>
+		/// Returns the throughput in samples per second.
+		/// </summary>
+		[[nodiscard]] double get_samples_per_second() const;
+	};
+
+	/// <summary>
+	/// Splits size parameters into the segments the threads update one after the other: at most thread_count
+	///	segments of whole cache lines (the matrices start on a cache line), so no line belongs to two segments.
+	/// </summary>
+	/// <returns>Elements of every segment but the last</returns>
+	[[nodiscard]] size_t get_segment_size(size_t size, size_t thread_count);
+
+	/// <summary>
+	/// Trains one epoch of data_set on thread_count threads without locks (Hogwild): every thread has a replica of the
+	///	dense layers that shares their weights and biases (DenseLayer::create_replica) and has its own activations and
+	///	gradients, runs feed_forward and back_propagate on its own batches and updates the shared weights right away.
+	///	Thread t updates the cache line aligned segments of every parameter starting with segment t, so while all the
+	///	threads update at once they write different cache lines. The threads read weights other threads are writing;
+	///	the races are the point of the method, they cost a little staleness instead of any synchronization.
+	///	Every thread allocates its replica and batches itself, after nn::numa::pin_worker. Only dense layers with
+	///	built-in activation functions are supported (std::runtime_error otherwise).
+	/// </summary>
+	nn::hogwild::Report train_epoch(const std::vector<nn::Layer*>& layers, nn::DataSet& data_set, float learning_rate,
+	                                size_t thread_count);
+}
@@ -0,0 +1,243 @@
+// File: include/NeuralNetwork/Kernels.h
+// Purpose: Header file for the SIMD kernels and the runtime CPU feature dispatcher.
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // int8_t, uint8_t, int32_t, uint32_t, uint64_t
+
+namespace nn
+{
+	// Defined in NeuralNetwork/HalfPrecision.h (which includes Matrix.h, that in turn includes this file).
+	struct bfloat16;
+	struct float16;
+}
+
+namespace nn::kernels
+{
+	/// <summary>
+	/// Instruction set levels the kernels are compiled for, in increasing order.
+	/// </summary>
+	enum class IsaLevel
+	{
+		/// <summary>
+		/// Portable C++ (no intrinsics).
+		/// </summary>
+		Scalar,
+
+		/// <summary>
+		/// SSE4.2 (128 bit vectors).
+		/// </summary>
+		SSE42,
+
+		/// <summary>
+		/// AVX2 + FMA + F16C (256 bit vectors).
+		/// </summary>
+		AVX2,
+
+		/// <summary>
+		/// AVX-512 F/BW/DQ/VL (512 bit vectors).
+		/// </summary>
+		AVX512
+	};
+
+	/// <summary>
+	/// Function pointers to the kernels of one instruction set level.
+	///	Matrices are row major, ld* is the distance in elements between the starts of two rows.
+	/// </summary>
+	struct KernelTable
+	{
+		/// <summary>
+		/// Level the kernels were selected for.
+		/// </summary>
+		IsaLevel level = IsaLevel::Scalar;
+
+		/// <summary>
+		/// Is the AVX-512 VNNI int8 dot product in use?
+		/// </summary>
+		bool vnni = false;
+
+		/// <summary>
+		/// Name of the BLAS library the matrix products are routed through (nullptr for the built-in kernels).
+		/// </summary>
+		const char* blas = nullptr;
+
+		/// <summary>
+		/// c (m x n) = a (m x k) * b (k x n)
+		/// </summary>
+		void (*sgemm)(const float* a, const float* b, float* c, size_t m, size_t n, size_t k,
+		              size_t lda, size_t ldb, size_t ldc) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = alpha * transpose(a) (a is k x m) * b (k x n) + beta * c (c is not read if beta is 0)
+		///	Only set by a BLAS backend, without one the operand is transposed explicitly and sgemm is used.
+		/// </summary>
+		void (*sgemm_tn)(const float* a, const float* b, float* c, size_t m, size_t n, size_t k, float alpha, float beta,
+		                 size_t lda, size_t ldb, size_t ldc) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = alpha * a (m x k) * transpose(b) (b is n x k) + beta * c (c is not read if beta is 0)
+		///	Only set by a BLAS backend, without one the operand is transposed explicitly and sgemm is used.
+		/// </summary>
+		void (*sgemm_nt)(const float* a, const float* b, float* c, size_t m, size_t n, size_t k, float alpha, float beta,
+		                 size_t lda, size_t ldb, size_t ldc) = nullptr;
+
+		/// <summary>
+		/// result[i] = alpha * sum(a[i][0..n)) for the m rows of a
+		/// </summary>
+		void (*row_sums)(const float* a, float* result, size_t m, size_t n, float alpha, size_t lda) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = alpha * a (m x k) * transpose(b) (b is n x k) + beta * c and
+		///	sums[i] = alpha * sum(a[i][0..k)) + beta * sums[i] in one sweep over a (c and sums are not read if beta is 0).
+		///	The weight and bias gradients of back propagation: a is the delta sums, b the previous activations.
+		/// </summary>
+		void (*sgemm_nt_row_sums)(const float* a, const float* b, float* c, float* sums, size_t m, size_t n, size_t k,
+		                          float alpha, float beta, size_t lda, size_t ldb, size_t ldc) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = a (m x k, bfloat16) * b (k x n), accumulated in float
+		/// </summary>
+		void (*sgemm_bf16)(const bfloat16* a, const float* b, float* c, size_t m, size_t n, size_t k) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = a (m x k, half precision) * b (k x n), accumulated in float
+		/// </summary>
+		void (*sgemm_fp16)(const float16* a, const float* b, float* c, size_t m, size_t n, size_t k) = nullptr;
+
+		/// <summary>
+		/// x[i] = x[i] * y[i]
+		/// </summary>
+		void (*hadamard)(float* x, const float* y, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = x[i] + alpha * y[i]
+		/// </summary>
+		void (*axpy)(float* x, const float* y, float alpha, size_t size) = nullptr;
+
+		/// <summary>
+		/// Where x[i] > max[i]: max[i] = x[i], argmax[i] = index (one step of a max pooling window)
+		/// </summary>
+		void (*max_argmax)(float* max, uint8_t* argmax, const float* x, uint8_t index, size_t size) = nullptr;
+
+		/// <summary>
+		/// Bit i of mask (bit i % 64 of mask[i / 64]) = random_bits(key ^ (counter + i)) >= threshold, so every bit is
+		///	set with probability 1 - threshold / 2^32. The bits after size in the last word are cleared.
+		/// </summary>
+		void (*random_mask)(uint64_t* mask, uint32_t key, uint32_t counter, uint32_t threshold, size_t size) = nullptr;
+
+		/// <summary>
+		/// y[i] = bit i of mask ? scale * x[i] : 0 (y may be x)
+		/// </summary>
+		void (*masked_scale)(float* y, const float* x, const uint64_t* mask, float scale, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = 1 / (1 + exp(-x[i]))
+		/// </summary>
+		void (*sigmoid)(float* x, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = sigmoid(x[i]) * (1 - sigmoid(x[i]))
+		/// </summary>
+		void (*sigmoid_derivative)(float* x, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = tanh(x[i])
+		/// </summary>
+		void (*tanh)(float* x, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = 1 - tanh(x[i])^2
+		/// </summary>
+		void (*tanh_derivative)(float* x, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = x[i] > 0 ? x[i] : slope * x[i] (ReLU for slope 0)
+		/// </summary>
+		void (*leaky_relu)(float* x, float slope, size_t size) = nullptr;
+
+		/// <summary>
+		/// x[i] = x[i] > 0 ? 1 : slope
+		/// </summary>
+		void (*leaky_relu_derivative)(float* x, float slope, size_t size) = nullptr;
+
+		/// <summary>
+		/// y[i] = delta[i] * a[i] * (1 - a[i]) where a = sigmoid(x): the derivative from the activations, without exp
+		/// </summary>
+		void (*sigmoid_backward)(float* y, const float* a, const float* delta, size_t size) = nullptr;
+
+		/// <summary>
+		/// y[i] = delta[i] * (1 - a[i]^2) where a = tanh(x)
+		/// </summary>
+		void (*tanh_backward)(float* y, const float* a, const float* delta, size_t size) = nullptr;
+
+		/// <summary>
+		/// y[i] = x[i] > 0 ? delta[i] : slope * delta[i] (x may be the activations, they have the sign of the sums)
+		/// </summary>
+		void (*leaky_relu_backward)(float* y, const float* x, const float* delta, float slope, size_t size) = nullptr;
+
+		/// <summary>
+		/// Returns sum(activations[i] * weights[i]), size is a multiple of 64 and activations are at most 127.
+		/// </summary>
+		int32_t (*dot_u8s8)(const uint8_t* activations, const int8_t* weights, size_t size) = nullptr;
+
+		/// <summary>
+		/// c (m x n) = a (m x k) * transpose(b) (b is n x k) with int32 accumulation: the m samples of u8 activations
+		///	against the n rows of s8 weights, in register blocks of several samples and rows. k is a multiple of 64 and
+		///	activations are at most 127 (like dot_u8s8).
+		/// </summary>
+		void (*gemm_u8s8)(const uint8_t* a, const int8_t* b, int32_t* c, size_t m, size_t n, size_t k, size_t lda, size_t ldb,
+		                  size_t ldc) = nullptr;
+	};
+
+	/// <summary>
+	/// Counter based random bits of random_mask: a 32 bit integer hash with full avalanche (2 multiplies, 3 shifts), so
+	///	any element of a random sequence costs a few vector instructions and no generator state.
+	/// </summary>
+	[[nodiscard]] constexpr uint32_t random_bits(uint32_t x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352du;
+		x ^= x >> 15;
+		x *= 0x846ca68bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	/// <summary>
+	/// Returns the kernels for the best instruction set level of this CPU (selected once, on first use).
+	///	The NN_ISA_LEVEL environment variable (scalar, sse4.2, avx2, avx512) forces a lower level for testing.
+	/// </summary>
+	[[nodiscard]] const KernelTable& get_kernels();
+
+	/// <summary>
+	/// Returns the highest instruction set level supported by both this CPU (and OS) and this build.
+	/// </summary>
+	[[nodiscard]] IsaLevel detect_isa_level();
+
+	/// <summary>
+	/// Builds the kernel table for the given level (clamped to detect_isa_level()).
+	///	If use_blas is set and the library was built with a BLAS backend, the matrix products go through it.
+	/// </summary>
+	[[nodiscard]] KernelTable create_kernel_table(IsaLevel level, bool use_blas = true);
+
+	/// <summary>
+	/// Returns the name of the BLAS library this build is linked with (NN_BLAS_BACKEND), nullptr if none.
+	/// </summary>
+	[[nodiscard]] const char* get_blas_name();
+
+	/// <summary>
+	/// Returns the name of the level as accepted by NN_ISA_LEVEL.
+	/// </summary>
+	[[nodiscard]] const char* get_isa_level_name(IsaLevel level);
+
+	/// <summary>
+	/// Overrides the entries of the table with the kernels of one level (each is compiled with its own flags).
+	/// </summary>
+	void register_scalar_kernels(KernelTable& table);
+	void register_sse42_kernels(KernelTable& table);
+	void register_avx2_kernels(KernelTable& table);
+	void register_avx512_kernels(KernelTable& table);
+	void register_avx512_vnni_kernels(KernelTable& table);
+	void register_blas_kernels(KernelTable& table);
+}
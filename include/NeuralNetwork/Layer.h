@@ -1,103 +1,125 @@
 // File: include/NeuralNetwork/Layer.h
-// Purpose: Header file for Layer class.
+// Purpose: Header file for Layer class, the interface of every layer of a neural network.
 
 #pragma once
 
-#include <memory> // std::unique_ptr
+#include <memory> // std::unique_ptr, std::shared_ptr
+#include <vector> // std::vector
 
 #include "NeuralNetwork/Matrix.h" // nn::Matrix
-#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationFunction
+#include "NeuralNetwork/HalfPrecision.h" // nn::Precision
 
 namespace nn
 {
-	class Layer
+	/// <summary>
+	/// A trainable matrix of a layer and its gradient (same size, filled by back propagation).
+	/// </summary>
+	struct Parameter
 	{
-	private:
 		/// <summary>
-		/// Activation matrix of this layer (columns are neurons, rows are batch size)
+		/// Name of the parameter, e.g. "weights" (static string).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> activations_;
+		const char* name;
 
 		/// <summary>
-		/// Activation matrix produced by the sum of the weights and biases prior to the activation function
+		/// Values of the parameter (owned by the layer).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> sums_;
+		Matrix<float>* value;
 
 		/// <summary>
-		/// Weights matrix of this layer
+		/// Gradient of the loss with respect to the values, averaged over the batch (owned by the layer).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> weights_;
+		Matrix<float>* gradient;
+	};
 
+	/// <summary>
+	/// Memory held by a layer, in bytes.
+	/// </summary>
+	struct MemoryRequirements
+	{
 		/// <summary>
-		/// Biases matrix of this layer
+		/// Parameters, their gradients and any copies of them (independent of the batch size).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> biases_;
+		size_t parameter_bytes = 0;
 
 		/// <summary>
-		/// Delta of the weights matrix of this layer
+		/// Results of feed_forward that back propagation reads (activations, pre-activation sums, caches).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> delta_activations_;
+		size_t activation_bytes = 0;
 
 		/// <summary>
-		/// Delta of the biases matrix of this layer
+		/// Scratch space of back propagation (delta matrices and buffers reused every batch).
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> delta_sums_;
+		size_t workspace_bytes = 0;
 
 		/// <summary>
-		/// Delta of the weights matrix of this layer
+		/// Returns the sum of all the requirements.
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> delta_weights_;
+		[[nodiscard]] size_t get_total_bytes() const;
+	};
 
+	/// <summary>
+	/// Interface of the layers of a NeuralNetwork. The network only calls these methods, so new layer types (dense,
+	///	convolution, pooling, ...) plug into its loops without changes. Every layer has neuron count x batch size
+	///	activations (one sample per column) and the delta of the loss with respect to them.
+	/// </summary>
+	class Layer
+	{
+	protected:
 		/// <summary>
-		/// Delta of the biases matrix of this layer
+		/// Activation matrix of this layer (rows are neurons, columns are the samples of the batch)
 		/// </summary>
-		std::unique_ptr<nn::Matrix<float>> delta_biases_;
+		std::unique_ptr<nn::Matrix<float>> activations_;
+
+		/// <summary>
+		/// Delta of the activations of this layer (set by back propagation)
+		/// </summary>
+		std::unique_ptr<nn::Matrix<float>> delta_activations_;
 
 		/// <summary>
 		/// Neuron count of this layer
 		/// </summary>
-		size_t neuron_count_;
+		size_t neuron_count_ = 0;
 
 		/// <summary>
 		/// Batch size of this layer
 		/// </summary>
-		size_t batch_size_;
+		size_t batch_size_ = 0;
 
 		/// <summary>
-		/// Activation function of this layer (default is sigmoid) (owned)
+		/// Does back propagation add to the gradients (true) or overwrite them (false)?
 		/// </summary>
-		std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function_;
+		bool accumulate_gradients_ = false;
 
-	public:
 		/// <summary>
-		/// Default constructor
+		/// Weight of the batch mean in the gradients (1 / micro batch count while accumulating)
 		/// </summary>
-		Layer();
+		float gradient_scale_ = 1.0f;
 
 		/// <summary>
-		/// Initializes the layer with the given neuron count and batch size
+		/// Uninitialized layer (for the derived classes)
 		/// </summary>
-		/// <param name="neuron_count">Number of neurons in the layer</param>
-		/// <param name="batch_size">The batch size for the layer</param>
-		Layer(const size_t neuron_count, const size_t batch_size);
+		Layer();
 
 		/// <summary>
-		/// Initializes the layer with the given neuron count, batch size and activation function
+		/// Returns the size of the data of matrix in bytes (0 if it is not allocated)
 		/// </summary>
-		/// <param name="neuron_count">Neuron count of this layer</param>
-		/// <param name="batch_size">Batch size of this layer</param>
-		/// <param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
-		Layer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count);
+		template <typename T>
+		[[nodiscard]] static size_t get_bytes(const std::unique_ptr<Matrix<T>>& matrix)
+		{
+			return matrix == nullptr ? 0 : matrix->get_rows() * matrix->get_cols() * sizeof(T);
+		}
 
 		/// <summary>
-		/// Initializes the layer with the given neuron count, batch size and activation function
+		/// Returns the size of the data of a shared matrix in bytes (counted by every layer sharing it)
 		/// </summary>
-		/// <param name="neuron_count">Neuron count of this layer</param>
-		/// <param name="batch_size">Batch size of this layer</param>
-		/// <param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
-		/// <param name="activation_function">Activation function for this layer</param>
-		Layer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count, std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
+		template <typename T>
+		[[nodiscard]] static size_t get_bytes(const std::shared_ptr<Matrix<T>>& matrix)
+		{
+			return matrix == nullptr ? 0 : matrix->get_rows() * matrix->get_cols() * sizeof(T);
+		}
 
+	public:
 		/// <summary>
 		/// Deletes the copy constructor
 		/// </summary>
@@ -106,7 +128,7 @@ namespace nn
 		/// <summary>
 		/// Destructor
 		/// </summary>
-		~Layer();
+		virtual ~Layer();
 
 		/// <summary>
 		/// Deletes the assignment operator
@@ -114,37 +136,7 @@ namespace nn
 		Layer& operator=(const Layer& other) = delete;
 
 		/// <summary>
-		/// Initializes the layer with the given neuron count and batch size
-		/// </summary>
-		/// <param name="neuron_count">Number of neurons in the layer</param>
-		/// <param name="batch_size">The batch size for the layer</param>
-		void initialize(const size_t neuron_count, const size_t batch_size);
-
-		/// <summary>
-		/// Initializes the layer with the given neuron count and batch size
-		/// </summary>
-		/// <param name="neuron_count">Number of neurons in the layer</param>
-		/// <param name="batch_size">The batch size for the layer</param>
-		/// <param name="previous_layer_neuron_count">Neuron count of previous layer</param>
-		void initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count);
-
-		/// <summary>
-		/// Initializes the layer with the given neuron count, batch size and activation function
-		/// </summary>
-		/// <param name="neuron_count">Number of neurons in the layer</param>
-		/// <param name="batch_size">The batch size for the layer</param>
-		///	<param name="previous_layer_neuron_count">Neuron count of the previous layer</param>
-		/// <param name="activation_function">Activation function for this layer</param>
-		void initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count, std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
-
-		/// <summary>
-		/// Sets the activation function for this layer
-		/// </summary>
-		/// <param name="activation_function">Activation function for this layer</param>
-		void set_activation_function(std::unique_ptr<nn::activation_functions::ActivationFunction> activation_function);
-
-		/// <summary>
-		/// Sets the biases matrix of this layer (does not copy, takes ownership)
+		/// Sets the activations matrix of this layer (does not copy, takes ownership)
 		/// </summary>
 		/// <param name="activations">Activations matrix to set in this layer</param>
 		void set_activations(std::unique_ptr<nn::Matrix<float>> activations);
@@ -155,36 +147,6 @@ namespace nn
 		/// <param name="activations">Activations matrix to set in this layer</param>
 		void set_activations(const Matrix<float>& activations);
 
-		/// <summary>
-		/// Sets the weights matrix of this layer (does not copy, takes ownership)
-		/// </summary>
-		/// <param name="weights">Weights matrix to set in this layer</param>
-		void set_weights(std::unique_ptr<nn::Matrix<float>> weights);
-
-		/// <summary>
-		/// Sets the weights matrix of this layer (copies)
-		/// </summary>
-		/// <param name="weights">Weights matrix to set in this layer</param>
-		void set_weights(const Matrix<float>& weights);
-
-		/// <summary>
-		/// Sets the biases matrix of this layer (does not copy, takes ownership)
-		/// </summary>
-		/// <param name="biases">Biases matrix to set in this layer</param>
-		void set_biases(std::unique_ptr<nn::Matrix<float>> biases);
-
-		/// <summary>
-		/// Sets the biases matrix of this layer (copies)
-		/// </summary>
-		/// <param name="biases">Biases matrix to set in this layer</param>
-		void set_biases(const Matrix<float>& biases);
-
-		/// <summary>
-		/// Resets the batch size of this layer and re-initializes the affected matrices
-		/// </summary>
-		/// <param name="batch_size"></param>
-		void change_batch_size(const size_t batch_size);
-
 		/// <summary>
 		/// Returns the neuron count of this layer
 		/// </summary>
@@ -193,83 +155,95 @@ namespace nn
 		/// <summary>
 		/// Returns the batch size of this layer
 		/// </summary>
-		/// <returns></returns>
 		[[nodiscard]] size_t get_batch_size() const;
 
 		/// <summary>
-		/// Returns the activation function of this layer
+		/// Returns the activation matrix of this layer (a layer that passes its input through may return the
+		///	activations of the previous layer)
 		/// </summary>
-		[[nodiscard]] const nn::activation_functions::ActivationFunction* get_activation_function() const;
+		[[nodiscard]] virtual const Matrix<float>& get_activations() const;
 
 		/// <summary>
-		/// Returns the activation matrix of this layer
+		/// Returns the delta activations matrix of this layer
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_activations() const;
+		[[nodiscard]] const Matrix<float>& get_delta_activations() const;
 
 		/// <summary>
-		/// Returns the sums matrix of this layer
+		/// Runs forward propagation on this layer
 		/// </summary>
-		/// <returns></returns>
-		[[nodiscard]] const Matrix<float>& get_sums() const;
+		/// <param name="previous_layer">Previous Layer</param>
+		virtual void feed_forward(const Layer& previous_layer) = 0;
 
 		/// <summary>
-		/// Returns the weights matrix of this layer
+		/// Runs back propagation on this layer: takes the delta activations from the next layer
+		/// (next_layer.propagate_delta_to_previous_layer) and calculates the gradients of the parameters.
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_weights() const;
+		/// <param name="next_layer">Next layer</param>
+		/// <param name="previous_layer">Previous Layer</param>
+		virtual void back_propagate(const Layer& next_layer, const Layer& previous_layer) = 0;
 
 		/// <summary>
-		/// Returns the biases matrix of this layer
+		/// Runs back propagation on this layer with the given expected activations (output layer)
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_biases() const;
+		/// <param name="expected_activations">Expected output of the network</param>
+		/// <param name="previous_layer">Previous Layer</param>
+		virtual void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) = 0;
 
 		/// <summary>
-		/// Returns the delta activations matrix of this layer
+		/// Calculates the delta activations of the previous layer from this (back propagated) layer
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_delta_activations() const;
+		/// <param name="previous_delta_activations">Delta activations of the previous layer</param>
+		virtual void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const = 0;
 
 		/// <summary>
-		/// Returns the delta sums matrix of this layer
+		/// Updates the parameters of this layer (value = value - learning_rate * gradient for every parameter)
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_delta_sums() const;
+		virtual void update_weights_and_biases(const float learning_rate);
 
 		/// <summary>
-		/// Returns the delta weights matrix of this layer
+		/// Returns the trainable parameters of this layer with their gradients (none by default)
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_delta_weights() const;
+		[[nodiscard]] virtual std::vector<Parameter> get_parameters();
 
 		/// <summary>
-		/// Returns the delta biases matrix of this layer
+		/// Returns the memory held by this layer at its batch size
 		/// </summary>
-		[[nodiscard]] const Matrix<float>& get_delta_biases() const;
+		[[nodiscard]] virtual MemoryRequirements get_memory_requirements() const = 0;
 
 		/// <summary>
-		/// Resets the layer to uninitialized state
+		/// Sets the precision of the weights used by forward propagation. Layers without reduced precision kernels
+		///	ignore it and compute in float.
 		/// </summary>
-		void reset();
+		/// <param name="precision">Precision of the weights</param>
+		virtual void set_weight_precision(const nn::Precision precision);
 
 		/// <summary>
-		/// Runs forward propagation on this layer
+		/// Frees the matrices feed_forward writes for back propagation (the activation bytes of get_memory_requirements),
+		///	the next feed_forward allocates them again. Gradient checkpointing releases the layers it recomputes. Layers
+		///	that cannot give their activations back keep them.
 		/// </summary>
-		/// <param name="previous_layer">Previous Layer</param>
-		void feed_forward(const Layer& previous_layer);
+		virtual void release_activations();
 
 		/// <summary>
-		/// Runs back propagation on this layer
+		/// Can feed_forward run again on the same input without changing the result or the state of the layer (e.g.
+		///	no running statistics or random numbers)? Only such layers are recomputed by gradient checkpointing.
 		/// </summary>
-		/// <param name="next_layer">Next layer</param>
-		/// <param name="previous_layer">Previous Layer</param>
-		void back_propagate(const Layer& next_layer, const Layer& previous_layer);
+		[[nodiscard]] virtual bool is_recomputable() const;
 
 		/// <summary>
-		/// Runs back propagation on this layer with the given expected activations
+		/// Sets how back propagation stores the gradients: gradient = scale * batch mean, added to the gradient if
+		///	accumulate. A large batch is trained as micro batches under the memory of one: the first overwrites, the
+		///	others accumulate in place, all with scale 1 / micro batch count, then one update steps with the mean.
 		/// </summary>
-		/// <param name="expected_activations">Expected output of the network</param>
-		/// <param name="previous_layer">Previous Layer</param>
-		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer);
+		/// <param name="accumulate">Add to the current gradients</param>
+		/// <param name="scale">Weight of the next batches</param>
+		void set_gradient_accumulation(const bool accumulate, const float scale = 1.0f);
 
 		/// <summary>
-		/// Updates the weights and biases of this layer
+		/// Switches between training and inference behavior (e.g. batch or running statistics). Layers that behave
+		///	the same in both ignore it.
 		/// </summary>
-		void update_weights_and_biases(const float learning_rate);
+		/// <param name="training">True while the network trains</param>
+		virtual void set_training(const bool training);
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,247 @@
+// File: include/NeuralNetwork/MatrixView.h
+// Purpose: Header file for MatrixView, a non-owning window into row major matrix data, and the kernels on views.
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <stdexcept> // std::runtime_error
+#include <type_traits> // std::enable_if_t, std::is_same_v
+
+namespace nn
+{
+	/// <summary>
+	/// Non-owning view of a rows x cols block of row major data, stride elements between the starts of two rows.
+	///	Batch slices (row ranges), column windows and blocks of a matrix are views of the same data, so they are
+	///	passed to the kernels without copying. MatrixView&lt;const T&gt; is the read only view.
+	/// </summary>
+	/// <typeparam name="T">Type of data in the matrix (const for a read only view).</typeparam>
+	template <typename T>
+	class MatrixView
+	{
+	private:
+		/// <summary>
+		/// First element of the view (not owned).
+		/// </summary>
+		T* data_;
+
+		/// <summary>
+		/// Rows in the view.
+		/// </summary>
+		size_t rows_;
+
+		/// <summary>
+		/// Columns in the view.
+		/// </summary>
+		size_t cols_;
+
+		/// <summary>
+		/// Elements between the starts of two rows (at least cols).
+		/// </summary>
+		size_t stride_;
+
+	public:
+		/// <summary>
+		/// Empty view.
+		/// </summary>
+		MatrixView();
+
+		/// <summary>
+		/// View of rows x cols contiguous elements.
+		/// </summary>
+		MatrixView(T* data, size_t rows, size_t cols);
+
+		/// <summary>
+		/// View of rows x cols elements with stride elements between the starts of two rows.
+		/// </summary>
+		MatrixView(T* data, size_t rows, size_t cols, size_t stride);
+
+		/// <summary>
+		/// Read only view of a writable view.
+		/// </summary>
+		template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+		MatrixView(const MatrixView<U>& other);
+
+		/// <summary>
+		/// Returns the element at row, col.
+		/// </summary>
+		[[nodiscard]] T& operator()(size_t row, size_t col) const;
+
+		/// <summary>
+		/// Returns the first element.
+		/// </summary>
+		[[nodiscard]] T* get_data() const;
+
+		/// <summary>
+		/// Returns the number of rows in the view.
+		/// </summary>
+		[[nodiscard]] size_t get_rows() const;
+
+		/// <summary>
+		/// Returns the number of columns in the view.
+		/// </summary>
+		[[nodiscard]] size_t get_cols() const;
+
+		/// <summary>
+		/// Returns the number of elements between the starts of two rows.
+		/// </summary>
+		[[nodiscard]] size_t get_stride() const;
+
+		/// <summary>
+		/// Are the rows stored back to back (stride == cols)?
+		/// </summary>
+		[[nodiscard]] bool is_contiguous() const;
+
+		/// <summary>
+		/// Returns the rows x cols block starting at row, col.
+		/// </summary>
+		[[nodiscard]] MatrixView<T> block(size_t row, size_t col, size_t rows, size_t cols) const;
+
+		/// <summary>
+		/// Returns count rows starting at first.
+		/// </summary>
+		[[nodiscard]] MatrixView<T> slice_rows(size_t first, size_t count) const;
+
+		/// <summary>
+		/// Returns count columns starting at first (e.g. a window of the samples of a batch).
+		/// </summary>
+		[[nodiscard]] MatrixView<T> slice_cols(size_t first, size_t count) const;
+	};
+
+	/// <summary>
+	/// c (m x n) = a (m x k) * b (k x n)
+	/// </summary>
+	void multiply(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c);
+
+	/// <summary>
+	/// c (m x n) = alpha * transpose(a) (a is k x m) * b (k x n) + beta * c, without materializing the transpose.
+	/// </summary>
+	void multiply_transposed_a(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c, float alpha = 1.0f,
+		float beta = 0.0f);
+
+	/// <summary>
+	/// c (m x n) = alpha * a (m x k) * transpose(b) (b is n x k) + beta * c, without materializing the transpose.
+	///	beta = 0 overwrites c, beta = 1 accumulates into it (gradient accumulation).
+	/// </summary>
+	void multiply_transposed_b(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c, float alpha = 1.0f,
+		float beta = 0.0f);
+
+	/// <summary>
+	/// result(i, 0) = alpha * sum of row i of a + beta * result(i, 0)
+	/// </summary>
+	void sum_rows(MatrixView<const float> a, MatrixView<float> result, float alpha = 1.0f, float beta = 0.0f);
+
+	/// <summary>
+	/// c = alpha * a * transpose(b) + beta * c and sums(i, 0) = alpha * sum of row i of a + beta * sums(i, 0) in one sweep
+	///	over a (the weight and bias gradients of back propagation). With a BLAS backend the product goes through the
+	///	library and the sums are a second pass.
+	/// </summary>
+	void multiply_transposed_b_sum_rows(MatrixView<const float> a, MatrixView<const float> b, MatrixView<float> c,
+		MatrixView<float> sums, float alpha = 1.0f, float beta = 0.0f);
+
+	/// <summary>
+	/// x = x * y element wise
+	/// </summary>
+	void hadamard_product(MatrixView<float> x, MatrixView<const float> y);
+
+	/// <summary>
+	/// x = x + scale * y
+	/// </summary>
+	void add_scaled(MatrixView<float> x, MatrixView<const float> y, float scale);
+
+	/// <summary>
+	/// destination = source
+	/// </summary>
+	void copy(MatrixView<const float> source, MatrixView<float> destination);
+}
+
+#pragma region Template Implementation
+
+template <typename T>
+nn::MatrixView<T>::MatrixView()
+	: data_(nullptr), rows_(0), cols_(0), stride_(0)
+{
+}
+
+template <typename T>
+nn::MatrixView<T>::MatrixView(T* data, const size_t rows, const size_t cols)
+	: data_(data), rows_(rows), cols_(cols), stride_(cols)
+{
+}
+
+template <typename T>
+nn::MatrixView<T>::MatrixView(T* data, const size_t rows, const size_t cols, const size_t stride)
+	: data_(data), rows_(rows), cols_(cols), stride_(stride)
+{
+	if (stride < cols)
+	{
+		throw std::runtime_error("Stride of a matrix view is smaller than its columns.");
+	}
+}
+
+template <typename T>
+template <typename U, typename>
+nn::MatrixView<T>::MatrixView(const MatrixView<U>& other)
+	: data_(other.get_data()), rows_(other.get_rows()), cols_(other.get_cols()), stride_(other.get_stride())
+{
+}
+
+template <typename T>
+T& nn::MatrixView<T>::operator()(const size_t row, const size_t col) const
+{
+	return this->data_[row * this->stride_ + col];
+}
+
+template <typename T>
+T* nn::MatrixView<T>::get_data() const
+{
+	return this->data_;
+}
+
+template <typename T>
+size_t nn::MatrixView<T>::get_rows() const
+{
+	return this->rows_;
+}
+
+template <typename T>
+size_t nn::MatrixView<T>::get_cols() const
+{
+	return this->cols_;
+}
+
+template <typename T>
+size_t nn::MatrixView<T>::get_stride() const
+{
+	return this->stride_;
+}
+
+template <typename T>
+bool nn::MatrixView<T>::is_contiguous() const
+{
+	return this->stride_ == this->cols_;
+}
+
+template <typename T>
+nn::MatrixView<T> nn::MatrixView<T>::block(const size_t row, const size_t col, const size_t rows, const size_t cols) const
+{
+	if (row + rows > this->rows_ || col + cols > this->cols_)
+	{
+		throw std::runtime_error("Block is outside of the matrix view.");
+	}
+
+	return MatrixView<T>(this->data_ + row * this->stride_ + col, rows, cols, this->stride_);
+}
+
+template <typename T>
+nn::MatrixView<T> nn::MatrixView<T>::slice_rows(const size_t first, const size_t count) const
+{
+	return this->block(first, 0, count, this->cols_);
+}
+
+template <typename T>
+nn::MatrixView<T> nn::MatrixView<T>::slice_cols(const size_t first, const size_t count) const
+{
+	return this->block(0, first, this->rows_, count);
+}
+
+#pragma endregion
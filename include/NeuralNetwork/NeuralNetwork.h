@@ -6,13 +6,52 @@
 #include <memory> // std::unique_ptr
 #include <list> // std::list
 #include <string> // std::string
+#include <vector> // std::vector
 
 #include "NeuralNetwork/Layer.h" // nn::Layer
 #include "NeuralNetwork/DataSet.h" // nn::TrainingSet
+#include "NeuralNetwork/Pipeline.h" // nn::pipeline::Report, nn::pipeline::Schedule
+#include "NeuralNetwork/Hogwild.h" // nn::hogwild::Report
+#include "NeuralNetwork/Distributed.h" // nn::distributed::Communicator, nn::distributed::Report
+#include "NeuralNetwork/Numa.h" // nn::numa::NodeReplicas
 
 
 namespace nn
 {
+	/// <summary>
+	/// Layers that keep their activations through back propagation with gradient checkpointing, and the memory and
+	///	compute it trades (see NeuralNetwork::plan_checkpoints).
+	/// </summary>
+	struct CheckpointPlan
+	{
+		/// <summary>
+		/// Does layer i keep its activations (checkpoint)? The layers between two checkpoints are released after
+		///	feed_forward and recomputed from the first checkpoint when back propagation reaches them.
+		/// </summary>
+		std::vector<bool> checkpoints;
+
+		/// <summary>
+		/// Activation bytes of all the layers (held through a step without checkpointing).
+		/// </summary>
+		size_t activation_bytes = 0;
+
+		/// <summary>
+		/// Activation bytes held at most during a step with checkpointing: the checkpoints, the segment being
+		///	recomputed and the layer after it (or the last segment, which is never released).
+		/// </summary>
+		size_t peak_activation_bytes = 0;
+
+		/// <summary>
+		/// Layer feed_forward calls a step repeats (the forward pass runs layer count - 1 of them).
+		/// </summary>
+		size_t recomputed_layers = 0;
+
+		/// <summary>
+		/// Returns the number of checkpoints.
+		/// </summary>
+		[[nodiscard]] size_t get_checkpoint_count() const;
+	};
+
 	class NeuralNetwork
 	{
 	private:
@@ -36,6 +75,69 @@ namespace nn
 		/// </summary>
 		float learning_rate_;
 
+		/// <summary>
+		/// Do the training steps after the first one run inside a nn::memory::NoAllocationGuard?
+		/// </summary>
+		bool allocation_guard_;
+
+		/// <summary>
+		/// Has the first (warm up) training step since the guard was enabled run?
+		/// </summary>
+		bool warmed_up_;
+
+		/// <summary>
+		/// Number of batches whose gradients are accumulated before one update of the weights and biases.
+		/// </summary>
+		size_t accumulation_steps_;
+
+		/// <summary>
+		/// Recompute activations instead of keeping them all through back propagation?
+		/// </summary>
+		bool gradient_checkpointing_;
+
+		/// <summary>
+		/// Plan of gradient checkpointing (made when it is enabled).
+		/// </summary>
+		CheckpointPlan checkpoint_plan_;
+
+		/// <summary>
+		/// The layers in order and which of them are released (gradient checkpointing).
+		/// </summary>
+		std::vector<nn::Layer*> checkpoint_layers_;
+		std::vector<bool> released_layers_;
+
+		/// <summary>
+		/// Index of the last checkpoint: the layers after it are back propagated first and never released.
+		/// </summary>
+		size_t last_checkpoint_;
+
+		/// <summary>
+		/// Is the layer at index released once the next layer (feed_forward) or the previous layer (back_propagate)
+		///	no longer needs it?
+		/// </summary>
+		[[nodiscard]] bool is_released_after_use(size_t index) const;
+
+		/// <summary>
+		/// Updates the weights and biases of every layer with the given learning rate.
+		/// </summary>
+		void update_weights_and_biases(const float learning_rate);
+
+		/// <summary>
+		/// Runs feed_forward on every layer after the input layer, releasing the layers between checkpoints.
+		/// </summary>
+		void feed_forward_layers();
+
+		/// <summary>
+		/// Recomputes a released layer and the released layers before it from the previous checkpoint.
+		/// </summary>
+		void recompute_layer(size_t index);
+
+		/// <summary>
+		/// Rounds the float weights of the dense layers into their reduced precision copies again, after something
+		///	other than update_weights_and_biases changed them.
+		/// </summary>
+		void refresh_weight_precision();
+
 	public:
 		/// <summary>
 		/// Default constructor.
@@ -65,6 +167,99 @@ namespace nn
 		/// <param name="batch_size"></param>
 		void set_batch_size(const size_t batch_size);
 
+		/// <summary>
+		/// Sets the precision of the weights used by forward propagation for every layer (see Layer::set_weight_precision).
+		/// </summary>
+		void set_weight_precision(const nn::Precision precision);
+
+		/// <summary>
+		/// Switches every layer between training and inference behavior (see Layer::set_training). train_one_epoch
+		///	switches to training for the epoch and back to inference after it.
+		/// </summary>
+		void set_training(const bool training);
+
+		/// <summary>
+		/// Sets the number of batches (micro batches) train_one_epoch accumulates the gradients of before one update,
+		///	for an effective batch of steps * batch size with the memory of one batch. The gradients are accumulated in
+		///	place and the update uses their mean (see Layer::set_gradient_accumulation). 1 updates after every batch.
+		/// </summary>
+		void set_accumulation_steps(const size_t steps);
+
+		/// <summary>
+		/// Returns the number of batches accumulated before one update.
+		/// </summary>
+		[[nodiscard]] size_t get_accumulation_steps() const;
+
+		/// <summary>
+		/// Keeps the activations of the checkpoint layers of plan_checkpoints only: feed_forward releases the others
+		///	(Layer::release_activations) and back_propagate recomputes them one segment at a time, which trades about
+		///	one extra forward pass for activation memory of order sqrt(layer count). Enable it after adding the layers.
+		///	The recomputed layers allocate their matrices again in every step, so it does not combine with the allocation
+		///	guard (std::logic_error when the guard is on).
+		/// </summary>
+		void set_gradient_checkpointing(const bool enabled);
+
+		/// <summary>
+		/// Plans the checkpoints for the current layers: about sqrt(layer count) segments of similar activation bytes
+		///	(from Layer::get_memory_requirements), the input layer, every layer that is not recomputable and the layer
+		///	before it being checkpoints.
+		/// </summary>
+		[[nodiscard]] nn::CheckpointPlan plan_checkpoints() const;
+
+		/// <summary>
+		/// Returns the plan used by gradient checkpointing (empty while it is disabled).
+		/// </summary>
+		[[nodiscard]] const nn::CheckpointPlan& get_checkpoint_plan() const;
+
+		/// <summary>
+		/// Splits the layers into stage_count contiguous pipeline stages of similar work (see nn::pipeline::plan_stages).
+		/// </summary>
+		/// <returns>Index of the first layer of every stage</returns>
+		[[nodiscard]] std::vector<size_t> plan_pipeline_stages(const size_t stage_count) const;
+
+		/// <summary>
+		/// Trains one epoch with the layers split into stage_count stages (plan_pipeline_stages) that run on their own
+		///	threads: every step streams get_accumulation_steps() batches through the stages as micro batches and updates
+		///	once, so the weights end up as with train_one_epoch. Deep networks keep more cores busy than the layers of one
+		///	batch could; more micro batches per step shrink the bubble at the start and end of every step.
+		///	Does not combine with gradient checkpointing (std::logic_error).
+		/// </summary>
+		/// <returns>Throughput and idle time of the stages</returns>
+		nn::pipeline::Report train_pipelined(const size_t stage_count,
+		                                     const nn::pipeline::Schedule schedule = nn::pipeline::Schedule::OneForwardOneBackward);
+
+		/// <summary>
+		/// Trains one epoch on thread_count threads that share the weights without locks (Hogwild, see
+		///	nn::hogwild::train_epoch): every thread trains its own batches and updates the weights after each of them,
+		///	reading weights the other threads are updating. For small or sparse models, where synchronizing the threads
+		///	would cost more than a batch, this trades a little staleness of the weights for throughput. Every batch is
+		///	an update, so the accumulation steps must be 1 (std::logic_error otherwise).
+		/// </summary>
+		/// <returns>Throughput and batches per thread</returns>
+		nn::hogwild::Report train_hogwild(const size_t thread_count);
+
+		/// <summary>
+		/// Trains one epoch as one rank of a data parallel job (see nn::distributed::train_epoch): every process owns
+		///	a replica and a shard of the data (the data set of this network) and connects to the others through the
+		///	communicator. The parameters of rank 0 are broadcast first, then every step updates all replicas with the
+		///	mean gradients of the ranks, all-reduced around the ring while back propagation goes on. The accumulation
+		///	steps must be 1 and gradient checkpointing must be disabled (std::logic_error otherwise).
+		/// </summary>
+		/// <returns>Throughput, traffic and hidden share of the communication of this rank</returns>
+		nn::distributed::Report train_distributed(nn::distributed::Communicator& communicator);
+
+		/// <summary>
+		/// Copies the weights to every NUMA node for inference on threads of all of them (see nn::numa::NodeReplicas).
+		///	The copies do not follow later training.
+		/// </summary>
+		[[nodiscard]] nn::numa::NodeReplicas create_node_replicas();
+
+		/// <summary>
+		/// Makes every training step after the next one (the warm up) throw std::logic_error if it allocates a matrix
+		/// (see nn::memory::NoAllocationGuard). Does not combine with gradient checkpointing (std::logic_error).
+		/// </summary>
+		void set_allocation_guard(const bool enabled);
+
 		/// <summary>
 		/// Sets the data set of the neural network. (Takes ownership)
 		/// </summary>
@@ -142,6 +337,18 @@ namespace nn
 		/// <returns>Output matrix</returns>
 		[[nodiscard]] const nn::Matrix<float>& get_output() const;
 
+		/// <summary>
+		/// Returns the memory held by all the layers (sum of Layer::get_memory_requirements).
+		/// </summary>
+		[[nodiscard]] nn::MemoryRequirements get_memory_requirements() const;
+
+		/// <summary>
+		/// Folds every BatchNorm that follows a DenseLayer with a linear activation into the weights and biases of that
+		///	layer and removes it (export step for inference, see BatchNorm::fold_into).
+		/// </summary>
+		/// <returns>Number of folded layers</returns>
+		size_t fold_batch_norms();
+
 		/// <summary>
 		/// Gets the data set of the neural network.
 		/// </summary>
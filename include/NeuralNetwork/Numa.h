@@ -0,0 +1,172 @@
+// File: include/NeuralNetwork/Numa.h
+// Purpose: Header file for NUMA placement: the nodes of the machine, thread pinning, memory placement and per node
+// replicas of the weights for inference.
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <vector> // std::vector
+
+namespace nn
+{
+	class Layer;
+	class DenseLayer;
+	template <typename T>
+	class Matrix;
+}
+
+namespace nn::numa
+{
+	/// <summary>
+	/// Returned for a node that is not known (memory not placed yet, or no NUMA support).
+	/// </summary>
+	constexpr size_t unknown_node = std::numeric_limits<size_t>::max();
+
+	/// <summary>
+	/// The CPUs of every NUMA node.
+	/// </summary>
+	struct Topology
+	{
+		/// <summary>
+		/// CPUs of every node, in node order.
+		/// </summary>
+		std::vector<std::vector<size_t>> node_cpus;
+
+		/// <summary>
+		/// Returns the number of nodes.
+		/// </summary>
+		[[nodiscard]] size_t get_node_count() const;
+
+		/// <summary>
+		/// Returns the node of a CPU (node 0 for a CPU that is not listed).
+		/// </summary>
+		[[nodiscard]] size_t get_node_of_cpu(size_t cpu) const;
+	};
+
+	/// <summary>
+	/// Parses a Linux CPU list such as "0-3,8,10-11".
+	/// </summary>
+	[[nodiscard]] std::vector<size_t> parse_cpu_list(const std::string& list);
+
+	/// <summary>
+	/// Returns the nodes of this machine (read once, from /sys/devices/system/node on Linux; elsewhere, or without
+	///	NUMA, one node with all the CPUs).
+	/// </summary>
+	[[nodiscard]] const Topology& get_topology();
+
+	/// <summary>
+	/// Where the worker threads of Hogwild and pipeline training run.
+	/// </summary>
+	enum class Pinning
+	{
+		/// <summary>
+		/// Wherever the operating system schedules them.
+		/// </summary>
+		None,
+
+		/// <summary>
+		/// Worker i on the i-th CPU, filling node 0 first: the workers share the caches and memory of as few nodes
+		///	as possible.
+		/// </summary>
+		Compact,
+
+		/// <summary>
+		/// Worker i on node i % nodes: the workers use the memory bandwidth of every node.
+		/// </summary>
+		Scatter
+	};
+
+	/// <summary>
+	/// Returns the pinning of the worker threads: set_pinning, or NN_PIN_THREADS (none, compact or scatter) until then.
+	/// </summary>
+	[[nodiscard]] Pinning get_pinning();
+
+	/// <summary>
+	/// Sets the pinning of the worker threads started from now on.
+	/// </summary>
+	void set_pinning(Pinning pinning);
+
+	/// <summary>
+	/// Returns the CPU of worker thread worker_index under pinning (pinning must not be None).
+	/// </summary>
+	[[nodiscard]] size_t get_worker_cpu(size_t worker_index, Pinning pinning);
+
+	/// <summary>
+	/// Pins the calling thread to worker_index's CPU under get_pinning(); nothing with Pinning::None.
+	/// </summary>
+	void pin_worker(size_t worker_index);
+
+	/// <summary>
+	/// Runs the calling thread on the given CPUs only.
+	/// </summary>
+	/// <returns>False where thread affinity is not supported</returns>
+	bool pin_current_thread(const std::vector<size_t>& cpus);
+
+	/// <summary>
+	/// Returns the node the calling thread runs on now.
+	/// </summary>
+	[[nodiscard]] size_t get_current_node();
+
+	/// <summary>
+	/// Moves the whole pages of [data, data + bytes) to node and keeps them there. Linux places a page on the node of
+	///	the thread that first writes it (first touch), so memory written by the thread that uses it needs no move;
+	///	this is for memory written elsewhere. Pages only partly in the range are left alone, they hold other data.
+	/// </summary>
+	/// <returns>False where memory placement is not supported</returns>
+	bool move_to_node(void* data, size_t bytes, size_t node);
+
+	/// <summary>
+	/// Returns the node of the page at data (unknown_node if it was never written or NUMA is not supported).
+	/// </summary>
+	[[nodiscard]] size_t get_memory_node(const void* data);
+
+	/// <summary>
+	/// One copy of the weights of a network per node, for inference on threads of every node: each copy is allocated
+	///	and written by a thread pinned to its node, so its pages are local to the threads of that node, which read
+	///	them without crossing the interconnect. The copies are read-only; only dense layers are supported
+	///	(std::runtime_error otherwise).
+	/// </summary>
+	class NodeReplicas
+	{
+	private:
+		/// <summary>
+		/// The layers of every node, all with their own weights and biases.
+		/// </summary>
+		std::vector<std::vector<std::unique_ptr<nn::DenseLayer>>> nodes_;
+
+	public:
+		/// <summary>
+		/// Copies the layers to every node.
+		/// </summary>
+		explicit NodeReplicas(const std::vector<nn::Layer*>& layers);
+
+		NodeReplicas(NodeReplicas&&) noexcept;
+		NodeReplicas& operator=(NodeReplicas&&) noexcept;
+		~NodeReplicas();
+
+		/// <summary>
+		/// Returns the number of copies (one per node).
+		/// </summary>
+		[[nodiscard]] size_t get_node_count() const;
+
+		/// <summary>
+		/// Returns the copy of the layers on node.
+		/// </summary>
+		[[nodiscard]] const std::vector<std::unique_ptr<nn::DenseLayer>>& get_layers(size_t node) const;
+
+		/// <summary>
+		/// Returns layers for the calling thread: replicas (DenseLayer::create_replica) of the copy of the node the
+		///	thread runs on, with the activations of the thread. Call it on the thread that uses them, after pinning it.
+		/// </summary>
+		[[nodiscard]] std::vector<std::unique_ptr<nn::DenseLayer>> create_thread_layers() const;
+	};
+
+	/// <summary>
+	/// Feeds input forward through the layers (the first is the input layer).
+	/// </summary>
+	/// <returns>Activations of the last layer</returns>
+	const nn::Matrix<float>& feed_forward(const std::vector<std::unique_ptr<nn::DenseLayer>>& layers, const nn::Matrix<float>& input);
+}
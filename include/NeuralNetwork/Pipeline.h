@@ -0,0 +1,215 @@
+// File: include/NeuralNetwork/Pipeline.h
+// Purpose: Header file for pipeline parallel training: the stages, the queues between them and the report.
+
+#pragma once
+
+#include <atomic> // std::atomic
+#include <cstddef> // size_t
+#include <vector> // std::vector
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+#include "NeuralNetwork/DataSet.h" // nn::DataSet
+
+namespace nn::pipeline
+{
+	/// <summary>
+	/// Bounded lock-free queue between exactly one producer thread and one consumer thread (a ring buffer). The
+	///	producer only writes the tail and the consumer only writes the head, each on its own cache line, and each
+	///	side keeps a copy of the other index so it reads the shared one only when the queue looks full or empty.
+	/// </summary>
+	template <typename T>
+	class SpscQueue
+	{
+	private:
+		/// <summary>
+		/// Bytes of a cache line: the indices on different lines do not invalidate each other.
+		/// </summary>
+		static constexpr size_t cache_line = 64;
+
+		std::vector<T> slots_;
+		size_t mask_;
+
+		/// <summary>
+		/// Next slot to read (written by the consumer) and the consumer's copy of the tail.
+		/// </summary>
+		alignas(cache_line) std::atomic<size_t> head_{ 0 };
+		size_t cached_tail_ = 0;
+
+		/// <summary>
+		/// Next slot to write (written by the producer) and the producer's copy of the head.
+		/// </summary>
+		alignas(cache_line) std::atomic<size_t> tail_{ 0 };
+		size_t cached_head_ = 0;
+
+		static size_t round_up_to_power_of_two(const size_t capacity)
+		{
+			size_t size = 1;
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+			return size;
+		}
+
+	public:
+		/// <summary>
+		/// Queue of at least capacity items (rounded up to a power of two).
+		/// </summary>
+		explicit SpscQueue(const size_t capacity)
+			: slots_(round_up_to_power_of_two(capacity)), mask_(slots_.size() - 1)
+		{
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/// <summary>
+		/// Returns the number of items the queue holds at most.
+		/// </summary>
+		[[nodiscard]] size_t get_capacity() const
+		{
+			return this->slots_.size();
+		}
+
+		/// <summary>
+		/// Appends the item unless the queue is full (producer only). Everything the producer wrote before is
+		///	visible to the consumer once it pops the item.
+		/// </summary>
+		/// <returns>False if the queue is full</returns>
+		bool try_push(const T& item)
+		{
+			const size_t tail = this->tail_.load(std::memory_order_relaxed);
+			if (tail - this->cached_head_ == this->slots_.size())
+			{
+				this->cached_head_ = this->head_.load(std::memory_order_acquire);
+				if (tail - this->cached_head_ == this->slots_.size())
+				{
+					return false;
+				}
+			}
+			this->slots_[tail & this->mask_] = item;
+			this->tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// <summary>
+		/// Removes the oldest item unless the queue is empty (consumer only).
+		/// </summary>
+		/// <returns>False if the queue is empty</returns>
+		bool try_pop(T& item)
+		{
+			const size_t head = this->head_.load(std::memory_order_relaxed);
+			if (head == this->cached_tail_)
+			{
+				this->cached_tail_ = this->tail_.load(std::memory_order_acquire);
+				if (head == this->cached_tail_)
+				{
+					return false;
+				}
+			}
+			item = this->slots_[head & this->mask_];
+			this->head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+	};
+
+	/// <summary>
+	/// How a thread waits for a SpscQueue: it yields for the first attempts, then sleeps between them, so when there
+	///	are more threads than cores a waiting thread gives its time slices to the thread it waits for.
+	/// </summary>
+	class Backoff
+	{
+	private:
+		size_t attempts_ = 0;
+
+	public:
+		/// <summary>
+		/// Waits a little longer than the previous call (up to a short sleep).
+		/// </summary>
+		void wait();
+	};
+
+	/// <summary>
+	/// Order in which a stage runs the forward and backward passes of the micro batches of a step. Both flush the
+	///	pipeline at the end of every step, so they give the same gradients as sequential gradient accumulation.
+	/// </summary>
+	enum class Schedule
+	{
+		/// <summary>
+		/// All forward passes, then all backward passes (GPipe): every stage holds the inputs of every micro batch.
+		/// </summary>
+		GPipe,
+
+		/// <summary>
+		/// One forward, one backward (1F1B, PipeDream-Flush): stage s starts the backward passes after
+		///	stage count - s forward passes, so at most that many micro batches are in flight in it.
+		/// </summary>
+		OneForwardOneBackward
+	};
+
+	/// <summary>
+	/// Measurements of one pipelined epoch.
+	/// </summary>
+	struct Report
+	{
+		/// <summary>
+		/// Index of the first layer of every stage (the input layer belongs to the first stage).
+		/// </summary>
+		std::vector<size_t> stage_first_layers;
+
+		/// <summary>
+		/// Micro batches of a step (the accumulation steps of the network).
+		/// </summary>
+		size_t micro_batches = 0;
+
+		/// <summary>
+		/// Samples trained.
+		/// </summary>
+		size_t samples = 0;
+
+		/// <summary>
+		/// Wall time of the epoch in seconds.
+		/// </summary>
+		double seconds = 0.0;
+
+		/// <summary>
+		/// Seconds every stage spent computing (forward, recomputation, backward and update), the rest of the
+		///	epoch it waited for its neighbours.
+		/// </summary>
+		std::vector<double> stage_busy_seconds;
+
+		/// <summary>
+		/// Returns the fraction of the stage time spent waiting: 1 - sum(busy) / (stages * seconds).
+		/// </summary>
+		[[nodiscard]] double get_bubble_fraction() const;
+
+		/// <summary>
+		/// Returns the bubble of a pipeline of equal stages: (stages - 1) / (micro batches + stages - 1).
+		/// </summary>
+		[[nodiscard]] double get_ideal_bubble_fraction() const;
+
+		/// <summary>
+		/// Returns the throughput in samples per second.
+		/// </summary>
+		[[nodiscard]] double get_samples_per_second() const;
+	};
+
+	/// <summary>
+	/// Splits the layers after the input layer into stage_count contiguous stages of similar work, estimated from
+	///	Layer::get_memory_requirements as the parameters times the batch size (the multiply-adds of a dense layer)
+	///	plus the activations. Throws std::runtime_error unless 1 <= stage_count < layer count.
+	/// </summary>
+	/// <returns>Index of the first layer of every stage (the first is 0)</returns>
+	[[nodiscard]] std::vector<size_t> plan_stages(const std::vector<nn::Layer*>& layers, size_t batch_size, size_t stage_count);
+
+	/// <summary>
+	/// Trains one epoch of data_set with one thread per stage (pinned by nn::numa::pin_worker). Every step feeds
+	///	micro_batches batches through the stages (SpscQueue of micro batch indices between neighbours, the
+	///	activations and deltas at the stage boundaries are copied into per micro batch buffers of the receiving stage)
+	///	and updates the weights once with the mean of their gradients, like NeuralNetwork::train_one_epoch with
+	///	accumulation. A stage keeps one micro batch in its layers and recomputes its forward pass from the buffered
+	///	input when it back propagates another one, so every layer must be recomputable (std::logic_error otherwise).
+	/// </summary>
+	nn::pipeline::Report train_epoch(const std::vector<nn::Layer*>& layers, nn::DataSet& data_set, float learning_rate,
+	                                 size_t micro_batches, const std::vector<size_t>& stage_first_layers, Schedule schedule);
+}
@@ -0,0 +1,110 @@
+// File: include/NeuralNetwork/Pool2D.h
+// Purpose: Header file for Pool2D class, a 2d max or average pooling layer.
+
+#pragma once
+
+#include <cstdint> // uint8_t
+#include <memory> // std::unique_ptr
+
+#include "NeuralNetwork/Layer.h" // nn::Layer
+
+namespace nn
+{
+	/// <summary>
+	/// What Pool2D takes from every window.
+	/// </summary>
+	enum class PoolingMode
+	{
+		/// <summary>
+		/// Largest value, the delta goes back to its position only.
+		/// </summary>
+		Max,
+
+		/// <summary>
+		/// Mean value, the delta is spread evenly over the window.
+		/// </summary>
+		Average
+	};
+
+	/// <summary>
+	/// 2d pooling layer, no weights. Uses the image layout of Conv2D: the activations of the previous layer are
+	///	channels x input_height x input_width images, one per column of the batch, and its activations are
+	///	channels x output_height x output_width images. Max pooling keeps the position of the maximum of every window
+	///	(one byte per output) so back propagation is a scatter of the delta instead of a search.
+	/// </summary>
+	class Pool2D : public Layer
+	{
+	private:
+		PoolingMode mode_;
+		size_t channels_;
+		size_t input_height_;
+		size_t input_width_;
+		size_t output_height_;
+		size_t output_width_;
+		size_t pool_size_;
+		size_t stride_;
+
+		/// <summary>
+		/// Position of the maximum in its window (row * pool_size + column) for every activation (max pooling only)
+		/// </summary>
+		std::unique_ptr<Matrix<uint8_t>> argmax_;
+
+	public:
+		/// <summary>
+		/// Initializes the layer.
+		/// </summary>
+		/// <param name="mode">Max or average pooling</param>
+		/// <param name="channels">Channels of the input (and output) images</param>
+		/// <param name="input_height">Height of the input images</param>
+		/// <param name="input_width">Width of the input images</param>
+		/// <param name="pool_size">Width and height of the windows (at most 16)</param>
+		/// <param name="batch_size">Batch size of the layer</param>
+		/// <param name="stride">Distance between two windows (0 for pool_size, windows without overlap)</param>
+		Pool2D(PoolingMode mode, size_t channels, size_t input_height, size_t input_width, size_t pool_size,
+			size_t batch_size, size_t stride = 0);
+
+		[[nodiscard]] PoolingMode get_mode() const;
+		[[nodiscard]] size_t get_channels() const;
+		[[nodiscard]] size_t get_input_height() const;
+		[[nodiscard]] size_t get_input_width() const;
+		[[nodiscard]] size_t get_output_height() const;
+		[[nodiscard]] size_t get_output_width() const;
+		[[nodiscard]] size_t get_pool_size() const;
+		[[nodiscard]] size_t get_stride() const;
+
+		/// <summary>
+		/// Returns the positions of the maxima of the last feed_forward (max pooling only).
+		/// </summary>
+		[[nodiscard]] const Matrix<uint8_t>& get_argmax() const;
+
+		/// <summary>
+		/// activations = maximum or mean of every window of the previous activations
+		/// </summary>
+		void feed_forward(const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Takes the delta activations from the next layer (nothing to learn).
+		/// </summary>
+		void back_propagate(const Layer& next_layer, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Calculates the delta activations from the expected activations (nothing to learn).
+		/// </summary>
+		void back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer) override;
+
+		/// <summary>
+		/// Routes the delta activations back to the maxima (max) or spreads them over the windows (average).
+		/// </summary>
+		void propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const override;
+
+		/// <summary>
+		/// Returns the memory of the matrices of this layer (no parameters).
+		/// </summary>
+		[[nodiscard]] MemoryRequirements get_memory_requirements() const override;
+
+		/// <summary>
+		/// Frees the activations and the positions of the maxima.
+		/// </summary>
+		void release_activations() override;
+	};
+}
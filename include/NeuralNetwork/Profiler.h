@@ -0,0 +1,196 @@
+// File: include/NeuralNetwork/Profiler.h
+// Purpose: Header file for the scoped timing profiler of the training hot path.
+
+#pragma once
+
+#include <chrono> // std::chrono::steady_clock
+#include <cstdint> // int64_t, uint32_t
+#include <ostream> // std::ostream
+#include <vector> // std::vector
+
+// The instrumentation in the library (NeuralNetwork, Layer, Matrix) uses these macros. They expand to nothing
+// unless the library is configured with -D NN_ENABLE_PROFILER=ON, so the disabled build has no timing code at all.
+#ifdef NN_ENABLE_PROFILER
+#define NN_PROFILE_CONCAT_IMPL(a, b) a##b
+#define NN_PROFILE_CONCAT(a, b) NN_PROFILE_CONCAT_IMPL(a, b)
+
+/// <summary>
+/// Times the rest of the enclosing scope as phase name (a string literal) of the current layer.
+/// </summary>
+#define NN_PROFILE_SCOPE(name) const nn::profiler::ScopedEvent NN_PROFILE_CONCAT(nn_profile_scope_, __LINE__)(name)
+
+/// <summary>
+/// Times the rest of the enclosing scope as phase name of the given layer (the current layer of the nested scopes).
+/// </summary>
+#define NN_PROFILE_LAYER_SCOPE(name, layer) \
+	const nn::profiler::ScopedEvent NN_PROFILE_CONCAT(nn_profile_scope_, __LINE__)(name, static_cast<int>(layer))
+
+/// <summary>
+/// Accounts the floating point operations and bytes of memory traffic of a kernel call to the enclosing scopes.
+/// </summary>
+#define NN_PROFILE_WORK(flop, bytes) nn::profiler::add_work(static_cast<uint64_t>(flop), static_cast<uint64_t>(bytes))
+#else
+#define NN_PROFILE_SCOPE(name) static_cast<void>(0)
+#define NN_PROFILE_LAYER_SCOPE(name, layer) static_cast<void>(0)
+#define NN_PROFILE_WORK(flop, bytes) static_cast<void>(0)
+#endif
+
+namespace nn::profiler
+{
+	/// <summary>
+	/// Is the instrumentation of the library compiled in?
+	/// </summary>
+#ifdef NN_ENABLE_PROFILER
+	constexpr bool enabled = true;
+#else
+	constexpr bool enabled = false;
+#endif
+
+	using clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// One timed scope.
+	/// </summary>
+	struct Event
+	{
+		/// <summary>
+		/// Phase name (a string literal, not owned).
+		/// </summary>
+		const char* name;
+
+		/// <summary>
+		/// Index of the layer in the network (0 is the input layer), -1 outside of a layer.
+		/// </summary>
+		int layer;
+
+		/// <summary>
+		/// Number of enclosing scopes on the same thread.
+		/// </summary>
+		uint32_t depth;
+
+		/// <summary>
+		/// Index of the recording thread, in the order the threads recorded their first event.
+		/// </summary>
+		uint32_t thread;
+
+		/// <summary>
+		/// Start in nanoseconds since the first event of the process.
+		/// </summary>
+		int64_t start;
+
+		/// <summary>
+		/// Duration in nanoseconds.
+		/// </summary>
+		int64_t duration;
+
+		/// <summary>
+		/// Floating point operations of the kernels called during the event (including nested events).
+		/// </summary>
+		uint64_t flop;
+
+		/// <summary>
+		/// Bytes the kernels called during the event read and wrote (every operand counted once per call).
+		/// </summary>
+		uint64_t bytes;
+	};
+
+	/// <summary>
+	/// Peak rates of this machine for the kernels in use, measured by measure_machine_peaks.
+	/// </summary>
+	struct MachinePeaks
+	{
+		/// <summary>
+		/// Floating point operations per second of the matrix product on cache resident operands.
+		/// </summary>
+		double flops;
+
+		/// <summary>
+		/// Bytes per second of a streaming kernel on operands much larger than the caches.
+		/// </summary>
+		double bytes_per_second;
+
+		/// <summary>
+		/// Bytes per second of the same kernel on operands that fit in the L2 cache.
+		/// </summary>
+		double cache_bytes_per_second;
+	};
+
+	/// <summary>
+	/// Phases that move at most this many bytes per call are held against the cache bandwidth (their operands
+	/// stay in the caches between calls), the rest against the memory bandwidth.
+	/// </summary>
+	constexpr uint64_t cache_resident_bytes = uint64_t(1) << 20;
+
+	/// <summary>
+	/// Times its lifetime. Events are appended to a buffer owned by the recording thread, so recording takes no
+	/// lock (only the first event of a thread registers its buffer).
+	/// </summary>
+	class ScopedEvent
+	{
+	private:
+		const char* name_;
+		int previous_layer_;
+		uint64_t start_flop_;
+		uint64_t start_bytes_;
+		clock::time_point start_;
+
+	public:
+		/// <summary>
+		/// Starts timing phase name of the current layer.
+		/// </summary>
+		explicit ScopedEvent(const char* name);
+
+		/// <summary>
+		/// Starts timing phase name of layer (which becomes the current layer until this event ends).
+		/// </summary>
+		ScopedEvent(const char* name, int layer);
+
+		ScopedEvent(const ScopedEvent&) = delete;
+		ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+		/// <summary>
+		/// Records the event.
+		/// </summary>
+		~ScopedEvent();
+	};
+
+	/// <summary>
+	/// Adds the work of a kernel call to the events of this thread that are in progress (see NN_PROFILE_WORK).
+	///	Transcendental functions (exp, tanh) count as one operation.
+	/// </summary>
+	void add_work(uint64_t flop, uint64_t bytes);
+
+	/// <summary>
+	/// Returns the events of every thread ordered by thread and start. Safe while other threads record (their
+	/// events that are not finished yet are missing).
+	/// </summary>
+	[[nodiscard]] std::vector<Event> get_events();
+
+	/// <summary>
+	/// Discards all events. No thread may record at the same time.
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Writes the events in the Chrome trace event format (load it in chrome://tracing or https://ui.perfetto.dev).
+	/// </summary>
+	void write_chrome_trace(std::ostream& os);
+
+	/// <summary>
+	/// Writes the total and mean time of every phase per layer and its share of the total time of the outermost scopes.
+	/// </summary>
+	void write_summary(std::ostream& os);
+
+	/// <summary>
+	/// Measures the matrix product and streaming rates of the selected kernels (takes about a second).
+	/// </summary>
+	[[nodiscard]] MachinePeaks measure_machine_peaks();
+
+	/// <summary>
+	/// Writes the achieved GFLOP/s and GB/s of every epoch, layer and phase that did work against the roofline of
+	/// the peaks: attainable = min(peak flops, arithmetic intensity * bandwidth), with the cache or memory bandwidth
+	/// (see cache_resident_bytes). Phases with an arithmetic intensity (flop/byte) below the ridge point
+	/// peaks.flops / bandwidth are bandwidth bound.
+	/// </summary>
+	void write_roofline(std::ostream& os, const MachinePeaks& peaks);
+}
@@ -0,0 +1,280 @@
+// File: include/NeuralNetwork/Quantization.h
+// Purpose: Header file for int8 post-training quantization of a NeuralNetwork.
+
+#pragma once
+
+#include <cstdint> // int8_t, uint8_t, int32_t
+#include <memory> // std::unique_ptr
+#include <vector> // std::vector
+
+#include "NeuralNetwork/Matrix.h" // nn::Matrix
+#include "NeuralNetwork/NeuralNetwork.h" // nn::NeuralNetwork
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer
+#include "NeuralNetwork/DataSet.h" // nn::DataSet
+#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationType
+
+namespace nn::quantization
+{
+	/// <summary>
+	/// Granularity of the weight scales.
+	/// </summary>
+	enum class ScaleGranularity
+	{
+		/// <summary>
+		/// One scale for the whole weights matrix of a layer.
+		/// </summary>
+		PerLayer,
+
+		/// <summary>
+		/// One scale for every row (neuron) of the weights matrix.
+		/// </summary>
+		PerRow
+	};
+
+	/// <summary>
+	/// Affine quantization of activations to 7 bit unsigned integers: real = scale * (quantized - zero_point).
+	///	Activations use 7 bits so the AVX2 u8 x s8 multiply-add (maddubs) can never saturate its 16 bit pair sums.
+	/// </summary>
+	struct ActivationQuantization
+	{
+		/// <summary>
+		/// Largest quantized activation value.
+		/// </summary>
+		static constexpr int32_t max_value = 127;
+
+		float scale = 1.0f;
+		int32_t zero_point = 0;
+
+		/// <summary>
+		/// Creates the quantization parameters covering the observed range [min, max] (the range always includes 0).
+		/// </summary>
+		[[nodiscard]] static ActivationQuantization from_range(float min, float max);
+
+		/// <summary>
+		/// Quantizes a single real value.
+		/// </summary>
+		[[nodiscard]] uint8_t quantize(float value) const;
+	};
+
+	/// <summary>
+	/// Observed range of the activations of every layer of a network (index 0 is the input layer).
+	/// </summary>
+	class Calibration
+	{
+	private:
+		/// <summary>
+		/// Smallest observed activation of each layer.
+		/// </summary>
+		std::vector<float> min_;
+
+		/// <summary>
+		/// Largest observed activation of each layer.
+		/// </summary>
+		std::vector<float> max_;
+
+	public:
+		/// <summary>
+		/// Runs the network over the data set (up to max_batches batches, 0 for all) and records the activation ranges.
+		///	The data set must use the same batch size as the network.
+		/// </summary>
+		void calibrate(NeuralNetwork& network, DataSet& data_set, size_t max_batches = 0);
+
+		/// <summary>
+		/// Records the activation ranges of the network for its current activations.
+		/// </summary>
+		void observe(NeuralNetwork& network);
+
+		/// <summary>
+		/// Returns the activation quantization of the given layer.
+		/// </summary>
+		[[nodiscard]] ActivationQuantization get_activation_quantization(size_t layer_index) const;
+
+		/// <summary>
+		/// Returns the number of layers that have been calibrated.
+		/// </summary>
+		[[nodiscard]] size_t get_layer_count() const;
+	};
+
+	/// <summary>
+	/// Fully connected layer with int8 weights, int32 accumulation and a fused dequantize + bias + activation + requantize epilogue.
+	///	The product runs over blocks of samples with the int8 GEMM of the kernel table, and the epilogue over every block
+	///	while its results are still in cache.
+	/// </summary>
+	class QuantizedLayer
+	{
+	private:
+		/// <summary>
+		/// Neuron count of this layer.
+		/// </summary>
+		size_t neuron_count_;
+
+		/// <summary>
+		/// Neuron count of the previous layer.
+		/// </summary>
+		size_t input_count_;
+
+		/// <summary>
+		/// Quantized weights (neuron_count x padded input count, padding is zero).
+		/// </summary>
+		Matrix<int8_t> weights_;
+
+		/// <summary>
+		/// Sum of every row of the quantized weights (to subtract the zero point of the input in the epilogue).
+		/// </summary>
+		Matrix<int32_t> weight_row_sums_;
+
+		/// <summary>
+		/// Scale of every row of the quantized weights.
+		/// </summary>
+		Matrix<float> weight_scales_;
+
+		/// <summary>
+		/// Biases of this layer (kept in float, added in the epilogue).
+		/// </summary>
+		Matrix<float> biases_;
+
+		/// <summary>
+		/// int32 products of the block of samples being processed (samples x neuron count).
+		/// </summary>
+		Matrix<int32_t> accumulators_;
+
+		/// <summary>
+		/// Real valued activations of the sample being processed (one row, stays in cache for the epilogue).
+		/// </summary>
+		Matrix<float> scratch_;
+
+		/// <summary>
+		/// Activation function of this layer.
+		/// </summary>
+		activation_functions::ActivationType activation_type_;
+
+		/// <summary>
+		/// Quantization of this layer's input.
+		/// </summary>
+		ActivationQuantization input_quantization_;
+
+	public:
+		/// <summary>
+		/// Quantizes the weights of the given layer.
+		/// </summary>
+		/// <param name="layer">Layer to quantize (must not be the input layer)</param>
+		/// <param name="input_quantization">Quantization of the activations of the previous layer</param>
+		/// <param name="granularity">Granularity of the weight scales</param>
+		QuantizedLayer(const DenseLayer& layer, const ActivationQuantization& input_quantization, ScaleGranularity granularity);
+
+		/// <summary>
+		/// Returns the neuron count of this layer.
+		/// </summary>
+		[[nodiscard]] size_t get_neuron_count() const;
+
+		/// <summary>
+		/// Returns the row stride (padded neuron count of previous layer) of the quantized input.
+		/// </summary>
+		[[nodiscard]] size_t get_input_stride() const;
+
+		/// <summary>
+		/// Returns the quantization of this layer's input.
+		/// </summary>
+		[[nodiscard]] const ActivationQuantization& get_input_quantization() const;
+
+		/// <summary>
+		/// Runs forward propagation and requantizes the activations for the next layer.
+		/// </summary>
+		/// <param name="input">Quantized input (batch size x input stride)</param>
+		/// <param name="output">Quantized output (batch size x output stride)</param>
+		/// <param name="output_quantization">Quantization of this layer's activations</param>
+		/// <param name="output_stride">Row stride of the output</param>
+		void feed_forward(const Matrix<uint8_t>& input, Matrix<uint8_t>& output,
+		                  const ActivationQuantization& output_quantization, size_t output_stride);
+
+		/// <summary>
+		/// Runs forward propagation and stores the real valued activations (neuron count x batch size, like nn::DenseLayer).
+		/// </summary>
+		/// <param name="input">Quantized input (batch size x input stride)</param>
+		/// <param name="output">Activations of this layer</param>
+		void feed_forward(const Matrix<uint8_t>& input, Matrix<float>& output);
+
+	private:
+		/// <summary>
+		/// Multiplies samples rows of the input, starting at first, by the weights into the accumulators.
+		/// </summary>
+		void multiply(const Matrix<uint8_t>& input, size_t first, size_t samples);
+
+		/// <summary>
+		/// Computes the real valued activations of one sample of the block from its accumulators into the scratch row.
+		/// </summary>
+		void calculate_activations(size_t sample);
+	};
+
+	/// <summary>
+	/// Inference only int8 version of a trained NeuralNetwork.
+	/// </summary>
+	class QuantizedNetwork
+	{
+	private:
+		/// <summary>
+		/// Quantized layers (every layer except the input layer).
+		/// </summary>
+		std::vector<std::unique_ptr<QuantizedLayer>> layers_;
+
+		/// <summary>
+		/// Quantized activations of every layer except the output layer.
+		/// </summary>
+		std::vector<std::unique_ptr<Matrix<uint8_t>>> activations_;
+
+		/// <summary>
+		/// Activations of the output layer.
+		/// </summary>
+		std::unique_ptr<Matrix<float>> output_;
+
+		/// <summary>
+		/// Neuron count of the input layer.
+		/// </summary>
+		size_t input_size_;
+
+		/// <summary>
+		/// Batch size the activation matrices are allocated for.
+		/// </summary>
+		size_t batch_size_;
+
+	public:
+		/// <summary>
+		/// Default constructor.
+		/// </summary>
+		QuantizedNetwork();
+
+		/// <summary>
+		/// Quantizes the given network using the activation ranges recorded by calibration.
+		/// </summary>
+		void quantize(NeuralNetwork& network, const Calibration& calibration, ScaleGranularity granularity = ScaleGranularity::PerRow);
+
+		/// <summary>
+		/// Runs forward propagation on the network.
+		/// </summary>
+		/// <param name="input">Input matrix (input size x batch size)</param>
+		/// <returns>Output matrix (output size x batch size)</returns>
+		const Matrix<float>& feed_forward(const Matrix<float>& input);
+
+		/// <summary>
+		/// Calculates the accuracy of the network on the given data set.
+		/// </summary>
+		[[nodiscard]] float calculate_accuracy(DataSet& data_set);
+
+		/// <summary>
+		/// Returns the output of the network for the last input.
+		/// </summary>
+		[[nodiscard]] const Matrix<float>& get_output() const;
+
+	private:
+		/// <summary>
+		/// (Re)allocates the activation matrices for the given batch size.
+		/// </summary>
+		void allocate_activations(size_t batch_size);
+	};
+
+	/// <summary>
+	/// Returns the dot product of a row of unsigned activations and a row of signed weights.
+	///	Uses the best int8 kernel of this CPU (see Kernels.h), size must be a multiple of 64.
+	/// </summary>
+	[[nodiscard]] int32_t dot_product(const uint8_t* activations, const int8_t* weights, size_t size);
+}
@@ -0,0 +1,450 @@
+// File: include/NeuralNetwork/StaticNetwork.h
+// Purpose: Header only fixed-topology network whose layer widths are known at compile time.
+
+#pragma once
+
+#include <array> // std::array
+#include <cmath> // std::exp
+#include <tuple> // std::tuple
+#include <utility> // std::index_sequence
+#include <stdexcept> // std::runtime_error
+
+#include "NeuralNetwork/NeuralNetwork.h" // nn::NeuralNetwork
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer, nn::as_dense_layer
+#include "NeuralNetwork/ActivationFunction.h" // nn::activation_functions::ActivationType
+
+namespace nn
+{
+	/// <summary>
+	/// Matrix whose size is known at compile time. Elements are stored inline (no heap allocation).
+	/// </summary>
+	/// <typeparam name="T">Type of data in matrix.</typeparam>
+	/// <typeparam name="Rows">Rows in the matrix.</typeparam>
+	/// <typeparam name="Cols">Columns in the matrix.</typeparam>
+	template <typename T, size_t Rows, size_t Cols>
+	class StaticMatrix
+	{
+	private:
+		/// <summary>
+		/// Matrix data in row major order.
+		/// </summary>
+		alignas(64) std::array<T, Rows * Cols> data_{};
+
+	public:
+		/// <summary>
+		/// Returns the element at row, col.
+		/// </summary>
+		[[nodiscard]] constexpr T& operator()(const size_t row, const size_t col) { return data_[row * Cols + col]; }
+
+		/// <summary>
+		/// Returns the element at row, col.
+		/// </summary>
+		[[nodiscard]] constexpr const T& operator()(const size_t row, const size_t col) const { return data_[row * Cols + col]; }
+
+		/// <summary>
+		/// Returns the element at index of the matrix data array.
+		/// </summary>
+		[[nodiscard]] constexpr T& operator[](const size_t index) { return data_[index]; }
+
+		/// <summary>
+		/// Returns the element at index of the matrix data array.
+		/// </summary>
+		[[nodiscard]] constexpr const T& operator[](const size_t index) const { return data_[index]; }
+
+		/// <summary>
+		/// Returns the matrix data.
+		/// </summary>
+		[[nodiscard]] constexpr T* get_data() { return data_.data(); }
+
+		/// <summary>
+		/// Returns the matrix data.
+		/// </summary>
+		[[nodiscard]] constexpr const T* get_data() const { return data_.data(); }
+
+		/// <summary>
+		/// Returns the number of rows in the matrix.
+		/// </summary>
+		[[nodiscard]] static constexpr size_t get_rows() { return Rows; }
+
+		/// <summary>
+		/// Returns the number of columns in the matrix.
+		/// </summary>
+		[[nodiscard]] static constexpr size_t get_cols() { return Cols; }
+	};
+
+	/// <summary>
+	/// Fully connected layer with compile time sizes, used by StaticNetwork.
+	///	Weights are kept transposed (InputCount x NeuronCount) so that the inner loop of the forward pass
+	///	is a contiguous axpy the compiler can vectorize and unroll.
+	/// </summary>
+	/// <typeparam name="NeuronCount">Neuron count of this layer</typeparam>
+	/// <typeparam name="InputCount">Neuron count of the previous layer</typeparam>
+	template <size_t NeuronCount, size_t InputCount>
+	class StaticLayer
+	{
+	private:
+		/// <summary>
+		/// Transposed weights matrix of this layer.
+		/// </summary>
+		StaticMatrix<float, InputCount, NeuronCount> weights_transposed_;
+
+		/// <summary>
+		/// Biases of this layer.
+		/// </summary>
+		std::array<float, NeuronCount> biases_{};
+
+		/// <summary>
+		/// Activations of this layer for the last input.
+		/// </summary>
+		alignas(64) std::array<float, NeuronCount> activations_{};
+
+		/// <summary>
+		/// Activation function of this layer (default is sigmoid, same as nn::DenseLayer).
+		/// </summary>
+		activation_functions::ActivationType activation_type_ = activation_functions::ActivationType::Sigmoid;
+
+	public:
+		/// <summary>
+		/// Copies weights (NeuronCount x InputCount, the layout of nn::DenseLayer) and biases (NeuronCount x 1) into this layer.
+		/// </summary>
+		void set_parameters(const Matrix<float>& weights, const Matrix<float>& biases)
+		{
+			if (weights.get_rows() != NeuronCount || weights.get_cols() != InputCount || biases.get_rows() != NeuronCount || biases.get_cols() != 1)
+			{
+				throw std::runtime_error("Cannot set static layer parameters with incompatible dimensions.");
+			}
+
+			for (size_t i = 0; i < NeuronCount; ++i)
+			{
+				for (size_t j = 0; j < InputCount; ++j)
+				{
+					weights_transposed_(j, i) = weights(i, j);
+				}
+				biases_[i] = biases[i];
+			}
+		}
+
+		/// <summary>
+		/// Copies the weights (NeuronCount x InputCount) and biases (NeuronCount x 1) of this layer into the given matrices.
+		/// </summary>
+		void get_parameters(Matrix<float>& weights, Matrix<float>& biases) const
+		{
+			if (weights.get_rows() != NeuronCount || weights.get_cols() != InputCount || biases.get_rows() != NeuronCount || biases.get_cols() != 1)
+			{
+				throw std::runtime_error("Cannot get static layer parameters with incompatible dimensions.");
+			}
+
+			for (size_t i = 0; i < NeuronCount; ++i)
+			{
+				for (size_t j = 0; j < InputCount; ++j)
+				{
+					weights(i, j) = weights_transposed_(j, i);
+				}
+				biases[i] = biases_[i];
+			}
+		}
+
+		/// <summary>
+		/// Sets the activation function of this layer.
+		/// </summary>
+		void set_activation_type(const activation_functions::ActivationType activation_type)
+		{
+			if (activation_type == activation_functions::ActivationType::Custom)
+			{
+				throw std::runtime_error("Static layers only support the built-in activation functions.");
+			}
+
+			activation_type_ = activation_type;
+		}
+
+		/// <summary>
+		/// Returns the activation function of this layer.
+		/// </summary>
+		[[nodiscard]] activation_functions::ActivationType get_activation_type() const { return activation_type_; }
+
+		/// <summary>
+		/// Returns the activations of this layer for the last input.
+		/// </summary>
+		[[nodiscard]] const std::array<float, NeuronCount>& get_activations() const { return activations_; }
+
+		/// <summary>
+		/// Runs forward propagation on this layer.
+		///	activations = activation_function(weights * input + biases)
+		/// </summary>
+		/// <param name="input">Activations of previous layer</param>
+		void feed_forward(const std::array<float, InputCount>& input)
+		{
+			activations_ = biases_;
+
+			// Every bound is a compile time constant, so the compiler can fully unroll and vectorize these loops.
+			for (size_t j = 0; j < InputCount; ++j)
+			{
+				const float x = input[j];
+				const float* weights_row = weights_transposed_.get_data() + j * NeuronCount;
+				for (size_t i = 0; i < NeuronCount; ++i)
+				{
+					activations_[i] += weights_row[i] * x;
+				}
+			}
+
+			this->activate();
+		}
+
+	private:
+		/// <summary>
+		/// Applies the activation function to the activations (switch is outside the loops so each loop stays branch free).
+		/// </summary>
+		void activate()
+		{
+			using activation_functions::ActivationType;
+
+			switch (activation_type_)
+			{
+			case ActivationType::Sigmoid:
+				for (size_t i = 0; i < NeuronCount; ++i)
+				{
+					activations_[i] = 1.0f / (1.0f + std::exp(-activations_[i]));
+				}
+				break;
+			case ActivationType::ReLU:
+				for (size_t i = 0; i < NeuronCount; ++i)
+				{
+					activations_[i] = activations_[i] > 0.0f ? activations_[i] : 0.0f;
+				}
+				break;
+			case ActivationType::LeakyReLU:
+				for (size_t i = 0; i < NeuronCount; ++i)
+				{
+					activations_[i] = activations_[i] > 0.0f ? activations_[i] : 0.01f * activations_[i];
+				}
+				break;
+			case ActivationType::Tanh:
+				for (size_t i = 0; i < NeuronCount; ++i)
+				{
+					activations_[i] = std::tanh(activations_[i]);
+				}
+				break;
+			case ActivationType::SoftMax:
+				{
+					float sum = 0.0f;
+					for (size_t i = 0; i < NeuronCount; ++i)
+					{
+						activations_[i] = std::exp(activations_[i]);
+						sum += activations_[i];
+					}
+					for (size_t i = 0; i < NeuronCount; ++i)
+					{
+						activations_[i] /= sum;
+					}
+				}
+				break;
+			case ActivationType::Linear:
+			case ActivationType::Custom:
+				break;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Inference only neural network whose topology is fixed at compile time, e.g. StaticNetwork&lt;784, 64, 64, 10&gt;.
+	///	All parameters and activations live inside the object, so inference performs no heap allocation.
+	///	(For large topologies prefer static storage over the stack, the object holds every weight.)
+	/// </summary>
+	/// <typeparam name="Sizes">Neuron count of every layer, starting with the input layer</typeparam>
+	template <size_t... Sizes>
+	class StaticNetwork
+	{
+		static_assert(sizeof...(Sizes) >= 2, "A static network needs at least an input and an output layer.");
+
+	public:
+		/// <summary>
+		/// Number of layers including the input layer.
+		/// </summary>
+		static constexpr size_t layer_count = sizeof...(Sizes);
+
+		/// <summary>
+		/// Neuron count of every layer.
+		/// </summary>
+		static constexpr std::array<size_t, layer_count> sizes = { Sizes... };
+
+		/// <summary>
+		/// Neuron count of the input layer.
+		/// </summary>
+		static constexpr size_t input_size = sizes.front();
+
+		/// <summary>
+		/// Neuron count of the output layer.
+		/// </summary>
+		static constexpr size_t output_size = sizes.back();
+
+		/// <summary>
+		/// Type of the Index-th layer with weights (layer Index + 1 of the network).
+		/// </summary>
+		template <size_t Index>
+		using layer_type = StaticLayer<sizes[Index + 1], sizes[Index]>;
+
+	private:
+		template <size_t... Indices>
+		static auto make_layers(std::index_sequence<Indices...>) -> std::tuple<layer_type<Indices>...>;
+
+		/// <summary>
+		/// Layers with weights (every layer except the input layer).
+		/// </summary>
+		decltype(make_layers(std::make_index_sequence<layer_count - 1>{})) layers_;
+
+	public:
+		/// <summary>
+		/// Returns the Index-th layer with weights.
+		/// </summary>
+		template <size_t Index>
+		[[nodiscard]] layer_type<Index>& get_layer() { return std::get<Index>(layers_); }
+
+		/// <summary>
+		/// Returns the Index-th layer with weights.
+		/// </summary>
+		template <size_t Index>
+		[[nodiscard]] const layer_type<Index>& get_layer() const { return std::get<Index>(layers_); }
+
+		/// <summary>
+		/// Runs forward propagation on the network.
+		/// </summary>
+		/// <param name="input">Input of the network</param>
+		/// <returns>Output of the network</returns>
+		const std::array<float, output_size>& feed_forward(const std::array<float, input_size>& input)
+		{
+			this->feed_forward(input, std::make_index_sequence<layer_count - 1>{});
+			return this->get_output();
+		}
+
+		/// <summary>
+		/// Returns the output of the network for the last input.
+		/// </summary>
+		[[nodiscard]] const std::array<float, output_size>& get_output() const
+		{
+			return std::get<layer_count - 2>(layers_).get_activations();
+		}
+
+		/// <summary>
+		/// Returns the index of the largest output for the last input.
+		/// </summary>
+		[[nodiscard]] size_t get_predicted_index() const
+		{
+			const auto& output = this->get_output();
+			size_t max_index = 0;
+			for (size_t i = 1; i < output_size; ++i)
+			{
+				if (output[i] > output[max_index])
+				{
+					max_index = i;
+				}
+			}
+
+			return max_index;
+		}
+
+		/// <summary>
+		/// Copies the weights, biases and activation functions from a dynamic network with the same topology.
+		/// </summary>
+		void load_from(NeuralNetwork& network)
+		{
+			auto& layers = network.get_layers();
+			if (layers.size() != layer_count)
+			{
+				throw std::runtime_error("Cannot load static network from a network with a different layer count.");
+			}
+
+			auto it = layers.begin();
+			for (size_t i = 0; i < layer_count; ++i, ++it)
+			{
+				if ((*it)->get_neuron_count() != sizes[i])
+				{
+					throw std::runtime_error("Cannot load static network from a network with different layer sizes.");
+				}
+			}
+
+			this->load_from(std::next(layers.begin()), std::make_index_sequence<layer_count - 1>{});
+		}
+
+		/// <summary>
+		/// Copies the weights, biases and activation functions of this network into a dynamic network with the same
+		///	topology. Every layer is checked before the first one is written.
+		/// </summary>
+		void store_to(NeuralNetwork& network) const
+		{
+			auto& layers = network.get_layers();
+			if (layers.size() != layer_count)
+			{
+				throw std::runtime_error("Cannot store static network to a network with a different layer count.");
+			}
+
+			auto it = layers.begin();
+			for (size_t i = 0; i < layer_count; ++i, ++it)
+			{
+				if ((*it)->get_neuron_count() != sizes[i])
+				{
+					throw std::runtime_error("Cannot store static network to a network with different layer sizes.");
+				}
+				if (i > 0)
+				{
+					const Matrix<float>& weights = as_dense_layer(**it).get_weights();
+					if (weights.get_rows() != sizes[i] || weights.get_cols() != sizes[i - 1])
+					{
+						throw std::runtime_error("Cannot store static network to a network with different layer sizes.");
+					}
+				}
+			}
+
+			this->store_to(std::next(layers.begin()), std::make_index_sequence<layer_count - 1>{});
+		}
+
+	private:
+		template <size_t... Indices>
+		void feed_forward(const std::array<float, input_size>& input, std::index_sequence<Indices...>)
+		{
+			std::get<0>(layers_).feed_forward(input);
+			// Feed every later layer with the activations of the layer before it.
+			(this->feed_forward_layer<Indices>(), ...);
+		}
+
+		template <size_t Index>
+		void feed_forward_layer()
+		{
+			if constexpr (Index > 0)
+			{
+				std::get<Index>(layers_).feed_forward(std::get<Index - 1>(layers_).get_activations());
+			}
+		}
+
+		template <typename Iterator, size_t... Indices>
+		void load_from(Iterator it, std::index_sequence<Indices...>)
+		{
+			((std::get<Indices>(layers_).set_parameters(as_dense_layer(**it).get_weights(), as_dense_layer(**it).get_biases()),
+			  std::get<Indices>(layers_).set_activation_type(
+				  activation_functions::get_activation_type(*as_dense_layer(**it).get_activation_function())),
+			  ++it), ...);
+		}
+
+		template <typename Iterator, size_t... Indices>
+		void store_to(Iterator it, std::index_sequence<Indices...>) const
+		{
+			((this->store_layer<Indices>(**it), ++it), ...);
+		}
+
+		template <size_t Index>
+		void store_layer(Layer& generic_layer) const
+		{
+			DenseLayer& layer = as_dense_layer(generic_layer);
+			Matrix<float> weights(sizes[Index + 1], sizes[Index]);
+			Matrix<float> biases(sizes[Index + 1], 1);
+			std::get<Index>(layers_).get_parameters(weights, biases);
+
+			layer.set_weights(weights);
+			layer.set_biases(biases);
+			const activation_functions::ActivationType activation_type = std::get<Index>(layers_).get_activation_type();
+			if (activation_functions::get_activation_type(*layer.get_activation_function()) != activation_type)
+			{
+				layer.set_activation_function(activation_functions::create_activation_function(activation_type));
+			}
+		}
+	};
+}
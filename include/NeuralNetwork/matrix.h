@@ -9,15 +9,14 @@
 #include <vector>	 // std::vector
 #include <iostream> // std::ostream
 #include <chrono> // std::chrono
-
-// Check if Intel MKL is available.
-#if defined(__has_include) && __has_include(<mkl.h>)
-#include <mkl.h>
-#else defined(__AVX2__) || defined(__AVX__)
-#include <immintrin.h>
-#endif
+#include <utility> // std::move
 
 #include "NeuralNetwork/AlignedMemoryAllocator.h" // nn::utils::AlignedMemoryAllocator
+#include "NeuralNetwork/AllocationTracker.h" // nn::memory::ScopedTag
+#include "NeuralNetwork/Expression.h" // nn::expressions::Expression
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+#include "NeuralNetwork/MatrixView.h" // nn::MatrixView
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_WORK
 
 namespace nn
 {
@@ -81,11 +80,53 @@ namespace nn
 		/// </summary>
 		Matrix(const Matrix<T>& other);
 
+		/// <summary>
+		/// Move constructor. Takes the data of other, which is left empty.
+		/// </summary>
+		Matrix(Matrix<T>&& other) noexcept;
+
+		/// <summary>
+		/// Constructor for a matrix with the size and elements of an expression (see Expression.h).
+		/// </summary>
+		template <typename E>
+		Matrix(const expressions::Expression<E>& expression);
+
 		/// <summary>
 		/// Assignment operator. Copies the data from other matrix to this matrix.
 		/// </summary>
 		Matrix& operator=(const Matrix<T>& other);
 
+		/// <summary>
+		/// Move assignment operator. Frees the data of this matrix and takes the data (and size) of other, which is left empty.
+		/// </summary>
+		Matrix& operator=(Matrix<T>&& other) noexcept;
+
+		/// <summary>
+		/// Evaluates an expression of the same size into this matrix in one pass (see Expression.h).
+		/// </summary>
+		template <typename E>
+		Matrix& operator=(const expressions::Expression<E>& expression);
+
+		/// <summary>
+		/// Returns a view of the whole matrix.
+		/// </summary>
+		[[nodiscard]] MatrixView<T> view();
+
+		/// <summary>
+		/// Returns a read only view of the whole matrix.
+		/// </summary>
+		[[nodiscard]] MatrixView<const T> view() const;
+
+		/// <summary>
+		/// Views convert implicitly, so matrices are passed to the kernels on views as they are.
+		/// </summary>
+		operator MatrixView<T>();
+
+		/// <summary>
+		/// Read only views convert implicitly, so matrices are passed to the kernels on views as they are.
+		/// </summary>
+		operator MatrixView<const T>() const;
+
 		/// <summary>
 		/// Returns the element at row, col.
 		/// </summary>
@@ -134,6 +175,12 @@ namespace nn
 		/// <returns>Array to the type T</returns>
 		[[nodiscard]] const T* get_data() const;
 
+		/// <summary>
+		/// Moves the data to a NUMA node (see AlignedMemoryAllocator::place_on_node).
+		/// </summary>
+		/// <returns>False where memory placement is not supported</returns>
+		bool place_on_node(size_t node);
+
 		/// <summary>
 		/// Returns the number of rows in the matrix.
 		/// </summary>
@@ -182,6 +229,13 @@ namespace nn
 		/// <param name="other">Other matrix</param>
 		void hadamard_product(const Matrix<T>& other);
 
+		/// <summary>
+		/// Adds other matrix multiplied by scale to this matrix (this = this + scale * other).
+		/// </summary>
+		/// <param name="other">Other matrix</param>
+		/// <param name="scale">Factor other matrix is multiplied with</param>
+		void add_scaled(const Matrix<T>& other, const T& scale);
+
 		/// <summary>
 		/// Performs an element wise operation on this matrix with other matrix and stores the result in this matrix.
 		/// </summary>
@@ -227,19 +281,41 @@ namespace nn
 
 		/// <summary>
 		/// Calculates the delta biases matrix and stores the result in this matrix(for layer class).
-		///	delta_biases = mean of delta_sums so it becomes a vector(1d matrix)
+		///	delta_biases = scale * mean of delta_sums so it becomes a vector(1d matrix), added to delta_biases if accumulate
 		/// </summary>
 		/// <param name="this_layer_delta_sums"></param>
-		void calculate_delta_biases_for_back_propagation(const Matrix<T>& this_layer_delta_sums);
+		/// <param name="scale">Weight of this batch (1 / micro batch count when accumulating)</param>
+		/// <param name="accumulate">Add to this matrix instead of overwriting it</param>
+		void calculate_delta_biases_for_back_propagation(const Matrix<T>& this_layer_delta_sums, const T scale = T(1),
+		                                                 const bool accumulate = false);
 
 		/// <summary>
 		/// Calculates the delta weights matrix and stores the result in this matrix(for layer class).
-		///	delta_weights = (delta_sums * transpose(previous_layer_activation)) / batch_size
+		///	delta_weights = scale * (delta_sums * transpose(previous_layer_activation)) / batch_size, added to
+		///	delta_weights if accumulate
 		/// </summary>
 		/// <param name="previous_layer_activations">Activation Matrix of previous layer</param>
 		/// <param name="this_layer_delta_sums">Delta sums matrix of this layer</param>
+		/// <param name="scale">Weight of this batch (1 / micro batch count when accumulating)</param>
+		/// <param name="accumulate">Add to this matrix instead of overwriting it</param>
 		void calculate_delta_weights_for_back_propagation(const Matrix<T>& previous_layer_activations,
-		                                                  const Matrix<T>& this_layer_delta_sums);
+		                                                  const Matrix<T>& this_layer_delta_sums, const T scale = T(1),
+		                                                  const bool accumulate = false);
+
+		/// <summary>
+		/// Calculates the delta weights (this matrix) and the delta biases of a layer in one sweep over the delta sums.
+		///	Same results as calculate_delta_weights_for_back_propagation and calculate_delta_biases_for_back_propagation,
+		///	the 1 / batch_size and scale are applied once when the products are stored.
+		/// </summary>
+		/// <param name="delta_biases">Delta biases matrix of this layer</param>
+		/// <param name="previous_layer_activations">Activation Matrix of previous layer</param>
+		/// <param name="this_layer_delta_sums">Delta sums matrix of this layer</param>
+		/// <param name="scale">Weight of this batch (1 / micro batch count when accumulating)</param>
+		/// <param name="accumulate">Add to the gradients instead of overwriting them</param>
+		void calculate_delta_weights_and_biases_for_back_propagation(Matrix<T>& delta_biases,
+		                                                             const Matrix<T>& previous_layer_activations,
+		                                                             const Matrix<T>& this_layer_delta_sums,
+		                                                             const T scale = T(1), const bool accumulate = false);
 
 		/// <summary>
 		/// Calculates the delta activation matrix from the expected output matrix and stores the result in this matrix(for layer class).
@@ -307,6 +383,79 @@ nn::Matrix<T>::Matrix(const Matrix<T>& other)
 	this->allocator_.copy_data(other.allocator_);
 }
 
+template <typename T>
+nn::Matrix<T>::Matrix(Matrix<T>&& other) noexcept
+	: rows_(other.rows_), cols_(other.cols_), allocator_(std::move(other.allocator_)), data_(other.data_)
+{
+	other.rows_ = 0;
+	other.cols_ = 0;
+	other.data_ = nullptr;
+}
+
+template <typename T>
+template <typename E>
+nn::Matrix<T>::Matrix(const expressions::Expression<E>& expression)
+	: rows_(0), cols_(0), data_(nullptr)
+{
+	this->init(expression.derived().get_rows(), expression.derived().get_cols());
+	expressions::evaluate(expression, this->view());
+}
+
+template <typename T>
+template <typename E>
+nn::Matrix<T>& nn::Matrix<T>::operator=(const expressions::Expression<E>& expression)
+{
+	// Check if the matrix is initialized.
+	if (this->get_rows() == 0 || this->get_cols() == 0 || !this->allocator_.is_initialized())
+	{
+		throw std::runtime_error("Cannot assign to an uninitialized matrix.");
+	}
+
+	expressions::evaluate(expression, this->view());
+	return *this;
+}
+
+template <typename T>
+nn::Matrix<T>& nn::Matrix<T>::operator=(Matrix<T>&& other) noexcept
+{
+	if (this != &other)
+	{
+		this->allocator_ = std::move(other.allocator_);
+		this->data_ = other.data_;
+		this->rows_ = other.rows_;
+		this->cols_ = other.cols_;
+		other.data_ = nullptr;
+		other.rows_ = 0;
+		other.cols_ = 0;
+	}
+
+	return *this;
+}
+
+template <typename T>
+nn::MatrixView<T> nn::Matrix<T>::view()
+{
+	return MatrixView<T>(this->data_, this->rows_, this->cols_);
+}
+
+template <typename T>
+nn::MatrixView<const T> nn::Matrix<T>::view() const
+{
+	return MatrixView<const T>(this->data_, this->rows_, this->cols_);
+}
+
+template <typename T>
+nn::Matrix<T>::operator MatrixView<T>()
+{
+	return this->view();
+}
+
+template <typename T>
+nn::Matrix<T>::operator MatrixView<const T>() const
+{
+	return this->view();
+}
+
 template <typename T>
 nn::Matrix<T>& nn::Matrix<T>::operator=(const Matrix<T>& other)
 {
@@ -321,6 +470,7 @@ nn::Matrix<T>& nn::Matrix<T>::operator=(const Matrix<T>& other)
 		throw std::runtime_error("Cannot copy matrices with incompatible dimensions.");
 	}
 
+	NN_PROFILE_WORK(0, 2 * sizeof(T) * this->get_rows() * this->get_cols());
 	this->allocator_.copy_data(other.allocator_);
 	return *this;
 }
@@ -373,6 +523,12 @@ const T* nn::Matrix<T>::get_data() const
 	return this->data_;
 }
 
+template <typename T>
+bool nn::Matrix<T>::place_on_node(const size_t node)
+{
+	return this->allocator_.place_on_node(node);
+}
+
 template <typename T>
 size_t nn::Matrix<T>::get_rows() const
 {
@@ -418,6 +574,9 @@ void nn::Matrix<T>::init(const size_t rows, const size_t cols)
 template <typename T>
 void nn::Matrix<T>::multiply(const Matrix<T>& matrix1, const Matrix<T>& matrix2, Matrix<T>& result)
 {
+	NN_PROFILE_WORK(2 * matrix1.get_rows() * matrix1.get_cols() * matrix2.get_cols(),
+		sizeof(T) * (matrix1.get_rows() * matrix1.get_cols() + matrix2.get_rows() * matrix2.get_cols() + result.get_rows() * result.get_cols()));
+
 	// Initialize the result matrix to default values.
 	for (size_t i = 0; i < result.rows_ * result.cols_; i++)
 	{
@@ -475,10 +634,16 @@ void nn::Matrix<T>::multiply_without_avx(const Matrix<T>& matrix1, const Matrix<
 template <typename T>
 void nn::Matrix<T>::hadamard_product(const Matrix<T>& other)
 {
-	this->perform_element_wise_operation(other, [](const T& value1, const T& value2) -> T
-	{
-		return value1 * value2;
-	});
+	// One operation per element
+	NN_PROFILE_WORK(this->get_rows() * this->get_cols(), 2 * sizeof(T) * this->get_rows() * this->get_cols());
+	*this = *this * other;
+}
+
+template <typename T>
+void nn::Matrix<T>::add_scaled(const Matrix<T>& other, const T& scale)
+{
+	NN_PROFILE_WORK(2 * this->get_rows() * this->get_cols(), 2 * sizeof(T) * this->get_rows() * this->get_cols());
+	*this = *this + scale * other;
 }
 
 template <typename T>
@@ -489,6 +654,8 @@ void nn::Matrix<T>::perform_element_wise_operation(const Matrix<T>& other, const
 		throw std::runtime_error("Cannot perform element wise operation on matrices with incompatible dimensions.");
 	}
 
+	// One operation per element
+	NN_PROFILE_WORK(this->get_rows() * this->get_cols(), 3 * sizeof(T) * this->get_rows() * this->get_cols());
 	for (size_t i = 0; i < this->get_rows() * this->get_cols(); i++)
 	{
 		this->operator[](i) = operation(this->operator[](i), other[i]);
@@ -498,6 +665,7 @@ void nn::Matrix<T>::perform_element_wise_operation(const Matrix<T>& other, const
 template <typename T>
 void nn::Matrix<T>::perform_element_wise_operation(const std::function<T(T)>& operation)
 {
+	NN_PROFILE_WORK(this->get_rows() * this->get_cols(), 2 * sizeof(T) * this->get_rows() * this->get_cols());
 	for (size_t i = 0; i < this->get_rows() * this->get_cols(); i++)
 	{
 		this->operator[](i) = operation(this->operator[](i));
@@ -527,7 +695,9 @@ template <typename T>
 nn::Matrix<T> nn::Matrix<T>::transpose() const
 {
 	// Initialize the result matrix.
+	const memory::ScopedTag tag("Matrix::transpose");
 	Matrix<T> result(this->get_cols(), this->get_rows());
+	NN_PROFILE_WORK(0, 2 * sizeof(T) * this->get_rows() * this->get_cols());
 
 	for (size_t i = 0; i < this->get_rows(); i++)
 	{
@@ -552,6 +722,7 @@ void nn::Matrix<T>::calculate_sums_for_forward_propagation(const Matrix<T>& weig
 
 	// Calculate sums.
 	Matrix<T>::multiply(weights, input, *this);
+	NN_PROFILE_WORK(this->get_rows() * this->get_cols(), sizeof(T) * (2 * this->get_rows() * this->get_cols() + this->get_rows()));
 	for (size_t i = 0; i < this->get_rows(); i++)
 	{
 		for (size_t j = 0; j < this->get_cols(); j++)
@@ -572,7 +743,8 @@ void nn::Matrix<T>::calculate_delta_activation_for_back_propagation(const Matrix
 }
 
 template <typename T>
-void nn::Matrix<T>::calculate_delta_biases_for_back_propagation(const Matrix<T>& this_layer_delta_sums)
+void nn::Matrix<T>::calculate_delta_biases_for_back_propagation(const Matrix<T>& this_layer_delta_sums, const T scale,
+                                                                 const bool accumulate)
 {
 	// Check if dimensions are compatible.
 	if (this->get_cols() != 1 || this->get_rows() != this_layer_delta_sums.get_rows())
@@ -581,6 +753,8 @@ void nn::Matrix<T>::calculate_delta_biases_for_back_propagation(const Matrix<T>&
 	}
 
 	// Calculate delta biases.
+	NN_PROFILE_WORK(this_layer_delta_sums.get_rows() * this_layer_delta_sums.get_cols() + this->get_rows(),
+		sizeof(T) * (this_layer_delta_sums.get_rows() * this_layer_delta_sums.get_cols() + this->get_rows()));
 	for (size_t i = 0; i < this->get_rows(); i++)
 	{
 		T res = T();
@@ -588,35 +762,60 @@ void nn::Matrix<T>::calculate_delta_biases_for_back_propagation(const Matrix<T>&
 		{
 			res += this_layer_delta_sums.at(i, j);
 		}
-		this->operator[](i) = res / this_layer_delta_sums.get_cols();
+		res = scale * res / this_layer_delta_sums.get_cols();
+		this->operator[](i) = accumulate ? this->operator[](i) + res : res;
 	}
 }
 
 template <typename T>
 void nn::Matrix<T>::calculate_delta_weights_for_back_propagation(const Matrix<T>& previous_layer_activations,
-                                                                 const Matrix<T>& this_layer_delta_sums)
+                                                                 const Matrix<T>& this_layer_delta_sums, const T scale,
+                                                                 const bool accumulate)
 {
-	const auto transpose_previous_layer_activation = previous_layer_activations.transpose();
-
-	this->multiply(this_layer_delta_sums, transpose_previous_layer_activation);
+	// Check if dimensions are compatible.
+	if (this->get_rows() != this_layer_delta_sums.get_rows() || this->get_cols() != previous_layer_activations.get_rows() ||
+		this_layer_delta_sums.get_cols() != previous_layer_activations.get_cols())
+	{
+		throw std::runtime_error("Cannot calculate delta weights for back propagation with incompatible dimensions.");
+	}
 
-	// delta_weights / batch_size
-	this->perform_element_wise_operation([&](const T& value) -> T
+	// Each dot product of a row of the delta sums and a row of the activations goes straight into its element, so
+	// accumulating needs no matrix of the size of the weights.
+	NN_PROFILE_WORK(2 * this->get_rows() * this->get_cols() * this_layer_delta_sums.get_cols(),
+		sizeof(T) * (this_layer_delta_sums.get_rows() * this_layer_delta_sums.get_cols() +
+			previous_layer_activations.get_rows() * previous_layer_activations.get_cols() + this->get_rows() * this->get_cols()));
+	for (size_t i = 0; i < this->get_rows(); i++)
 	{
-		return value / this_layer_delta_sums.get_cols();
-	});
+		for (size_t k = 0; k < this->get_cols(); k++)
+		{
+			T res = T();
+			for (size_t j = 0; j < this_layer_delta_sums.get_cols(); j++)
+			{
+				res += this_layer_delta_sums.at(i, j) * previous_layer_activations.at(k, j);
+			}
+			res = scale * res / this_layer_delta_sums.get_cols();
+			this->operator()(i, k) = accumulate ? this->operator()(i, k) + res : res;
+		}
+	}
+}
+
+template <typename T>
+void nn::Matrix<T>::calculate_delta_weights_and_biases_for_back_propagation(Matrix<T>& delta_biases,
+                                                                            const Matrix<T>& previous_layer_activations,
+                                                                            const Matrix<T>& this_layer_delta_sums,
+                                                                            const T scale, const bool accumulate)
+{
+	delta_biases.calculate_delta_biases_for_back_propagation(this_layer_delta_sums, scale, accumulate);
+	this->calculate_delta_weights_for_back_propagation(previous_layer_activations, this_layer_delta_sums, scale, accumulate);
 }
 
 template <typename T>
 void nn::Matrix<T>::calculate_delta_activation_from_expected_output(const Matrix<T>& this_layer_activations,
                                                                     const Matrix<T>& expected_output)
 {
-	*this = this_layer_activations;
-
-	this->perform_element_wise_operation(expected_output, [&](const T& value1, const T& value2) -> T
-	{
-		return (value1 - value2) * static_cast<T>(2.0);
-	});
+	// 2 * (activations - expected) in one pass
+	NN_PROFILE_WORK(2 * this->get_rows() * this->get_cols(), 2 * sizeof(T) * this->get_rows() * this->get_cols());
+	*this = (this_layer_activations - expected_output) * static_cast<T>(2.0);
 }
 
 
@@ -642,61 +841,88 @@ std::ostream& operator<<(std::ostream& os, const nn::Matrix<T>& matrix)
 
 #pragma region Float Specialization
 
-// Check if Intel MKL is available.
-#if defined(__has_include) && __has_include(<mkl.h>)
-
 template <>
 inline void nn::Matrix<float>::multiply(const Matrix<float>& matrix1, const Matrix<float>& matrix2,
 	Matrix<float>& result)
 {
-	// Initialize the result matrix to zero using MKL.
-	for (size_t i = 0; i < result.rows_ * result.cols_; ++i)
+	// Dispatch to the kernel for the instruction set of this CPU or the BLAS library (selected once, see Kernels.h).
+	nn::multiply(matrix1.view(), matrix2.view(), result.view());
+}
+
+template <>
+inline void nn::Matrix<float>::calculate_delta_activation_for_back_propagation(const Matrix<float>& next_layer_weights,
+                                                                               const Matrix<float>& next_layer_delta_sums)
+{
+	// transpose(weights) * delta_sums without materializing the transpose (plain loops without a BLAS backend)
+	NN_PROFILE_SCOPE("gemm");
+	nn::multiply_transposed_a(next_layer_weights.view(), next_layer_delta_sums.view(), this->view(), 1.0f, 0.0f);
+}
+
+template <>
+inline void nn::Matrix<float>::calculate_delta_biases_for_back_propagation(const Matrix<float>& this_layer_delta_sums,
+                                                                          const float scale, const bool accumulate)
+{
+	// Check if dimensions are compatible.
+	if (this->get_cols() != 1 || this->get_rows() != this_layer_delta_sums.get_rows())
 	{
-				result[i] = 0.0f;
+		throw std::runtime_error("Cannot calculate delta biases for back propagation with incompatible dimensions.");
 	}
 
-	// Perform matrix multiplication using MKL.
-	cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, static_cast<int>(matrix1.get_rows()), static_cast<int>(matrix2.get_cols()), static_cast<int>(matrix1.get_cols()),
-				1.0f, matrix1.get_data(), static_cast<int>(matrix1.get_cols()), matrix2.get_data(), static_cast<int>(matrix2.get_cols()), 1.0f, result.get_data(),
-		static_cast<int>(result.get_cols()));
+	// Mean of every row of the delta sums
+	nn::sum_rows(this_layer_delta_sums.view(), this->view(), scale / static_cast<float>(this_layer_delta_sums.get_cols()),
+		accumulate ? 1.0f : 0.0f);
 }
 
-#else defined(__AVX2__) || defined(__AVX__)
+template <>
+inline void nn::Matrix<float>::calculate_delta_weights_for_back_propagation(const Matrix<float>& previous_layer_activations,
+                                                                            const Matrix<float>& this_layer_delta_sums,
+                                                                            const float batch_scale, const bool accumulate)
+{
+	// (delta_sums * transpose(previous_layer_activations)) / batch_size in one product, added to the gradient if accumulate
+	NN_PROFILE_SCOPE("gemm");
+	nn::multiply_transposed_b(this_layer_delta_sums.view(), previous_layer_activations.view(), this->view(),
+		batch_scale / static_cast<float>(this_layer_delta_sums.get_cols()), accumulate ? 1.0f : 0.0f);
+}
 
 template <>
-inline void nn::Matrix<float>::multiply(const Matrix<float>& matrix1, const Matrix<float>& matrix2,
-	Matrix<float>& result)
+inline void nn::Matrix<float>::calculate_delta_weights_and_biases_for_back_propagation(Matrix<float>& delta_biases,
+	const Matrix<float>& previous_layer_activations, const Matrix<float>& this_layer_delta_sums, const float batch_scale,
+	const bool accumulate)
 {
-	// Initialize the result matrix to zero using intrinsics but data may not always be multiple of 8.
-	for (size_t i = 0; i < (result.rows_ * result.cols_) / 8; ++i)
+	if (delta_biases.get_cols() != 1 || delta_biases.get_rows() != this_layer_delta_sums.get_rows())
 	{
-		_mm256_store_ps(result.get_data() + i * 8, _mm256_setzero_ps());
+		throw std::runtime_error("Cannot calculate delta biases for back propagation with incompatible dimensions.");
 	}
-	for (size_t i = (result.rows_ * result.cols_) / 8 * 8; i < result.rows_ * result.cols_; ++i)
+
+	// delta_weights = scale * delta_sums * transpose(previous_layer_activations) / batch_size and the means of the rows of
+	// the delta sums, no transposed copy of the activations and no pass over the gradients after the product
+	NN_PROFILE_SCOPE("gemm");
+	nn::multiply_transposed_b_sum_rows(this_layer_delta_sums.view(), previous_layer_activations.view(), this->view(),
+		delta_biases.view(), batch_scale / static_cast<float>(this_layer_delta_sums.get_cols()), accumulate ? 1.0f : 0.0f);
+}
+
+template <>
+inline void nn::Matrix<float>::hadamard_product(const Matrix<float>& other)
+{
+	if (this->get_rows() != other.get_rows() || this->get_cols() != other.get_cols())
 	{
-		result[i] = 0.0f;
+		throw std::runtime_error("Cannot perform element wise operation on matrices with incompatible dimensions.");
 	}
 
-	// Perform matrix multiplication using intrinsics.
-	for (size_t i = 0; i < matrix1.get_rows(); ++i)
+	NN_PROFILE_WORK(this->get_rows() * this->get_cols(), 3 * sizeof(float) * this->get_rows() * this->get_cols());
+	kernels::get_kernels().hadamard(this->get_data(), other.get_data(), this->get_rows() * this->get_cols());
+}
+
+template <>
+inline void nn::Matrix<float>::add_scaled(const Matrix<float>& other, const float& scale)
+{
+	if (this->get_rows() != other.get_rows() || this->get_cols() != other.get_cols())
 	{
-		for (size_t k = 0; k < matrix1.get_cols(); ++k)
-		{
-			for (size_t j = 0; j < (matrix2.get_cols() / 8) * 8; j += 8)
-			{
-				const __m256 m1_vec = _mm256_set1_ps(matrix1.data_[i * matrix1.cols_ + k]);
-				const __m256 m2_vec = _mm256_load_ps(matrix2.data_ + k * matrix2.cols_ + j);
-				const __m256 m3_vec = _mm256_load_ps(result.data_ + i * result.cols_ + j);
-				_mm256_store_ps(result.data_ + i * result.cols_ + j, _mm256_fmadd_ps(m1_vec, m2_vec, m3_vec));
-			}
-			for (size_t j = (matrix2.get_cols() / 8) * 8; j < matrix2.get_cols(); ++j)
-			{
-				result.data_[i * result.cols_ + j] += matrix1.data_[i * matrix1.cols_ + k] * matrix2.data_[k * matrix2.cols_ + j];
-			}
-		}
+		throw std::runtime_error("Cannot perform element wise operation on matrices with incompatible dimensions.");
 	}
-}
 
-#endif
+	NN_PROFILE_WORK(2 * this->get_rows() * this->get_cols(), 3 * sizeof(float) * this->get_rows() * this->get_cols());
+	kernels::get_kernels().axpy(this->get_data(), other.get_data(), scale, this->get_rows() * this->get_cols());
+}
 
 #pragma endregion
@@ -3,9 +3,40 @@
 
 #include "NeuralNetwork/ActivationFunction.h"
 
+#include <algorithm> // std::copy_n, std::fill
 #include <cmath> // exp
+#include <stdexcept> // std::runtime_error
 
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
 #include "NeuralNetwork/Matrix.h" // nn::Matrix
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_WORK
+
+namespace
+{
+	/// <summary>
+	/// Accounts flop_per_element operations of an in place activation of mat (every element read and written once).
+	/// </summary>
+	void profile_element_wise([[maybe_unused]] const nn::Matrix<float>& mat, [[maybe_unused]] const size_t flop_per_element)
+	{
+		NN_PROFILE_WORK(flop_per_element * mat.get_rows() * mat.get_cols(), 2 * sizeof(float) * mat.get_rows() * mat.get_cols());
+	}
+
+	/// <summary>
+	/// Accounts flop_per_element operations of a fused backward pass over mat (two inputs read, one output written).
+	/// </summary>
+	void profile_backward([[maybe_unused]] const nn::Matrix<float>& mat, [[maybe_unused]] const size_t flop_per_element)
+	{
+		NN_PROFILE_WORK(flop_per_element * mat.get_rows() * mat.get_cols(), 3 * sizeof(float) * mat.get_rows() * mat.get_cols());
+	}
+}
+
+void nn::activation_functions::ActivationFunction::backward(const Matrix<float>& sums, const Matrix<float>&,
+                                                            const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	delta_sums = sums;
+	this->derivative(delta_sums);
+	delta_sums.hadamard_product(delta_activations);
+}
 
 float nn::activation_functions::Sigmoid::activation_function(const float x)
 {
@@ -14,70 +45,95 @@ float nn::activation_functions::Sigmoid::activation_function(const float x)
 
 void nn::activation_functions::Sigmoid::activate(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return 1 / (1 + exp(-x));
-	});
+	// 1 / (1 + exp(-x))
+	profile_element_wise(mat, 4);
+	kernels::get_kernels().sigmoid(mat.get_data(), mat.get_rows() * mat.get_cols());
 }
 
 void nn::activation_functions::Sigmoid::derivative(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return activation_function(x) * (1 - activation_function(x));
-	});
+	// s * (1 - s) with s = sigmoid(x)
+	profile_element_wise(mat, 6);
+	kernels::get_kernels().sigmoid_derivative(mat.get_data(), mat.get_rows() * mat.get_cols());
+}
+
+void nn::activation_functions::Sigmoid::backward(const Matrix<float>&, const Matrix<float>& activations,
+                                                 const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	// delta * s * (1 - s) with s = sigmoid(x), the activations
+	profile_backward(delta_sums, 3);
+	kernels::get_kernels().sigmoid_backward(delta_sums.get_data(), activations.get_data(), delta_activations.get_data(),
+	                                        delta_sums.get_rows() * delta_sums.get_cols());
 }
 
 void nn::activation_functions::ReLU::activate(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return (x > 0) * x;
-	});
+	profile_element_wise(mat, 1);
+	kernels::get_kernels().leaky_relu(mat.get_data(), 0.0f, mat.get_rows() * mat.get_cols());
 }
 
 void nn::activation_functions::ReLU::derivative(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return (x > 0);
-	});
+	profile_element_wise(mat, 1);
+	kernels::get_kernels().leaky_relu_derivative(mat.get_data(), 0.0f, mat.get_rows() * mat.get_cols());
+}
+
+void nn::activation_functions::ReLU::backward(const Matrix<float>&, const Matrix<float>& activations,
+                                              const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	// The activations are positive where the sums are
+	profile_backward(delta_sums, 1);
+	kernels::get_kernels().leaky_relu_backward(delta_sums.get_data(), activations.get_data(), delta_activations.get_data(),
+	                                           0.0f, delta_sums.get_rows() * delta_sums.get_cols());
 }
 
 void nn::activation_functions::Tanh::activate(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return (exp(x) - exp(-x)) / (exp(x) + exp(-x));
-	});
+	profile_element_wise(mat, 1);
+	kernels::get_kernels().tanh(mat.get_data(), mat.get_rows() * mat.get_cols());
 }
 
 void nn::activation_functions::Tanh::derivative(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return 1.0f - tanh(x) * tanh(x);
-	});
+	// 1 - tanh(x)^2
+	profile_element_wise(mat, 3);
+	kernels::get_kernels().tanh_derivative(mat.get_data(), mat.get_rows() * mat.get_cols());
+}
+
+void nn::activation_functions::Tanh::backward(const Matrix<float>&, const Matrix<float>& activations,
+                                              const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	// delta * (1 - t^2) with t = tanh(x), the activations
+	profile_backward(delta_sums, 3);
+	kernels::get_kernels().tanh_backward(delta_sums.get_data(), activations.get_data(), delta_activations.get_data(),
+	                                     delta_sums.get_rows() * delta_sums.get_cols());
 }
 
 void nn::activation_functions::LeakyReLU::activate(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return (x > 0) * x + (x <= 0) * 0.01f * x;
-	});
+	profile_element_wise(mat, 2);
+	kernels::get_kernels().leaky_relu(mat.get_data(), 0.01f, mat.get_rows() * mat.get_cols());
 }
 
 void nn::activation_functions::LeakyReLU::derivative(Matrix<float>& mat)
 {
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return (x > 0) + (x <= 0) * 0.01f;
-	});
+	profile_element_wise(mat, 1);
+	kernels::get_kernels().leaky_relu_derivative(mat.get_data(), 0.01f, mat.get_rows() * mat.get_cols());
+}
+
+void nn::activation_functions::LeakyReLU::backward(const Matrix<float>&, const Matrix<float>& activations,
+                                                   const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	// The activations are positive where the sums are (the slope is positive)
+	profile_backward(delta_sums, 2);
+	kernels::get_kernels().leaky_relu_backward(delta_sums.get_data(), activations.get_data(), delta_activations.get_data(),
+	                                           0.01f, delta_sums.get_rows() * delta_sums.get_cols());
 }
 
 void nn::activation_functions::SoftMax::activate(Matrix<float>& mat)
 {
+	// exp (twice), the sum and the division
+	profile_element_wise(mat, 4);
 	for (size_t j = 0; j < mat.get_cols(); ++j)
 	{
 		float sum = 0.0f;
@@ -95,27 +151,109 @@ void nn::activation_functions::SoftMax::activate(Matrix<float>& mat)
 
 void nn::activation_functions::SoftMax::derivative(Matrix<float>& mat)
 {
-	const auto temp = mat;
-	mat.perform_element_wise_operation([](const float x) -> float
-	{
-		return 0;
-	});
-
+	// sum over k of x_i * ((i == k) - x_k) = x_i * (1 - sum of the column), no copy of the column needed
+	profile_element_wise(mat, 3);
 	for (size_t j = 0; j < mat.get_cols(); ++j)
 	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < mat.get_rows(); ++i)
+		{
+			sum += mat(i, j);
+		}
+
 		for (size_t i = 0; i < mat.get_rows(); ++i)
 		{
-			for (size_t k = 0; k < mat.get_rows(); k++)
-			{
-				if (i == k)
-				{
-					mat(i, j) += temp(i, j) * (1 - temp(k, j));
-				}
-				else
-				{
-					mat(i, j) -= temp(i, j) * temp(k, j);
-				}
-			}
+			mat(i, j) = mat(i, j) * (1 - sum);
 		}
 	}
 }
+
+void nn::activation_functions::SoftMax::backward(const Matrix<float>& sums, const Matrix<float>&,
+                                                 const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	// The derivative of the sums times the delta in one pass over each column, without a copy of the sums
+	profile_backward(delta_sums, 4);
+	for (size_t j = 0; j < sums.get_cols(); ++j)
+	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < sums.get_rows(); ++i)
+		{
+			sum += sums(i, j);
+		}
+
+		for (size_t i = 0; i < sums.get_rows(); ++i)
+		{
+			delta_sums(i, j) = sums(i, j) * (1 - sum) * delta_activations(i, j);
+		}
+	}
+}
+
+void nn::activation_functions::Linear::activate(Matrix<float>&)
+{
+}
+
+void nn::activation_functions::Linear::derivative(Matrix<float>& mat)
+{
+	profile_element_wise(mat, 0);
+	std::fill(mat.get_data(), mat.get_data() + mat.get_rows() * mat.get_cols(), 1.0f);
+}
+
+void nn::activation_functions::Linear::backward(const Matrix<float>&, const Matrix<float>&,
+                                                const Matrix<float>& delta_activations, Matrix<float>& delta_sums)
+{
+	profile_element_wise(delta_sums, 0);
+	std::copy_n(delta_activations.get_data(), delta_sums.get_rows() * delta_sums.get_cols(), delta_sums.get_data());
+}
+
+nn::activation_functions::ActivationType nn::activation_functions::get_activation_type(
+	const ActivationFunction& activation_function)
+{
+	if (dynamic_cast<const Sigmoid*>(&activation_function))
+	{
+		return ActivationType::Sigmoid;
+	}
+	if (dynamic_cast<const ReLU*>(&activation_function))
+	{
+		return ActivationType::ReLU;
+	}
+	if (dynamic_cast<const LeakyReLU*>(&activation_function))
+	{
+		return ActivationType::LeakyReLU;
+	}
+	if (dynamic_cast<const Tanh*>(&activation_function))
+	{
+		return ActivationType::Tanh;
+	}
+	if (dynamic_cast<const SoftMax*>(&activation_function))
+	{
+		return ActivationType::SoftMax;
+	}
+	if (dynamic_cast<const Linear*>(&activation_function))
+	{
+		return ActivationType::Linear;
+	}
+
+	return ActivationType::Custom;
+}
+
+std::unique_ptr<nn::activation_functions::ActivationFunction> nn::activation_functions::create_activation_function(
+	const ActivationType type)
+{
+	switch (type)
+	{
+	case ActivationType::Sigmoid:
+		return std::make_unique<Sigmoid>();
+	case ActivationType::ReLU:
+		return std::make_unique<ReLU>();
+	case ActivationType::LeakyReLU:
+		return std::make_unique<LeakyReLU>();
+	case ActivationType::Tanh:
+		return std::make_unique<Tanh>();
+	case ActivationType::SoftMax:
+		return std::make_unique<SoftMax>();
+	case ActivationType::Linear:
+		return std::make_unique<Linear>();
+	default:
+		throw std::runtime_error("Custom activation functions cannot be created by type.");
+	}
+}
@@ -0,0 +1,131 @@
+// File: src/NeuralNetwork/AllocationTracker.cpp
+// Purpose: Implementation file for the allocation statistics of AlignedMemoryAllocator.
+
+#include "NeuralNetwork/AllocationTracker.h"
+
+#include <atomic> // std::atomic
+#include <cstring> // std::strcmp
+#include <iomanip> // std::setw
+#include <mutex> // std::mutex, std::lock_guard
+#include <stdexcept> // std::logic_error
+#include <string> // std::string, std::to_string
+
+namespace
+{
+	std::atomic<size_t> live_bytes{ 0 };
+	std::atomic<size_t> peak_bytes{ 0 };
+	std::atomic<size_t> allocations{ 0 };
+	std::atomic<size_t> deallocations{ 0 };
+
+	std::mutex tags_mutex;
+
+	/// <summary>
+	/// Allocations per tag. Few tags, so a linear search beats hashing. Constructed on first use, so matrices
+	/// of static storage duration in other translation units are counted as well.
+	/// </summary>
+	std::vector<nn::memory::TagStats>& get_tags()
+	{
+		static std::vector<nn::memory::TagStats> tags;
+		return tags;
+	}
+
+	thread_local const char* current_tag = nn::memory::untagged;
+	thread_local size_t guard_depth = 0;
+}
+
+nn::memory::ScopedTag::ScopedTag(const char* tag)
+	: previous_tag_(current_tag)
+{
+	current_tag = tag;
+}
+
+nn::memory::ScopedTag::~ScopedTag()
+{
+	current_tag = this->previous_tag_;
+}
+
+nn::memory::NoAllocationGuard::NoAllocationGuard()
+{
+	++guard_depth;
+}
+
+nn::memory::NoAllocationGuard::~NoAllocationGuard()
+{
+	--guard_depth;
+}
+
+void nn::memory::record_allocation(const size_t bytes)
+{
+	if (guard_depth != 0)
+	{
+		throw std::logic_error("Allocation of " + std::to_string(bytes) + " bytes (" + current_tag +
+			") inside a NoAllocationGuard.");
+	}
+
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	const size_t live = live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	size_t peak = peak_bytes.load(std::memory_order_relaxed);
+	while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+
+	const std::lock_guard<std::mutex> lock(tags_mutex);
+	std::vector<TagStats>& tags = get_tags();
+	for (TagStats& tag : tags)
+	{
+		if (tag.tag == current_tag || std::strcmp(tag.tag, current_tag) == 0)
+		{
+			++tag.allocations;
+			tag.bytes += bytes;
+			return;
+		}
+	}
+	tags.push_back(TagStats{ current_tag, 1, bytes });
+}
+
+void nn::memory::record_deallocation(const size_t bytes)
+{
+	deallocations.fetch_add(1, std::memory_order_relaxed);
+	live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+nn::memory::AllocationStats nn::memory::get_stats()
+{
+	return AllocationStats{
+		live_bytes.load(std::memory_order_relaxed),
+		peak_bytes.load(std::memory_order_relaxed),
+		allocations.load(std::memory_order_relaxed),
+		deallocations.load(std::memory_order_relaxed)
+	};
+}
+
+std::vector<nn::memory::TagStats> nn::memory::get_tag_stats()
+{
+	const std::lock_guard<std::mutex> lock(tags_mutex);
+	return get_tags();
+}
+
+void nn::memory::reset()
+{
+	allocations.store(0, std::memory_order_relaxed);
+	deallocations.store(0, std::memory_order_relaxed);
+	peak_bytes.store(live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	const std::lock_guard<std::mutex> lock(tags_mutex);
+	get_tags().clear();
+}
+
+void nn::memory::write_report(std::ostream& os)
+{
+	const AllocationStats stats = get_stats();
+	os << "live bytes: " << stats.live_bytes << ", peak bytes: " << stats.peak_bytes << ", allocations: "
+		<< stats.allocations << ", frees: " << stats.deallocations << "\n";
+
+	os << std::left << std::setw(40) << "tag" << std::right << std::setw(14) << "allocations" << std::setw(16)
+		<< "bytes" << "\n";
+	for (const TagStats& tag : get_tag_stats())
+	{
+		os << std::left << std::setw(40) << tag.tag << std::right << std::setw(14) << tag.allocations
+			<< std::setw(16) << tag.bytes << "\n";
+	}
+}
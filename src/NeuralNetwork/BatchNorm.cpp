@@ -0,0 +1,410 @@
+// File: src/NeuralNetwork/BatchNorm.cpp
+// Purpose: Source file for BatchNorm class, a batch normalization layer.
+
+#include "NeuralNetwork/BatchNorm.h"
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_WORK
+
+#include <algorithm> // std::fill
+#include <cmath> // std::sqrt
+
+// Every neuron is a row of the activation matrices and the samples of the batch are its columns, so the statistics of a
+// neuron are reductions over one contiguous row: the sums use the row_sums kernel, the sums of products use independent
+// partial sums the compiler vectorizes.
+
+namespace
+{
+	/// <summary>
+	/// Returns the sum of x[i] * y[i] with 8 independent partial sums (vectorizes without reassociating).
+	/// </summary>
+	float dot(const float* x, const float* y, const size_t size)
+	{
+		float lanes[8] = {};
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			for (size_t lane = 0; lane < 8; ++lane)
+			{
+				lanes[lane] += x[i + lane] * y[i + lane];
+			}
+		}
+		for (; i < size; ++i)
+		{
+			lanes[i % 8] += x[i] * y[i];
+		}
+
+		float sum = 0.0f;
+		for (const float lane : lanes)
+		{
+			sum += lane;
+		}
+		return sum;
+	}
+
+	void fill(nn::Matrix<float>& matrix, const float value)
+	{
+		std::fill(matrix.get_data(), matrix.get_data() + matrix.get_rows() * matrix.get_cols(), value);
+	}
+}
+
+nn::BatchNorm::BatchNorm(const size_t neuron_count, const size_t batch_size,
+                         std::unique_ptr<activation_functions::ActivationFunction> activation_function,
+                         const float momentum, const float epsilon)
+	: momentum_(momentum), epsilon_(epsilon)
+{
+	if (neuron_count == 0 || batch_size == 0)
+	{
+		throw std::runtime_error("Invalid batch normalization parameters.");
+	}
+	if (momentum < 0.0f || momentum > 1.0f || epsilon <= 0.0f)
+	{
+		throw std::runtime_error("Batch normalization needs a momentum in [0, 1] and a positive epsilon.");
+	}
+
+	this->neuron_count_ = neuron_count;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices
+	this->activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->gamma_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->beta_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->delta_gamma_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->delta_beta_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->delta_mean_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->delta_projection_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->running_mean_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->running_variance_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->mean_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->inverse_std_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->normalized_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+
+	// Identity transform until the layer learns
+	fill(*this->gamma_, 1.0f);
+	fill(*this->beta_, 0.0f);
+	fill(*this->delta_gamma_, 0.0f);
+	fill(*this->delta_beta_, 0.0f);
+	fill(*this->delta_mean_, 0.0f);
+	fill(*this->delta_projection_, 0.0f);
+	fill(*this->running_mean_, 0.0f);
+	fill(*this->running_variance_, 1.0f);
+
+	if (activation_function)
+	{
+		this->activation_function_ = std::move(activation_function);
+	}
+	else
+	{
+		this->activation_function_ = std::make_unique<activation_functions::Linear>();
+	}
+}
+
+float nn::BatchNorm::get_momentum() const
+{
+	return this->momentum_;
+}
+
+float nn::BatchNorm::get_epsilon() const
+{
+	return this->epsilon_;
+}
+
+bool nn::BatchNorm::is_training() const
+{
+	return this->training_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_gamma() const
+{
+	return *this->gamma_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_beta() const
+{
+	return *this->beta_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_delta_gamma() const
+{
+	return *this->delta_gamma_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_delta_beta() const
+{
+	return *this->delta_beta_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_running_mean() const
+{
+	return *this->running_mean_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_running_variance() const
+{
+	return *this->running_variance_;
+}
+
+const nn::Matrix<float>& nn::BatchNorm::get_normalized() const
+{
+	return *this->normalized_;
+}
+
+const nn::activation_functions::ActivationFunction* nn::BatchNorm::get_activation_function() const
+{
+	return this->activation_function_.get();
+}
+
+void nn::BatchNorm::set_gamma(const Matrix<float>& gamma)
+{
+	if (gamma.get_rows() != this->neuron_count_ || gamma.get_cols() != 1)
+	{
+		throw std::runtime_error("Gamma matrix is not the correct size.");
+	}
+	*this->gamma_ = gamma;
+}
+
+void nn::BatchNorm::set_beta(const Matrix<float>& beta)
+{
+	if (beta.get_rows() != this->neuron_count_ || beta.get_cols() != 1)
+	{
+		throw std::runtime_error("Beta matrix is not the correct size.");
+	}
+	*this->beta_ = beta;
+}
+
+void nn::BatchNorm::set_running_statistics(const Matrix<float>& mean, const Matrix<float>& variance)
+{
+	if (mean.get_rows() != this->neuron_count_ || mean.get_cols() != 1 ||
+		variance.get_rows() != this->neuron_count_ || variance.get_cols() != 1)
+	{
+		throw std::runtime_error("Running statistics are not the correct size.");
+	}
+	*this->running_mean_ = mean;
+	*this->running_variance_ = variance;
+}
+
+void nn::BatchNorm::set_training(const bool training)
+{
+	this->training_ = training;
+}
+
+void nn::BatchNorm::feed_forward(const Layer& previous_layer)
+{
+	const Matrix<float>& input = previous_layer.get_activations();
+	if (input.get_rows() != this->neuron_count_ || input.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the batch normalization.");
+	}
+
+	const size_t batch = this->batch_size_;
+	const float inverse_batch = 1.0f / static_cast<float>(batch);
+	// Unbiased variance for the running statistics (a single sample has none)
+	const float correction = batch > 1 ? static_cast<float>(batch) / static_cast<float>(batch - 1) : 1.0f;
+
+	{
+		NN_PROFILE_SCOPE("normalize");
+		NN_PROFILE_WORK(6 * this->neuron_count_ * batch, 4 * sizeof(float) * this->neuron_count_ * batch);
+		if (this->training_)
+		{
+			kernels::get_kernels().row_sums(input.get_data(), this->mean_->get_data(), this->neuron_count_, batch,
+				inverse_batch, batch);
+		}
+
+		for (size_t i = 0; i < this->neuron_count_; ++i)
+		{
+			const float* in = input.get_data() + i * batch;
+			float* normalized = this->normalized_->get_data() + i * batch;
+			float* sums = this->sums_->get_data() + i * batch;
+
+			float mean, inverse_std;
+			if (this->training_)
+			{
+				// Centered values first, the variance is the mean of their squares
+				mean = (*this->mean_)[i];
+				for (size_t b = 0; b < batch; ++b)
+				{
+					normalized[b] = in[b] - mean;
+				}
+				const float variance = dot(normalized, normalized, batch) * inverse_batch;
+				inverse_std = 1.0f / std::sqrt(variance + this->epsilon_);
+
+				(*this->running_mean_)[i] += this->momentum_ * (mean - (*this->running_mean_)[i]);
+				(*this->running_variance_)[i] += this->momentum_ * (correction * variance - (*this->running_variance_)[i]);
+			}
+			else
+			{
+				mean = (*this->running_mean_)[i];
+				inverse_std = 1.0f / std::sqrt((*this->running_variance_)[i] + this->epsilon_);
+				(*this->mean_)[i] = mean;
+				for (size_t b = 0; b < batch; ++b)
+				{
+					normalized[b] = in[b] - mean;
+				}
+			}
+			(*this->inverse_std_)[i] = inverse_std;
+
+			const float gamma = (*this->gamma_)[i], beta = (*this->beta_)[i];
+			for (size_t b = 0; b < batch; ++b)
+			{
+				normalized[b] *= inverse_std;
+				sums[b] = gamma * normalized[b] + beta;
+			}
+		}
+	}
+
+	NN_PROFILE_SCOPE("activation");
+	// Copy the sums to the activations matrix
+	this->activations_->operator=(*this->sums_);
+	// Apply the activation function to the activations matrix
+	this->activation_function_->activate(*this->activations_);
+}
+
+void nn::BatchNorm::back_propagate(const Layer& next_layer, const Layer&)
+{
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		next_layer.propagate_delta_to_previous_layer(*this->delta_activations_);
+	}
+
+	this->calculate_gradients();
+}
+
+void nn::BatchNorm::back_propagate(const Matrix<float>& expected_activations, const Layer&)
+{
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		this->delta_activations_->calculate_delta_activation_from_expected_output(this->get_activations(), expected_activations);
+	}
+
+	this->calculate_gradients();
+}
+
+void nn::BatchNorm::calculate_gradients()
+{
+	{
+		NN_PROFILE_SCOPE("activation_derivative");
+		this->activation_function_->backward(*this->sums_, *this->activations_, *this->delta_activations_, *this->delta_sums_);
+	}
+
+	// Means over the batch: delta_beta = delta_sums, delta_gamma = delta_sums * normalized
+	NN_PROFILE_SCOPE("delta_gamma_beta");
+	const size_t batch = this->batch_size_;
+	const float inverse_batch = 1.0f / static_cast<float>(batch);
+	NN_PROFILE_WORK(3 * this->neuron_count_ * batch + 4 * this->neuron_count_, 2 * sizeof(float) * this->neuron_count_ * batch);
+	kernels::get_kernels().row_sums(this->delta_sums_->get_data(), this->delta_mean_->get_data(), this->neuron_count_, batch,
+		inverse_batch, batch);
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		(*this->delta_projection_)[i] = inverse_batch *
+			dot(this->delta_sums_->get_data() + i * batch, this->normalized_->get_data() + i * batch, batch);
+	}
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		const float beta = this->gradient_scale_ * (*this->delta_mean_)[i];
+		const float gamma = this->gradient_scale_ * (*this->delta_projection_)[i];
+		(*this->delta_beta_)[i] = this->accumulate_gradients_ ? (*this->delta_beta_)[i] + beta : beta;
+		(*this->delta_gamma_)[i] = this->accumulate_gradients_ ? (*this->delta_gamma_)[i] + gamma : gamma;
+	}
+}
+
+void nn::BatchNorm::propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const
+{
+	if (previous_delta_activations.get_rows() != this->neuron_count_ || previous_delta_activations.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the batch normalization.");
+	}
+
+	NN_PROFILE_SCOPE("delta_normalize");
+	const size_t batch = this->batch_size_;
+	NN_PROFILE_WORK(4 * this->neuron_count_ * batch, 3 * sizeof(float) * this->neuron_count_ * batch);
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		const float* delta = this->delta_sums_->get_data() + i * batch;
+		const float* normalized = this->normalized_->get_data() + i * batch;
+		float* previous_delta = previous_delta_activations.get_data() + i * batch;
+		const float scale = (*this->gamma_)[i] * (*this->inverse_std_)[i];
+
+		// The running statistics are constants
+		if (!this->training_)
+		{
+			for (size_t b = 0; b < batch; ++b)
+			{
+				previous_delta[b] = scale * delta[b];
+			}
+			continue;
+		}
+
+		// The batch mean and variance move with every sample: remove the mean of the delta and its projection on the
+		// normalized values (their means over the batch, the unscaled gradients of beta and gamma of this batch)
+		const float delta_mean = (*this->delta_mean_)[i];
+		const float delta_projection = (*this->delta_projection_)[i];
+		for (size_t b = 0; b < batch; ++b)
+		{
+			previous_delta[b] = scale * (delta[b] - delta_mean - normalized[b] * delta_projection);
+		}
+	}
+}
+
+std::vector<nn::Parameter> nn::BatchNorm::get_parameters()
+{
+	return { { "gamma", this->gamma_.get(), this->delta_gamma_.get() }, { "beta", this->beta_.get(), this->delta_beta_.get() } };
+}
+
+bool nn::BatchNorm::is_recomputable() const
+{
+	return false;
+}
+
+nn::MemoryRequirements nn::BatchNorm::get_memory_requirements() const
+{
+	MemoryRequirements requirements;
+	requirements.parameter_bytes = get_bytes(this->gamma_) + get_bytes(this->beta_) + get_bytes(this->delta_gamma_) +
+		get_bytes(this->delta_beta_) + get_bytes(this->running_mean_) + get_bytes(this->running_variance_);
+	// Back propagation reads the normalized values and the statistics of feed_forward
+	requirements.activation_bytes = get_bytes(this->activations_) + get_bytes(this->sums_) + get_bytes(this->normalized_) +
+		get_bytes(this->mean_) + get_bytes(this->inverse_std_);
+	requirements.workspace_bytes = get_bytes(this->delta_activations_) + get_bytes(this->delta_sums_) +
+		get_bytes(this->delta_mean_) + get_bytes(this->delta_projection_);
+	return requirements;
+}
+
+void nn::BatchNorm::fold_into(DenseLayer& previous_layer)
+{
+	if (this->activation_function_ == nullptr)
+	{
+		throw std::runtime_error("Batch normalization has already been folded.");
+	}
+	if (previous_layer.get_parameters().empty() || previous_layer.get_neuron_count() != this->neuron_count_)
+	{
+		throw std::runtime_error("Batch normalization does not follow the given layer.");
+	}
+	if (activation_functions::get_activation_type(*previous_layer.get_activation_function()) !=
+		activation_functions::ActivationType::Linear)
+	{
+		throw std::runtime_error("Batch normalization can only be folded into a layer with a linear activation.");
+	}
+
+	// gamma * (W x + b - mean) / std + beta = (scale * W) x + scale * (b - mean) + beta
+	Matrix<float> weights = previous_layer.get_weights();
+	Matrix<float> biases = previous_layer.get_biases();
+	const size_t inputs = weights.get_cols();
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		const float scale = (*this->gamma_)[i] / std::sqrt((*this->running_variance_)[i] + this->epsilon_);
+		float* row = weights.get_data() + i * inputs;
+		for (size_t j = 0; j < inputs; ++j)
+		{
+			row[j] *= scale;
+		}
+		biases[i] = scale * (biases[i] - (*this->running_mean_)[i]) + (*this->beta_)[i];
+	}
+
+	previous_layer.set_weights(weights);
+	previous_layer.set_biases(biases);
+	previous_layer.set_activation_function(std::move(this->activation_function_));
+}
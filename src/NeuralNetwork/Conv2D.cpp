@@ -0,0 +1,557 @@
+// File: src/NeuralNetwork/Conv2D.cpp
+// Purpose: Source file for Conv2D class, a 2d convolutional layer.
+
+#include "NeuralNetwork/Conv2D.h"
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_WORK
+
+#include <algorithm> // std::min, std::max
+#include <cmath> // std::sqrt
+#include <cstring> // std::memcpy, std::memset
+
+// Layout: the images of a batch are the columns of the activation matrices, so element (channel, y, x) of sample b
+// is at ((channel * height + y) * width + x) * batch_size + b. Viewed as channels x (height * width * batch_size),
+// the same data is the matrix product output of the convolution, so sums_ is written in place. The columns of a
+// row of output positions are contiguous as well, which the direct path uses for its shifted spans.
+
+nn::Conv2D::Conv2D(const size_t input_channels, const size_t input_height, const size_t input_width,
+                   const size_t output_channels, const size_t kernel_size, const size_t batch_size, const size_t stride,
+                   const size_t padding, std::unique_ptr<activation_functions::ActivationFunction> activation_function,
+                   const ConvolutionAlgorithm algorithm)
+	: input_channels_(input_channels), input_height_(input_height), input_width_(input_width),
+	  output_channels_(output_channels), output_height_(0), output_width_(0), kernel_size_(kernel_size), stride_(stride),
+	  padding_(padding), algorithm_(ConvolutionAlgorithm::Im2col)
+{
+	if (input_channels == 0 || output_channels == 0 || kernel_size == 0 || stride == 0 || batch_size == 0)
+	{
+		throw std::runtime_error("Invalid convolution parameters.");
+	}
+	if (input_height + 2 * padding < kernel_size || input_width + 2 * padding < kernel_size)
+	{
+		throw std::runtime_error("Kernel is larger than the padded input.");
+	}
+
+	this->output_height_ = (input_height + 2 * padding - kernel_size) / stride + 1;
+	this->output_width_ = (input_width + 2 * padding - kernel_size) / stride + 1;
+	const size_t neuron_count = output_channels * this->output_height_ * this->output_width_;
+	const size_t fan_in = input_channels * kernel_size * kernel_size;
+
+	this->neuron_count_ = neuron_count;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices
+	this->activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->weights_ = std::make_unique<Matrix<float>>(output_channels, fan_in);
+	this->biases_ = std::make_unique<Matrix<float>>(output_channels, 1);
+	this->sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_weights_ = std::make_unique<Matrix<float>>(output_channels, fan_in);
+	this->delta_biases_ = std::make_unique<Matrix<float>>(output_channels, 1);
+	this->delta_sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+
+	// Every kernel sees fan_in inputs, so the range of the weights shrinks with it
+	const float range = 1.0f / std::sqrt(static_cast<float>(fan_in));
+	this->weights_->randomize(-range, range);
+	this->biases_->randomize(-range, range);
+
+	if (activation_function)
+	{
+		this->activation_function_ = std::move(activation_function);
+	}
+	else
+	{
+		this->activation_function_ = std::make_unique<activation_functions::Sigmoid>();
+	}
+
+	this->set_algorithm(algorithm);
+}
+
+size_t nn::Conv2D::get_input_channels() const
+{
+	return this->input_channels_;
+}
+
+size_t nn::Conv2D::get_input_height() const
+{
+	return this->input_height_;
+}
+
+size_t nn::Conv2D::get_input_width() const
+{
+	return this->input_width_;
+}
+
+size_t nn::Conv2D::get_output_channels() const
+{
+	return this->output_channels_;
+}
+
+size_t nn::Conv2D::get_output_height() const
+{
+	return this->output_height_;
+}
+
+size_t nn::Conv2D::get_output_width() const
+{
+	return this->output_width_;
+}
+
+size_t nn::Conv2D::get_kernel_size() const
+{
+	return this->kernel_size_;
+}
+
+size_t nn::Conv2D::get_stride() const
+{
+	return this->stride_;
+}
+
+size_t nn::Conv2D::get_padding() const
+{
+	return this->padding_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_weights() const
+{
+	return *this->weights_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_biases() const
+{
+	return *this->biases_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_sums() const
+{
+	return *this->sums_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_delta_sums() const
+{
+	return *this->delta_sums_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_delta_weights() const
+{
+	return *this->delta_weights_;
+}
+
+const nn::Matrix<float>& nn::Conv2D::get_delta_biases() const
+{
+	return *this->delta_biases_;
+}
+
+const nn::activation_functions::ActivationFunction* nn::Conv2D::get_activation_function() const
+{
+	return this->activation_function_.get();
+}
+
+void nn::Conv2D::set_weights(const Matrix<float>& weights)
+{
+	if (weights.get_rows() != this->weights_->get_rows() || weights.get_cols() != this->weights_->get_cols())
+	{
+		throw std::runtime_error("Weights matrix is not the correct size.");
+	}
+	*this->weights_ = weights;
+}
+
+void nn::Conv2D::set_biases(const Matrix<float>& biases)
+{
+	if (biases.get_rows() != this->biases_->get_rows() || biases.get_cols() != this->biases_->get_cols())
+	{
+		throw std::runtime_error("Biases matrix is not the correct size.");
+	}
+	*this->biases_ = biases;
+}
+
+nn::ConvolutionAlgorithm nn::Conv2D::get_algorithm() const
+{
+	return this->algorithm_;
+}
+
+void nn::Conv2D::set_algorithm(const ConvolutionAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case ConvolutionAlgorithm::Auto:
+		this->algorithm_ = this->kernel_size_ == 3 && this->stride_ == 1 ? ConvolutionAlgorithm::Direct : ConvolutionAlgorithm::Im2col;
+		break;
+	case ConvolutionAlgorithm::Direct:
+		if (this->stride_ != 1)
+		{
+			throw std::runtime_error("The direct convolution requires stride 1.");
+		}
+		this->algorithm_ = ConvolutionAlgorithm::Direct;
+		break;
+	case ConvolutionAlgorithm::Im2col:
+		this->algorithm_ = ConvolutionAlgorithm::Im2col;
+		break;
+	}
+
+	// Only the im2col path uses the receptive fields
+	if (this->algorithm_ == ConvolutionAlgorithm::Direct)
+	{
+		this->columns_.reset();
+		this->delta_columns_.reset();
+	}
+}
+
+void nn::Conv2D::ensure_size(std::unique_ptr<Matrix<float>>& matrix, const size_t rows, const size_t cols)
+{
+	if (matrix == nullptr || matrix->get_rows() != rows || matrix->get_cols() != cols)
+	{
+		matrix = std::make_unique<Matrix<float>>(rows, cols);
+	}
+}
+
+void nn::Conv2D::im2col(const Matrix<float>& input)
+{
+	NN_PROFILE_SCOPE("im2col");
+	const size_t batch = this->batch_size_;
+	const size_t positions = this->output_height_ * this->output_width_;
+	const size_t k = this->kernel_size_;
+	ensure_size(this->columns_, this->input_channels_ * k * k, positions * batch);
+	NN_PROFILE_WORK(0, 2 * sizeof(float) * this->columns_->get_rows() * this->columns_->get_cols());
+
+	const float* in = input.get_data();
+	for (size_t c = 0; c < this->input_channels_; ++c)
+	{
+		for (size_t ky = 0; ky < k; ++ky)
+		{
+			for (size_t kx = 0; kx < k; ++kx)
+			{
+				float* row = this->columns_->get_data() + ((c * k + ky) * k + kx) * positions * batch;
+				for (size_t oy = 0; oy < this->output_height_; ++oy)
+				{
+					// Input row of this output row (in padded coordinates)
+					const size_t iy = oy * this->stride_ + ky;
+					for (size_t ox = 0; ox < this->output_width_; ++ox)
+					{
+						const size_t ix = ox * this->stride_ + kx;
+						float* destination = row + (oy * this->output_width_ + ox) * batch;
+						if (iy < this->padding_ || iy >= this->input_height_ + this->padding_ ||
+							ix < this->padding_ || ix >= this->input_width_ + this->padding_)
+						{
+							std::memset(destination, 0, batch * sizeof(float));
+							continue;
+						}
+						const float* source = in + ((c * this->input_height_ + iy - this->padding_) * this->input_width_ + ix - this->padding_) * batch;
+						std::memcpy(destination, source, batch * sizeof(float));
+					}
+				}
+			}
+		}
+	}
+}
+
+void nn::Conv2D::feed_forward(const Layer& previous_layer)
+{
+	const Matrix<float>& input = previous_layer.get_activations();
+	if (input.get_rows() != this->input_channels_ * this->input_height_ * this->input_width_ || input.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the input of the convolution.");
+	}
+
+	const size_t batch = this->batch_size_;
+	const size_t positions = this->output_height_ * this->output_width_;
+	const size_t k = this->kernel_size_;
+	// Allocate the matrices again after release_activations
+	ensure_size(this->activations_, this->neuron_count_, batch);
+	ensure_size(this->sums_, this->neuron_count_, batch);
+	const MatrixView<float> sums(this->sums_->get_data(), this->output_channels_, positions * batch);
+
+	{
+		NN_PROFILE_SCOPE("sums");
+		if (this->algorithm_ == ConvolutionAlgorithm::Im2col)
+		{
+			// sums = kernels (output channels x receptive field) * receptive fields (receptive field x positions), then the biases
+			this->im2col(input);
+			NN_PROFILE_SCOPE("gemm");
+			multiply(*this->weights_, *this->columns_, sums);
+			NN_PROFILE_WORK(sums.get_rows() * sums.get_cols(), 2 * sizeof(float) * sums.get_rows() * sums.get_cols());
+			expressions::evaluate(sums + expressions::broadcast(*this->biases_, sums.get_rows(), sums.get_cols()), sums);
+		}
+		else
+		{
+			NN_PROFILE_SCOPE("direct");
+			const kernels::KernelTable& table = kernels::get_kernels();
+			expressions::evaluate(expressions::broadcast(*this->biases_, sums.get_rows(), sums.get_cols()), sums);
+			NN_PROFILE_WORK(2 * this->weights_->get_rows() * this->weights_->get_cols() * positions * batch,
+				sizeof(float) * (input.get_rows() * batch + 2 * sums.get_rows() * sums.get_cols()));
+
+			// Every weight times the span of the input under it, one axpy per output row (stride 1)
+			for (size_t o = 0; o < this->output_channels_; ++o)
+			{
+				for (size_t c = 0; c < this->input_channels_; ++c)
+				{
+					for (size_t ky = 0; ky < k; ++ky)
+					{
+						for (size_t kx = 0; kx < k; ++kx)
+						{
+							const float weight = this->weights_->at(o, (c * k + ky) * k + kx);
+							// Output columns whose input column is inside the image
+							const size_t ox_begin = this->padding_ > kx ? this->padding_ - kx : 0;
+							const size_t ox_end = std::min(this->output_width_, this->input_width_ + this->padding_ - kx);
+							if (ox_begin >= ox_end)
+							{
+								continue;
+							}
+							for (size_t oy = 0; oy < this->output_height_; ++oy)
+							{
+								const size_t iy = oy + ky;
+								if (iy < this->padding_ || iy >= this->input_height_ + this->padding_)
+								{
+									continue;
+								}
+								float* out = &sums(o, (oy * this->output_width_ + ox_begin) * batch);
+								const float* in = input.get_data() + ((c * this->input_height_ + iy - this->padding_) * this->input_width_ +
+									ox_begin + kx - this->padding_) * batch;
+								table.axpy(out, in, weight, (ox_end - ox_begin) * batch);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	NN_PROFILE_SCOPE("activation");
+	// Copy the sums to the activations matrix
+	this->activations_->operator=(*this->sums_);
+	// Apply the activation function to the activations matrix
+	this->activation_function_->activate(*this->activations_);
+}
+
+void nn::Conv2D::back_propagate(const Layer& next_layer, const Layer& previous_layer)
+{
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		next_layer.propagate_delta_to_previous_layer(*this->delta_activations_);
+	}
+
+	this->calculate_delta_sums();
+	this->calculate_gradients(previous_layer);
+}
+
+void nn::Conv2D::back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer)
+{
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		this->delta_activations_->calculate_delta_activation_from_expected_output(this->get_activations(), expected_activations);
+	}
+
+	this->calculate_delta_sums();
+	this->calculate_gradients(previous_layer);
+}
+
+void nn::Conv2D::calculate_delta_sums()
+{
+	NN_PROFILE_SCOPE("activation_derivative");
+	this->activation_function_->backward(*this->sums_, *this->activations_, *this->delta_activations_, *this->delta_sums_);
+}
+
+void nn::Conv2D::calculate_gradients(const Layer& previous_layer)
+{
+	const size_t batch = this->batch_size_;
+	const size_t positions = this->output_height_ * this->output_width_;
+	const size_t k = this->kernel_size_;
+	const float scale = this->gradient_scale_ / static_cast<float>(batch);
+	const float beta = this->accumulate_gradients_ ? 1.0f : 0.0f;
+	const MatrixView<const float> delta_sums(this->delta_sums_->get_data(), this->output_channels_, positions * batch);
+
+	if (this->algorithm_ == ConvolutionAlgorithm::Im2col)
+	{
+		// The receptive fields of this batch are still in columns_ from feed_forward, the biases are the means over the
+		// batch of the sums over the output positions, taken in the same sweep over the delta sums
+		NN_PROFILE_SCOPE("delta_weights");
+		multiply_transposed_b_sum_rows(delta_sums, *this->columns_, *this->delta_weights_, *this->delta_biases_, scale, beta);
+		return;
+	}
+
+	// Mean over the batch of the sum over the output positions
+	{
+		NN_PROFILE_SCOPE("delta_biases");
+		sum_rows(delta_sums, *this->delta_biases_, scale, beta);
+	}
+
+	NN_PROFILE_SCOPE("delta_weights");
+
+	// Dot products of the delta spans with the input spans under every weight
+	const Matrix<float>& input = previous_layer.get_activations();
+	NN_PROFILE_WORK(2 * this->weights_->get_rows() * this->weights_->get_cols() * positions * batch,
+		sizeof(float) * (input.get_rows() * batch + delta_sums.get_rows() * delta_sums.get_cols()));
+	for (size_t o = 0; o < this->output_channels_; ++o)
+	{
+		for (size_t c = 0; c < this->input_channels_; ++c)
+		{
+			for (size_t ky = 0; ky < k; ++ky)
+			{
+				for (size_t kx = 0; kx < k; ++kx)
+				{
+					// Independent partial sums, so the reduction vectorizes without reassociating
+					float lanes[8] = {};
+					const size_t ox_begin = this->padding_ > kx ? this->padding_ - kx : 0;
+					const size_t ox_end = std::min(this->output_width_, this->input_width_ + this->padding_ - kx);
+					for (size_t oy = 0; ox_begin < ox_end && oy < this->output_height_; ++oy)
+					{
+						const size_t iy = oy + ky;
+						if (iy < this->padding_ || iy >= this->input_height_ + this->padding_)
+						{
+							continue;
+						}
+						const float* delta = &delta_sums(o, (oy * this->output_width_ + ox_begin) * batch);
+						const float* in = input.get_data() + ((c * this->input_height_ + iy - this->padding_) * this->input_width_ +
+							ox_begin + kx - this->padding_) * batch;
+						const size_t size = (ox_end - ox_begin) * batch;
+						size_t i = 0;
+						for (; i + 8 <= size; i += 8)
+						{
+							for (size_t lane = 0; lane < 8; ++lane)
+							{
+								lanes[lane] += delta[i + lane] * in[i + lane];
+							}
+						}
+						for (; i < size; ++i)
+						{
+							lanes[i % 8] += delta[i] * in[i];
+						}
+					}
+					float sum = 0.0f;
+					for (const float lane : lanes)
+					{
+						sum += lane;
+					}
+					float& delta_weight = (*this->delta_weights_)(o, (c * k + ky) * k + kx);
+					delta_weight = beta == 0.0f ? scale * sum : delta_weight + scale * sum;
+				}
+			}
+		}
+	}
+}
+
+void nn::Conv2D::propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const
+{
+	if (previous_delta_activations.get_rows() != this->input_channels_ * this->input_height_ * this->input_width_ ||
+		previous_delta_activations.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the input of the convolution.");
+	}
+
+	const size_t batch = this->batch_size_;
+	const size_t positions = this->output_height_ * this->output_width_;
+	const size_t k = this->kernel_size_;
+	const MatrixView<const float> delta_sums(this->delta_sums_->get_data(), this->output_channels_, positions * batch);
+	float* previous_delta = previous_delta_activations.get_data();
+	std::memset(previous_delta, 0, previous_delta_activations.get_rows() * batch * sizeof(float));
+
+	if (this->algorithm_ == ConvolutionAlgorithm::Im2col)
+	{
+		// Delta of the receptive fields, then every field is added back to the input positions it was read from (col2im)
+		ensure_size(this->delta_columns_, this->input_channels_ * k * k, positions * batch);
+		{
+			NN_PROFILE_SCOPE("gemm");
+			multiply_transposed_a(*this->weights_, delta_sums, *this->delta_columns_);
+		}
+
+		NN_PROFILE_SCOPE("col2im");
+		NN_PROFILE_WORK(this->delta_columns_->get_rows() * this->delta_columns_->get_cols(),
+			3 * sizeof(float) * this->delta_columns_->get_rows() * this->delta_columns_->get_cols());
+		const kernels::KernelTable& table = kernels::get_kernels();
+		for (size_t c = 0; c < this->input_channels_; ++c)
+		{
+			for (size_t ky = 0; ky < k; ++ky)
+			{
+				for (size_t kx = 0; kx < k; ++kx)
+				{
+					const float* row = this->delta_columns_->get_data() + ((c * k + ky) * k + kx) * positions * batch;
+					for (size_t oy = 0; oy < this->output_height_; ++oy)
+					{
+						const size_t iy = oy * this->stride_ + ky;
+						if (iy < this->padding_ || iy >= this->input_height_ + this->padding_)
+						{
+							continue;
+						}
+						for (size_t ox = 0; ox < this->output_width_; ++ox)
+						{
+							const size_t ix = ox * this->stride_ + kx;
+							if (ix < this->padding_ || ix >= this->input_width_ + this->padding_)
+							{
+								continue;
+							}
+							table.axpy(previous_delta + ((c * this->input_height_ + iy - this->padding_) * this->input_width_ + ix - this->padding_) * batch,
+								row + (oy * this->output_width_ + ox) * batch, 1.0f, batch);
+						}
+					}
+				}
+			}
+		}
+		return;
+	}
+
+	// The transpose of the forward pass: every weight times the delta span goes back to the input span under it
+	NN_PROFILE_SCOPE("direct");
+	NN_PROFILE_WORK(2 * this->weights_->get_rows() * this->weights_->get_cols() * positions * batch,
+		sizeof(float) * (2 * previous_delta_activations.get_rows() * batch + delta_sums.get_rows() * delta_sums.get_cols()));
+	const kernels::KernelTable& table = kernels::get_kernels();
+	for (size_t o = 0; o < this->output_channels_; ++o)
+	{
+		for (size_t c = 0; c < this->input_channels_; ++c)
+		{
+			for (size_t ky = 0; ky < k; ++ky)
+			{
+				for (size_t kx = 0; kx < k; ++kx)
+				{
+					const float weight = this->weights_->at(o, (c * k + ky) * k + kx);
+					const size_t ox_begin = this->padding_ > kx ? this->padding_ - kx : 0;
+					const size_t ox_end = std::min(this->output_width_, this->input_width_ + this->padding_ - kx);
+					if (ox_begin >= ox_end)
+					{
+						continue;
+					}
+					for (size_t oy = 0; oy < this->output_height_; ++oy)
+					{
+						const size_t iy = oy + ky;
+						if (iy < this->padding_ || iy >= this->input_height_ + this->padding_)
+						{
+							continue;
+						}
+						table.axpy(previous_delta + ((c * this->input_height_ + iy - this->padding_) * this->input_width_ + ox_begin + kx - this->padding_) * batch,
+							&delta_sums(o, (oy * this->output_width_ + ox_begin) * batch), weight, (ox_end - ox_begin) * batch);
+					}
+				}
+			}
+		}
+	}
+}
+
+std::vector<nn::Parameter> nn::Conv2D::get_parameters()
+{
+	return { { "weights", this->weights_.get(), this->delta_weights_.get() }, { "biases", this->biases_.get(), this->delta_biases_.get() } };
+}
+
+nn::MemoryRequirements nn::Conv2D::get_memory_requirements() const
+{
+	MemoryRequirements requirements;
+	requirements.parameter_bytes = get_bytes(this->weights_) + get_bytes(this->biases_) + get_bytes(this->delta_weights_) +
+		get_bytes(this->delta_biases_);
+	requirements.activation_bytes = get_bytes(this->activations_) + get_bytes(this->sums_);
+	requirements.workspace_bytes = get_bytes(this->delta_activations_) + get_bytes(this->delta_sums_);
+
+	// The receptive fields are sized on first use, count them from the start (not after release_activations)
+	if (this->algorithm_ == ConvolutionAlgorithm::Im2col)
+	{
+		const size_t fields = this->input_channels_ * this->kernel_size_ * this->kernel_size_ *
+			this->output_height_ * this->output_width_ * this->batch_size_ * sizeof(float);
+		requirements.activation_bytes += this->activations_ != nullptr ? fields : 0;
+		requirements.workspace_bytes += fields;
+	}
+	return requirements;
+}
+
+void nn::Conv2D::release_activations()
+{
+	this->activations_.reset();
+	this->sums_.reset();
+	this->columns_.reset();
+}
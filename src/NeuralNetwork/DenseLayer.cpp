@@ -0,0 +1,554 @@
+// File: src/NeuralNetwork/DenseLayer.cpp
+// Purpose: Source file for DenseLayer class, a fully connected layer of a neural network.
+
+#include "NeuralNetwork/DenseLayer.h"
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE
+
+nn::DenseLayer::DenseLayer() = default;
+
+nn::DenseLayer::DenseLayer(const size_t neuron_count, const size_t batch_size)
+{
+	this->initialize(neuron_count, batch_size);
+}
+
+nn::DenseLayer::DenseLayer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count)
+{
+	this->initialize(neuron_count, batch_size, previous_layer_neuron_count);
+}
+
+nn::DenseLayer::DenseLayer(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count,
+                           std::unique_ptr<activation_functions::ActivationFunction> activation_function)
+{
+	this->initialize(neuron_count, batch_size, previous_layer_neuron_count, std::move(activation_function));
+}
+
+nn::DenseLayer::~DenseLayer() = default;
+
+void nn::DenseLayer::initialize(const size_t neuron_count, const size_t batch_size)
+{
+	// Check if the layer has already been initialized.
+	if (this->neuron_count_ != 0)
+	{
+		throw std::runtime_error("Layer has already been initialized.");
+	}
+
+	this->neuron_count_ = neuron_count;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices.
+	this->activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	// Set the actication function to Sigmoid.
+	this->activation_function_ = std::make_unique<activation_functions::Sigmoid>();
+}
+
+void nn::DenseLayer::initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count)
+{
+	// Check if the layer has already been initialized.
+	if (this->neuron_count_ != 0)
+	{
+		throw std::runtime_error("Layer has already been initialized.");
+	}
+
+	this->neuron_count_ = neuron_count;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices
+	this->activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->weights_ = std::make_unique<Matrix<float>>(neuron_count, previous_layer_neuron_count);
+	this->biases_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	// Initialize the delta matrices
+	this->delta_activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_weights_ = std::make_unique<Matrix<float>>(neuron_count, previous_layer_neuron_count);
+	this->delta_biases_ = std::make_unique<Matrix<float>>(neuron_count, 1);
+	this->delta_sums_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+
+	// Randomize the weights and biases
+	this->weights_->randomize(-1.0f, 1.0f);
+	this->biases_->randomize(-1.0f, 1.0f);
+
+	// Initialize the activation function to the sigmoid function
+	this->activation_function_ = std::make_unique<activation_functions::Sigmoid>();
+}
+
+void nn::DenseLayer::initialize(const size_t neuron_count, const size_t batch_size, const size_t previous_layer_neuron_count,
+                                std::unique_ptr<activation_functions::ActivationFunction> activation_function)
+{
+	this->initialize(neuron_count, batch_size, previous_layer_neuron_count);
+
+	// Delete the previous activation function
+	this->activation_function_.reset();
+	// Set the activation function
+	this->activation_function_ = std::move(activation_function);
+}
+
+void nn::DenseLayer::set_activation_function(std::unique_ptr<activation_functions::ActivationFunction> activation_function)
+{
+	// Delete the previous activation function
+	this->activation_function_.reset();
+	// Set the activation function
+	this->activation_function_ = std::move(activation_function);
+}
+
+void nn::DenseLayer::set_weights(std::unique_ptr<Matrix<float>> weights)
+{
+	// Check if weights is initialized
+	if (this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Weights matrix is not initialized.");
+	}
+	// Check if the size of the weights matrix is correct
+	if (weights->get_rows() != this->weights_->get_rows() || weights->get_cols() != this->weights_->get_cols())
+	{
+		throw std::runtime_error("Weights matrix is not the correct size.");
+	}
+
+	// Delete the previous weights matrix
+	this->weights_.reset();
+	// Set the weights matrix
+	this->weights_ = std::move(weights);
+	this->update_reduced_precision_weights();
+}
+
+void nn::DenseLayer::set_weights(const Matrix<float>& weights)
+{
+	// Check if weights is initialized
+	if (this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Weights matrix is not initialized.");
+	}
+	// Check if the size of the weights matrix is correct
+	if (weights.get_rows() != this->weights_->get_rows() || weights.get_cols() != this->weights_->get_cols())
+	{
+		throw std::runtime_error("Weights matrix is not the correct size.");
+	}
+
+	// Loop through the weights matrix and set the weights
+	for (size_t i = 0; i < weights.get_rows() * weights.get_cols(); i++)
+	{
+		this->weights_->operator[](i) = weights[i];
+	}
+	this->update_reduced_precision_weights();
+}
+
+void nn::DenseLayer::set_biases(std::unique_ptr<nn::Matrix<float>> biases)
+{
+	// Check if biases is initialized
+	if (this->biases_ == nullptr)
+	{
+		throw std::runtime_error("Biases matrix is not initialized.");
+	}
+	// Check if the size of the biases matrix is correct
+	if (biases->get_rows() != this->biases_->get_rows() || biases->get_cols() != this->biases_->get_cols())
+	{
+		throw std::runtime_error("Biases matrix is not the correct size.");
+	}
+
+	// Delete the previous biases matrix
+	this->biases_.reset();
+	// Set the biases matrix
+	this->biases_ = std::move(biases);
+}
+
+void nn::DenseLayer::set_biases(const Matrix<float>& biases)
+{
+// Check if biases is initialized
+	if (this->biases_ == nullptr)
+	{
+		throw std::runtime_error("Biases matrix is not initialized.");
+	}
+	// Check if the size of the biases matrix is correct
+	if (biases.get_rows() != this->biases_->get_rows() || biases.get_cols() != this->biases_->get_cols())
+	{
+		throw std::runtime_error("Biases matrix is not the correct size.");
+	}
+
+	// Loop through the biases matrix and set the biases
+	for (size_t i = 0; i < biases.get_rows() * biases.get_cols(); i++)
+	{
+		this->biases_->operator[](i) = biases[i];
+	}
+}
+
+void nn::DenseLayer::share_parameters(const DenseLayer& source)
+{
+	// Check if both layers are initialized and of the same shape
+	if (this->weights_ == nullptr || source.weights_ == nullptr)
+	{
+		throw std::runtime_error("Weights matrix is not initialized.");
+	}
+	if (this->weights_->get_rows() != source.weights_->get_rows() || this->weights_->get_cols() != source.weights_->get_cols())
+	{
+		throw std::runtime_error("Weights matrix is not the correct size.");
+	}
+
+	this->weights_ = source.weights_;
+	this->biases_ = source.biases_;
+	this->update_reduced_precision_weights();
+}
+
+std::unique_ptr<nn::DenseLayer> nn::DenseLayer::create_replica() const
+{
+	// Check if the layer is initialized
+	if (this->neuron_count_ == 0)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+
+	auto replica = std::make_unique<DenseLayer>();
+	replica->neuron_count_ = this->neuron_count_;
+	replica->batch_size_ = this->batch_size_;
+	replica->activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+	replica->activation_function_ = activation_functions::create_activation_function(
+		activation_functions::get_activation_type(*this->activation_function_));
+	// An input layer has only activations
+	if (this->weights_ == nullptr)
+	{
+		return replica;
+	}
+
+	replica->weights_ = this->weights_;
+	replica->biases_ = this->biases_;
+	replica->sums_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+	replica->delta_activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+	replica->delta_weights_ = std::make_unique<Matrix<float>>(this->weights_->get_rows(), this->weights_->get_cols());
+	replica->delta_biases_ = std::make_unique<Matrix<float>>(this->neuron_count_, 1);
+	replica->delta_sums_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+	return replica;
+}
+
+void nn::DenseLayer::set_weight_precision(const Precision precision)
+{
+	// Check if this layer is initialized and is not the input layer
+	if (this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Weights matrix is not initialized.");
+	}
+
+	this->weight_precision_ = precision;
+
+	// Keep only the copy for the selected precision
+	this->weights_bf16_.reset();
+	this->weights_fp16_.reset();
+	if (precision == Precision::BFloat16)
+	{
+		this->weights_bf16_ = std::make_unique<Matrix<bfloat16>>(this->weights_->get_rows(), this->weights_->get_cols());
+	}
+	else if (precision == Precision::Float16)
+	{
+		this->weights_fp16_ = std::make_unique<Matrix<float16>>(this->weights_->get_rows(), this->weights_->get_cols());
+	}
+
+	this->update_reduced_precision_weights();
+}
+
+void nn::DenseLayer::change_batch_size(const size_t batch_size)
+{
+	// Check if the layer is initialized
+	if (this->neuron_count_ == 0)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+	// Check if the batch size is the same
+	if (batch_size == this->batch_size_)
+	{
+		return;
+	}
+
+	// Change the batch size
+	this->batch_size_ = batch_size;
+
+	// Delete the activations matrix and create a new one
+	this->activations_.reset();
+	this->activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+
+	// Check if the layer is a hidden layer
+	if (this->weights_ == nullptr)
+	{
+		return;
+	}
+
+	// Delete remaining matrices and create new ones
+	this->sums_.reset();
+	this->sums_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+	this->delta_activations_.reset();
+	this->delta_activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+	this->delta_sums_.reset();
+	this->delta_sums_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+}
+
+nn::Precision nn::DenseLayer::get_weight_precision() const
+{
+	return this->weight_precision_;
+}
+
+const nn::activation_functions::ActivationFunction* nn::DenseLayer::get_activation_function() const
+{
+	return this->activation_function_.get();
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_sums() const
+{
+	if (this->sums_ == nullptr)
+	{
+		throw std::runtime_error("Sums matrix is not initialized.");
+	}
+
+	return *this->sums_;
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_weights() const
+{
+	if (this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Weights matrix is not initialized.");
+	}
+
+	return *this->weights_;
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_biases() const
+{
+	if (this->biases_ == nullptr)
+	{
+		throw std::runtime_error("Biases matrix is not initialized.");
+	}
+
+	return *this->biases_;
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_delta_sums() const
+{
+	if (this->delta_sums_ == nullptr)
+	{
+		throw std::runtime_error("Delta sums matrix is not initialized.");
+	}
+
+	return *this->delta_sums_;
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_delta_weights() const
+{
+	if (this->delta_weights_ == nullptr)
+	{
+		throw std::runtime_error("Delta weights matrix is not initialized.");
+	}
+
+	return *this->delta_weights_;
+}
+
+const nn::Matrix<float>& nn::DenseLayer::get_delta_biases() const
+{
+	if (this->delta_biases_ == nullptr)
+	{
+		throw std::runtime_error("Delta biases matrix is not initialized.");
+	}
+
+	return *this->delta_biases_;
+}
+
+void nn::DenseLayer::reset()
+{
+	// Check if the layer is initialized
+	if (this->neuron_count_ == 0)
+	{
+		return;
+	}
+
+	// Resets neuron count and batch size
+	this->neuron_count_ = 0;
+	this->batch_size_ = 0;
+
+	// Resets the activation matrix
+	this->activations_.reset();
+
+	// Check if the layer is a hidden layer
+	if (this->weights_ == nullptr)
+	{
+		return;
+	}
+
+	// Resets the weights, biases, sums, and delta matrices
+	this->weights_.reset();
+	this->weights_bf16_.reset();
+	this->weights_fp16_.reset();
+	this->weight_precision_ = Precision::Float32;
+	this->biases_.reset();
+	this->sums_.reset();
+	this->delta_activations_.reset();
+	this->delta_weights_.reset();
+	this->delta_biases_.reset();
+	this->delta_sums_.reset();
+}
+
+void nn::DenseLayer::feed_forward(const Layer& previous_layer)
+{
+	// Check if this layer is initialized and is not the input layer
+	if (this->neuron_count_ == 0 || previous_layer.get_neuron_count() == 0 || this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+
+	// Allocate the matrices again after release_activations
+	if (this->activations_ == nullptr)
+	{
+		this->activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+		this->sums_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+	}
+
+	// Calculate the sums with the weights of the selected precision
+	{
+		NN_PROFILE_SCOPE("sums");
+		switch (this->weight_precision_)
+		{
+		case Precision::BFloat16:
+			half_precision::calculate_sums_for_forward_propagation(*this->weights_bf16_, *this->biases_, previous_layer.get_activations(), *this->sums_);
+			break;
+		case Precision::Float16:
+			half_precision::calculate_sums_for_forward_propagation(*this->weights_fp16_, *this->biases_, previous_layer.get_activations(), *this->sums_);
+			break;
+		case Precision::Float32:
+			this->sums_->calculate_sums_for_forward_propagation(*this->weights_, *this->biases_, previous_layer.get_activations());
+			break;
+		}
+	}
+
+	NN_PROFILE_SCOPE("activation");
+	// Copy the sums to the activations matrix
+	this->activations_->operator=(*this->sums_);
+	// Apply the activation function to the activations matrix
+	this->activation_function_->activate(*this->activations_);
+}
+
+void nn::DenseLayer::back_propagate(const Layer& next_layer, const Layer& previous_layer)
+{
+	// Check if this layer is initialized and is not the input layer
+	if (next_layer.get_neuron_count() == 0 || previous_layer.get_neuron_count() == 0 || this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		next_layer.propagate_delta_to_previous_layer(*this->delta_activations_);
+	}
+
+	// Calculate the delta sums
+	this->calculate_delta_sums();
+
+	// Calculate delta weights and delta biases in one sweep over the delta sums
+	NN_PROFILE_SCOPE("delta_weights");
+	this->delta_weights_->calculate_delta_weights_and_biases_for_back_propagation(*this->delta_biases_,
+		previous_layer.get_activations(), *this->delta_sums_, this->gradient_scale_, this->accumulate_gradients_);
+}
+
+void nn::DenseLayer::back_propagate(const Matrix<float>& expected_activations, const Layer& previous_layer)
+{
+// Check if this layer is initialized and is not the input layer
+	if (this->activations_ == nullptr || this->weights_ == nullptr)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+
+	// Calculate the delta activations
+	{
+		NN_PROFILE_SCOPE("delta_activations");
+		this->delta_activations_->calculate_delta_activation_from_expected_output(this->get_activations(), expected_activations);
+	}
+
+	// Calculate the delta sums
+	this->calculate_delta_sums();
+
+	// Calculate delta weights and delta biases in one sweep over the delta sums
+	NN_PROFILE_SCOPE("delta_weights");
+	this->delta_weights_->calculate_delta_weights_and_biases_for_back_propagation(*this->delta_biases_,
+		previous_layer.get_activations(), *this->delta_sums_, this->gradient_scale_, this->accumulate_gradients_);
+}
+
+void nn::DenseLayer::propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const
+{
+	previous_delta_activations.calculate_delta_activation_for_back_propagation(this->get_weights(), this->get_delta_sums());
+}
+
+void nn::DenseLayer::calculate_delta_sums()
+{
+	NN_PROFILE_SCOPE("activation_derivative");
+	this->activation_function_->backward(*this->sums_, *this->activations_, *this->delta_activations_, *this->delta_sums_);
+}
+
+void nn::DenseLayer::update_weights_and_biases(const float learning_rate)
+{
+	// Check if this layer is initialized and is not the input layer
+	if (this->weights_ == nullptr || this->biases_ == nullptr)
+	{
+		throw std::runtime_error("Layer is not initialized.");
+	}
+
+	// Update the weights and biases (weight = weight - learning_rate * delta_weight)
+	this->weights_->add_scaled(*this->delta_weights_, -learning_rate);
+	this->biases_->add_scaled(*this->delta_biases_, -learning_rate);
+
+	// Refresh the reduced precision copy from the updated master weights
+	this->update_reduced_precision_weights();
+}
+
+std::vector<nn::Parameter> nn::DenseLayer::get_parameters()
+{
+	// The input layer has nothing to train
+	if (this->weights_ == nullptr)
+	{
+		return {};
+	}
+
+	return { { "weights", this->weights_.get(), this->delta_weights_.get() }, { "biases", this->biases_.get(), this->delta_biases_.get() } };
+}
+
+nn::MemoryRequirements nn::DenseLayer::get_memory_requirements() const
+{
+	MemoryRequirements requirements;
+	requirements.parameter_bytes = get_bytes(this->weights_) + get_bytes(this->biases_) + get_bytes(this->delta_weights_) +
+		get_bytes(this->delta_biases_) + get_bytes(this->weights_bf16_) + get_bytes(this->weights_fp16_);
+	// Back propagation reads the activations and sums of feed_forward
+	requirements.activation_bytes = get_bytes(this->activations_) + get_bytes(this->sums_);
+	requirements.workspace_bytes = get_bytes(this->delta_activations_) + get_bytes(this->delta_sums_);
+	return requirements;
+}
+
+void nn::DenseLayer::release_activations()
+{
+	// The input layer has nothing to recompute its activations from
+	if (this->weights_ == nullptr)
+	{
+		return;
+	}
+	this->activations_.reset();
+	this->sums_.reset();
+}
+
+void nn::DenseLayer::update_reduced_precision_weights()
+{
+	if (this->weights_bf16_ != nullptr)
+	{
+		half_precision::convert(*this->weights_, *this->weights_bf16_);
+	}
+	if (this->weights_fp16_ != nullptr)
+	{
+		half_precision::convert(*this->weights_, *this->weights_fp16_);
+	}
+}
+
+nn::DenseLayer& nn::as_dense_layer(Layer& layer)
+{
+	auto* dense_layer = dynamic_cast<DenseLayer*>(&layer);
+	if (dense_layer == nullptr)
+	{
+		throw std::runtime_error("Only dense layers are supported.");
+	}
+	return *dense_layer;
+}
+
+const nn::DenseLayer& nn::as_dense_layer(const Layer& layer)
+{
+	return as_dense_layer(const_cast<Layer&>(layer));
+}
@@ -0,0 +1,658 @@
+// File: src/NeuralNetwork/Distributed.cpp
+// Purpose: Implementation file for distributed data parallel training.
+
+#include "NeuralNetwork/Distributed.h"
+#include "NeuralNetwork/Pipeline.h" // nn::pipeline::SpscQueue, nn::pipeline::Backoff
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_LAYER_SCOPE, NN_PROFILE_WORK
+
+#include <algorithm> // std::min, std::max, std::min_element
+#include <atomic> // std::atomic
+#include <cerrno> // errno
+#include <cstring> // std::memcpy, std::strerror
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <limits> // std::numeric_limits
+#include <stdexcept> // std::runtime_error
+#include <thread> // std::thread, std::this_thread::sleep_for
+
+#ifndef _WIN32
+#include <fcntl.h> // fcntl
+#include <netdb.h> // getaddrinfo
+#include <netinet/in.h> // IPPROTO_TCP
+#include <netinet/tcp.h> // TCP_NODELAY
+#include <poll.h> // poll
+#include <sys/socket.h> // socket, bind, listen, accept, connect, send, recv
+#include <sys/un.h> // sockaddr_un
+#include <unistd.h> // close, unlink
+#endif
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// Message that ends the epoch (instead of a layer index).
+	/// </summary>
+	constexpr size_t stop = std::numeric_limits<size_t>::max();
+
+	/// <summary>
+	/// Floats a rank receives before it forwards them in a broadcast.
+	/// </summary>
+	constexpr size_t broadcast_piece = 64 * 1024;
+
+	/// <summary>
+	/// Thrown in the threads that wait on a queue after another thread failed.
+	/// </summary>
+	struct Aborted
+	{
+	};
+
+	std::runtime_error socket_error(const std::string& what)
+	{
+		return std::runtime_error(what + ": " + std::strerror(errno));
+	}
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+	// A peer that closed its socket makes send fail with EPIPE instead of raising SIGPIPE (Linux, BSDs)
+	constexpr int send_flags = MSG_NOSIGNAL;
+#else
+	// macOS has no MSG_NOSIGNAL: SO_NOSIGPIPE is set on the sockets instead (configure)
+	constexpr int send_flags = 0;
+#endif
+
+	/// <summary>
+	/// Socket address of a Tcp "host:port" or a Unix path.
+	/// </summary>
+	struct SocketAddress
+	{
+		sockaddr_storage storage{};
+		socklen_t length = 0;
+		int family = AF_UNSPEC;
+		std::string path;
+	};
+
+	SocketAddress resolve(const nn::distributed::Transport transport, const std::string& address)
+	{
+		SocketAddress result;
+		if (transport == nn::distributed::Transport::Unix)
+		{
+			sockaddr_un unix_address{};
+			if (address.empty() || address.size() >= sizeof(unix_address.sun_path))
+			{
+				throw std::runtime_error("Invalid Unix socket path: " + address);
+			}
+			unix_address.sun_family = AF_UNIX;
+			std::memcpy(unix_address.sun_path, address.c_str(), address.size() + 1);
+			std::memcpy(&result.storage, &unix_address, sizeof(unix_address));
+			result.length = sizeof(unix_address);
+			result.family = AF_UNIX;
+			result.path = address;
+			return result;
+		}
+
+		const size_t colon = address.rfind(':');
+		if (colon == std::string::npos || colon == 0 || colon + 1 == address.size())
+		{
+			throw std::runtime_error("Invalid TCP address (host:port): " + address);
+		}
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* info = nullptr;
+		if (getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon + 1).c_str(), &hints, &info) != 0 || info == nullptr)
+		{
+			throw std::runtime_error("Cannot resolve TCP address: " + address);
+		}
+		std::memcpy(&result.storage, info->ai_addr, info->ai_addrlen);
+		result.length = static_cast<socklen_t>(info->ai_addrlen);
+		result.family = info->ai_family;
+		freeaddrinfo(info);
+		return result;
+	}
+
+	/// <summary>
+	/// Makes a connected socket non-blocking (transfers poll), keeps it from raising SIGPIPE where send has no
+	///	MSG_NOSIGNAL and, for TCP, sends small messages right away.
+	/// </summary>
+	void configure(const int socket, const int family)
+	{
+		if (fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK) != 0)
+		{
+			throw socket_error("Cannot make the socket non-blocking");
+		}
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+		const int no_signal = 1;
+		if (setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &no_signal, sizeof(no_signal)) != 0)
+		{
+			throw socket_error("Cannot disable SIGPIPE on the socket");
+		}
+#endif
+		if (family != AF_UNIX)
+		{
+			const int enabled = 1;
+			setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+		}
+	}
+
+	int open_listener(const SocketAddress& address)
+	{
+		const int listener = ::socket(address.family, SOCK_STREAM, 0);
+		if (listener < 0)
+		{
+			throw socket_error("Cannot create a socket");
+		}
+		if (address.family == AF_UNIX)
+		{
+			// A path left over from an earlier run would make bind fail
+			unlink(address.path.c_str());
+		}
+		else
+		{
+			const int enabled = 1;
+			setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+		}
+		if (bind(listener, reinterpret_cast<const sockaddr*>(&address.storage), address.length) != 0 || listen(listener, 1) != 0)
+		{
+			const std::runtime_error error = socket_error("Cannot listen");
+			close(listener);
+			throw error;
+		}
+		return listener;
+	}
+
+	/// <summary>
+	/// Connects to a listener, retrying until it is up or the deadline has passed.
+	/// </summary>
+	int connect_to(const SocketAddress& address, const clock::time_point deadline)
+	{
+		for (;;)
+		{
+			const int socket = ::socket(address.family, SOCK_STREAM, 0);
+			if (socket < 0)
+			{
+				throw socket_error("Cannot create a socket");
+			}
+			if (connect(socket, reinterpret_cast<const sockaddr*>(&address.storage), address.length) == 0)
+			{
+				return socket;
+			}
+			const int error = errno;
+			close(socket);
+			// The neighbour is not listening yet
+			if ((error != ECONNREFUSED && error != ENOENT) || clock::now() > deadline)
+			{
+				errno = error;
+				throw socket_error("Cannot connect to the next rank");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	int accept_from(const int listener, const clock::time_point deadline)
+	{
+		pollfd descriptor{ listener, POLLIN, 0 };
+		const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+		if (poll(&descriptor, 1, static_cast<int>(std::max<long long>(remaining.count(), 0))) <= 0)
+		{
+			throw std::runtime_error("The previous rank did not connect in time.");
+		}
+		const int socket = accept(listener, nullptr, nullptr);
+		if (socket < 0)
+		{
+			throw socket_error("Cannot accept the previous rank");
+		}
+		return socket;
+	}
+#endif
+}
+
+std::vector<std::string> nn::distributed::get_local_addresses(const Transport transport, const std::string& base, const size_t world_size)
+{
+	std::vector<std::string> addresses;
+	if (transport == Transport::Unix)
+	{
+		for (size_t rank = 0; rank < world_size; ++rank)
+		{
+			addresses.push_back(base + "." + std::to_string(rank));
+		}
+		return addresses;
+	}
+
+	const size_t colon = base.rfind(':');
+	if (colon == std::string::npos)
+	{
+		throw std::runtime_error("Invalid TCP address (host:port): " + base);
+	}
+	const unsigned long port = std::stoul(base.substr(colon + 1));
+	for (size_t rank = 0; rank < world_size; ++rank)
+	{
+		addresses.push_back(base.substr(0, colon + 1) + std::to_string(port + rank));
+	}
+	return addresses;
+}
+
+nn::distributed::Communicator::Communicator(const Transport transport, const std::vector<std::string>& addresses, const size_t rank,
+                                            const std::chrono::milliseconds timeout)
+	: rank_(rank), world_size_(addresses.size()), timeout_(timeout)
+{
+	if (rank >= addresses.size())
+	{
+		throw std::runtime_error("Rank is not in the ring.");
+	}
+	if (this->world_size_ == 1)
+	{
+		return;
+	}
+#ifdef _WIN32
+	static_cast<void>(transport);
+	throw std::runtime_error("Distributed training needs POSIX sockets.");
+#else
+	const SocketAddress own = resolve(transport, addresses[rank]);
+	const SocketAddress next = resolve(transport, addresses[(rank + 1) % this->world_size_]);
+	const auto deadline = clock::now() + timeout;
+
+	// Listening first lets the previous rank connect while this one connects to the next: no rank waits in a cycle
+	const int listener = open_listener(own);
+	try
+	{
+		this->send_socket_ = connect_to(next, deadline);
+		this->receive_socket_ = accept_from(listener, deadline);
+		configure(this->send_socket_, own.family);
+		configure(this->receive_socket_, own.family);
+	}
+	catch (...)
+	{
+		close(listener);
+		if (own.family == AF_UNIX)
+		{
+			unlink(own.path.c_str());
+		}
+		if (this->send_socket_ >= 0)
+		{
+			close(this->send_socket_);
+		}
+		if (this->receive_socket_ >= 0)
+		{
+			close(this->receive_socket_);
+		}
+		throw;
+	}
+	close(listener);
+	if (own.family == AF_UNIX)
+	{
+		unlink(own.path.c_str());
+	}
+#endif
+}
+
+nn::distributed::Communicator::~Communicator()
+{
+#ifndef _WIN32
+	if (this->send_socket_ >= 0)
+	{
+		close(this->send_socket_);
+	}
+	if (this->receive_socket_ >= 0)
+	{
+		close(this->receive_socket_);
+	}
+#endif
+}
+
+size_t nn::distributed::Communicator::get_rank() const
+{
+	return this->rank_;
+}
+
+size_t nn::distributed::Communicator::get_world_size() const
+{
+	return this->world_size_;
+}
+
+size_t nn::distributed::Communicator::get_bytes_sent() const
+{
+	return this->bytes_sent_;
+}
+
+void nn::distributed::Communicator::exchange(const void* send_data, const size_t send_bytes, void* receive_data, const size_t receive_bytes)
+{
+#ifdef _WIN32
+	static_cast<void>(send_data);
+	static_cast<void>(send_bytes);
+	static_cast<void>(receive_data);
+	static_cast<void>(receive_bytes);
+	throw std::runtime_error("Distributed training needs POSIX sockets.");
+#else
+	const auto* send_bytes_data = static_cast<const char*>(send_data);
+	auto* receive_bytes_data = static_cast<char*>(receive_data);
+	size_t sent = 0, received = 0;
+	// Both directions at once: a rank that only sent could wait for a neighbour that waits for it to receive
+	while (sent < send_bytes || received < receive_bytes)
+	{
+		pollfd descriptors[2] = {
+			{ sent < send_bytes ? this->send_socket_ : -1, POLLOUT, 0 },
+			{ received < receive_bytes ? this->receive_socket_ : -1, POLLIN, 0 }
+		};
+		const int ready = poll(descriptors, 2, static_cast<int>(this->timeout_.count()));
+		if (ready == 0)
+		{
+			throw std::runtime_error("A neighbouring rank did not answer in time.");
+		}
+		if (ready < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			throw socket_error("Cannot wait for the neighbouring ranks");
+		}
+
+		if (descriptors[0].revents != 0)
+		{
+			const ssize_t count = send(this->send_socket_, send_bytes_data + sent, send_bytes - sent, send_flags);
+			if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				throw socket_error("Cannot send to the next rank");
+			}
+			sent += count > 0 ? static_cast<size_t>(count) : 0;
+		}
+		if (descriptors[1].revents != 0)
+		{
+			const ssize_t count = recv(this->receive_socket_, receive_bytes_data + received, receive_bytes - received, 0);
+			if (count == 0)
+			{
+				throw std::runtime_error("The previous rank closed the connection.");
+			}
+			if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				throw socket_error("Cannot receive from the previous rank");
+			}
+			received += count > 0 ? static_cast<size_t>(count) : 0;
+		}
+	}
+	this->bytes_sent_ += send_bytes;
+#endif
+}
+
+void nn::distributed::Communicator::all_reduce(float* data, const size_t size)
+{
+	const size_t ranks = this->world_size_;
+	if (ranks == 1 || size == 0)
+	{
+		return;
+	}
+	NN_PROFILE_SCOPE("distributed/all_reduce");
+	NN_PROFILE_WORK(size, 2 * sizeof(float) * size);
+
+	// Chunk c is [c * size / ranks, (c + 1) * size / ranks)
+	const auto chunk_start = [size, ranks](const size_t chunk) { return chunk * size / ranks; };
+	const auto chunk_size = [&chunk_start](const size_t chunk) { return chunk_start(chunk + 1) - chunk_start(chunk); };
+	this->buffer_.resize(std::max(this->buffer_.size(), (size + ranks - 1) / ranks));
+
+	// Reduce-scatter: after step s the chunk rank - s - 1 holds the sum of s + 2 ranks, in the end rank holds the
+	// whole sum of chunk rank + 1
+	for (size_t step = 0; step + 1 < ranks; ++step)
+	{
+		const size_t send_chunk = (this->rank_ + ranks - step) % ranks;
+		const size_t receive_chunk = (this->rank_ + 2 * ranks - step - 1) % ranks;
+		this->exchange(data + chunk_start(send_chunk), chunk_size(send_chunk) * sizeof(float),
+			this->buffer_.data(), chunk_size(receive_chunk) * sizeof(float));
+		nn::kernels::get_kernels().axpy(data + chunk_start(receive_chunk), this->buffer_.data(), 1.0f, chunk_size(receive_chunk));
+	}
+
+	// All-gather: the summed chunks are passed on and overwrite the partial sums
+	for (size_t step = 0; step + 1 < ranks; ++step)
+	{
+		const size_t send_chunk = (this->rank_ + 1 + ranks - step) % ranks;
+		const size_t receive_chunk = (this->rank_ + ranks - step) % ranks;
+		this->exchange(data + chunk_start(send_chunk), chunk_size(send_chunk) * sizeof(float),
+			data + chunk_start(receive_chunk), chunk_size(receive_chunk) * sizeof(float));
+	}
+}
+
+void nn::distributed::Communicator::broadcast(float* data, const size_t size)
+{
+	if (this->world_size_ == 1)
+	{
+		return;
+	}
+	NN_PROFILE_SCOPE("distributed/broadcast");
+	const bool forwards = (this->rank_ + 1) % this->world_size_ != 0;
+	for (size_t start = 0; start < size; start += broadcast_piece)
+	{
+		const size_t bytes = std::min(broadcast_piece, size - start) * sizeof(float);
+		if (this->rank_ != 0)
+		{
+			this->exchange(nullptr, 0, data + start, bytes);
+		}
+		if (forwards)
+		{
+			this->exchange(data + start, bytes, nullptr, 0);
+		}
+	}
+}
+
+namespace
+{
+	/// <summary>
+	/// Training thread and communication thread of one distributed epoch.
+	/// </summary>
+	class Trainer
+	{
+	private:
+		const std::vector<nn::Layer*>& layers_;
+		nn::distributed::Communicator& communicator_;
+
+		/// <summary>
+		/// Layers whose gradients are ready to be all-reduced (from the last one) and how many are done.
+		/// </summary>
+		nn::pipeline::SpscQueue<size_t> reduce_queue_;
+		std::atomic<size_t> reduced_layers_{ 0 };
+
+		/// <summary>
+		/// Seconds the communication thread spent in all-reduce (read after it joined).
+		/// </summary>
+		double communication_seconds_ = 0.0;
+
+		std::atomic<bool> failed_{ false };
+		std::exception_ptr error_;
+
+		void record_error()
+		{
+			if (!this->failed_.exchange(true))
+			{
+				this->error_ = std::current_exception();
+			}
+		}
+
+		void wait(nn::pipeline::Backoff& backoff) const
+		{
+			if (this->failed_.load(std::memory_order_relaxed))
+			{
+				throw Aborted();
+			}
+			backoff.wait();
+		}
+
+		void push(const size_t message)
+		{
+			nn::pipeline::Backoff backoff;
+			while (!this->reduce_queue_.try_push(message))
+			{
+				this->wait(backoff);
+			}
+		}
+
+		/// <summary>
+		/// All-reduces the gradients of the layers the training thread hands over until it sends stop.
+		/// </summary>
+		void communicate()
+		{
+			for (;;)
+			{
+				size_t index;
+				nn::pipeline::Backoff backoff;
+				while (!this->reduce_queue_.try_pop(index))
+				{
+					this->wait(backoff);
+				}
+				if (index == stop)
+				{
+					return;
+				}
+
+				const auto start = clock::now();
+				for (const nn::Parameter& parameter : this->layers_[index]->get_parameters())
+				{
+					this->communicator_.all_reduce(parameter.gradient->get_data(),
+						parameter.gradient->get_rows() * parameter.gradient->get_cols());
+				}
+				this->communication_seconds_ += std::chrono::duration<double>(clock::now() - start).count();
+				this->reduced_layers_.fetch_add(1, std::memory_order_release);
+			}
+		}
+
+		void train(nn::DataSet& data_set, const float learning_rate, const size_t steps, nn::distributed::Report& report)
+		{
+			const size_t last = this->layers_.size() - 1;
+			// The gradients are summed over the ranks, the update uses their mean
+			const float rank_learning_rate = learning_rate / static_cast<float>(this->communicator_.get_world_size());
+			for (size_t step = 0; step < steps; ++step)
+			{
+				this->layers_.front()->set_activations(data_set.get_batch_input());
+				for (size_t i = 1; i <= last; ++i)
+				{
+					NN_PROFILE_LAYER_SCOPE("feed_forward", i);
+					this->layers_[i]->feed_forward(*this->layers_[i - 1]);
+				}
+				{
+					NN_PROFILE_LAYER_SCOPE("back_propagate", last);
+					this->layers_[last]->back_propagate(data_set.get_batch_output(), *this->layers_[last - 1]);
+				}
+				// Back propagating a layer reads the weights and deltas of the next one, not its gradients: those are
+				// all-reduced meanwhile
+				this->push(last);
+				for (size_t i = last - 1; i > 0; --i)
+				{
+					{
+						NN_PROFILE_LAYER_SCOPE("back_propagate", i);
+						this->layers_[i]->back_propagate(*this->layers_[i + 1], *this->layers_[i - 1]);
+					}
+					this->push(i);
+				}
+
+				const auto wait_start = clock::now();
+				nn::pipeline::Backoff backoff;
+				while (this->reduced_layers_.load(std::memory_order_acquire) != (step + 1) * last)
+				{
+					this->wait(backoff);
+				}
+				report.exposed_communication_seconds += std::chrono::duration<double>(clock::now() - wait_start).count();
+
+				for (size_t i = 1; i <= last; ++i)
+				{
+					NN_PROFILE_LAYER_SCOPE("update_weights_and_biases", i);
+					this->layers_[i]->update_weights_and_biases(rank_learning_rate);
+				}
+				report.samples += this->layers_.front()->get_batch_size();
+				data_set.go_to_next_batch();
+			}
+			this->push(stop);
+		}
+
+	public:
+		Trainer(const std::vector<nn::Layer*>& layers, nn::distributed::Communicator& communicator)
+			: layers_(layers), communicator_(communicator), reduce_queue_(layers.size() + 1)
+		{
+		}
+
+		nn::distributed::Report run(nn::DataSet& data_set, const float learning_rate, const size_t steps)
+		{
+			nn::distributed::Report report;
+			report.steps = steps;
+			const size_t bytes_sent = this->communicator_.get_bytes_sent();
+			const auto start = clock::now();
+
+			std::thread communication([this]()
+			{
+				try
+				{
+					this->communicate();
+				}
+				catch (const Aborted&)
+				{
+				}
+				catch (...)
+				{
+					this->record_error();
+				}
+			});
+			try
+			{
+				this->train(data_set, learning_rate, steps, report);
+			}
+			catch (const Aborted&)
+			{
+			}
+			catch (...)
+			{
+				this->record_error();
+			}
+			communication.join();
+
+			report.seconds = std::chrono::duration<double>(clock::now() - start).count();
+			report.communication_seconds = this->communication_seconds_;
+			report.bytes_sent = this->communicator_.get_bytes_sent() - bytes_sent;
+			if (this->error_)
+			{
+				std::rethrow_exception(this->error_);
+			}
+			return report;
+		}
+	};
+}
+
+double nn::distributed::Report::get_samples_per_second() const
+{
+	return this->seconds > 0.0 ? static_cast<double>(this->samples) / this->seconds : 0.0;
+}
+
+double nn::distributed::Report::get_overlap_fraction() const
+{
+	if (this->communication_seconds <= 0.0)
+	{
+		return 0.0;
+	}
+	return std::max(0.0, 1.0 - this->exposed_communication_seconds / this->communication_seconds);
+}
+
+void nn::distributed::broadcast_parameters(const std::vector<Layer*>& layers, Communicator& communicator)
+{
+	for (Layer* layer : layers)
+	{
+		for (const Parameter& parameter : layer->get_parameters())
+		{
+			communicator.broadcast(parameter.value->get_data(), parameter.value->get_rows() * parameter.value->get_cols());
+		}
+	}
+}
+
+nn::distributed::Report nn::distributed::train_epoch(const std::vector<Layer*>& layers, DataSet& data_set, const float learning_rate,
+                                                     Communicator& communicator)
+{
+	if (layers.size() < 2)
+	{
+		throw std::runtime_error("Neural network is not ready to be trained.");
+	}
+
+	// Every rank trains the batches of the smallest shard: rank r writes its count into slot r, the sum gathers them
+	std::vector<float> batch_counts(communicator.get_world_size(), 0.0f);
+	batch_counts[communicator.get_rank()] = static_cast<float>(data_set.get_total_size() / layers.front()->get_batch_size());
+	communicator.all_reduce(batch_counts.data(), batch_counts.size());
+	const auto steps = static_cast<size_t>(*std::min_element(batch_counts.begin(), batch_counts.end()));
+
+	data_set.reset();
+	Trainer trainer(layers, communicator);
+	return trainer.run(data_set, learning_rate, steps);
+}
@@ -0,0 +1,138 @@
+// File: src/NeuralNetwork/Dropout.cpp
+// Purpose: Source file for Dropout class, a layer that drops random activations while training.
+
+#include "NeuralNetwork/Dropout.h"
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels, nn::kernels::random_bits
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_WORK
+
+#include <cmath> // std::ldexp
+#include <cstring> // std::memcpy
+
+nn::Dropout::Dropout(const size_t neuron_count, const size_t batch_size, const float rate, const uint32_t seed)
+	: rate_(rate), seed_(seed)
+{
+	if (neuron_count == 0 || batch_size == 0)
+	{
+		throw std::runtime_error("Invalid dropout parameters.");
+	}
+	if (!(rate >= 0.0f && rate < 1.0f))
+	{
+		throw std::runtime_error("Dropout rate must be in [0, 1).");
+	}
+
+	this->neuron_count_ = neuron_count;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices
+	this->activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->delta_activations_ = std::make_unique<Matrix<float>>(neuron_count, batch_size);
+	this->mask_ = std::make_unique<Matrix<uint64_t>>((neuron_count * batch_size + 63) / 64, 1);
+}
+
+float nn::Dropout::get_rate() const
+{
+	return this->rate_;
+}
+
+bool nn::Dropout::is_training() const
+{
+	return this->training_;
+}
+
+const nn::Matrix<uint64_t>& nn::Dropout::get_mask() const
+{
+	return *this->mask_;
+}
+
+const nn::Matrix<float>& nn::Dropout::get_activations() const
+{
+	return this->pass_through_ != nullptr ? *this->pass_through_ : Layer::get_activations();
+}
+
+void nn::Dropout::set_training(const bool training)
+{
+	this->training_ = training;
+	this->pass_through_ = nullptr;
+}
+
+void nn::Dropout::feed_forward(const Layer& previous_layer)
+{
+	const Matrix<float>& input = previous_layer.get_activations();
+	if (input.get_rows() != this->neuron_count_ || input.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the dropout.");
+	}
+
+	if (!this->training_)
+	{
+		this->pass_through_ = &input;
+		return;
+	}
+	this->pass_through_ = nullptr;
+
+	const size_t size = this->neuron_count_ * this->batch_size_;
+	const kernels::KernelTable& table = kernels::get_kernels();
+	{
+		NN_PROFILE_SCOPE("dropout_mask");
+		NN_PROFILE_WORK(8 * size, size / 8);
+		// The 32 bit counter of the kernel must not wrap within a call: start the next block of 2^32 instead
+		if (static_cast<uint32_t>(this->counter_) > UINT32_MAX - size)
+		{
+			this->counter_ = (this->counter_ >> 32 << 32) + (uint64_t{ 1 } << 32);
+		}
+		// Every block of 2^32 numbers has its own key
+		const uint32_t key = kernels::random_bits(this->seed_ ^ kernels::random_bits(static_cast<uint32_t>(this->counter_ >> 32)));
+		const auto threshold = static_cast<uint32_t>(std::ldexp(static_cast<double>(this->rate_), 32));
+		table.random_mask(this->mask_->get_data(), key, static_cast<uint32_t>(this->counter_), threshold, size);
+		this->counter_ += size;
+	}
+
+	NN_PROFILE_SCOPE("dropout");
+	NN_PROFILE_WORK(size, 2 * sizeof(float) * size);
+	table.masked_scale(this->activations_->get_data(), input.get_data(), this->mask_->get_data(), 1.0f / (1.0f - this->rate_), size);
+}
+
+void nn::Dropout::back_propagate(const Layer& next_layer, const Layer&)
+{
+	NN_PROFILE_SCOPE("delta_activations");
+	next_layer.propagate_delta_to_previous_layer(*this->delta_activations_);
+}
+
+void nn::Dropout::back_propagate(const Matrix<float>& expected_activations, const Layer&)
+{
+	NN_PROFILE_SCOPE("delta_activations");
+	this->delta_activations_->calculate_delta_activation_from_expected_output(this->get_activations(), expected_activations);
+}
+
+void nn::Dropout::propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const
+{
+	if (previous_delta_activations.get_rows() != this->neuron_count_ || previous_delta_activations.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the dropout.");
+	}
+
+	NN_PROFILE_SCOPE("dropout_delta");
+	const size_t size = this->neuron_count_ * this->batch_size_;
+	NN_PROFILE_WORK(size, 2 * sizeof(float) * size);
+	if (!this->training_)
+	{
+		std::memcpy(previous_delta_activations.get_data(), this->delta_activations_->get_data(), size * sizeof(float));
+		return;
+	}
+	// The dropped activations did not contribute to the loss
+	kernels::get_kernels().masked_scale(previous_delta_activations.get_data(), this->delta_activations_->get_data(),
+		this->mask_->get_data(), 1.0f / (1.0f - this->rate_), size);
+}
+
+nn::MemoryRequirements nn::Dropout::get_memory_requirements() const
+{
+	MemoryRequirements requirements;
+	requirements.activation_bytes = get_bytes(this->activations_) + get_bytes(this->mask_);
+	requirements.workspace_bytes = get_bytes(this->delta_activations_);
+	return requirements;
+}
+
+bool nn::Dropout::is_recomputable() const
+{
+	return false;
+}
@@ -0,0 +1,201 @@
+// File: src/NeuralNetwork/HalfPrecision.cpp
+// Purpose: Implementation file for 16 bit floating point storage types and their kernels.
+
+#include "NeuralNetwork/HalfPrecision.h"
+
+#include <cmath> // std::nearbyint, std::ldexp
+#include <cstring> // memcpy
+#include <type_traits> // std::is_same_v
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	uint32_t float_to_bits(const float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float bits_to_float(const uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	/// <summary>
+	/// Software float to IEEE half conversion (round to nearest even), used when F16C is not available.
+	/// </summary>
+	[[maybe_unused]] uint16_t float_to_half(const float value)
+	{
+		uint32_t bits = float_to_bits(value);
+		const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+		bits &= 0x7fffffffu;
+
+		// Infinity or NaN (keep NaN quiet)
+		if (bits >= 0x7f800000u)
+		{
+			return static_cast<uint16_t>(sign | 0x7c00u | (bits > 0x7f800000u ? 0x0200u : 0u));
+		}
+		// Rounds to a value larger than the largest half (65504)
+		if (bits >= 0x477ff000u)
+		{
+			return static_cast<uint16_t>(sign | 0x7c00u);
+		}
+		// Subnormal half (or zero): scale so the result is an integer count of 2^-24
+		if (bits < 0x38800000u)
+		{
+			return static_cast<uint16_t>(sign | static_cast<uint16_t>(std::nearbyint(bits_to_float(bits) * 16777216.0f)));
+		}
+
+		// Normal half: round the 13 dropped mantissa bits to nearest even, then re-bias the exponent (127 - 15)
+		bits += 0x0fffu + ((bits >> 13) & 1u);
+		bits -= 0x38000000u;
+		return static_cast<uint16_t>(sign | (bits >> 13));
+	}
+
+	/// <summary>
+	/// Software IEEE half to float conversion, used when F16C is not available.
+	/// </summary>
+	[[maybe_unused]] float half_to_float(const uint16_t half)
+	{
+		const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1fu;
+		const uint32_t mantissa = half & 0x03ffu;
+
+		if (exponent == 0)
+		{
+			const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+			return sign ? -magnitude : magnitude;
+		}
+		if (exponent == 0x1f)
+		{
+			return bits_to_float(sign | 0x7f800000u | (mantissa << 13));
+		}
+
+		return bits_to_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+	}
+
+	template <typename Half>
+	void convert_matrix(const nn::Matrix<float>& source, nn::Matrix<Half>& destination)
+	{
+		if (source.get_rows() != destination.get_rows() || source.get_cols() != destination.get_cols())
+		{
+			throw std::runtime_error("Cannot convert matrices with incompatible dimensions.");
+		}
+
+		for (size_t i = 0; i < source.get_rows() * source.get_cols(); ++i)
+		{
+			destination[i] = Half(source[i]);
+		}
+	}
+
+	template <typename Half>
+	void convert_matrix(const nn::Matrix<Half>& source, nn::Matrix<float>& destination)
+	{
+		if (source.get_rows() != destination.get_rows() || source.get_cols() != destination.get_cols())
+		{
+			throw std::runtime_error("Cannot convert matrices with incompatible dimensions.");
+		}
+
+		for (size_t i = 0; i < source.get_rows() * source.get_cols(); ++i)
+		{
+			destination[i] = static_cast<float>(source[i]);
+		}
+	}
+
+	template <typename Half>
+	void multiply_half(const nn::Matrix<Half>& weights, const nn::Matrix<float>& input, nn::Matrix<float>& result)
+	{
+		if (weights.get_cols() != input.get_rows() || result.get_rows() != weights.get_rows() || result.get_cols() != input.get_cols())
+		{
+			throw std::runtime_error("Cannot multiply matrices with incompatible dimensions.");
+		}
+
+		// 16 bit weights, float input and result
+		NN_PROFILE_WORK(2 * weights.get_rows() * weights.get_cols() * input.get_cols(), sizeof(Half) * weights.get_rows() * weights.get_cols() +
+			sizeof(float) * (input.get_rows() * input.get_cols() + result.get_rows() * result.get_cols()));
+
+		const nn::kernels::KernelTable& kernels = nn::kernels::get_kernels();
+		if constexpr (std::is_same_v<Half, nn::bfloat16>)
+		{
+			kernels.sgemm_bf16(weights.get_data(), input.get_data(), result.get_data(), weights.get_rows(), input.get_cols(), weights.get_cols());
+		}
+		else
+		{
+			kernels.sgemm_fp16(weights.get_data(), input.get_data(), result.get_data(), weights.get_rows(), input.get_cols(), weights.get_cols());
+		}
+	}
+}
+
+nn::bfloat16::bfloat16(const float value)
+{
+	const uint32_t float_bits = float_to_bits(value);
+
+	// Keep NaN a (quiet) NaN, rounding could turn it into infinity
+	if ((float_bits & 0x7fffffffu) > 0x7f800000u)
+	{
+		this->bits = static_cast<uint16_t>((float_bits >> 16) | 0x0040u);
+		return;
+	}
+
+	// Round to nearest even on the 16 dropped bits
+	this->bits = static_cast<uint16_t>((float_bits + 0x7fffu + ((float_bits >> 16) & 1u)) >> 16);
+}
+
+nn::bfloat16::operator float() const
+{
+	return bits_to_float(static_cast<uint32_t>(this->bits) << 16);
+}
+
+nn::float16::float16(const float value)
+{
+#if defined(__F16C__)
+	this->bits = _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+	this->bits = float_to_half(value);
+#endif
+}
+
+nn::float16::operator float() const
+{
+#if defined(__F16C__)
+	return _cvtsh_ss(this->bits);
+#else
+	return half_to_float(this->bits);
+#endif
+}
+
+void nn::half_precision::convert(const Matrix<float>& source, Matrix<bfloat16>& destination)
+{
+	convert_matrix(source, destination);
+}
+
+void nn::half_precision::convert(const Matrix<float>& source, Matrix<float16>& destination)
+{
+	convert_matrix(source, destination);
+}
+
+void nn::half_precision::convert(const Matrix<bfloat16>& source, Matrix<float>& destination)
+{
+	convert_matrix(source, destination);
+}
+
+void nn::half_precision::convert(const Matrix<float16>& source, Matrix<float>& destination)
+{
+	convert_matrix(source, destination);
+}
+
+void nn::half_precision::multiply(const Matrix<bfloat16>& weights, const Matrix<float>& input, Matrix<float>& result)
+{
+	multiply_half(weights, input, result);
+}
+
+void nn::half_precision::multiply(const Matrix<float16>& weights, const Matrix<float>& input, Matrix<float>& result)
+{
+	multiply_half(weights, input, result);
+}
@@ -0,0 +1,326 @@
+// File: src/NeuralNetwork/Hogwild.cpp
+// Purpose: Implementation file for Hogwild training.
+
+#include "NeuralNetwork/Hogwild.h"
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer, nn::as_dense_layer
+#include "NeuralNetwork/Pipeline.h" // nn::pipeline::SpscQueue
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+#include "NeuralNetwork/Numa.h" // nn::numa::pin_worker
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_LAYER_SCOPE, NN_PROFILE_WORK
+
+#include <algorithm> // std::min, std::max, std::fill_n
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono::steady_clock
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr, std::make_unique
+#include <stdexcept> // std::runtime_error
+#include <thread> // std::thread, std::this_thread::yield
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// Bytes of a cache line.
+	/// </summary>
+	constexpr size_t cache_line = 64;
+
+	/// <summary>
+	/// Message that ends the epoch (instead of a slot index).
+	/// </summary>
+	constexpr size_t stop = std::numeric_limits<size_t>::max();
+
+	/// <summary>
+	/// Batches a worker holds: one it trains on while the next one is copied in.
+	/// </summary>
+	constexpr size_t slot_count = 2;
+
+	/// <summary>
+	/// Thrown in the threads that wait on a queue after another thread failed.
+	/// </summary>
+	struct Aborted
+	{
+	};
+
+	/// <summary>
+	/// One thread: replicas of the layers (shared weights and biases, own activations and gradients) and the batches
+	///	the feeding thread copies in, both allocated by the thread itself so their pages are on its NUMA node (first
+	///	touch). Every worker starts on its own cache line, so the counters of one do not share a line with the
+	///	queues of another.
+	/// </summary>
+	struct alignas(cache_line) Worker
+	{
+		std::vector<std::unique_ptr<nn::DenseLayer>> layers;
+		std::vector<nn::Matrix<float>> inputs;
+		std::vector<nn::Matrix<float>> outputs;
+
+		/// <summary>
+		/// Slots holding a batch to train on (fed) and slots the worker is done with (returned).
+		/// </summary>
+		nn::pipeline::SpscQueue<size_t> ready;
+		nn::pipeline::SpscQueue<size_t> free;
+
+		size_t batches = 0;
+
+		Worker()
+			: ready(slot_count + 1), free(slot_count)
+		{
+		}
+	};
+
+	/// <summary>
+	/// Threads and shared state of one Hogwild epoch.
+	/// </summary>
+	class Hogwild
+	{
+	private:
+		const std::vector<nn::Layer*>& layers_;
+		std::vector<std::unique_ptr<Worker>> workers_;
+		float learning_rate_;
+		size_t batch_size_;
+
+		std::atomic<bool> failed_{ false };
+		std::exception_ptr error_;
+
+		void record_error()
+		{
+			if (!this->failed_.exchange(true))
+			{
+				this->error_ = std::current_exception();
+			}
+		}
+
+		void wait(nn::pipeline::Backoff& backoff) const
+		{
+			if (this->failed_.load(std::memory_order_relaxed))
+			{
+				throw Aborted();
+			}
+			backoff.wait();
+		}
+
+		/// <summary>
+		/// value -= learning_rate * gradient one segment at a time, starting with the segment of the worker.
+		/// </summary>
+		void update(const nn::Parameter& parameter, const size_t worker_index) const
+		{
+			const size_t size = parameter.value->get_rows() * parameter.value->get_cols();
+			const size_t segment_size = nn::hogwild::get_segment_size(size, this->workers_.size());
+			const size_t segment_count = (size + segment_size - 1) / segment_size;
+			NN_PROFILE_WORK(2 * size, 3 * sizeof(float) * size);
+			for (size_t i = 0; i < segment_count; ++i)
+			{
+				const size_t start = (worker_index + i) % segment_count * segment_size;
+				nn::kernels::get_kernels().axpy(parameter.value->get_data() + start, parameter.gradient->get_data() + start,
+					-this->learning_rate_, std::min(segment_size, size - start));
+			}
+		}
+
+		/// <summary>
+		/// Trains the batches the feeding thread hands to one worker until it sends stop.
+		/// </summary>
+		void run_worker(const size_t worker_index)
+		{
+			Worker& worker = *this->workers_[worker_index];
+			nn::numa::pin_worker(worker_index);
+			for (const nn::Layer* layer : this->layers_)
+			{
+				worker.layers.push_back(nn::as_dense_layer(*layer).create_replica());
+			}
+			for (size_t slot = 0; slot < slot_count; ++slot)
+			{
+				worker.inputs.emplace_back(this->layers_.front()->get_neuron_count(), this->batch_size_);
+				worker.outputs.emplace_back(this->layers_.back()->get_neuron_count(), this->batch_size_);
+				// Written here first, not by the feeding thread, so the pages are on the node of this thread
+				std::fill_n(worker.inputs.back().get_data(), worker.inputs.back().get_rows() * worker.inputs.back().get_cols(), 0.0f);
+				std::fill_n(worker.outputs.back().get_data(), worker.outputs.back().get_rows() * worker.outputs.back().get_cols(), 0.0f);
+				static_cast<void>(worker.free.try_push(slot));
+			}
+
+			for (;;)
+			{
+				size_t slot;
+				nn::pipeline::Backoff backoff;
+				while (!worker.ready.try_pop(slot))
+				{
+					this->wait(backoff);
+				}
+				if (slot == stop)
+				{
+					return;
+				}
+
+				worker.layers.front()->set_activations(worker.inputs[slot]);
+				for (size_t i = 1; i < worker.layers.size(); ++i)
+				{
+					NN_PROFILE_LAYER_SCOPE("feed_forward", i);
+					worker.layers[i]->feed_forward(*worker.layers[i - 1]);
+				}
+				{
+					NN_PROFILE_LAYER_SCOPE("back_propagate", worker.layers.size() - 1);
+					worker.layers.back()->back_propagate(worker.outputs[slot], *worker.layers[worker.layers.size() - 2]);
+				}
+				for (size_t i = worker.layers.size() - 2; i > 0; --i)
+				{
+					NN_PROFILE_LAYER_SCOPE("back_propagate", i);
+					worker.layers[i]->back_propagate(*worker.layers[i + 1], *worker.layers[i - 1]);
+				}
+				// The batch is no longer read: the next one can be copied in while the weights are updated
+				nn::pipeline::Backoff free_backoff;
+				while (!worker.free.try_push(slot))
+				{
+					this->wait(free_backoff);
+				}
+				for (size_t i = 1; i < worker.layers.size(); ++i)
+				{
+					NN_PROFILE_LAYER_SCOPE("update_weights_and_biases", i);
+					for (const nn::Parameter& parameter : worker.layers[i]->get_parameters())
+					{
+						this->update(parameter, worker_index);
+					}
+				}
+				++worker.batches;
+			}
+		}
+
+		/// <summary>
+		/// Copies every batch of the data set into a free slot of the first worker that has one.
+		/// </summary>
+		void feed(nn::DataSet& data_set, nn::hogwild::Report& report)
+		{
+			size_t next_worker = 0;
+			while (!data_set.is_end())
+			{
+				size_t slot;
+				Worker* worker = nullptr;
+				nn::pipeline::Backoff backoff;
+				while (worker == nullptr)
+				{
+					for (size_t i = 0; i < this->workers_.size() && worker == nullptr; ++i)
+					{
+						Worker& candidate = *this->workers_[(next_worker + i) % this->workers_.size()];
+						worker = candidate.free.try_pop(slot) ? &candidate : nullptr;
+					}
+					if (worker == nullptr)
+					{
+						this->wait(backoff);
+					}
+				}
+				next_worker = (next_worker + 1) % this->workers_.size();
+
+				worker->inputs[slot] = data_set.get_batch_input();
+				worker->outputs[slot] = data_set.get_batch_output();
+				data_set.go_to_next_batch();
+				report.samples += this->batch_size_;
+				nn::pipeline::Backoff push_backoff;
+				while (!worker->ready.try_push(slot))
+				{
+					this->wait(push_backoff);
+				}
+			}
+			for (const auto& worker : this->workers_)
+			{
+				nn::pipeline::Backoff backoff;
+				while (!worker->ready.try_push(stop))
+				{
+					this->wait(backoff);
+				}
+			}
+		}
+
+	public:
+		Hogwild(const std::vector<nn::Layer*>& layers, const float learning_rate, const size_t thread_count)
+			: layers_(layers), learning_rate_(learning_rate), batch_size_(layers.front()->get_batch_size())
+		{
+			for (const nn::Layer* layer : layers)
+			{
+				static_cast<void>(nn::as_dense_layer(*layer));
+			}
+			for (size_t w = 0; w < thread_count; ++w)
+			{
+				this->workers_.push_back(std::make_unique<Worker>());
+			}
+		}
+
+		nn::hogwild::Report run(nn::DataSet& data_set)
+		{
+			nn::hogwild::Report report;
+			const auto start = clock::now();
+
+			std::vector<std::thread> threads;
+			for (size_t w = 0; w < this->workers_.size(); ++w)
+			{
+				threads.emplace_back([this, w]()
+				{
+					try
+					{
+						this->run_worker(w);
+					}
+					catch (const Aborted&)
+					{
+					}
+					catch (...)
+					{
+						this->record_error();
+					}
+				});
+			}
+			try
+			{
+				this->feed(data_set, report);
+			}
+			catch (const Aborted&)
+			{
+			}
+			catch (...)
+			{
+				this->record_error();
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			report.seconds = std::chrono::duration<double>(clock::now() - start).count();
+			for (const auto& worker : this->workers_)
+			{
+				report.thread_batches.push_back(worker->batches);
+			}
+			if (this->error_)
+			{
+				std::rethrow_exception(this->error_);
+			}
+			return report;
+		}
+	};
+}
+
+double nn::hogwild::Report::get_samples_per_second() const
+{
+	return this->seconds > 0.0 ? static_cast<double>(this->samples) / this->seconds : 0.0;
+}
+
+size_t nn::hogwild::get_segment_size(const size_t size, const size_t thread_count)
+{
+	constexpr size_t line = cache_line / sizeof(float);
+	const size_t segment_size = (size + thread_count - 1) / thread_count;
+	return std::max<size_t>((segment_size + line - 1) / line * line, line);
+}
+
+nn::hogwild::Report nn::hogwild::train_epoch(const std::vector<Layer*>& layers, DataSet& data_set, const float learning_rate,
+                                             const size_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		throw std::runtime_error("Hogwild training needs at least one thread.");
+	}
+	if (layers.size() < 2)
+	{
+		throw std::runtime_error("Neural network is not ready to be trained.");
+	}
+
+	data_set.reset();
+	Hogwild hogwild(layers, learning_rate, thread_count);
+	return hogwild.run(data_set);
+}
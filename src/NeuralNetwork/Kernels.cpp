@@ -0,0 +1,241 @@
+// File: src/NeuralNetwork/Kernels.cpp
+// Purpose: Implementation file for the runtime CPU feature dispatcher.
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <algorithm> // std::min
+#include <cstdlib> // std::getenv
+#include <cstring> // strcmp
+#include <iostream> // std::cerr
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NN_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+#ifdef NN_X86
+	/// <summary>
+	/// Executes cpuid for the given leaf and sub-leaf (registers are eax, ebx, ecx, edx).
+	/// </summary>
+	void cpuid(const unsigned leaf, const unsigned sub_leaf, unsigned registers[4])
+	{
+#if defined(_MSC_VER)
+		int values[4];
+		__cpuidex(values, static_cast<int>(leaf), static_cast<int>(sub_leaf));
+		for (int i = 0; i < 4; ++i)
+		{
+			registers[i] = static_cast<unsigned>(values[i]);
+		}
+#else
+		__cpuid_count(leaf, sub_leaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	/// <summary>
+	/// Returns the register state the OS saves on context switches (XCR0).
+	/// </summary>
+	unsigned long long xgetbv()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+
+	bool has_bit(const unsigned value, const unsigned bit)
+	{
+		return (value >> bit) & 1u;
+	}
+#endif
+
+	/// <summary>
+	/// Returns the highest level the CPU and OS support (ignoring which kernels were compiled).
+	/// </summary>
+	nn::kernels::IsaLevel detect_cpu_isa_level(bool& vnni)
+	{
+		using nn::kernels::IsaLevel;
+		vnni = false;
+
+#ifdef NN_X86
+		unsigned registers[4];
+		cpuid(0, 0, registers);
+		const unsigned max_leaf = registers[0];
+
+		cpuid(1, 0, registers);
+		const unsigned leaf1_ecx = registers[2];
+		if (!has_bit(leaf1_ecx, 20))
+		{
+			return IsaLevel::Scalar;
+		}
+
+		// AVX needs the OS to save the ymm registers (XCR0 bits 1 and 2)
+		const bool os_xsave = has_bit(leaf1_ecx, 27);
+		const unsigned long long xcr0 = os_xsave ? xgetbv() : 0;
+		if (max_leaf < 7 || !has_bit(leaf1_ecx, 28) || !has_bit(leaf1_ecx, 12) || !has_bit(leaf1_ecx, 29) || (xcr0 & 0x6) != 0x6)
+		{
+			return IsaLevel::SSE42;
+		}
+
+		cpuid(7, 0, registers);
+		const unsigned leaf7_ebx = registers[1];
+		const unsigned leaf7_ecx = registers[2];
+		if (!has_bit(leaf7_ebx, 5))
+		{
+			return IsaLevel::SSE42;
+		}
+
+		// AVX-512 F, DQ, BW and VL, with the opmask and zmm state saved by the OS (XCR0 bits 5, 6 and 7)
+		if (!has_bit(leaf7_ebx, 16) || !has_bit(leaf7_ebx, 17) || !has_bit(leaf7_ebx, 30) || !has_bit(leaf7_ebx, 31) ||
+			(xcr0 & 0xe6) != 0xe6)
+		{
+			return IsaLevel::AVX2;
+		}
+
+		vnni = has_bit(leaf7_ecx, 11);
+		return IsaLevel::AVX512;
+#else
+		return IsaLevel::Scalar;
+#endif
+	}
+
+	/// <summary>
+	/// Returns the highest level whose kernels are part of this build.
+	/// </summary>
+	nn::kernels::IsaLevel get_compiled_isa_level()
+	{
+#if defined(NN_HAS_AVX512_KERNELS)
+		return nn::kernels::IsaLevel::AVX512;
+#elif defined(NN_HAS_AVX2_KERNELS)
+		return nn::kernels::IsaLevel::AVX2;
+#elif defined(NN_HAS_SSE42_KERNELS)
+		return nn::kernels::IsaLevel::SSE42;
+#else
+		return nn::kernels::IsaLevel::Scalar;
+#endif
+	}
+
+	/// <summary>
+	/// Returns the level requested through NN_ISA_LEVEL (or the detected level if it is not set).
+	/// </summary>
+	nn::kernels::IsaLevel get_requested_isa_level(const nn::kernels::IsaLevel detected)
+	{
+		using nn::kernels::IsaLevel;
+
+		const char* requested = std::getenv("NN_ISA_LEVEL");
+		if (requested == nullptr || *requested == '\0')
+		{
+			return detected;
+		}
+
+		for (const auto level : { IsaLevel::Scalar, IsaLevel::SSE42, IsaLevel::AVX2, IsaLevel::AVX512 })
+		{
+			if (strcmp(requested, nn::kernels::get_isa_level_name(level)) == 0)
+			{
+				if (level > detected)
+				{
+					std::cerr << "NN_ISA_LEVEL=" << requested << " is not supported, using "
+						<< nn::kernels::get_isa_level_name(detected) << ".\n";
+					return detected;
+				}
+				return level;
+			}
+		}
+
+		std::cerr << "Unknown NN_ISA_LEVEL=" << requested << ", using " << nn::kernels::get_isa_level_name(detected) << ".\n";
+		return detected;
+	}
+}
+
+nn::kernels::IsaLevel nn::kernels::detect_isa_level()
+{
+	bool vnni;
+	return std::min(detect_cpu_isa_level(vnni), get_compiled_isa_level());
+}
+
+nn::kernels::KernelTable nn::kernels::create_kernel_table(IsaLevel level, const bool use_blas)
+{
+	level = std::min(level, detect_isa_level());
+
+	// Every level starts from the one below it and overrides the kernels it implements
+	KernelTable table;
+	register_scalar_kernels(table);
+#if defined(NN_HAS_SSE42_KERNELS)
+	if (level >= IsaLevel::SSE42)
+	{
+		register_sse42_kernels(table);
+	}
+#endif
+#if defined(NN_HAS_AVX2_KERNELS)
+	if (level >= IsaLevel::AVX2)
+	{
+		register_avx2_kernels(table);
+	}
+#endif
+#if defined(NN_HAS_AVX512_KERNELS)
+	if (level >= IsaLevel::AVX512)
+	{
+		register_avx512_kernels(table);
+
+		bool vnni;
+		detect_cpu_isa_level(vnni);
+		if (vnni)
+		{
+			register_avx512_vnni_kernels(table);
+		}
+	}
+#endif
+#if defined(NN_HAS_BLAS_KERNELS)
+	// The BLAS library replaces the matrix products of every level
+	if (use_blas)
+	{
+		register_blas_kernels(table);
+	}
+#else
+	static_cast<void>(use_blas);
+#endif
+
+	table.level = level;
+	return table;
+}
+
+const char* nn::kernels::get_blas_name()
+{
+#if defined(NN_HAS_BLAS_KERNELS)
+	return NN_BLAS_NAME;
+#else
+	return nullptr;
+#endif
+}
+
+const nn::kernels::KernelTable& nn::kernels::get_kernels()
+{
+	// Thread safe one time initialization
+	static const KernelTable table = create_kernel_table(get_requested_isa_level(detect_isa_level()));
+	return table;
+}
+
+const char* nn::kernels::get_isa_level_name(const IsaLevel level)
+{
+	switch (level)
+	{
+	case IsaLevel::Scalar:
+		return "scalar";
+	case IsaLevel::SSE42:
+		return "sse4.2";
+	case IsaLevel::AVX2:
+		return "avx2";
+	case IsaLevel::AVX512:
+		return "avx512";
+	}
+
+	return "unknown";
+}
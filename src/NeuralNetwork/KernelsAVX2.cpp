@@ -0,0 +1,690 @@
+// File: src/NeuralNetwork/KernelsAVX2.cpp
+// Purpose: AVX2 + FMA + F16C kernels (compiled with -mavx2 -mfma -mf16c, only called when the CPU supports them).
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <immintrin.h>
+#include <utility> // std::index_sequence (types only, no code is emitted from this header)
+
+namespace
+{
+	/// <summary>
+	/// Samples and weight rows of one block of the int8 product: 8 accumulators, 4 rows of activations and a row of
+	///	weights in the 16 vector registers.
+	/// </summary>
+	constexpr size_t int8_samples_per_block = 4, int8_rows_per_block = 2;
+
+	/// <summary>
+	/// Rows of c computed by one call of the transposed product micro-kernel (two 8 wide columns each).
+	/// </summary>
+	constexpr size_t rows_per_block = 4;
+
+	/// <summary>
+	/// Columns of c computed by one call of the transposed product micro-kernel.
+	/// </summary>
+	constexpr size_t cols_per_block = 16;
+
+	/// <summary>
+	/// Depth of the packed panel of b (16 KB).
+	/// </summary>
+	constexpr size_t depth_per_block = 256;
+
+	enum class HalfFormat
+	{
+		BFloat16,
+		Float16
+	};
+
+	float horizontal_sum(const __m256 vector)
+	{
+		const __m128 sum128 = _mm_add_ps(_mm256_castps256_ps128(vector), _mm256_extractf128_ps(vector, 1));
+		const __m128 sum64 = _mm_add_ps(sum128, _mm_movehl_ps(sum128, sum128));
+		const __m128 sum32 = _mm_add_ss(sum64, _mm_movehdup_ps(sum64));
+		return _mm_cvtss_f32(sum32);
+	}
+
+	/// <summary>
+	/// Converts one 16 bit value (raw bits) to float.
+	/// </summary>
+	template <HalfFormat Format>
+	float half_to_float(const uint16_t bits)
+	{
+		if constexpr (Format == HalfFormat::BFloat16)
+		{
+			const uint32_t float_bits = static_cast<uint32_t>(bits) << 16;
+			return _mm_cvtss_f32(_mm_castsi128_ps(_mm_cvtsi32_si128(static_cast<int>(float_bits))));
+		}
+		else
+		{
+			return _cvtsh_ss(bits);
+		}
+	}
+
+	/// <summary>
+	/// Loads 8 consecutive 16 bit values (raw bits) as floats.
+	/// </summary>
+	template <HalfFormat Format>
+	__m256 load_half(const uint16_t* data)
+	{
+		const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		if constexpr (Format == HalfFormat::BFloat16)
+		{
+			// bfloat16 is the upper half of a float
+			return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(raw), 16));
+		}
+		else
+		{
+			return _mm256_cvtph_ps(raw);
+		}
+	}
+
+	void sgemm(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	           const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			float* c_row = c + i * ldc;
+			for (size_t j = 0; j < n; ++j)
+			{
+				c_row[j] = 0.0f;
+			}
+			for (size_t p = 0; p < k; ++p)
+			{
+				const __m256 a_vector = _mm256_set1_ps(a[i * lda + p]);
+				const float* b_row = b + p * ldb;
+				size_t j = 0;
+				for (; j + 8 <= n; j += 8)
+				{
+					_mm256_storeu_ps(c_row + j, _mm256_fmadd_ps(a_vector, _mm256_loadu_ps(b_row + j), _mm256_loadu_ps(c_row + j)));
+				}
+				for (; j < n; ++j)
+				{
+					c_row[j] += a[i * lda + p] * b_row[j];
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Returns the mask of the first count (at most 8) lanes for maskload / maskstore.
+	/// </summary>
+	__m256i tail_mask(const size_t count)
+	{
+		const int lanes = count >= 8 ? 8 : static_cast<int>(count);
+		return _mm256_cmpgt_epi32(_mm256_set1_epi32(lanes), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	}
+
+	/// <summary>
+	/// Copies rows [0..cols) x columns [0..depth) of b to panel transposed, cols_per_block floats per row of the panel
+	///	(the columns after cols are zero), so the products with b^T run over contiguous aligned rows.
+	/// </summary>
+	void pack_transposed(const float* b, float* panel, const size_t cols, const size_t depth, const size_t ldb)
+	{
+		for (size_t j = 0; j < cols_per_block; ++j)
+		{
+			for (size_t p = 0; p < depth; ++p)
+			{
+				panel[p * cols_per_block + j] = j < cols ? b[j * ldb + p] : 0.0f;
+			}
+		}
+	}
+
+	/// <summary>
+	/// c[0..Rows)[0..cols) = alpha * a[0..Rows)[0..k) * panel + beta * c (c is not read if beta is 0), and with Sums
+	///	sums[0..Rows) = alpha * sum(a[0..Rows)[0..k)) + beta * sums from the elements of a broadcast for the product.
+	///	The rows are expanded with fold expressions so every accumulator is indexed by a constant and stays in a register.
+	/// </summary>
+	template <bool Sums, size_t... Rows>
+	void micro_kernel_nt(std::index_sequence<Rows...>, const float* a, const float* panel, float* c, float* sums,
+	                     const size_t cols, const size_t k, const size_t lda, const size_t ldc, const float alpha,
+	                     const float beta)
+	{
+		const __m256i mask0 = tail_mask(cols);
+		const __m256i mask1 = tail_mask(cols > 8 ? cols - 8 : 0);
+
+		__m256 c0[] = { (static_cast<void>(Rows), _mm256_setzero_ps())... };
+		__m256 c1[] = { (static_cast<void>(Rows), _mm256_setzero_ps())... };
+		float row_sums[] = { (static_cast<void>(Rows), 0.0f)... };
+
+		for (size_t p = 0; p < k; ++p)
+		{
+			const __m256 b0 = _mm256_load_ps(panel + p * cols_per_block);
+			const __m256 b1 = _mm256_load_ps(panel + p * cols_per_block + 8);
+			((c0[Rows] = _mm256_fmadd_ps(_mm256_broadcast_ss(a + Rows * lda + p), b0, c0[Rows]),
+			  c1[Rows] = _mm256_fmadd_ps(_mm256_broadcast_ss(a + Rows * lda + p), b1, c1[Rows])), ...);
+			if constexpr (Sums)
+			{
+				((row_sums[Rows] += a[Rows * lda + p]), ...);
+			}
+		}
+
+		// Epilogue: alpha and beta are applied once per element of c
+		const __m256 alpha_vector = _mm256_set1_ps(alpha);
+		if (beta == 0.0f)
+		{
+			((_mm256_maskstore_ps(c + Rows * ldc, mask0, _mm256_mul_ps(alpha_vector, c0[Rows])),
+			  _mm256_maskstore_ps(c + Rows * ldc + 8, mask1, _mm256_mul_ps(alpha_vector, c1[Rows]))), ...);
+			if constexpr (Sums)
+			{
+				((sums[Rows] = alpha * row_sums[Rows]), ...);
+			}
+			return;
+		}
+		const __m256 beta_vector = _mm256_set1_ps(beta);
+		((_mm256_maskstore_ps(c + Rows * ldc, mask0, _mm256_fmadd_ps(alpha_vector, c0[Rows],
+		    _mm256_mul_ps(beta_vector, _mm256_maskload_ps(c + Rows * ldc, mask0)))),
+		  _mm256_maskstore_ps(c + Rows * ldc + 8, mask1, _mm256_fmadd_ps(alpha_vector, c1[Rows],
+		    _mm256_mul_ps(beta_vector, _mm256_maskload_ps(c + Rows * ldc + 8, mask1))))), ...);
+		if constexpr (Sums)
+		{
+			((sums[Rows] = alpha * row_sums[Rows] + beta * sums[Rows]), ...);
+		}
+	}
+
+	template <bool Sums>
+	void micro_kernel_nt(const size_t rows, const float* a, const float* panel, float* c, float* sums, const size_t cols,
+	                     const size_t k, const size_t lda, const size_t ldc, const float alpha, const float beta)
+	{
+		switch (rows)
+		{
+		case 1: micro_kernel_nt<Sums>(std::make_index_sequence<1>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 2: micro_kernel_nt<Sums>(std::make_index_sequence<2>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 3: micro_kernel_nt<Sums>(std::make_index_sequence<3>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		default: micro_kernel_nt<Sums>(std::make_index_sequence<4>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		}
+	}
+
+	void sgemm_nt_row_sums(const float* a, const float* b, float* c, float* sums, const size_t m, const size_t n,
+	                       const size_t k, const float alpha, const float beta, const size_t lda, const size_t ldb,
+	                       const size_t ldc)
+	{
+		alignas(32) float panel[depth_per_block * cols_per_block];
+
+		// Every depth block after the first adds to c, the row sums ride along the first panel of every depth block
+		for (size_t p = 0; p < k || p == 0; p += depth_per_block)
+		{
+			const size_t depth = k - p < depth_per_block ? k - p : depth_per_block;
+			const float block_beta = p == 0 ? beta : 1.0f;
+			for (size_t j = 0; j < n || j == 0; j += cols_per_block)
+			{
+				const size_t cols = n - j < cols_per_block ? n - j : cols_per_block;
+				pack_transposed(b + j * ldb + p, panel, cols, depth, ldb);
+				for (size_t i = 0; i < m; i += rows_per_block)
+				{
+					const size_t rows = m - i < rows_per_block ? m - i : rows_per_block;
+					if (j == 0)
+					{
+						micro_kernel_nt<true>(rows, a + i * lda + p, panel, c + i * ldc + j, sums + i, cols, depth, lda, ldc,
+							alpha, block_beta);
+					}
+					else
+					{
+						micro_kernel_nt<false>(rows, a + i * lda + p, panel, c + i * ldc + j, sums + i, cols, depth, lda, ldc,
+							alpha, block_beta);
+					}
+				}
+			}
+		}
+	}
+
+	template <HalfFormat Format>
+	void sgemm_half(const uint16_t* a, const float* b, float* c, const size_t m, const size_t n, const size_t k)
+	{
+		if (n < 8)
+		{
+			// Small batches are bound by the weight bandwidth: stream every row of a once per column of b and
+			// convert it 8 at a time against a contiguous copy of (a chunk of) the column.
+			constexpr size_t chunk_size = 1024;
+			alignas(32) float column[chunk_size];
+
+			for (size_t j = 0; j < n; ++j)
+			{
+				for (size_t i = 0; i < m; ++i)
+				{
+					c[i * n + j] = 0.0f;
+				}
+
+				for (size_t chunk_start = 0; chunk_start < k; chunk_start += chunk_size)
+				{
+					const size_t chunk = k - chunk_start < chunk_size ? k - chunk_start : chunk_size;
+					for (size_t p = 0; p < chunk; ++p)
+					{
+						column[p] = b[(chunk_start + p) * n + j];
+					}
+
+					for (size_t i = 0; i < m; ++i)
+					{
+						const uint16_t* a_row = a + i * k + chunk_start;
+						__m256 accumulator = _mm256_setzero_ps();
+						size_t p = 0;
+						for (; p + 8 <= chunk; p += 8)
+						{
+							accumulator = _mm256_fmadd_ps(load_half<Format>(a_row + p), _mm256_load_ps(column + p), accumulator);
+						}
+						float sum = horizontal_sum(accumulator);
+						for (; p < chunk; ++p)
+						{
+							sum += half_to_float<Format>(a_row[p]) * column[p];
+						}
+						c[i * n + j] += sum;
+					}
+				}
+			}
+			return;
+		}
+
+		// Larger batches: broadcast every converted element of a over a row of b.
+		for (size_t i = 0; i < m; ++i)
+		{
+			float* c_row = c + i * n;
+			for (size_t j = 0; j < n; ++j)
+			{
+				c_row[j] = 0.0f;
+			}
+			for (size_t p = 0; p < k; ++p)
+			{
+				const float a_value = half_to_float<Format>(a[i * k + p]);
+				const __m256 a_vector = _mm256_set1_ps(a_value);
+				const float* b_row = b + p * n;
+				size_t j = 0;
+				for (; j + 8 <= n; j += 8)
+				{
+					_mm256_storeu_ps(c_row + j, _mm256_fmadd_ps(a_vector, _mm256_loadu_ps(b_row + j), _mm256_loadu_ps(c_row + j)));
+				}
+				for (; j < n; ++j)
+				{
+					c_row[j] += a_value * b_row[j];
+				}
+			}
+		}
+	}
+
+	void sgemm_bf16(const nn::bfloat16* a, const float* b, float* c, const size_t m, const size_t n, const size_t k)
+	{
+		// nn::bfloat16 is a standard layout wrapper of its uint16_t bits
+		sgemm_half<HalfFormat::BFloat16>(reinterpret_cast<const uint16_t*>(a), b, c, m, n, k);
+	}
+
+	void sgemm_fp16(const nn::float16* a, const float* b, float* c, const size_t m, const size_t n, const size_t k)
+	{
+		// nn::float16 is a standard layout wrapper of its uint16_t bits
+		sgemm_half<HalfFormat::Float16>(reinterpret_cast<const uint16_t*>(a), b, c, m, n, k);
+	}
+
+	void hadamard(float* x, const float* y, const size_t size)
+	{
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			_mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+		}
+		for (; i < size; ++i)
+		{
+			x[i] *= y[i];
+		}
+	}
+
+	void axpy(float* x, const float* y, const float alpha, const size_t size)
+	{
+		const __m256 alpha_vector = _mm256_set1_ps(alpha);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			_mm256_storeu_ps(x + i, _mm256_fmadd_ps(alpha_vector, _mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+		}
+		for (; i < size; ++i)
+		{
+			x[i] += alpha * y[i];
+		}
+	}
+
+	/// <summary>
+	/// exp(x) (Cephes polynomial, ~1 ulp relative error in the clamped range).
+	/// </summary>
+	__m256 exp(__m256 x)
+	{
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.0f));
+
+		// x = n * ln(2) + r, |r| <= ln(2) / 2 (ln(2) split in two for precision)
+		const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+		                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+		r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+		__m256 y = _mm256_set1_ps(1.9875691500e-4f);
+		y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(1.3981999507e-3f));
+		y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(8.3334519073e-3f));
+		y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(4.1665795894e-2f));
+		y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(1.6666665459e-1f));
+		y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(5.0000001201e-1f));
+		y = _mm256_fmadd_ps(y, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+
+		// y * 2^n
+		const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+	}
+
+	__m256 sigmoid(const __m256 x)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		return _mm256_div_ps(one, _mm256_add_ps(one, exp(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+	}
+
+	__m256 tanh(const __m256 x)
+	{
+		// tanh(|x|) = (1 - exp(-2|x|)) / (1 + exp(-2|x|)), the sign is copied back from x
+		const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 e = exp(_mm256_mul_ps(_mm256_andnot_ps(sign_mask, x), _mm256_set1_ps(-2.0f)));
+		const __m256 magnitude = _mm256_div_ps(_mm256_sub_ps(one, e), _mm256_add_ps(one, e));
+		return _mm256_or_ps(magnitude, _mm256_and_ps(sign_mask, x));
+	}
+
+	/// <summary>
+	/// Applies operation to x in place, 8 at a time (the tail goes through a zero padded copy).
+	/// </summary>
+	template <typename Operation>
+	void transform(float* x, const size_t size, const Operation operation)
+	{
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			_mm256_storeu_ps(x + i, operation(_mm256_loadu_ps(x + i)));
+		}
+		if (i < size)
+		{
+			alignas(32) float tail[8] = {};
+			for (size_t j = 0; j < size - i; ++j)
+			{
+				tail[j] = x[i + j];
+			}
+			_mm256_store_ps(tail, operation(_mm256_load_ps(tail)));
+			for (size_t j = 0; j < size - i; ++j)
+			{
+				x[i + j] = tail[j];
+			}
+		}
+	}
+
+	void max_argmax(float* max, uint8_t* argmax, const float* x, const uint8_t index, const size_t size)
+	{
+		const __m128i index_vector = _mm_set1_epi8(static_cast<char>(index));
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			const __m256 values = _mm256_loadu_ps(x + i);
+			const __m256 current = _mm256_loadu_ps(max + i);
+			const __m256 greater = _mm256_cmp_ps(values, current, _CMP_GT_OQ);
+			_mm256_storeu_ps(max + i, _mm256_blendv_ps(current, values, greater));
+
+			// Narrow the 32 bit lane mask to 8 bytes and blend the index into them
+			const __m256i mask = _mm256_castps_si256(greater);
+			__m128i byte_mask = _mm_packs_epi32(_mm256_castsi256_si128(mask), _mm256_extracti128_si256(mask, 1));
+			byte_mask = _mm_packs_epi16(byte_mask, byte_mask);
+			const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(argmax + i));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(argmax + i), _mm_blendv_epi8(bytes, index_vector, byte_mask));
+		}
+		for (; i < size; ++i)
+		{
+			if (x[i] > max[i])
+			{
+				max[i] = x[i];
+				argmax[i] = index;
+			}
+		}
+	}
+
+	/// <summary>
+	/// nn::kernels::random_bits of 8 lanes.
+	/// </summary>
+	__m256i random_bits(__m256i x)
+	{
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+		x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+		x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846ca68bu)));
+		return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	}
+
+	void random_mask(uint64_t* mask, const uint32_t key, const uint32_t counter, const uint32_t threshold, const size_t size)
+	{
+		// Unsigned compare: random >= threshold exactly where max(random, threshold) == random
+		const __m256i threshold_vector = _mm256_set1_epi32(static_cast<int>(threshold));
+		const __m256i key_vector = _mm256_set1_epi32(static_cast<int>(key));
+		for (size_t word = 0; word * 64 < size; ++word)
+		{
+			__m256i counters = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter + static_cast<uint32_t>(word * 64))),
+			                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+			uint64_t value = 0;
+			for (size_t j = 0; j < 64; j += 8)
+			{
+				const __m256i random = random_bits(_mm256_xor_si256(counters, key_vector));
+				const __m256i keep = _mm256_cmpeq_epi32(_mm256_max_epu32(random, threshold_vector), random);
+				value |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(keep)))) << j;
+				counters = _mm256_add_epi32(counters, _mm256_set1_epi32(8));
+			}
+			// Clear the bits after size
+			const size_t bits = size - word * 64;
+			mask[word] = bits < 64 ? value & ((uint64_t{ 1 } << bits) - 1) : value;
+		}
+	}
+
+	void masked_scale(float* y, const float* x, const uint64_t* mask, const float scale, const size_t size)
+	{
+		const __m256 scale_vector = _mm256_set1_ps(scale);
+		const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			// Spread the 8 bits of the mask to the lanes
+			const auto bits = static_cast<int>((mask[i / 64] >> (i % 64)) & 0xff);
+			const __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), lane_bits), lane_bits);
+			_mm256_storeu_ps(y + i, _mm256_and_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i), scale_vector), _mm256_castsi256_ps(keep)));
+		}
+		for (; i < size; ++i)
+		{
+			y[i] = (mask[i / 64] >> (i % 64)) & 1 ? scale * x[i] : 0.0f;
+		}
+	}
+
+	void sigmoid(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m256 value) { return sigmoid(value); });
+	}
+
+	void sigmoid_derivative(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m256 value)
+		{
+			const __m256 s = sigmoid(value);
+			return _mm256_mul_ps(s, _mm256_sub_ps(_mm256_set1_ps(1.0f), s));
+		});
+	}
+
+	void tanh(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m256 value) { return tanh(value); });
+	}
+
+	void tanh_derivative(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m256 value)
+		{
+			const __m256 t = tanh(value);
+			return _mm256_fnmadd_ps(t, t, _mm256_set1_ps(1.0f));
+		});
+	}
+
+	void leaky_relu(float* x, const float slope, const size_t size)
+	{
+		const __m256 slope_vector = _mm256_set1_ps(slope);
+		transform(x, size, [slope_vector](const __m256 value)
+		{
+			const __m256 positive = _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ);
+			return _mm256_blendv_ps(_mm256_mul_ps(slope_vector, value), value, positive);
+		});
+	}
+
+	void leaky_relu_derivative(float* x, const float slope, const size_t size)
+	{
+		const __m256 slope_vector = _mm256_set1_ps(slope);
+		transform(x, size, [slope_vector](const __m256 value)
+		{
+			const __m256 positive = _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ);
+			return _mm256_blendv_ps(slope_vector, _mm256_set1_ps(1.0f), positive);
+		});
+	}
+
+	void sigmoid_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			const __m256 value = _mm256_loadu_ps(a + i);
+			const __m256 derivative = _mm256_mul_ps(value, _mm256_sub_ps(one, value));
+			_mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_loadu_ps(delta + i), derivative));
+		}
+		for (; i < size; ++i)
+		{
+			y[i] = delta[i] * a[i] * (1.0f - a[i]);
+		}
+	}
+
+	void tanh_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			const __m256 value = _mm256_loadu_ps(a + i);
+			_mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_loadu_ps(delta + i), _mm256_fnmadd_ps(value, value, one)));
+		}
+		for (; i < size; ++i)
+		{
+			y[i] = delta[i] * (1.0f - a[i] * a[i]);
+		}
+	}
+
+	void leaky_relu_backward(float* y, const float* x, const float* delta, const float slope, const size_t size)
+	{
+		const __m256 slope_vector = _mm256_set1_ps(slope);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			const __m256 positive = _mm256_cmp_ps(_mm256_loadu_ps(x + i), _mm256_setzero_ps(), _CMP_GT_OQ);
+			const __m256 value = _mm256_loadu_ps(delta + i);
+			_mm256_storeu_ps(y + i, _mm256_blendv_ps(_mm256_mul_ps(slope_vector, value), value, positive));
+		}
+		for (; i < size; ++i)
+		{
+			y[i] = x[i] > 0.0f ? delta[i] : slope * delta[i];
+		}
+	}
+
+	int32_t dot_u8s8(const uint8_t* activations, const int8_t* weights, const size_t size)
+	{
+		// vpmaddubsw: u8 x s8 products summed in pairs to int16 (cannot saturate for 7 bit activations),
+		// vpmaddwd with ones: int16 pairs summed to int32.
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i accumulator = _mm256_setzero_si256();
+		for (size_t i = 0; i < size; i += 32)
+		{
+			const __m256i products = _mm256_maddubs_epi16(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(activations + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			accumulator = _mm256_add_epi32(accumulator, _mm256_madd_epi16(products, ones));
+		}
+
+		const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(accumulator), _mm256_extracti128_si256(accumulator, 1));
+		const __m128i sum64 = _mm_add_epi32(sum128, _mm_unpackhi_epi64(sum128, sum128));
+		const __m128i sum32 = _mm_add_epi32(sum64, _mm_shuffle_epi32(sum64, 1));
+		return _mm_cvtsi128_si32(sum32);
+	}
+
+	int32_t horizontal_sum_epi32(const __m256i vector)
+	{
+		const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(vector), _mm256_extracti128_si256(vector, 1));
+		const __m128i sum64 = _mm_add_epi32(sum128, _mm_unpackhi_epi64(sum128, sum128));
+		return _mm_cvtsi128_si32(_mm_add_epi32(sum64, _mm_shuffle_epi32(sum64, 1)));
+	}
+
+	/// <summary>
+	/// c[s][r] = a[s] . b[r] for the samples and weight rows of one block: cell Cells is sample
+	///	Cells / int8_rows_per_block and row Cells % int8_rows_per_block. The missing samples and rows of a partial block
+	///	point at the last valid one and are not stored.
+	/// </summary>
+	template <size_t... Cells>
+	void micro_kernel_u8s8(std::index_sequence<Cells...>, const uint8_t* const* a, const int8_t* const* b, int32_t* c,
+	                       const size_t samples, const size_t rows, const size_t k, const size_t ldc)
+	{
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i accumulators[] = { (static_cast<void>(Cells), _mm256_setzero_si256())... };
+		for (size_t p = 0; p < k; p += 32)
+		{
+			((accumulators[Cells] = _mm256_add_epi32(accumulators[Cells], _mm256_madd_epi16(_mm256_maddubs_epi16(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a[Cells / int8_rows_per_block] + p)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b[Cells % int8_rows_per_block] + p))), ones))), ...);
+		}
+
+		const int32_t sums[] = { horizontal_sum_epi32(accumulators[Cells])... };
+		for (size_t cell = 0; cell < sizeof...(Cells); ++cell)
+		{
+			const size_t s = cell / int8_rows_per_block, r = cell % int8_rows_per_block;
+			if (s < samples && r < rows)
+			{
+				c[s * ldc + r] = sums[cell];
+			}
+		}
+	}
+
+	void gemm_u8s8(const uint8_t* a, const int8_t* b, int32_t* c, const size_t m, const size_t n, const size_t k,
+	               const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		// Row blocks outside: the weight rows of a block stay in L1 while every sample block runs against them
+		for (size_t j = 0; j < n; j += int8_rows_per_block)
+		{
+			const size_t rows = n - j < int8_rows_per_block ? n - j : int8_rows_per_block;
+			const int8_t* b_rows[int8_rows_per_block];
+			for (size_t r = 0; r < int8_rows_per_block; ++r)
+			{
+				b_rows[r] = b + (j + (r < rows ? r : rows - 1)) * ldb;
+			}
+			for (size_t i = 0; i < m; i += int8_samples_per_block)
+			{
+				const size_t samples = m - i < int8_samples_per_block ? m - i : int8_samples_per_block;
+				const uint8_t* a_rows[int8_samples_per_block];
+				for (size_t s = 0; s < int8_samples_per_block; ++s)
+				{
+					a_rows[s] = a + (i + (s < samples ? s : samples - 1)) * lda;
+				}
+				micro_kernel_u8s8(std::make_index_sequence<int8_samples_per_block * int8_rows_per_block>(), a_rows, b_rows,
+					c + i * ldc + j, samples, rows, k, ldc);
+			}
+		}
+	}
+}
+
+void nn::kernels::register_avx2_kernels(KernelTable& table)
+{
+	table.sgemm = sgemm;
+	table.sgemm_nt_row_sums = sgemm_nt_row_sums;
+	table.sgemm_bf16 = sgemm_bf16;
+	table.sgemm_fp16 = sgemm_fp16;
+	table.hadamard = hadamard;
+	table.axpy = axpy;
+	table.max_argmax = max_argmax;
+	table.random_mask = random_mask;
+	table.masked_scale = masked_scale;
+	table.sigmoid = sigmoid;
+	table.sigmoid_derivative = sigmoid_derivative;
+	table.tanh = tanh;
+	table.tanh_derivative = tanh_derivative;
+	table.leaky_relu = leaky_relu;
+	table.leaky_relu_derivative = leaky_relu_derivative;
+	table.sigmoid_backward = sigmoid_backward;
+	table.tanh_backward = tanh_backward;
+	table.leaky_relu_backward = leaky_relu_backward;
+	table.dot_u8s8 = dot_u8s8;
+	table.gemm_u8s8 = gemm_u8s8;
+}
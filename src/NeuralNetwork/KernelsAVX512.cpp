@@ -0,0 +1,602 @@
+// File: src/NeuralNetwork/KernelsAVX512.cpp
+// Purpose: AVX-512 kernels (compiled with -mavx512f -mavx512bw -mavx512dq -mavx512vl, only called when the CPU supports them).
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <immintrin.h>
+#include <utility> // std::index_sequence (types only, no code is emitted from this header)
+
+namespace
+{
+	/// <summary>
+	/// Samples and weight rows of one block of the int8 product: 16 accumulators, 4 rows of activations and a row of
+	///	weights in the 32 vector registers.
+	/// </summary>
+	constexpr size_t int8_samples_per_block = 4, int8_rows_per_block = 4;
+
+	/// <summary>
+	/// Rows of c computed by one micro-kernel call (two 16 wide columns each, 2 * rows_per_block accumulators).
+	/// </summary>
+	constexpr size_t rows_per_block = 6;
+
+	/// <summary>
+	/// Columns of c computed by one micro-kernel call.
+	/// </summary>
+	constexpr size_t cols_per_block = 32;
+
+	/// <summary>
+	/// Depth of the panel of b kept in L1/L2 while all row blocks of a are run against it.
+	/// </summary>
+	constexpr size_t depth_per_block = 256;
+
+	/// <summary>
+	/// Below this many columns of c the product is computed as dot products over rows of a instead.
+	/// </summary>
+	constexpr size_t dot_product_max_cols = 8;
+
+	/// <summary>
+	/// Returns the mask of the first count (at most 16) lanes.
+	/// </summary>
+	__mmask16 tail_mask(const size_t count)
+	{
+		return count >= 16 ? static_cast<__mmask16>(0xffff) : static_cast<__mmask16>((1u << count) - 1u);
+	}
+
+	/// <summary>
+	/// c[0..Rows)[0..cols) (+)= a[0..Rows)[0..k) * b[0..k)[0..cols), cols at most 32 (masked, no remainder loops).
+	///	The rows are expanded with fold expressions so every accumulator is indexed by a constant and stays in a register.
+	/// </summary>
+	template <size_t... Rows>
+	void micro_kernel(std::index_sequence<Rows...>, const float* a, const float* b, float* c, const size_t cols,
+	                  const size_t k, const size_t lda, const size_t ldb, const size_t ldc, const bool accumulate)
+	{
+		const __mmask16 mask0 = tail_mask(cols);
+		const __mmask16 mask1 = cols > 16 ? tail_mask(cols - 16) : static_cast<__mmask16>(0);
+
+		__m512 c0[] = { (accumulate ? _mm512_maskz_loadu_ps(mask0, c + Rows * ldc) : _mm512_setzero_ps())... };
+		__m512 c1[] = { (accumulate ? _mm512_maskz_loadu_ps(mask1, c + Rows * ldc + 16) : _mm512_setzero_ps())... };
+
+		for (size_t p = 0; p < k; ++p)
+		{
+			const __m512 b0 = _mm512_maskz_loadu_ps(mask0, b + p * ldb);
+			const __m512 b1 = _mm512_maskz_loadu_ps(mask1, b + p * ldb + 16);
+			((c0[Rows] = _mm512_fmadd_ps(_mm512_set1_ps(a[Rows * lda + p]), b0, c0[Rows]),
+			  c1[Rows] = _mm512_fmadd_ps(_mm512_set1_ps(a[Rows * lda + p]), b1, c1[Rows])), ...);
+		}
+
+		((_mm512_mask_storeu_ps(c + Rows * ldc, mask0, c0[Rows]), _mm512_mask_storeu_ps(c + Rows * ldc + 16, mask1, c1[Rows])), ...);
+	}
+
+	void micro_kernel(const size_t rows, const float* a, const float* b, float* c, const size_t cols, const size_t k,
+	                  const size_t lda, const size_t ldb, const size_t ldc, const bool accumulate)
+	{
+		switch (rows)
+		{
+		case 1: micro_kernel(std::make_index_sequence<1>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		case 2: micro_kernel(std::make_index_sequence<2>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		case 3: micro_kernel(std::make_index_sequence<3>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		case 4: micro_kernel(std::make_index_sequence<4>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		case 5: micro_kernel(std::make_index_sequence<5>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		default: micro_kernel(std::make_index_sequence<6>(), a, b, c, cols, k, lda, ldb, ldc, accumulate); break;
+		}
+	}
+
+	/// <summary>
+	/// c = a * b for narrow b (a few samples): every row of a is streamed once per column of b and reduced
+	/// against a contiguous copy of (a chunk of) the column, 4 rows at a time.
+	/// </summary>
+	void sgemm_narrow(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	                  const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		constexpr size_t chunk_size = 1024;
+		alignas(64) float column[chunk_size];
+
+		for (size_t j = 0; j < n; ++j)
+		{
+			for (size_t chunk_start = 0; chunk_start < k || chunk_start == 0; chunk_start += chunk_size)
+			{
+				const size_t chunk = k - chunk_start < chunk_size ? k - chunk_start : chunk_size;
+				for (size_t p = 0; p < chunk; ++p)
+				{
+					column[p] = b[(chunk_start + p) * ldb + j];
+				}
+
+				size_t i = 0;
+				for (; i + 4 <= m; i += 4)
+				{
+					const float* a_row = a + i * lda + chunk_start;
+					__m512 sum0 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps();
+					__m512 sum2 = _mm512_setzero_ps(), sum3 = _mm512_setzero_ps();
+					for (size_t p = 0; p < chunk; p += 16)
+					{
+						const __mmask16 mask = tail_mask(chunk - p);
+						const __m512 x = _mm512_maskz_load_ps(mask, column + p);
+						sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a_row + p), x, sum0);
+						sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a_row + lda + p), x, sum1);
+						sum2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a_row + 2 * lda + p), x, sum2);
+						sum3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a_row + 3 * lda + p), x, sum3);
+					}
+					const float previous[4] = {
+						chunk_start ? c[i * ldc + j] : 0.0f, chunk_start ? c[(i + 1) * ldc + j] : 0.0f,
+						chunk_start ? c[(i + 2) * ldc + j] : 0.0f, chunk_start ? c[(i + 3) * ldc + j] : 0.0f
+					};
+					c[i * ldc + j] = previous[0] + _mm512_reduce_add_ps(sum0);
+					c[(i + 1) * ldc + j] = previous[1] + _mm512_reduce_add_ps(sum1);
+					c[(i + 2) * ldc + j] = previous[2] + _mm512_reduce_add_ps(sum2);
+					c[(i + 3) * ldc + j] = previous[3] + _mm512_reduce_add_ps(sum3);
+				}
+				for (; i < m; ++i)
+				{
+					const float* a_row = a + i * lda + chunk_start;
+					__m512 sum = _mm512_setzero_ps();
+					for (size_t p = 0; p < chunk; p += 16)
+					{
+						const __mmask16 mask = tail_mask(chunk - p);
+						sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a_row + p), _mm512_maskz_load_ps(mask, column + p), sum);
+					}
+					c[i * ldc + j] = (chunk_start ? c[i * ldc + j] : 0.0f) + _mm512_reduce_add_ps(sum);
+				}
+			}
+		}
+	}
+
+	void sgemm(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	           const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		if (n < dot_product_max_cols)
+		{
+			sgemm_narrow(a, b, c, m, n, k, lda, ldb, ldc);
+			return;
+		}
+
+		// Panels of b (depth_per_block x cols_per_block) are reused by every row block of a while they are hot
+		for (size_t p = 0; p < k || p == 0; p += depth_per_block)
+		{
+			const size_t depth = k - p < depth_per_block ? k - p : depth_per_block;
+			for (size_t j = 0; j < n; j += cols_per_block)
+			{
+				const size_t cols = n - j < cols_per_block ? n - j : cols_per_block;
+				for (size_t i = 0; i < m; i += rows_per_block)
+				{
+					const size_t rows = m - i < rows_per_block ? m - i : rows_per_block;
+					micro_kernel(rows, a + i * lda + p, b + p * ldb + j, c + i * ldc + j, cols, depth, lda, ldb, ldc, p != 0);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Copies rows [0..cols) x columns [0..depth) of b to panel transposed, cols_per_block floats per row of the panel
+	///	(the columns after cols are zero), so the products with b^T run over contiguous aligned rows.
+	/// </summary>
+	void pack_transposed(const float* b, float* panel, const size_t cols, const size_t depth, const size_t ldb)
+	{
+		for (size_t j = 0; j < cols_per_block; ++j)
+		{
+			for (size_t p = 0; p < depth; ++p)
+			{
+				panel[p * cols_per_block + j] = j < cols ? b[j * ldb + p] : 0.0f;
+			}
+		}
+	}
+
+	/// <summary>
+	/// c[0..Rows)[0..cols) = alpha * a[0..Rows)[0..k) * panel + beta * c (c is not read if beta is 0), and with Sums
+	///	sums[0..Rows) = alpha * sum(a[0..Rows)[0..k)) + beta * sums from the elements of a broadcast for the product.
+	/// </summary>
+	template <bool Sums, size_t... Rows>
+	void micro_kernel_nt(std::index_sequence<Rows...>, const float* a, const float* panel, float* c, float* sums,
+	                     const size_t cols, const size_t k, const size_t lda, const size_t ldc, const float alpha,
+	                     const float beta)
+	{
+		const __mmask16 mask0 = tail_mask(cols);
+		const __mmask16 mask1 = cols > 16 ? tail_mask(cols - 16) : static_cast<__mmask16>(0);
+
+		__m512 c0[] = { (static_cast<void>(Rows), _mm512_setzero_ps())... };
+		__m512 c1[] = { (static_cast<void>(Rows), _mm512_setzero_ps())... };
+		float row_sums[] = { (static_cast<void>(Rows), 0.0f)... };
+
+		for (size_t p = 0; p < k; ++p)
+		{
+			const __m512 b0 = _mm512_load_ps(panel + p * cols_per_block);
+			const __m512 b1 = _mm512_load_ps(panel + p * cols_per_block + 16);
+			((c0[Rows] = _mm512_fmadd_ps(_mm512_set1_ps(a[Rows * lda + p]), b0, c0[Rows]),
+			  c1[Rows] = _mm512_fmadd_ps(_mm512_set1_ps(a[Rows * lda + p]), b1, c1[Rows])), ...);
+			if constexpr (Sums)
+			{
+				((row_sums[Rows] += a[Rows * lda + p]), ...);
+			}
+		}
+
+		// Epilogue: alpha and beta are applied once per element of c
+		const __m512 alpha_vector = _mm512_set1_ps(alpha);
+		if (beta == 0.0f)
+		{
+			((_mm512_mask_storeu_ps(c + Rows * ldc, mask0, _mm512_mul_ps(alpha_vector, c0[Rows])),
+			  _mm512_mask_storeu_ps(c + Rows * ldc + 16, mask1, _mm512_mul_ps(alpha_vector, c1[Rows]))), ...);
+			if constexpr (Sums)
+			{
+				((sums[Rows] = alpha * row_sums[Rows]), ...);
+			}
+			return;
+		}
+		const __m512 beta_vector = _mm512_set1_ps(beta);
+		((_mm512_mask_storeu_ps(c + Rows * ldc, mask0, _mm512_fmadd_ps(alpha_vector, c0[Rows],
+		    _mm512_mul_ps(beta_vector, _mm512_maskz_loadu_ps(mask0, c + Rows * ldc)))),
+		  _mm512_mask_storeu_ps(c + Rows * ldc + 16, mask1, _mm512_fmadd_ps(alpha_vector, c1[Rows],
+		    _mm512_mul_ps(beta_vector, _mm512_maskz_loadu_ps(mask1, c + Rows * ldc + 16))))), ...);
+		if constexpr (Sums)
+		{
+			((sums[Rows] = alpha * row_sums[Rows] + beta * sums[Rows]), ...);
+		}
+	}
+
+	template <bool Sums>
+	void micro_kernel_nt(const size_t rows, const float* a, const float* panel, float* c, float* sums, const size_t cols,
+	                     const size_t k, const size_t lda, const size_t ldc, const float alpha, const float beta)
+	{
+		switch (rows)
+		{
+		case 1: micro_kernel_nt<Sums>(std::make_index_sequence<1>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 2: micro_kernel_nt<Sums>(std::make_index_sequence<2>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 3: micro_kernel_nt<Sums>(std::make_index_sequence<3>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 4: micro_kernel_nt<Sums>(std::make_index_sequence<4>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		case 5: micro_kernel_nt<Sums>(std::make_index_sequence<5>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		default: micro_kernel_nt<Sums>(std::make_index_sequence<6>(), a, panel, c, sums, cols, k, lda, ldc, alpha, beta); break;
+		}
+	}
+
+	void sgemm_nt_row_sums(const float* a, const float* b, float* c, float* sums, const size_t m, const size_t n,
+	                       const size_t k, const float alpha, const float beta, const size_t lda, const size_t ldb,
+	                       const size_t ldc)
+	{
+		alignas(64) float panel[depth_per_block * cols_per_block];
+
+		// Every depth block after the first adds to c, the row sums ride along the first panel of every depth block
+		for (size_t p = 0; p < k || p == 0; p += depth_per_block)
+		{
+			const size_t depth = k - p < depth_per_block ? k - p : depth_per_block;
+			const float block_beta = p == 0 ? beta : 1.0f;
+			for (size_t j = 0; j < n || j == 0; j += cols_per_block)
+			{
+				const size_t cols = n - j < cols_per_block ? n - j : cols_per_block;
+				pack_transposed(b + j * ldb + p, panel, cols, depth, ldb);
+				for (size_t i = 0; i < m; i += rows_per_block)
+				{
+					const size_t rows = m - i < rows_per_block ? m - i : rows_per_block;
+					if (j == 0)
+					{
+						micro_kernel_nt<true>(rows, a + i * lda + p, panel, c + i * ldc + j, sums + i, cols, depth, lda, ldc,
+							alpha, block_beta);
+					}
+					else
+					{
+						micro_kernel_nt<false>(rows, a + i * lda + p, panel, c + i * ldc + j, sums + i, cols, depth, lda, ldc,
+							alpha, block_beta);
+					}
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// exp(x) (Cephes polynomial, ~1 ulp relative error in the clamped range).
+	/// </summary>
+	__m512 exp(__m512 x)
+	{
+		x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.3f)), _mm512_set1_ps(88.0f));
+
+		// x = n * ln(2) + r, |r| <= ln(2) / 2 (ln(2) split in two for precision)
+		const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+		                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+		r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+
+		__m512 y = _mm512_set1_ps(1.9875691500e-4f);
+		y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(1.3981999507e-3f));
+		y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(8.3334519073e-3f));
+		y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(4.1665795894e-2f));
+		y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(1.6666665459e-1f));
+		y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(5.0000001201e-1f));
+		y = _mm512_fmadd_ps(y, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+
+		// y * 2^n
+		return _mm512_scalef_ps(y, n);
+	}
+
+	__m512 sigmoid(const __m512 x)
+	{
+		const __m512 one = _mm512_set1_ps(1.0f);
+		return _mm512_div_ps(one, _mm512_add_ps(one, exp(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+	}
+
+	__m512 tanh(const __m512 x)
+	{
+		// tanh(|x|) = (1 - exp(-2|x|)) / (1 + exp(-2|x|)), the sign is copied back from x
+		const __m512 one = _mm512_set1_ps(1.0f);
+		const __m512 e = exp(_mm512_mul_ps(_mm512_abs_ps(x), _mm512_set1_ps(-2.0f)));
+		const __m512 magnitude = _mm512_div_ps(_mm512_sub_ps(one, e), _mm512_add_ps(one, e));
+		return _mm512_or_ps(magnitude, _mm512_and_ps(_mm512_set1_ps(-0.0f), x));
+	}
+
+	/// <summary>
+	/// Applies operation to x in place, 16 at a time (the tail is a masked load and store).
+	/// </summary>
+	template <typename Operation>
+	void transform(float* x, const size_t size, const Operation operation)
+	{
+		size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			_mm512_storeu_ps(x + i, operation(_mm512_loadu_ps(x + i)));
+		}
+		if (i < size)
+		{
+			const __mmask16 mask = tail_mask(size - i);
+			_mm512_mask_storeu_ps(x + i, mask, operation(_mm512_maskz_loadu_ps(mask, x + i)));
+		}
+	}
+
+	void hadamard(float* x, const float* y, const size_t size)
+	{
+		size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			_mm512_storeu_ps(x + i, _mm512_mul_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+		}
+		if (i < size)
+		{
+			const __mmask16 mask = tail_mask(size - i);
+			_mm512_mask_storeu_ps(x + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i)));
+		}
+	}
+
+	void axpy(float* x, const float* y, const float alpha, const size_t size)
+	{
+		const __m512 alpha_vector = _mm512_set1_ps(alpha);
+		size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			_mm512_storeu_ps(x + i, _mm512_fmadd_ps(alpha_vector, _mm512_loadu_ps(y + i), _mm512_loadu_ps(x + i)));
+		}
+		if (i < size)
+		{
+			const __mmask16 mask = tail_mask(size - i);
+			_mm512_mask_storeu_ps(x + i, mask,
+			                      _mm512_fmadd_ps(alpha_vector, _mm512_maskz_loadu_ps(mask, y + i), _mm512_maskz_loadu_ps(mask, x + i)));
+		}
+	}
+
+	void max_argmax(float* max, uint8_t* argmax, const float* x, const uint8_t index, const size_t size)
+	{
+		const __m128i index_vector = _mm_set1_epi8(static_cast<char>(index));
+		for (size_t i = 0; i < size; i += 16)
+		{
+			// The compare mask selects both the lanes of max and the bytes of argmax to write
+			const __mmask16 mask = tail_mask(size - i);
+			const __m512 values = _mm512_maskz_loadu_ps(mask, x + i);
+			const __mmask16 greater = _mm512_mask_cmp_ps_mask(mask, values, _mm512_maskz_loadu_ps(mask, max + i), _CMP_GT_OQ);
+			_mm512_mask_storeu_ps(max + i, greater, values);
+			_mm_mask_storeu_epi8(argmax + i, greater, index_vector);
+		}
+	}
+
+	/// <summary>
+	/// nn::kernels::random_bits of 16 lanes.
+	/// </summary>
+	__m512i random_bits(__m512i x)
+	{
+		x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+		x = _mm512_mullo_epi32(x, _mm512_set1_epi32(0x7feb352d));
+		x = _mm512_xor_si512(x, _mm512_srli_epi32(x, 15));
+		x = _mm512_mullo_epi32(x, _mm512_set1_epi32(static_cast<int>(0x846ca68bu)));
+		return _mm512_xor_si512(x, _mm512_srli_epi32(x, 16));
+	}
+
+	void random_mask(uint64_t* mask, const uint32_t key, const uint32_t counter, const uint32_t threshold, const size_t size)
+	{
+		const __m512i threshold_vector = _mm512_set1_epi32(static_cast<int>(threshold));
+		const __m512i key_vector = _mm512_set1_epi32(static_cast<int>(key));
+		const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		for (size_t word = 0; word * 64 < size; ++word)
+		{
+			__m512i counters = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(counter + static_cast<uint32_t>(word * 64))), lanes);
+			uint64_t value = 0;
+			for (size_t j = 0; j < 64; j += 16)
+			{
+				const __mmask16 keep = _mm512_cmpge_epu32_mask(random_bits(_mm512_xor_si512(counters, key_vector)), threshold_vector);
+				value |= static_cast<uint64_t>(keep) << j;
+				counters = _mm512_add_epi32(counters, _mm512_set1_epi32(16));
+			}
+			// Clear the bits after size
+			const size_t bits = size - word * 64;
+			mask[word] = bits < 64 ? value & ((uint64_t{ 1 } << bits) - 1) : value;
+		}
+	}
+
+	void masked_scale(float* y, const float* x, const uint64_t* mask, const float scale, const size_t size)
+	{
+		const __m512 scale_vector = _mm512_set1_ps(scale);
+		for (size_t i = 0; i < size; i += 16)
+		{
+			// 16 bits of the mask are the lane mask directly, the dropped lanes are zeroed
+			const __mmask16 valid = tail_mask(size - i);
+			const auto keep = static_cast<__mmask16>((mask[i / 64] >> (i % 64)) & valid);
+			_mm512_mask_storeu_ps(y + i, valid, _mm512_maskz_mul_ps(keep, _mm512_maskz_loadu_ps(valid, x + i), scale_vector));
+		}
+	}
+
+	void sigmoid(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m512 value) { return sigmoid(value); });
+	}
+
+	void sigmoid_derivative(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m512 value)
+		{
+			const __m512 s = sigmoid(value);
+			return _mm512_mul_ps(s, _mm512_sub_ps(_mm512_set1_ps(1.0f), s));
+		});
+	}
+
+	void tanh(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m512 value) { return tanh(value); });
+	}
+
+	void tanh_derivative(float* x, const size_t size)
+	{
+		transform(x, size, [](const __m512 value)
+		{
+			const __m512 t = tanh(value);
+			return _mm512_fnmadd_ps(t, t, _mm512_set1_ps(1.0f));
+		});
+	}
+
+	void leaky_relu(float* x, const float slope, const size_t size)
+	{
+		const __m512 slope_vector = _mm512_set1_ps(slope);
+		transform(x, size, [slope_vector](const __m512 value)
+		{
+			const __mmask16 positive = _mm512_cmp_ps_mask(value, _mm512_setzero_ps(), _CMP_GT_OQ);
+			return _mm512_mask_blend_ps(positive, _mm512_mul_ps(slope_vector, value), value);
+		});
+	}
+
+	void leaky_relu_derivative(float* x, const float slope, const size_t size)
+	{
+		const __m512 slope_vector = _mm512_set1_ps(slope);
+		transform(x, size, [slope_vector](const __m512 value)
+		{
+			const __mmask16 positive = _mm512_cmp_ps_mask(value, _mm512_setzero_ps(), _CMP_GT_OQ);
+			return _mm512_mask_blend_ps(positive, slope_vector, _mm512_set1_ps(1.0f));
+		});
+	}
+
+	void sigmoid_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		const __m512 one = _mm512_set1_ps(1.0f);
+		for (size_t i = 0; i < size; i += 16)
+		{
+			const __mmask16 valid = tail_mask(size - i);
+			const __m512 value = _mm512_maskz_loadu_ps(valid, a + i);
+			const __m512 derivative = _mm512_mul_ps(value, _mm512_sub_ps(one, value));
+			_mm512_mask_storeu_ps(y + i, valid, _mm512_mul_ps(_mm512_maskz_loadu_ps(valid, delta + i), derivative));
+		}
+	}
+
+	void tanh_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		const __m512 one = _mm512_set1_ps(1.0f);
+		for (size_t i = 0; i < size; i += 16)
+		{
+			const __mmask16 valid = tail_mask(size - i);
+			const __m512 value = _mm512_maskz_loadu_ps(valid, a + i);
+			_mm512_mask_storeu_ps(y + i, valid, _mm512_mul_ps(_mm512_maskz_loadu_ps(valid, delta + i), _mm512_fnmadd_ps(value, value, one)));
+		}
+	}
+
+	void leaky_relu_backward(float* y, const float* x, const float* delta, const float slope, const size_t size)
+	{
+		const __m512 slope_vector = _mm512_set1_ps(slope);
+		for (size_t i = 0; i < size; i += 16)
+		{
+			const __mmask16 valid = tail_mask(size - i);
+			const __mmask16 positive = _mm512_cmp_ps_mask(_mm512_maskz_loadu_ps(valid, x + i), _mm512_setzero_ps(), _CMP_GT_OQ);
+			const __m512 value = _mm512_maskz_loadu_ps(valid, delta + i);
+			_mm512_mask_storeu_ps(y + i, valid, _mm512_mask_blend_ps(positive, _mm512_mul_ps(slope_vector, value), value));
+		}
+	}
+
+	int32_t dot_u8s8(const uint8_t* activations, const int8_t* weights, const size_t size)
+	{
+		// vpmaddubsw / vpmaddwd on 64 bytes at a time (AVX-512 BW)
+		const __m512i ones = _mm512_set1_epi16(1);
+		__m512i accumulator = _mm512_setzero_si512();
+		for (size_t i = 0; i < size; i += 64)
+		{
+			const __m512i products = _mm512_maddubs_epi16(_mm512_loadu_si512(activations + i), _mm512_loadu_si512(weights + i));
+			accumulator = _mm512_add_epi32(accumulator, _mm512_madd_epi16(products, ones));
+		}
+
+		return _mm512_reduce_add_epi32(accumulator);
+	}
+
+	/// <summary>
+	/// c[s][r] = a[s] . b[r] for the samples and weight rows of one block: cell Cells is sample
+	///	Cells / int8_rows_per_block and row Cells % int8_rows_per_block. The missing samples and rows of a partial block
+	///	point at the last valid one and are not stored.
+	/// </summary>
+	template <size_t... Cells>
+	void micro_kernel_u8s8(std::index_sequence<Cells...>, const uint8_t* const* a, const int8_t* const* b, int32_t* c,
+	                       const size_t samples, const size_t rows, const size_t k, const size_t ldc)
+	{
+		const __m512i ones = _mm512_set1_epi16(1);
+		__m512i accumulators[] = { (static_cast<void>(Cells), _mm512_setzero_si512())... };
+		for (size_t p = 0; p < k; p += 64)
+		{
+			((accumulators[Cells] = _mm512_add_epi32(accumulators[Cells], _mm512_madd_epi16(_mm512_maddubs_epi16(
+				_mm512_loadu_si512(a[Cells / int8_rows_per_block] + p), _mm512_loadu_si512(b[Cells % int8_rows_per_block] + p)),
+				ones))), ...);
+		}
+
+		const int32_t sums[] = { _mm512_reduce_add_epi32(accumulators[Cells])... };
+		for (size_t cell = 0; cell < sizeof...(Cells); ++cell)
+		{
+			const size_t s = cell / int8_rows_per_block, r = cell % int8_rows_per_block;
+			if (s < samples && r < rows)
+			{
+				c[s * ldc + r] = sums[cell];
+			}
+		}
+	}
+
+	void gemm_u8s8(const uint8_t* a, const int8_t* b, int32_t* c, const size_t m, const size_t n, const size_t k,
+	               const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		// Row blocks outside: the weight rows of a block stay in L1 while every sample block runs against them
+		for (size_t j = 0; j < n; j += int8_rows_per_block)
+		{
+			const size_t rows = n - j < int8_rows_per_block ? n - j : int8_rows_per_block;
+			const int8_t* b_rows[int8_rows_per_block];
+			for (size_t r = 0; r < int8_rows_per_block; ++r)
+			{
+				b_rows[r] = b + (j + (r < rows ? r : rows - 1)) * ldb;
+			}
+			for (size_t i = 0; i < m; i += int8_samples_per_block)
+			{
+				const size_t samples = m - i < int8_samples_per_block ? m - i : int8_samples_per_block;
+				const uint8_t* a_rows[int8_samples_per_block];
+				for (size_t s = 0; s < int8_samples_per_block; ++s)
+				{
+					a_rows[s] = a + (i + (s < samples ? s : samples - 1)) * lda;
+				}
+				micro_kernel_u8s8(std::make_index_sequence<int8_samples_per_block * int8_rows_per_block>(), a_rows, b_rows,
+					c + i * ldc + j, samples, rows, k, ldc);
+			}
+		}
+	}
+}
+
+void nn::kernels::register_avx512_kernels(KernelTable& table)
+{
+	table.sgemm = sgemm;
+	table.sgemm_nt_row_sums = sgemm_nt_row_sums;
+	table.hadamard = hadamard;
+	table.axpy = axpy;
+	table.max_argmax = max_argmax;
+	table.random_mask = random_mask;
+	table.masked_scale = masked_scale;
+	table.sigmoid = sigmoid;
+	table.sigmoid_derivative = sigmoid_derivative;
+	table.tanh = tanh;
+	table.tanh_derivative = tanh_derivative;
+	table.leaky_relu = leaky_relu;
+	table.leaky_relu_derivative = leaky_relu_derivative;
+	table.sigmoid_backward = sigmoid_backward;
+	table.tanh_backward = tanh_backward;
+	table.leaky_relu_backward = leaky_relu_backward;
+	table.dot_u8s8 = dot_u8s8;
+	table.gemm_u8s8 = gemm_u8s8;
+}
@@ -0,0 +1,88 @@
+// File: src/NeuralNetwork/KernelsAVX512VNNI.cpp
+// Purpose: AVX-512 VNNI kernels (compiled with -mavx512f -mavx512vnni, only called when the CPU supports them).
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <immintrin.h>
+#include <utility> // std::index_sequence (types only, no code is emitted from this header)
+
+namespace
+{
+	/// <summary>
+	/// Samples and weight rows of one block of the int8 product: 16 accumulators, 4 rows of activations and a row of
+	///	weights in the 32 vector registers.
+	/// </summary>
+	constexpr size_t int8_samples_per_block = 4, int8_rows_per_block = 4;
+
+	int32_t dot_u8s8(const uint8_t* activations, const int8_t* weights, const size_t size)
+	{
+		// vpdpbusd: 64 u8 x s8 products summed in groups of 4 into 16 int32 lanes (no int16 intermediate)
+		__m512i accumulator = _mm512_setzero_si512();
+		for (size_t i = 0; i < size; i += 64)
+		{
+			accumulator = _mm512_dpbusd_epi32(accumulator, _mm512_loadu_si512(activations + i), _mm512_loadu_si512(weights + i));
+		}
+
+		return _mm512_reduce_add_epi32(accumulator);
+	}
+
+	/// <summary>
+	/// c[s][r] = a[s] . b[r] for the samples and weight rows of one block: cell Cells is sample
+	///	Cells / int8_rows_per_block and row Cells % int8_rows_per_block. The missing samples and rows of a partial block
+	///	point at the last valid one and are not stored.
+	/// </summary>
+	template <size_t... Cells>
+	void micro_kernel_u8s8(std::index_sequence<Cells...>, const uint8_t* const* a, const int8_t* const* b, int32_t* c,
+	                       const size_t samples, const size_t rows, const size_t k, const size_t ldc)
+	{
+		__m512i accumulators[] = { (static_cast<void>(Cells), _mm512_setzero_si512())... };
+		for (size_t p = 0; p < k; p += 64)
+		{
+			((accumulators[Cells] = _mm512_dpbusd_epi32(accumulators[Cells], _mm512_loadu_si512(a[Cells / int8_rows_per_block] + p),
+				_mm512_loadu_si512(b[Cells % int8_rows_per_block] + p))), ...);
+		}
+
+		const int32_t sums[] = { _mm512_reduce_add_epi32(accumulators[Cells])... };
+		for (size_t cell = 0; cell < sizeof...(Cells); ++cell)
+		{
+			const size_t s = cell / int8_rows_per_block, r = cell % int8_rows_per_block;
+			if (s < samples && r < rows)
+			{
+				c[s * ldc + r] = sums[cell];
+			}
+		}
+	}
+
+	void gemm_u8s8(const uint8_t* a, const int8_t* b, int32_t* c, const size_t m, const size_t n, const size_t k,
+	               const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		// Row blocks outside: the weight rows of a block stay in L1 while every sample block runs against them
+		for (size_t j = 0; j < n; j += int8_rows_per_block)
+		{
+			const size_t rows = n - j < int8_rows_per_block ? n - j : int8_rows_per_block;
+			const int8_t* b_rows[int8_rows_per_block];
+			for (size_t r = 0; r < int8_rows_per_block; ++r)
+			{
+				b_rows[r] = b + (j + (r < rows ? r : rows - 1)) * ldb;
+			}
+			for (size_t i = 0; i < m; i += int8_samples_per_block)
+			{
+				const size_t samples = m - i < int8_samples_per_block ? m - i : int8_samples_per_block;
+				const uint8_t* a_rows[int8_samples_per_block];
+				for (size_t s = 0; s < int8_samples_per_block; ++s)
+				{
+					a_rows[s] = a + (i + (s < samples ? s : samples - 1)) * lda;
+				}
+				micro_kernel_u8s8(std::make_index_sequence<int8_samples_per_block * int8_rows_per_block>(), a_rows, b_rows,
+					c + i * ldc + j, samples, rows, k, ldc);
+			}
+		}
+	}
+}
+
+void nn::kernels::register_avx512_vnni_kernels(KernelTable& table)
+{
+	table.dot_u8s8 = dot_u8s8;
+	table.gemm_u8s8 = gemm_u8s8;
+	table.vnni = true;
+}
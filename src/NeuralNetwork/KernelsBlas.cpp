@@ -0,0 +1,93 @@
+// File: src/NeuralNetwork/KernelsBlas.cpp
+// Purpose: Matrix product kernels backed by the CBLAS library selected with NN_BLAS_BACKEND.
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <vector> // std::vector
+
+// Set by CMake: <cblas.h> for OpenBLAS, BLIS and the reference BLAS, <mkl_cblas.h> for MKL
+#include NN_CBLAS_HEADER
+
+namespace
+{
+	/// <summary>
+	/// c (m x n) = alpha * op(a) * op(b) + beta * c (BLAS rejects empty products and leading dimensions of 0, so those are
+	///	handled here).
+	/// </summary>
+	void gemm(const CBLAS_TRANSPOSE transpose_a, const CBLAS_TRANSPOSE transpose_b, const float* a, const float* b, float* c,
+	          const size_t m, const size_t n, const size_t k, const float alpha, const float beta, const size_t lda,
+	          const size_t ldb, const size_t ldc)
+	{
+		if (m == 0 || n == 0)
+		{
+			return;
+		}
+		if (k == 0)
+		{
+			for (size_t i = 0; i < m; ++i)
+			{
+				for (size_t j = 0; j < n; ++j)
+				{
+					c[i * ldc + j] = beta == 0.0f ? 0.0f : beta * c[i * ldc + j];
+				}
+			}
+			return;
+		}
+
+		// With beta = 0 c is overwritten, it does not have to be cleared first
+		cblas_sgemm(CblasRowMajor, transpose_a, transpose_b, static_cast<int>(m), static_cast<int>(n), static_cast<int>(k),
+		            alpha, a, static_cast<int>(lda), b, static_cast<int>(ldb), beta, c, static_cast<int>(ldc));
+	}
+
+	void sgemm(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	           const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		gemm(CblasNoTrans, CblasNoTrans, a, b, c, m, n, k, 1.0f, 0.0f, lda, ldb, ldc);
+	}
+
+	void sgemm_tn(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k, const float alpha,
+	              const float beta, const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		gemm(CblasTrans, CblasNoTrans, a, b, c, m, n, k, alpha, beta, lda, ldb, ldc);
+	}
+
+	void sgemm_nt(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k, const float alpha,
+	              const float beta, const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		gemm(CblasNoTrans, CblasTrans, a, b, c, m, n, k, alpha, beta, lda, ldb, ldc);
+	}
+
+	void row_sums(const float* a, float* result, const size_t m, const size_t n, const float alpha, const size_t lda)
+	{
+		if (m == 0)
+		{
+			return;
+		}
+		if (n == 0)
+		{
+			for (size_t i = 0; i < m; ++i)
+			{
+				result[i] = 0.0f;
+			}
+			return;
+		}
+
+		// result = alpha * a * ones
+		thread_local std::vector<float> ones;
+		if (ones.size() < n)
+		{
+			ones.assign(n, 1.0f);
+		}
+		cblas_sgemv(CblasRowMajor, CblasNoTrans, static_cast<int>(m), static_cast<int>(n), alpha, a, static_cast<int>(lda),
+		            ones.data(), 1, 0.0f, result, 1);
+	}
+}
+
+void nn::kernels::register_blas_kernels(KernelTable& table)
+{
+	table.sgemm = sgemm;
+	table.sgemm_tn = sgemm_tn;
+	table.sgemm_nt = sgemm_nt;
+	table.row_sums = row_sums;
+	table.blas = NN_BLAS_NAME;
+}
@@ -0,0 +1,244 @@
+// File: src/NeuralNetwork/KernelsSSE42.cpp
+// Purpose: SSE4.2 kernels (compiled with -msse4.2, only called when the CPU supports it).
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <immintrin.h>
+#include <utility> // std::index_sequence (types only, no code is emitted from this header)
+#include <cstring> // std::memcpy (a builtin, no code is emitted from this header)
+
+namespace
+{
+	/// <summary>
+	/// Samples and weight rows of one block of the int8 product: 8 accumulators, 4 rows of activations and a row of
+	///	weights in the 16 vector registers.
+	/// </summary>
+	constexpr size_t int8_samples_per_block = 4, int8_rows_per_block = 2;
+
+	void sgemm(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	           const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			float* c_row = c + i * ldc;
+			for (size_t j = 0; j < n; ++j)
+			{
+				c_row[j] = 0.0f;
+			}
+			for (size_t p = 0; p < k; ++p)
+			{
+				const __m128 a_vector = _mm_set1_ps(a[i * lda + p]);
+				const float* b_row = b + p * ldb;
+				size_t j = 0;
+				for (; j + 4 <= n; j += 4)
+				{
+					_mm_storeu_ps(c_row + j, _mm_add_ps(_mm_loadu_ps(c_row + j), _mm_mul_ps(a_vector, _mm_loadu_ps(b_row + j))));
+				}
+				for (; j < n; ++j)
+				{
+					c_row[j] += a[i * lda + p] * b_row[j];
+				}
+			}
+		}
+	}
+
+	void hadamard(float* x, const float* y, const size_t size)
+	{
+		size_t i = 0;
+		for (; i + 4 <= size; i += 4)
+		{
+			_mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+		}
+		for (; i < size; ++i)
+		{
+			x[i] *= y[i];
+		}
+	}
+
+	void axpy(float* x, const float* y, const float alpha, const size_t size)
+	{
+		const __m128 alpha_vector = _mm_set1_ps(alpha);
+		size_t i = 0;
+		for (; i + 4 <= size; i += 4)
+		{
+			_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(alpha_vector, _mm_loadu_ps(y + i))));
+		}
+		for (; i < size; ++i)
+		{
+			x[i] += alpha * y[i];
+		}
+	}
+
+	/// <summary>
+	/// nn::kernels::random_bits of 4 lanes.
+	/// </summary>
+	__m128i random_bits(__m128i x)
+	{
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+		x = _mm_mullo_epi32(x, _mm_set1_epi32(0x7feb352d));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+		x = _mm_mullo_epi32(x, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+		return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	}
+
+	void random_mask(uint64_t* mask, const uint32_t key, const uint32_t counter, const uint32_t threshold, const size_t size)
+	{
+		// Unsigned compare: random >= threshold exactly where max(random, threshold) == random
+		const __m128i threshold_vector = _mm_set1_epi32(static_cast<int>(threshold));
+		const __m128i key_vector = _mm_set1_epi32(static_cast<int>(key));
+		for (size_t word = 0; word * 64 < size; ++word)
+		{
+			__m128i counters = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter + static_cast<uint32_t>(word * 64))),
+			                                 _mm_setr_epi32(0, 1, 2, 3));
+			uint64_t value = 0;
+			for (size_t j = 0; j < 64; j += 4)
+			{
+				const __m128i random = random_bits(_mm_xor_si128(counters, key_vector));
+				const __m128i keep = _mm_cmpeq_epi32(_mm_max_epu32(random, threshold_vector), random);
+				value |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(keep)))) << j;
+				counters = _mm_add_epi32(counters, _mm_set1_epi32(4));
+			}
+			// Clear the bits after size
+			const size_t bits = size - word * 64;
+			mask[word] = bits < 64 ? value & ((uint64_t{ 1 } << bits) - 1) : value;
+		}
+	}
+
+	void masked_scale(float* y, const float* x, const uint64_t* mask, const float scale, const size_t size)
+	{
+		const __m128 scale_vector = _mm_set1_ps(scale);
+		const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+		size_t i = 0;
+		for (; i + 4 <= size; i += 4)
+		{
+			// Spread the 4 bits of the mask to the lanes
+			const auto bits = static_cast<int>((mask[i / 64] >> (i % 64)) & 0xf);
+			const __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lane_bits), lane_bits);
+			_mm_storeu_ps(y + i, _mm_and_ps(_mm_mul_ps(_mm_loadu_ps(x + i), scale_vector), _mm_castsi128_ps(keep)));
+		}
+		for (; i < size; ++i)
+		{
+			y[i] = (mask[i / 64] >> (i % 64)) & 1 ? scale * x[i] : 0.0f;
+		}
+	}
+
+	void max_argmax(float* max, uint8_t* argmax, const float* x, const uint8_t index, const size_t size)
+	{
+		const __m128i index_vector = _mm_set1_epi8(static_cast<char>(index));
+		size_t i = 0;
+		for (; i + 4 <= size; i += 4)
+		{
+			const __m128 values = _mm_loadu_ps(x + i);
+			const __m128 current = _mm_loadu_ps(max + i);
+			const __m128 greater = _mm_cmpgt_ps(values, current);
+			_mm_storeu_ps(max + i, _mm_blendv_ps(current, values, greater));
+
+			// Narrow the 32 bit lane mask to 4 bytes and blend the index into them
+			__m128i byte_mask = _mm_packs_epi32(_mm_castps_si128(greater), _mm_castps_si128(greater));
+			byte_mask = _mm_packs_epi16(byte_mask, byte_mask);
+			int32_t bytes;
+			std::memcpy(&bytes, argmax + i, sizeof(bytes));
+			bytes = _mm_cvtsi128_si32(_mm_blendv_epi8(_mm_cvtsi32_si128(bytes), index_vector, byte_mask));
+			std::memcpy(argmax + i, &bytes, sizeof(bytes));
+		}
+		for (; i < size; ++i)
+		{
+			if (x[i] > max[i])
+			{
+				max[i] = x[i];
+				argmax[i] = index;
+			}
+		}
+	}
+
+	int32_t dot_u8s8(const uint8_t* activations, const int8_t* weights, const size_t size)
+	{
+		// pmaddubsw: u8 x s8 products summed in pairs to int16, pmaddwd with ones: pairs summed to int32
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i accumulator = _mm_setzero_si128();
+		for (size_t i = 0; i < size; i += 16)
+		{
+			const __m128i products = _mm_maddubs_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(activations + i)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			accumulator = _mm_add_epi32(accumulator, _mm_madd_epi16(products, ones));
+		}
+
+		accumulator = _mm_add_epi32(accumulator, _mm_unpackhi_epi64(accumulator, accumulator));
+		accumulator = _mm_add_epi32(accumulator, _mm_shuffle_epi32(accumulator, 1));
+		return _mm_cvtsi128_si32(accumulator);
+	}
+
+	int32_t horizontal_sum_epi32(__m128i vector)
+	{
+		vector = _mm_add_epi32(vector, _mm_unpackhi_epi64(vector, vector));
+		return _mm_cvtsi128_si32(_mm_add_epi32(vector, _mm_shuffle_epi32(vector, 1)));
+	}
+
+	/// <summary>
+	/// c[s][r] = a[s] . b[r] for the samples and weight rows of one block: cell Cells is sample
+	///	Cells / int8_rows_per_block and row Cells % int8_rows_per_block. The missing samples and rows of a partial block
+	///	point at the last valid one and are not stored.
+	/// </summary>
+	template <size_t... Cells>
+	void micro_kernel_u8s8(std::index_sequence<Cells...>, const uint8_t* const* a, const int8_t* const* b, int32_t* c,
+	                       const size_t samples, const size_t rows, const size_t k, const size_t ldc)
+	{
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i accumulators[] = { (static_cast<void>(Cells), _mm_setzero_si128())... };
+		for (size_t p = 0; p < k; p += 16)
+		{
+			((accumulators[Cells] = _mm_add_epi32(accumulators[Cells], _mm_madd_epi16(_mm_maddubs_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(a[Cells / int8_rows_per_block] + p)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(b[Cells % int8_rows_per_block] + p))), ones))), ...);
+		}
+
+		const int32_t sums[] = { horizontal_sum_epi32(accumulators[Cells])... };
+		for (size_t cell = 0; cell < sizeof...(Cells); ++cell)
+		{
+			const size_t s = cell / int8_rows_per_block, r = cell % int8_rows_per_block;
+			if (s < samples && r < rows)
+			{
+				c[s * ldc + r] = sums[cell];
+			}
+		}
+	}
+
+	void gemm_u8s8(const uint8_t* a, const int8_t* b, int32_t* c, const size_t m, const size_t n, const size_t k,
+	               const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		// Row blocks outside: the weight rows of a block stay in L1 while every sample block runs against them
+		for (size_t j = 0; j < n; j += int8_rows_per_block)
+		{
+			const size_t rows = n - j < int8_rows_per_block ? n - j : int8_rows_per_block;
+			const int8_t* b_rows[int8_rows_per_block];
+			for (size_t r = 0; r < int8_rows_per_block; ++r)
+			{
+				b_rows[r] = b + (j + (r < rows ? r : rows - 1)) * ldb;
+			}
+			for (size_t i = 0; i < m; i += int8_samples_per_block)
+			{
+				const size_t samples = m - i < int8_samples_per_block ? m - i : int8_samples_per_block;
+				const uint8_t* a_rows[int8_samples_per_block];
+				for (size_t s = 0; s < int8_samples_per_block; ++s)
+				{
+					a_rows[s] = a + (i + (s < samples ? s : samples - 1)) * lda;
+				}
+				micro_kernel_u8s8(std::make_index_sequence<int8_samples_per_block * int8_rows_per_block>(), a_rows, b_rows,
+					c + i * ldc + j, samples, rows, k, ldc);
+			}
+		}
+	}
+}
+
+void nn::kernels::register_sse42_kernels(KernelTable& table)
+{
+	table.sgemm = sgemm;
+	table.hadamard = hadamard;
+	table.axpy = axpy;
+	table.max_argmax = max_argmax;
+	table.random_mask = random_mask;
+	table.masked_scale = masked_scale;
+	table.dot_u8s8 = dot_u8s8;
+	table.gemm_u8s8 = gemm_u8s8;
+}
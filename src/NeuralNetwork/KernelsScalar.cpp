@@ -0,0 +1,316 @@
+// File: src/NeuralNetwork/KernelsScalar.cpp
+// Purpose: Portable kernels (the fallback for every entry of the kernel table).
+
+#include "NeuralNetwork/Kernels.h"
+
+#include <cmath> // std::exp, std::tanh
+
+#include "NeuralNetwork/HalfPrecision.h" // nn::bfloat16, nn::float16
+
+namespace
+{
+	void sgemm(const float* a, const float* b, float* c, const size_t m, const size_t n, const size_t k,
+	           const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			float* c_row = c + i * ldc;
+			for (size_t j = 0; j < n; ++j)
+			{
+				c_row[j] = 0.0f;
+			}
+			for (size_t p = 0; p < k; ++p)
+			{
+				const float a_value = a[i * lda + p];
+				const float* b_row = b + p * ldb;
+				for (size_t j = 0; j < n; ++j)
+				{
+					c_row[j] += a_value * b_row[j];
+				}
+			}
+		}
+	}
+
+	template <typename Half>
+	void sgemm_half(const Half* a, const float* b, float* c, const size_t m, const size_t n, const size_t k)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			float* c_row = c + i * n;
+			for (size_t j = 0; j < n; ++j)
+			{
+				c_row[j] = 0.0f;
+			}
+			for (size_t p = 0; p < k; ++p)
+			{
+				const auto a_value = static_cast<float>(a[i * k + p]);
+				const float* b_row = b + p * n;
+				for (size_t j = 0; j < n; ++j)
+				{
+					c_row[j] += a_value * b_row[j];
+				}
+			}
+		}
+	}
+
+	void hadamard(float* x, const float* y, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] *= y[i];
+		}
+	}
+
+	void axpy(float* x, const float* y, const float alpha, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] += alpha * y[i];
+		}
+	}
+
+	void max_argmax(float* max, uint8_t* argmax, const float* x, const uint8_t index, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (x[i] > max[i])
+			{
+				max[i] = x[i];
+				argmax[i] = index;
+			}
+		}
+	}
+
+	void random_mask(uint64_t* mask, const uint32_t key, const uint32_t counter, const uint32_t threshold, const size_t size)
+	{
+		for (size_t word = 0; word * 64 < size; ++word)
+		{
+			const size_t bits = size - word * 64 < 64 ? size - word * 64 : 64;
+			uint64_t value = 0;
+			for (size_t j = 0; j < bits; ++j)
+			{
+				const uint32_t random = nn::kernels::random_bits(key ^ (counter + static_cast<uint32_t>(word * 64 + j)));
+				value |= static_cast<uint64_t>(random >= threshold) << j;
+			}
+			mask[word] = value;
+		}
+	}
+
+	void masked_scale(float* y, const float* x, const uint64_t* mask, const float scale, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			y[i] = (mask[i / 64] >> (i % 64)) & 1 ? scale * x[i] : 0.0f;
+		}
+	}
+
+	void sigmoid(float* x, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] = 1.0f / (1.0f + std::exp(-x[i]));
+		}
+	}
+
+	void sigmoid_derivative(float* x, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			const float value = 1.0f / (1.0f + std::exp(-x[i]));
+			x[i] = value * (1.0f - value);
+		}
+	}
+
+	void tanh(float* x, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] = std::tanh(x[i]);
+		}
+	}
+
+	void tanh_derivative(float* x, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			const float value = std::tanh(x[i]);
+			x[i] = 1.0f - value * value;
+		}
+	}
+
+	void leaky_relu(float* x, const float slope, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] = x[i] > 0.0f ? x[i] : slope * x[i];
+		}
+	}
+
+	void leaky_relu_derivative(float* x, const float slope, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			x[i] = x[i] > 0.0f ? 1.0f : slope;
+		}
+	}
+
+	void sigmoid_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			y[i] = delta[i] * a[i] * (1.0f - a[i]);
+		}
+	}
+
+	void tanh_backward(float* y, const float* a, const float* delta, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			y[i] = delta[i] * (1.0f - a[i] * a[i]);
+		}
+	}
+
+	void leaky_relu_backward(float* y, const float* x, const float* delta, const float slope, const size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			y[i] = x[i] > 0.0f ? delta[i] : slope * delta[i];
+		}
+	}
+
+	void row_sums(const float* a, float* result, const size_t m, const size_t n, const float alpha, const size_t lda)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			float sum = 0.0f;
+			for (size_t j = 0; j < n; ++j)
+			{
+				sum += a[i * lda + j];
+			}
+			result[i] = alpha * sum;
+		}
+	}
+
+	void sgemm_nt_row_sums(const float* a, const float* b, float* c, float* sums, const size_t m, const size_t n,
+	                       const size_t k, const float alpha, const float beta, const size_t lda, const size_t ldb,
+	                       const size_t ldc)
+	{
+		// Panels of b are copied transposed, so the inner loop runs over contiguous rows like sgemm (and vectorizes)
+		constexpr size_t cols_per_block = 64, depth_per_block = 128;
+		float panel[depth_per_block * cols_per_block];
+
+		// Every depth block after the first adds to c, the row sums ride along the first panel of every depth block
+		for (size_t p = 0; p < k || p == 0; p += depth_per_block)
+		{
+			const size_t depth = k - p < depth_per_block ? k - p : depth_per_block;
+			const float block_beta = p == 0 ? beta : 1.0f;
+			for (size_t j = 0; j < n || j == 0; j += cols_per_block)
+			{
+				const size_t cols = n - j < cols_per_block ? n - j : cols_per_block;
+				for (size_t jj = 0; jj < cols; ++jj)
+				{
+					for (size_t pp = 0; pp < depth; ++pp)
+					{
+						panel[pp * cols + jj] = b[(j + jj) * ldb + p + pp];
+					}
+				}
+
+				for (size_t i = 0; i < m; ++i)
+				{
+					const float* a_row = a + i * lda + p;
+					float row[cols_per_block] = {};
+					float sum = 0.0f;
+					for (size_t pp = 0; pp < depth; ++pp)
+					{
+						const float a_value = a_row[pp];
+						sum += a_value;
+						for (size_t jj = 0; jj < cols; ++jj)
+						{
+							row[jj] += a_value * panel[pp * cols + jj];
+						}
+					}
+
+					float* c_row = c + i * ldc + j;
+					for (size_t jj = 0; jj < cols; ++jj)
+					{
+						c_row[jj] = block_beta == 0.0f ? alpha * row[jj] : alpha * row[jj] + block_beta * c_row[jj];
+					}
+					if (j == 0)
+					{
+						sums[i] = block_beta == 0.0f ? alpha * sum : alpha * sum + block_beta * sums[i];
+					}
+				}
+			}
+		}
+	}
+
+	int32_t dot_u8s8(const uint8_t* activations, const int8_t* weights, const size_t size)
+	{
+		int32_t accumulator = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			accumulator += static_cast<int32_t>(activations[i]) * static_cast<int32_t>(weights[i]);
+		}
+
+		return accumulator;
+	}
+
+	void gemm_u8s8(const uint8_t* a, const int8_t* b, int32_t* c, const size_t m, const size_t n, const size_t k,
+	               const size_t lda, const size_t ldb, const size_t ldc)
+	{
+		// Blocks of 4 weight rows x 4 samples: every weight loaded is used for 4 samples, every activation for 4 rows
+		constexpr size_t block = 4;
+		for (size_t j = 0; j < n; j += block)
+		{
+			const size_t rows = n - j < block ? n - j : block;
+			for (size_t i = 0; i < m; i += block)
+			{
+				const size_t samples = m - i < block ? m - i : block;
+				int32_t accumulators[block][block] = {};
+				for (size_t p = 0; p < k; ++p)
+				{
+					for (size_t s = 0; s < samples; ++s)
+					{
+						const int32_t activation = a[(i + s) * lda + p];
+						for (size_t r = 0; r < rows; ++r)
+						{
+							accumulators[s][r] += activation * static_cast<int32_t>(b[(j + r) * ldb + p]);
+						}
+					}
+				}
+				for (size_t s = 0; s < samples; ++s)
+				{
+					for (size_t r = 0; r < rows; ++r)
+					{
+						c[(i + s) * ldc + j + r] = accumulators[s][r];
+					}
+				}
+			}
+		}
+	}
+}
+
+void nn::kernels::register_scalar_kernels(KernelTable& table)
+{
+	table.sgemm = sgemm;
+	table.row_sums = row_sums;
+	table.sgemm_nt_row_sums = sgemm_nt_row_sums;
+	table.sgemm_bf16 = sgemm_half<bfloat16>;
+	table.sgemm_fp16 = sgemm_half<float16>;
+	table.hadamard = hadamard;
+	table.axpy = axpy;
+	table.max_argmax = max_argmax;
+	table.random_mask = random_mask;
+	table.masked_scale = masked_scale;
+	table.sigmoid = sigmoid;
+	table.sigmoid_derivative = sigmoid_derivative;
+	table.tanh = tanh;
+	table.tanh_derivative = tanh_derivative;
+	table.leaky_relu = leaky_relu;
+	table.leaky_relu_derivative = leaky_relu_derivative;
+	table.sigmoid_backward = sigmoid_backward;
+	table.tanh_backward = tanh_backward;
+	table.leaky_relu_backward = leaky_relu_backward;
+	table.dot_u8s8 = dot_u8s8;
+	table.gemm_u8s8 = gemm_u8s8;
+}
@@ -0,0 +1,230 @@
+// File: src/NeuralNetwork/MatrixView.cpp
+// Purpose: Implementation file for the kernels on matrix views.
+
+#include "NeuralNetwork/MatrixView.h"
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_WORK
+
+#include <cstring> // std::memcpy
+
+namespace
+{
+	void check_same_size(const nn::MatrixView<const float>& x, const nn::MatrixView<const float>& y)
+	{
+		if (x.get_rows() != y.get_rows() || x.get_cols() != y.get_cols())
+		{
+			throw std::runtime_error("Cannot perform element wise operation on matrices with incompatible dimensions.");
+		}
+	}
+
+	/// <summary>
+	/// Calls kernel(x_row, y_row, size) once for contiguous views, once per row otherwise.
+	/// </summary>
+	template <typename Kernel>
+	void for_each_row(const nn::MatrixView<float>& x, const nn::MatrixView<const float>& y, const Kernel& kernel)
+	{
+		if (x.is_contiguous() && y.is_contiguous())
+		{
+			kernel(x.get_data(), y.get_data(), x.get_rows() * x.get_cols());
+			return;
+		}
+
+		for (size_t i = 0; i < x.get_rows(); ++i)
+		{
+			kernel(&x(i, 0), &y(i, 0), x.get_cols());
+		}
+	}
+}
+
+void nn::multiply(const MatrixView<const float> a, const MatrixView<const float> b, const MatrixView<float> c)
+{
+	if (a.get_cols() != b.get_rows() || c.get_rows() != a.get_rows() || c.get_cols() != b.get_cols())
+	{
+		throw std::runtime_error("Cannot multiply matrices with incompatible dimensions.");
+	}
+
+	NN_PROFILE_WORK(2 * a.get_rows() * a.get_cols() * b.get_cols(), sizeof(float) *
+		(a.get_rows() * a.get_cols() + b.get_rows() * b.get_cols() + c.get_rows() * c.get_cols()));
+	kernels::get_kernels().sgemm(a.get_data(), b.get_data(), c.get_data(), c.get_rows(), c.get_cols(), a.get_cols(),
+		a.get_stride(), b.get_stride(), c.get_stride());
+}
+
+void nn::multiply_transposed_a(const MatrixView<const float> a, const MatrixView<const float> b, const MatrixView<float> c,
+	const float alpha, const float beta)
+{
+	if (a.get_rows() != b.get_rows() || c.get_rows() != a.get_cols() || c.get_cols() != b.get_cols())
+	{
+		throw std::runtime_error("Cannot multiply matrices with incompatible dimensions.");
+	}
+
+	NN_PROFILE_WORK(2 * c.get_rows() * c.get_cols() * a.get_rows(), sizeof(float) *
+		(a.get_rows() * a.get_cols() + b.get_rows() * b.get_cols() + c.get_rows() * c.get_cols()));
+	const kernels::KernelTable& table = kernels::get_kernels();
+	if (table.sgemm_tn != nullptr)
+	{
+		table.sgemm_tn(a.get_data(), b.get_data(), c.get_data(), c.get_rows(), c.get_cols(), a.get_rows(), alpha, beta,
+			a.get_stride(), b.get_stride(), c.get_stride());
+		return;
+	}
+
+	// Rank one updates with the rows of a and b, every loop runs over contiguous rows
+	for (size_t i = 0; i < c.get_rows(); ++i)
+	{
+		for (size_t j = 0; j < c.get_cols(); ++j)
+		{
+			c(i, j) = beta == 0.0f ? 0.0f : beta * c(i, j);
+		}
+	}
+	for (size_t p = 0; p < a.get_rows(); ++p)
+	{
+		for (size_t i = 0; i < c.get_rows(); ++i)
+		{
+			const float a_value = alpha * a(p, i);
+			float* c_row = &c(i, 0);
+			const float* b_row = &b(p, 0);
+			for (size_t j = 0; j < c.get_cols(); ++j)
+			{
+				c_row[j] += a_value * b_row[j];
+			}
+		}
+	}
+}
+
+void nn::multiply_transposed_b(const MatrixView<const float> a, const MatrixView<const float> b, const MatrixView<float> c,
+	const float alpha, const float beta)
+{
+	if (a.get_cols() != b.get_cols() || c.get_rows() != a.get_rows() || c.get_cols() != b.get_rows())
+	{
+		throw std::runtime_error("Cannot multiply matrices with incompatible dimensions.");
+	}
+
+	NN_PROFILE_WORK(2 * c.get_rows() * c.get_cols() * a.get_cols(), sizeof(float) *
+		(a.get_rows() * a.get_cols() + b.get_rows() * b.get_cols() + c.get_rows() * c.get_cols()));
+	const kernels::KernelTable& table = kernels::get_kernels();
+	if (table.sgemm_nt != nullptr)
+	{
+		table.sgemm_nt(a.get_data(), b.get_data(), c.get_data(), c.get_rows(), c.get_cols(), a.get_cols(), alpha, beta,
+			a.get_stride(), b.get_stride(), c.get_stride());
+		return;
+	}
+
+	// Dot products of the rows of a and b, in independent partial sums so the reduction vectorizes
+	const size_t k = a.get_cols();
+	for (size_t i = 0; i < c.get_rows(); ++i)
+	{
+		const float* a_row = &a(i, 0);
+		for (size_t j = 0; j < c.get_cols(); ++j)
+		{
+			const float* b_row = &b(j, 0);
+			float lanes[8] = {};
+			size_t p = 0;
+			for (; p + 8 <= k; p += 8)
+			{
+				for (size_t lane = 0; lane < 8; ++lane)
+				{
+					lanes[lane] += a_row[p + lane] * b_row[p + lane];
+				}
+			}
+			float sum = 0.0f;
+			for (; p < k; ++p)
+			{
+				sum += a_row[p] * b_row[p];
+			}
+			for (const float lane : lanes)
+			{
+				sum += lane;
+			}
+			c(i, j) = beta == 0.0f ? alpha * sum : alpha * sum + beta * c(i, j);
+		}
+	}
+}
+
+void nn::sum_rows(const MatrixView<const float> a, const MatrixView<float> result, const float alpha, const float beta)
+{
+	if (result.get_rows() != a.get_rows() || result.get_cols() != 1)
+	{
+		throw std::runtime_error("Cannot calculate row sums with incompatible dimensions.");
+	}
+
+	NN_PROFILE_WORK(a.get_rows() * a.get_cols() + a.get_rows(), sizeof(float) * (a.get_rows() * a.get_cols() + a.get_rows()));
+	const kernels::KernelTable& table = kernels::get_kernels();
+	if (beta != 0.0f)
+	{
+		// The kernel overwrites: one row at a time into a register, then added to the result
+		for (size_t i = 0; i < a.get_rows(); ++i)
+		{
+			float sum;
+			table.row_sums(&a(i, 0), &sum, 1, a.get_cols(), alpha, a.get_stride());
+			result(i, 0) = sum + beta * result(i, 0);
+		}
+		return;
+	}
+	if (result.get_stride() == 1)
+	{
+		table.row_sums(a.get_data(), result.get_data(), a.get_rows(), a.get_cols(), alpha, a.get_stride());
+		return;
+	}
+
+	// A column of a wider matrix
+	for (size_t i = 0; i < a.get_rows(); ++i)
+	{
+		table.row_sums(&a(i, 0), &result(i, 0), 1, a.get_cols(), alpha, a.get_stride());
+	}
+}
+
+void nn::multiply_transposed_b_sum_rows(const MatrixView<const float> a, const MatrixView<const float> b,
+	const MatrixView<float> c, const MatrixView<float> sums, const float alpha, const float beta)
+{
+	const kernels::KernelTable& table = kernels::get_kernels();
+	if (table.blas != nullptr || sums.get_stride() != 1)
+	{
+		multiply_transposed_b(a, b, c, alpha, beta);
+		sum_rows(a, sums, alpha, beta);
+		return;
+	}
+	if (a.get_cols() != b.get_cols() || c.get_rows() != a.get_rows() || c.get_cols() != b.get_rows() ||
+		sums.get_rows() != a.get_rows() || sums.get_cols() != 1)
+	{
+		throw std::runtime_error("Cannot multiply matrices with incompatible dimensions.");
+	}
+
+	NN_PROFILE_WORK(2 * c.get_rows() * c.get_cols() * a.get_cols() + a.get_rows() * a.get_cols(), sizeof(float) *
+		(a.get_rows() * a.get_cols() + b.get_rows() * b.get_cols() + c.get_rows() * c.get_cols() + a.get_rows()));
+	table.sgemm_nt_row_sums(a.get_data(), b.get_data(), c.get_data(), sums.get_data(), c.get_rows(), c.get_cols(),
+		a.get_cols(), alpha, beta, a.get_stride(), b.get_stride(), c.get_stride());
+}
+
+void nn::hadamard_product(const MatrixView<float> x, const MatrixView<const float> y)
+{
+	check_same_size(x, y);
+
+	NN_PROFILE_WORK(x.get_rows() * x.get_cols(), 3 * sizeof(float) * x.get_rows() * x.get_cols());
+	const kernels::KernelTable& table = kernels::get_kernels();
+	for_each_row(x, y, [&table](float* x_row, const float* y_row, const size_t size)
+	{
+		table.hadamard(x_row, y_row, size);
+	});
+}
+
+void nn::add_scaled(const MatrixView<float> x, const MatrixView<const float> y, const float scale)
+{
+	check_same_size(x, y);
+
+	NN_PROFILE_WORK(2 * x.get_rows() * x.get_cols(), 3 * sizeof(float) * x.get_rows() * x.get_cols());
+	const kernels::KernelTable& table = kernels::get_kernels();
+	for_each_row(x, y, [&table, scale](float* x_row, const float* y_row, const size_t size)
+	{
+		table.axpy(x_row, y_row, scale, size);
+	});
+}
+
+void nn::copy(const MatrixView<const float> source, const MatrixView<float> destination)
+{
+	check_same_size(destination, source);
+
+	NN_PROFILE_WORK(0, 2 * sizeof(float) * source.get_rows() * source.get_cols());
+	for_each_row(destination, source, [](float* destination_row, const float* source_row, const size_t size)
+	{
+		std::memcpy(destination_row, source_row, size * sizeof(float));
+	});
+}
@@ -2,16 +2,30 @@
 // Purpose: Implementation file for NeuralNetwork class.
 
 #include "NeuralNetwork/NeuralNetwork.h"
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer, nn::as_dense_layer
+#include "NeuralNetwork/BatchNorm.h" // nn::BatchNorm
+#include "NeuralNetwork/AllocationTracker.h" // nn::memory::ScopedTag, nn::memory::NoAllocationGuard
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_LAYER_SCOPE
 
+#include <algorithm> // std::count, std::max
+#include <cmath> // std::ceil, std::sqrt
 #include <fstream> // std::ofstream
+#include <optional> // std::optional
+
+size_t nn::CheckpointPlan::get_checkpoint_count() const
+{
+	return static_cast<size_t>(std::count(this->checkpoints.begin(), this->checkpoints.end(), true));
+}
 
 nn::NeuralNetwork::NeuralNetwork()
-	: batch_size_(1), learning_rate_(0.01f)
+	: batch_size_(1), learning_rate_(0.01f), allocation_guard_(false), warmed_up_(false), accumulation_steps_(1),
+	  gradient_checkpointing_(false), last_checkpoint_(0)
 {
 }
 
 nn::NeuralNetwork::NeuralNetwork(const float learning_rate, const size_t batch_size)
-	: batch_size_(batch_size), learning_rate_(learning_rate)
+	: batch_size_(batch_size), learning_rate_(learning_rate), allocation_guard_(false), warmed_up_(false), accumulation_steps_(1),
+	  gradient_checkpointing_(false), last_checkpoint_(0)
 {
 }
 
@@ -25,6 +39,337 @@ void nn::NeuralNetwork::set_batch_size(const size_t batch_size)
 	batch_size_ = batch_size;
 }
 
+void nn::NeuralNetwork::set_weight_precision(const Precision precision)
+{
+	// iterate through the layers except the first one
+	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it)
+	{
+		(*it)->set_weight_precision(precision);
+	}
+}
+
+void nn::NeuralNetwork::set_training(const bool training)
+{
+	for (const auto& layer : this->layers_)
+	{
+		layer->set_training(training);
+	}
+}
+
+void nn::NeuralNetwork::set_accumulation_steps(const size_t steps)
+{
+	if (steps == 0)
+	{
+		throw std::runtime_error("Gradients must be accumulated over at least one batch.");
+	}
+	accumulation_steps_ = steps;
+}
+
+size_t nn::NeuralNetwork::get_accumulation_steps() const
+{
+	return accumulation_steps_;
+}
+
+void nn::NeuralNetwork::set_gradient_checkpointing(const bool enabled)
+{
+	if (enabled && this->allocation_guard_)
+	{
+		throw std::logic_error("Gradient checkpointing allocates the recomputed layers in every step, disable the allocation guard.");
+	}
+	this->gradient_checkpointing_ = enabled;
+	this->checkpoint_plan_ = enabled ? this->plan_checkpoints() : CheckpointPlan();
+	this->checkpoint_layers_.clear();
+	this->released_layers_.assign(enabled ? this->layers_.size() : 0, false);
+	this->last_checkpoint_ = 0;
+	if (!enabled)
+	{
+		return;
+	}
+
+	for (const auto& layer : this->layers_)
+	{
+		this->checkpoint_layers_.push_back(layer.get());
+	}
+	for (size_t i = 0; i < this->checkpoint_plan_.checkpoints.size(); ++i)
+	{
+		this->last_checkpoint_ = this->checkpoint_plan_.checkpoints[i] ? i : this->last_checkpoint_;
+	}
+}
+
+nn::CheckpointPlan nn::NeuralNetwork::plan_checkpoints() const
+{
+	CheckpointPlan plan;
+	const size_t count = this->layers_.size();
+	if (count == 0)
+	{
+		return plan;
+	}
+
+	std::vector<size_t> bytes;
+	std::vector<bool> recomputable;
+	for (const auto& layer : this->layers_)
+	{
+		bytes.push_back(layer->get_memory_requirements().activation_bytes);
+		recomputable.push_back(layer->is_recomputable());
+		plan.activation_bytes += bytes.back();
+	}
+
+	// About sqrt(count) segments with the same activation bytes, the input layer and the layers that cannot run twice
+	// start a segment. The layer before one that cannot run twice is kept too: such a layer may pass the activations of
+	// the previous layer through (a dropout outside training) instead of copying them.
+	const auto segment_count = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+	const size_t budget = (plan.activation_bytes - bytes.front() + segment_count - 1) / segment_count;
+	plan.checkpoints.assign(count, false);
+	plan.checkpoints.front() = true;
+	size_t segment_bytes = 0;
+	for (size_t i = 1; i < count; ++i)
+	{
+		const bool before_checkpoint = i + 1 < count && !recomputable[i + 1];
+		if (!recomputable[i] || before_checkpoint || (segment_bytes != 0 && segment_bytes + bytes[i] > budget))
+		{
+			plan.checkpoints[i] = true;
+			segment_bytes = 0;
+			continue;
+		}
+		segment_bytes += bytes[i];
+	}
+
+	// The checkpoints stay, one segment between two checkpoints is recomputed at a time while the first layer after
+	// it still holds its activations, the last segment is never released
+	size_t last_checkpoint = 0, kept_bytes = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (plan.checkpoints[i])
+		{
+			last_checkpoint = i;
+			kept_bytes += bytes[i];
+		}
+	}
+	size_t segment_peak = 0;
+	for (size_t first = 1; first < count;)
+	{
+		if (plan.checkpoints[first])
+		{
+			++first;
+			continue;
+		}
+		size_t last = first, segment = 0;
+		for (; last < count && !plan.checkpoints[last]; ++last)
+		{
+			segment += bytes[last];
+		}
+		if (first > last_checkpoint)
+		{
+			segment_peak = std::max(segment_peak, segment);
+		}
+		else
+		{
+			plan.recomputed_layers += last - first;
+			const size_t next = last + 1;
+			segment_peak = std::max(segment_peak, segment + (next < count && !plan.checkpoints[next] ? bytes[next] : 0));
+		}
+		first = last;
+	}
+	plan.peak_activation_bytes = kept_bytes + segment_peak;
+	return plan;
+}
+
+const nn::CheckpointPlan& nn::NeuralNetwork::get_checkpoint_plan() const
+{
+	return this->checkpoint_plan_;
+}
+
+bool nn::NeuralNetwork::is_released_after_use(const size_t index) const
+{
+	return !this->checkpoint_plan_.checkpoints[index] && index < this->last_checkpoint_;
+}
+
+void nn::NeuralNetwork::recompute_layer(const size_t index)
+{
+	if (!this->released_layers_[index])
+	{
+		return;
+	}
+
+	// The released layers before it up to the previous checkpoint
+	size_t first = index;
+	while (this->released_layers_[first - 1])
+	{
+		--first;
+	}
+	for (size_t i = first; i <= index; ++i)
+	{
+		NN_PROFILE_LAYER_SCOPE("recompute", i);
+		this->checkpoint_layers_[i]->feed_forward(*this->checkpoint_layers_[i - 1]);
+		this->released_layers_[i] = false;
+	}
+}
+
+void nn::NeuralNetwork::feed_forward_layers()
+{
+	if (!this->gradient_checkpointing_)
+	{
+		// iterate through the layers except the first one
+		size_t layer_index = 1;
+		for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it, ++layer_index)
+		{
+			NN_PROFILE_LAYER_SCOPE("feed_forward", layer_index);
+			const auto previous_layer = std::prev(it);
+			(*it)->feed_forward(*previous_layer->get());
+		}
+		return;
+	}
+
+	if (this->checkpoint_layers_.size() != this->layers_.size())
+	{
+		throw std::logic_error("The layers changed after gradient checkpointing was planned.");
+	}
+	for (size_t i = 1; i < this->checkpoint_layers_.size(); ++i)
+	{
+		NN_PROFILE_LAYER_SCOPE("feed_forward", i);
+		this->checkpoint_layers_[i]->feed_forward(*this->checkpoint_layers_[i - 1]);
+		this->released_layers_[i] = false;
+		// Back propagation recomputes the previous layer when it gets there
+		if (this->is_released_after_use(i - 1))
+		{
+			this->checkpoint_layers_[i - 1]->release_activations();
+			this->released_layers_[i - 1] = true;
+		}
+	}
+}
+
+std::vector<size_t> nn::NeuralNetwork::plan_pipeline_stages(const size_t stage_count) const
+{
+	std::vector<Layer*> layers;
+	for (const auto& layer : this->layers_)
+	{
+		layers.push_back(layer.get());
+	}
+	return pipeline::plan_stages(layers, this->batch_size_, stage_count);
+}
+
+nn::pipeline::Report nn::NeuralNetwork::train_pipelined(const size_t stage_count, const pipeline::Schedule schedule)
+{
+	if (!this->is_ready())
+	{
+		throw std::runtime_error("Neural network is not ready to be trained.");
+	}
+	if (this->gradient_checkpointing_)
+	{
+		throw std::logic_error("Pipeline training recomputes the stages itself, disable gradient checkpointing.");
+	}
+	const std::vector<size_t> stage_first_layers = this->plan_pipeline_stages(stage_count);
+	std::vector<Layer*> layers;
+	for (const auto& layer : this->layers_)
+	{
+		layers.push_back(layer.get());
+	}
+
+	NN_PROFILE_SCOPE("epoch");
+	this->set_training(true);
+	const pipeline::Report report = pipeline::train_epoch(layers, *this->data_set_, this->learning_rate_,
+		this->accumulation_steps_, stage_first_layers, schedule);
+	for (const auto& layer : this->layers_)
+	{
+		layer->set_gradient_accumulation(false);
+	}
+	this->data_set_->reset();
+	this->set_training(false);
+	return report;
+}
+
+nn::hogwild::Report nn::NeuralNetwork::train_hogwild(const size_t thread_count)
+{
+	if (!this->is_ready())
+	{
+		throw std::runtime_error("Neural network is not ready to be trained.");
+	}
+	if (this->accumulation_steps_ != 1)
+	{
+		throw std::logic_error("Hogwild training updates after every batch, set the accumulation steps to 1.");
+	}
+	std::vector<Layer*> layers;
+	for (const auto& layer : this->layers_)
+	{
+		layers.push_back(layer.get());
+	}
+
+	NN_PROFILE_SCOPE("epoch");
+	this->set_training(true);
+	const hogwild::Report report = hogwild::train_epoch(layers, *this->data_set_, this->learning_rate_, thread_count);
+	// The threads updated the float weights only
+	this->refresh_weight_precision();
+	this->data_set_->reset();
+	this->set_training(false);
+	return report;
+}
+
+nn::distributed::Report nn::NeuralNetwork::train_distributed(distributed::Communicator& communicator)
+{
+	if (!this->is_ready())
+	{
+		throw std::runtime_error("Neural network is not ready to be trained.");
+	}
+	if (this->accumulation_steps_ != 1)
+	{
+		throw std::logic_error("Distributed training combines the gradients of the ranks, set the accumulation steps to 1.");
+	}
+	if (this->gradient_checkpointing_)
+	{
+		throw std::logic_error("Distributed training back propagates every layer itself, disable gradient checkpointing.");
+	}
+	std::vector<Layer*> layers;
+	for (const auto& layer : this->layers_)
+	{
+		layers.push_back(layer.get());
+	}
+
+	NN_PROFILE_SCOPE("epoch");
+	distributed::broadcast_parameters(layers, communicator);
+	this->refresh_weight_precision();
+	this->set_training(true);
+	const distributed::Report report = distributed::train_epoch(layers, *this->data_set_, this->learning_rate_, communicator);
+	this->data_set_->reset();
+	this->set_training(false);
+	return report;
+}
+
+nn::numa::NodeReplicas nn::NeuralNetwork::create_node_replicas()
+{
+	if (!this->is_ready())
+	{
+		throw std::runtime_error("Neural network is not ready to be replicated.");
+	}
+	std::vector<Layer*> layers;
+	for (const auto& layer : this->layers_)
+	{
+		layers.push_back(layer.get());
+	}
+	return numa::NodeReplicas(layers);
+}
+
+void nn::NeuralNetwork::refresh_weight_precision()
+{
+	for (const auto& layer : this->layers_)
+	{
+		auto* dense_layer = dynamic_cast<DenseLayer*>(layer.get());
+		if (dense_layer != nullptr && dense_layer->get_parameters().size() != 0)
+		{
+			dense_layer->set_weight_precision(dense_layer->get_weight_precision());
+		}
+	}
+}
+
+void nn::NeuralNetwork::set_allocation_guard(const bool enabled)
+{
+	if (enabled && this->gradient_checkpointing_)
+	{
+		throw std::logic_error("Gradient checkpointing allocates the recomputed layers in every step, disable it first.");
+	}
+	allocation_guard_ = enabled;
+	warmed_up_ = false;
+}
+
 void nn::NeuralNetwork::set_data_set(std::unique_ptr<DataSet> training_set)
 {
 	data_set_ = std::move(training_set);
@@ -41,16 +386,15 @@ void nn::NeuralNetwork::feed_forward()
 	{
 		throw std::runtime_error("Neural network is not ready to be fed forward.");
 	}
+	const memory::ScopedTag tag("NeuralNetwork::feed_forward");
 
 	// first item of the list
-	this->layers_.front()->set_activations(this->data_set_->get_batch_input());
-
-	// iterate through the layers except the first one
-	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it)
 	{
-		const auto previous_layer = std::prev(it);
-		(*it)->feed_forward(*previous_layer->get());
+		NN_PROFILE_LAYER_SCOPE("data_set/get_batch_input", 0);
+		this->layers_.front()->set_activations(this->data_set_->get_batch_input());
 	}
+
+	this->feed_forward_layers();
 }
 
 void nn::NeuralNetwork::feed_forward_with_input(const Matrix<float>& input)
@@ -64,12 +408,7 @@ void nn::NeuralNetwork::feed_forward_with_input(const Matrix<float>& input)
 	// first item of the list
 	this->layers_.front()->set_activations(input);
 
-	// iterate through the layers except the first one
-	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it)
-	{
-		const auto previous_layer = std::prev(it);
-		(*it)->feed_forward(*previous_layer->get());
-	}
+	this->feed_forward_layers();
 }
 
 void nn::NeuralNetwork::back_propagate()
@@ -78,32 +417,71 @@ void nn::NeuralNetwork::back_propagate()
 	{
 		throw std::runtime_error("Neural network is not ready to be back propagated.");
 	}
+	const memory::ScopedTag tag("NeuralNetwork::back_propagate");
 
 	// last item of the list
 	auto last_layer = std::prev(this->layers_.end());
 	auto second_to_last_layer = std::prev(last_layer);
-	(*last_layer)->back_propagate(this->data_set_->get_batch_output(), *second_to_last_layer->get());
+	size_t layer_index = this->layers_.size() - 1;
+	if (this->gradient_checkpointing_ && this->checkpoint_layers_.size() != this->layers_.size())
+	{
+		throw std::logic_error("The layers changed after gradient checkpointing was planned.");
+	}
+	{
+		NN_PROFILE_LAYER_SCOPE("back_propagate", layer_index);
+		const Matrix<float>* expected_output;
+		{
+			NN_PROFILE_SCOPE("data_set/get_batch_output");
+			expected_output = &this->data_set_->get_batch_output();
+		}
+		if (this->gradient_checkpointing_)
+		{
+			this->recompute_layer(layer_index - 1);
+		}
+		(*last_layer)->back_propagate(*expected_output, *second_to_last_layer->get());
+	}
 
 	// iterate through the second to the last layer to the second layer
 	for (auto it = std::prev(this->layers_.end(), 2); it != this->layers_.begin(); --it)
 	{
+		// Not inside the macro, it expands to nothing without the profiler
+		--layer_index;
+		NN_PROFILE_LAYER_SCOPE("back_propagate", layer_index);
+		if (this->gradient_checkpointing_)
+		{
+			this->recompute_layer(layer_index - 1);
+		}
 		const auto next_layer = std::next(it);
 		const auto previous_layer = std::prev(it);
 		(*it)->back_propagate(*next_layer->get(), *previous_layer->get());
+		// The next layer has handed on its delta
+		if (this->gradient_checkpointing_ && this->is_released_after_use(layer_index + 1))
+		{
+			(*next_layer)->release_activations();
+			this->released_layers_[layer_index + 1] = true;
+		}
 	}
 }
 
 void nn::NeuralNetwork::update_weights_and_biases()
+{
+	this->update_weights_and_biases(this->learning_rate_);
+}
+
+void nn::NeuralNetwork::update_weights_and_biases(const float learning_rate)
 {
 	if (!this->is_ready())
 	{
 		throw std::runtime_error("Neural network is not ready to update weights and biases.");
 	}
+	const memory::ScopedTag tag("NeuralNetwork::update_weights_and_biases");
 
 	// iterate through the layers except the first one
-	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it)
+	size_t layer_index = 1;
+	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end(); ++it, ++layer_index)
 	{
-		(*it)->update_weights_and_biases(this->learning_rate_);
+		NN_PROFILE_LAYER_SCOPE("update_weights_and_biases", layer_index);
+		(*it)->update_weights_and_biases(learning_rate);
 	}
 }
 
@@ -117,16 +495,51 @@ void nn::NeuralNetwork::train(const size_t epochs)
 
 void nn::NeuralNetwork::train_one_epoch()
 {
+	NN_PROFILE_SCOPE("epoch");
+	this->set_training(true);
 	this->data_set_->reset();
+	// Every micro batch weighs 1 / steps in the gradients, the first of a group overwrites them
+	const float scale = 1.0f / static_cast<float>(this->accumulation_steps_);
+	size_t micro_batch = 0;
 	while (!this->data_set_->is_end())
 	{
-		this->feed_forward();
-		this->back_propagate();
-		this->update_weights_and_biases();
+		NN_PROFILE_SCOPE("batch");
+		{
+			// Everything a step needs is allocated by the warm up step
+			std::optional<memory::NoAllocationGuard> guard;
+			if (this->allocation_guard_ && this->warmed_up_)
+			{
+				guard.emplace();
+			}
+			this->feed_forward();
+			for (const auto& layer : this->layers_)
+			{
+				layer->set_gradient_accumulation(micro_batch != 0, scale);
+			}
+			this->back_propagate();
+			if (++micro_batch == this->accumulation_steps_)
+			{
+				this->update_weights_and_biases();
+				micro_batch = 0;
+			}
+			this->warmed_up_ = true;
+		}
 
+		NN_PROFILE_SCOPE("data_set/go_to_next_batch");
 		this->data_set_->go_to_next_batch();
 	}
+	// The last group of the epoch may be short: its gradients are the sum over micro_batch batches / steps
+	if (micro_batch != 0)
+	{
+		this->update_weights_and_biases(this->learning_rate_ * static_cast<float>(this->accumulation_steps_) /
+			static_cast<float>(micro_batch));
+	}
+	for (const auto& layer : this->layers_)
+	{
+		layer->set_gradient_accumulation(false);
+	}
 	this->data_set_->reset();
+	this->set_training(false);
 }
 
 float nn::NeuralNetwork::calculate_accuracy()
@@ -139,8 +552,8 @@ float nn::NeuralNetwork::calculate_accuracy()
 	{
 		this->feed_forward();
 
-		auto activation_matrix = this->get_output();
-		auto expected_matrix = this->data_set_->get_batch_output();
+		const auto& activation_matrix = this->get_output();
+		const auto& expected_matrix = this->data_set_->get_batch_output();
 
 		for (size_t i = 0; i < activation_matrix.get_cols(); ++i)
 		{
@@ -178,14 +591,11 @@ float nn::NeuralNetwork::get_loss()
 	{
 		this->feed_forward();
 
-		auto activation_matrix = this->get_output();
-		auto expected_matrix = this->data_set_->get_batch_output();
+		const auto& activation_matrix = this->get_output();
+		const auto& expected_matrix = this->data_set_->get_batch_output();
 
-		for (size_t i = 0; i < activation_matrix.get_rows() * activation_matrix.get_cols(); ++i)
-		{
-			const auto temp = static_cast<float>(pow(activation_matrix[i] - expected_matrix[i], 2));
-			loss += temp * temp;
-		}
+		// Sum of (activation - expected)^4 in one pass
+		loss += expressions::sum(expressions::square(expressions::square(activation_matrix - expected_matrix)));
 		data_set_->go_to_next_batch();
 	}
 
@@ -197,6 +607,12 @@ float nn::NeuralNetwork::get_loss()
 
 void nn::NeuralNetwork::save_to_file(const std::string& file_name) const
 {
+	// Only dense layers can be saved (checked before the file is created)
+	for (const auto& layer : this->layers_)
+	{
+		static_cast<void>(as_dense_layer(*layer));
+	}
+
 	// Open file
 	std::ofstream file(file_name);
 	if (!file.is_open())
@@ -210,15 +626,16 @@ void nn::NeuralNetwork::save_to_file(const std::string& file_name) const
 	file << this->layers_.size() << "\n";
 
 	// Write information for each layer
-	for (const auto& layer : this->layers_)
+	for (const auto& generic_layer : this->layers_)
 	{
+		const DenseLayer* layer = &as_dense_layer(*generic_layer);
 		// Write number of neurons
 		file << layer->get_neuron_count() << "\n";
 		// Write the name of activation function class with RTTI
 		file << typeid(*layer->get_activation_function()).name() << "\n";
 
 		// Check if the layer is the first layer
-		if (layer == this->layers_.front())
+		if (generic_layer == this->layers_.front())
 		{
 			// Write the input size
 			file << layer->get_neuron_count() << "\n";
@@ -260,6 +677,40 @@ const nn::Matrix<float>& nn::NeuralNetwork::get_output() const
 	return this->layers_.back()->get_activations();
 }
 
+nn::MemoryRequirements nn::NeuralNetwork::get_memory_requirements() const
+{
+	MemoryRequirements total;
+	for (const auto& layer : this->layers_)
+	{
+		const MemoryRequirements requirements = layer->get_memory_requirements();
+		total.parameter_bytes += requirements.parameter_bytes;
+		total.activation_bytes += requirements.activation_bytes;
+		total.workspace_bytes += requirements.workspace_bytes;
+	}
+	return total;
+}
+
+size_t nn::NeuralNetwork::fold_batch_norms()
+{
+	size_t folded = 0;
+	for (auto it = std::next(this->layers_.begin()); it != this->layers_.end();)
+	{
+		auto* batch_norm = dynamic_cast<BatchNorm*>(it->get());
+		auto* previous_layer = dynamic_cast<DenseLayer*>(std::prev(it)->get());
+		if (batch_norm == nullptr || previous_layer == nullptr || previous_layer->get_parameters().empty() ||
+			activation_functions::get_activation_type(*previous_layer->get_activation_function()) != activation_functions::ActivationType::Linear)
+		{
+			++it;
+			continue;
+		}
+
+		batch_norm->fold_into(*previous_layer);
+		it = this->layers_.erase(it);
+		++folded;
+	}
+	return folded;
+}
+
 nn::DataSet* nn::NeuralNetwork::get_data_set()
 {
 	return this->data_set_.get();
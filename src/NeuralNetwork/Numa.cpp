@@ -0,0 +1,356 @@
+// File: src/NeuralNetwork/Numa.cpp
+// Purpose: Implementation file for NUMA placement.
+
+#include "NeuralNetwork/Numa.h"
+#include "NeuralNetwork/DenseLayer.h" // nn::DenseLayer, nn::as_dense_layer
+
+#include <algorithm> // std::max, std::min
+#include <atomic> // std::atomic
+#include <cstdint> // uintptr_t
+#include <cstdlib> // std::getenv
+#include <cstring> // strcmp
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <fstream> // std::ifstream
+#include <iostream> // std::cerr
+#include <sstream> // std::stringstream
+#include <stdexcept> // std::runtime_error
+#include <thread> // std::thread
+
+#ifdef __linux__
+#include <sched.h> // sched_setaffinity, sched_getcpu
+#include <sys/syscall.h> // SYS_mbind, SYS_get_mempolicy
+#include <unistd.h> // syscall, sysconf
+#endif
+
+namespace
+{
+#ifdef __linux__
+	// Memory policy constants of <linux/mempolicy.h> (the system calls have no glibc wrapper without libnuma)
+	constexpr int mpol_bind = 2;
+	constexpr unsigned mpol_mf_move = 1u << 1;
+	constexpr int mpol_f_node = 1 << 0;
+	constexpr int mpol_f_addr = 1 << 1;
+#endif
+
+	nn::numa::Topology read_topology()
+	{
+		nn::numa::Topology topology;
+#ifdef __linux__
+		for (size_t node = 0;; ++node)
+		{
+			std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+			std::string list;
+			if (!file || !std::getline(file, list))
+			{
+				break;
+			}
+			topology.node_cpus.push_back(nn::numa::parse_cpu_list(list));
+		}
+#endif
+		// No NUMA information: one node with every CPU
+		if (topology.node_cpus.empty())
+		{
+			std::vector<size_t> cpus(std::max(std::thread::hardware_concurrency(), 1u));
+			for (size_t cpu = 0; cpu < cpus.size(); ++cpu)
+			{
+				cpus[cpu] = cpu;
+			}
+			topology.node_cpus.push_back(cpus);
+		}
+		return topology;
+	}
+
+	/// <summary>
+	/// Returns the pinning requested through NN_PIN_THREADS (None if it is not set).
+	/// </summary>
+	nn::numa::Pinning get_requested_pinning()
+	{
+		const char* requested = std::getenv("NN_PIN_THREADS");
+		if (requested == nullptr || *requested == '\0' || strcmp(requested, "none") == 0)
+		{
+			return nn::numa::Pinning::None;
+		}
+		if (strcmp(requested, "compact") == 0)
+		{
+			return nn::numa::Pinning::Compact;
+		}
+		if (strcmp(requested, "scatter") == 0)
+		{
+			return nn::numa::Pinning::Scatter;
+		}
+		std::cerr << "Unknown NN_PIN_THREADS=" << requested << ", not pinning the threads.\n";
+		return nn::numa::Pinning::None;
+	}
+
+	std::atomic<nn::numa::Pinning>& get_pinning_setting()
+	{
+		static std::atomic<nn::numa::Pinning> pinning{ get_requested_pinning() };
+		return pinning;
+	}
+}
+
+size_t nn::numa::Topology::get_node_count() const
+{
+	return this->node_cpus.size();
+}
+
+size_t nn::numa::Topology::get_node_of_cpu(const size_t cpu) const
+{
+	for (size_t node = 0; node < this->node_cpus.size(); ++node)
+	{
+		for (const size_t node_cpu : this->node_cpus[node])
+		{
+			if (node_cpu == cpu)
+			{
+				return node;
+			}
+		}
+	}
+	return 0;
+}
+
+std::vector<size_t> nn::numa::parse_cpu_list(const std::string& list)
+{
+	std::vector<size_t> cpus;
+	std::stringstream stream(list);
+	std::string range;
+	while (std::getline(stream, range, ','))
+	{
+		if (range.empty() || range == "\n")
+		{
+			continue;
+		}
+		const size_t dash = range.find('-');
+		try
+		{
+			const size_t first = std::stoul(range.substr(0, dash));
+			const size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+			for (size_t cpu = first; cpu <= last; ++cpu)
+			{
+				cpus.push_back(cpu);
+			}
+		}
+		catch (const std::logic_error&)
+		{
+			throw std::runtime_error("Invalid CPU list: " + list);
+		}
+	}
+	return cpus;
+}
+
+const nn::numa::Topology& nn::numa::get_topology()
+{
+	static const Topology topology = read_topology();
+	return topology;
+}
+
+nn::numa::Pinning nn::numa::get_pinning()
+{
+	return get_pinning_setting().load();
+}
+
+void nn::numa::set_pinning(const Pinning pinning)
+{
+	get_pinning_setting().store(pinning);
+}
+
+size_t nn::numa::get_worker_cpu(const size_t worker_index, const Pinning pinning)
+{
+	const Topology& topology = get_topology();
+	if (pinning == Pinning::Scatter)
+	{
+		// Round robin over the nodes, then over the CPUs of the node
+		const std::vector<size_t>& cpus = topology.node_cpus[worker_index % topology.get_node_count()];
+		return cpus[worker_index / topology.get_node_count() % cpus.size()];
+	}
+	if (pinning == Pinning::Compact)
+	{
+		size_t cpu_count = 0;
+		for (const auto& cpus : topology.node_cpus)
+		{
+			cpu_count += cpus.size();
+		}
+		size_t index = worker_index % cpu_count;
+		for (const auto& cpus : topology.node_cpus)
+		{
+			if (index < cpus.size())
+			{
+				return cpus[index];
+			}
+			index -= cpus.size();
+		}
+	}
+	throw std::logic_error("Threads are not pinned.");
+}
+
+void nn::numa::pin_worker(const size_t worker_index)
+{
+	const Pinning pinning = get_pinning();
+	if (pinning != Pinning::None)
+	{
+		static_cast<void>(pin_current_thread({ get_worker_cpu(worker_index, pinning) }));
+	}
+}
+
+bool nn::numa::pin_current_thread(const std::vector<size_t>& cpus)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (const size_t cpu : cpus)
+	{
+		if (cpu < CPU_SETSIZE)
+		{
+			CPU_SET(cpu, &set);
+		}
+	}
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	static_cast<void>(cpus);
+	return false;
+#endif
+}
+
+size_t nn::numa::get_current_node()
+{
+#ifdef __linux__
+	const int cpu = sched_getcpu();
+	if (cpu >= 0)
+	{
+		return get_topology().get_node_of_cpu(static_cast<size_t>(cpu));
+	}
+#endif
+	return 0;
+}
+
+bool nn::numa::move_to_node(void* data, const size_t bytes, const size_t node)
+{
+#ifdef __linux__
+	const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+	const auto start = (reinterpret_cast<uintptr_t>(data) + page - 1) / page * page;
+	const auto end = (reinterpret_cast<uintptr_t>(data) + bytes) / page * page;
+	if (end <= start)
+	{
+		return true;
+	}
+	constexpr size_t mask_bits = 8 * sizeof(unsigned long);
+	if (node >= mask_bits)
+	{
+		return false;
+	}
+	const unsigned long mask = 1ul << node;
+	return syscall(SYS_mbind, start, end - start, mpol_bind, &mask, mask_bits, mpol_mf_move) == 0;
+#else
+	static_cast<void>(data);
+	static_cast<void>(bytes);
+	static_cast<void>(node);
+	return false;
+#endif
+}
+
+size_t nn::numa::get_memory_node(const void* data)
+{
+#ifdef __linux__
+	int node = -1;
+	if (syscall(SYS_get_mempolicy, &node, nullptr, 0, data, mpol_f_node | mpol_f_addr) == 0 && node >= 0)
+	{
+		return static_cast<size_t>(node);
+	}
+#else
+	static_cast<void>(data);
+#endif
+	return unknown_node;
+}
+
+nn::numa::NodeReplicas::NodeReplicas(const std::vector<Layer*>& layers)
+{
+	if (layers.size() < 2)
+	{
+		throw std::runtime_error("Neural network is not ready to be replicated.");
+	}
+	std::vector<const DenseLayer*> sources;
+	for (const Layer* layer : layers)
+	{
+		sources.push_back(&as_dense_layer(*layer));
+	}
+
+	// Every copy is allocated and written on its node (first touch), then moved there in case the pages were
+	// written before (memory the allocator reuses)
+	const Topology& topology = get_topology();
+	this->nodes_.resize(topology.get_node_count());
+	std::exception_ptr error;
+	for (size_t node = 0; node < this->nodes_.size() && !error; ++node)
+	{
+		std::thread thread([&, node]()
+		{
+			try
+			{
+				static_cast<void>(pin_current_thread(topology.node_cpus[node]));
+				for (const DenseLayer* source : sources)
+				{
+					std::unique_ptr<DenseLayer> copy = source->create_replica();
+					if (!copy->get_parameters().empty())
+					{
+						copy->set_weights(std::make_unique<Matrix<float>>(source->get_weights()));
+						copy->set_biases(std::make_unique<Matrix<float>>(source->get_biases()));
+						copy->set_weight_precision(source->get_weight_precision());
+						for (const Parameter& parameter : copy->get_parameters())
+						{
+							static_cast<void>(parameter.value->place_on_node(node));
+						}
+					}
+					this->nodes_[node].push_back(std::move(copy));
+				}
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+		});
+		thread.join();
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+nn::numa::NodeReplicas::NodeReplicas(NodeReplicas&&) noexcept = default;
+nn::numa::NodeReplicas& nn::numa::NodeReplicas::operator=(NodeReplicas&&) noexcept = default;
+nn::numa::NodeReplicas::~NodeReplicas() = default;
+
+size_t nn::numa::NodeReplicas::get_node_count() const
+{
+	return this->nodes_.size();
+}
+
+const std::vector<std::unique_ptr<nn::DenseLayer>>& nn::numa::NodeReplicas::get_layers(const size_t node) const
+{
+	return this->nodes_.at(node);
+}
+
+std::vector<std::unique_ptr<nn::DenseLayer>> nn::numa::NodeReplicas::create_thread_layers() const
+{
+	const size_t node = std::min(get_current_node(), this->nodes_.size() - 1);
+	std::vector<std::unique_ptr<DenseLayer>> layers;
+	for (const auto& layer : this->nodes_[node])
+	{
+		layers.push_back(layer->create_replica());
+		// The reduced precision weights are per layer: the thread rounds its own from the copy of the node
+		if (!layers.back()->get_parameters().empty() && layer->get_weight_precision() != Precision::Float32)
+		{
+			layers.back()->set_weight_precision(layer->get_weight_precision());
+		}
+	}
+	return layers;
+}
+
+const nn::Matrix<float>& nn::numa::feed_forward(const std::vector<std::unique_ptr<DenseLayer>>& layers, const Matrix<float>& input)
+{
+	layers.front()->set_activations(input);
+	for (size_t i = 1; i < layers.size(); ++i)
+	{
+		layers[i]->feed_forward(*layers[i - 1]);
+	}
+	return layers.back()->get_activations();
+}
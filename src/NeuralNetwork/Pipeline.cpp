@@ -0,0 +1,565 @@
+// File: src/NeuralNetwork/Pipeline.cpp
+// Purpose: Implementation file for pipeline parallel training.
+
+#include "NeuralNetwork/Pipeline.h"
+#include "NeuralNetwork/Numa.h" // nn::numa::pin_worker
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_LAYER_SCOPE
+
+#include <algorithm> // std::max, std::min
+#include <chrono> // std::chrono::steady_clock
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr, std::make_unique
+#include <stdexcept> // std::runtime_error, std::logic_error
+#include <thread> // std::thread, std::this_thread::yield, std::this_thread::sleep_for
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// Message that ends the epoch (instead of a micro batch index).
+	/// </summary>
+	constexpr size_t stop = std::numeric_limits<size_t>::max();
+
+	/// <summary>
+	/// Thrown in the threads that wait on a queue after another thread failed.
+	/// </summary>
+	struct Aborted
+	{
+	};
+
+	/// <summary>
+	/// Stands in for the layers of the neighbouring stages: hands the buffered input of the current micro batch on as
+	///	its activations and the delta received from the next stage on to the last layer of the stage.
+	/// </summary>
+	class BoundaryLayer final : public nn::Layer
+	{
+	public:
+		const nn::Matrix<float>* input = nullptr;
+		const nn::Matrix<float>* delta = nullptr;
+
+		BoundaryLayer(const size_t neuron_count, const size_t batch_size)
+		{
+			this->neuron_count_ = neuron_count;
+			this->batch_size_ = batch_size;
+		}
+
+		[[nodiscard]] const nn::Matrix<float>& get_activations() const override
+		{
+			return *this->input;
+		}
+
+		void feed_forward(const Layer&) override
+		{
+			throw std::logic_error("A stage boundary is not computed.");
+		}
+
+		void back_propagate(const Layer&, const Layer&) override
+		{
+			throw std::logic_error("A stage boundary is not computed.");
+		}
+
+		void back_propagate(const nn::Matrix<float>&, const Layer&) override
+		{
+			throw std::logic_error("A stage boundary is not computed.");
+		}
+
+		void propagate_delta_to_previous_layer(nn::Matrix<float>& previous_delta_activations) const override
+		{
+			previous_delta_activations = *this->delta;
+		}
+
+		[[nodiscard]] nn::MemoryRequirements get_memory_requirements() const override
+		{
+			return {};
+		}
+	};
+
+	/// <summary>
+	/// Contiguous layers run by one thread and the buffers its neighbours write into.
+	/// </summary>
+	struct Stage
+	{
+		std::vector<nn::Layer*> layers;
+		size_t first_layer;
+
+		/// <summary>
+		/// Inputs of the micro batches of a step (written by the previous stage, the data set for the first stage)
+		///	and the deltas of the activations of the last layer (written by the next stage).
+		/// </summary>
+		std::vector<nn::Matrix<float>> inputs;
+		std::vector<nn::Matrix<float>> deltas;
+		BoundaryLayer input;
+		BoundaryLayer output;
+
+		/// <summary>
+		/// Micro batches whose input (forward) or delta (backward) is ready.
+		/// </summary>
+		nn::pipeline::SpscQueue<size_t> forward_queue;
+		nn::pipeline::SpscQueue<size_t> backward_queue;
+
+		/// <summary>
+		/// Micro batch the activations of the layers belong to.
+		/// </summary>
+		size_t resident = stop;
+
+		double busy_seconds = 0.0;
+
+		Stage(const size_t input_neurons, const size_t output_neurons, const size_t batch_size, const size_t micro_batches)
+			: first_layer(0), input(input_neurons, batch_size), output(output_neurons, batch_size),
+			  forward_queue(micro_batches + 1), backward_queue(micro_batches)
+		{
+		}
+	};
+
+	/// <summary>
+	/// Threads and shared state of one pipelined epoch.
+	/// </summary>
+	class Pipeline
+	{
+	private:
+		std::vector<std::unique_ptr<Stage>> stages_;
+		nn::pipeline::Schedule schedule_;
+		size_t micro_batches_;
+		size_t batch_size_;
+
+		/// <summary>
+		/// Expected outputs of the micro batches of a step (read by the last stage).
+		/// </summary>
+		std::vector<nn::Matrix<float>> targets_;
+
+		/// <summary>
+		/// Micro batches and learning rate of the current step: written by the feeding thread before it sends the
+		///	first micro batch, read by every stage when that micro batch reaches it.
+		/// </summary>
+		size_t step_micro_batches_ = 0;
+		float step_learning_rate_ = 0.0f;
+
+		/// <summary>
+		/// Steps the first stage has finished (its buffers are free for the next step).
+		/// </summary>
+		std::atomic<size_t> completed_steps_{ 0 };
+
+		std::atomic<bool> failed_{ false };
+		std::exception_ptr error_;
+
+		void record_error()
+		{
+			if (!this->failed_.exchange(true))
+			{
+				this->error_ = std::current_exception();
+			}
+		}
+
+		void wait(nn::pipeline::Backoff& backoff) const
+		{
+			if (this->failed_.load(std::memory_order_relaxed))
+			{
+				throw Aborted();
+			}
+			backoff.wait();
+		}
+
+		size_t receive(nn::pipeline::SpscQueue<size_t>& queue)
+		{
+			size_t index;
+			nn::pipeline::Backoff backoff;
+			while (!queue.try_pop(index))
+			{
+				this->wait(backoff);
+			}
+			return index;
+		}
+
+		void send(nn::pipeline::SpscQueue<size_t>& queue, const size_t index)
+		{
+			nn::pipeline::Backoff backoff;
+			while (!queue.try_push(index))
+			{
+				this->wait(backoff);
+			}
+		}
+
+		/// <summary>
+		/// Runs the layers of the stage on the input of micro batch index, hands the activations on to the next stage
+		///	unless it recomputes them for back propagation.
+		/// </summary>
+		void forward(const size_t stage_index, const size_t index, const bool recompute)
+		{
+			Stage& stage = *this->stages_[stage_index];
+			const auto start = clock::now();
+			stage.input.input = &stage.inputs[index];
+			const nn::Layer* previous_layer = &stage.input;
+			for (size_t i = 0; i < stage.layers.size(); ++i)
+			{
+				if (recompute)
+				{
+					NN_PROFILE_LAYER_SCOPE("recompute", stage.first_layer + i);
+					stage.layers[i]->feed_forward(*previous_layer);
+				}
+				else
+				{
+					NN_PROFILE_LAYER_SCOPE("feed_forward", stage.first_layer + i);
+					stage.layers[i]->feed_forward(*previous_layer);
+				}
+				previous_layer = stage.layers[i];
+			}
+			stage.resident = index;
+
+			const bool last = stage_index + 1 == this->stages_.size();
+			if (!recompute && !last)
+			{
+				this->stages_[stage_index + 1]->inputs[index] = previous_layer->get_activations();
+			}
+			stage.busy_seconds += std::chrono::duration<double>(clock::now() - start).count();
+			if (!recompute && !last)
+			{
+				this->send(this->stages_[stage_index + 1]->forward_queue, index);
+			}
+		}
+
+		/// <summary>
+		/// Back propagates micro batch index through the layers of the stage (the first of a step overwrites the
+		///	gradients, the others add to them) and hands the delta of its input on to the previous stage.
+		/// </summary>
+		void backward(const size_t stage_index, const size_t index)
+		{
+			Stage& stage = *this->stages_[stage_index];
+			const bool last = stage_index + 1 == this->stages_.size();
+			if (!last && this->receive(stage.backward_queue) != index)
+			{
+				throw std::logic_error("The micro batches of a stage are back propagated out of order.");
+			}
+			if (stage.resident != index)
+			{
+				this->forward(stage_index, index, true);
+			}
+
+			const auto start = clock::now();
+			const float scale = 1.0f / static_cast<float>(this->micro_batches_);
+			for (nn::Layer* layer : stage.layers)
+			{
+				layer->set_gradient_accumulation(index != 0, scale);
+			}
+			const size_t count = stage.layers.size();
+			{
+				NN_PROFILE_LAYER_SCOPE("back_propagate", stage.first_layer + count - 1);
+				const nn::Layer& previous_layer = count > 1 ? *stage.layers[count - 2] : stage.input;
+				if (last)
+				{
+					stage.layers.back()->back_propagate(this->targets_[index], previous_layer);
+				}
+				else
+				{
+					stage.output.delta = &stage.deltas[index];
+					stage.layers.back()->back_propagate(stage.output, previous_layer);
+				}
+			}
+			for (size_t i = count - 1; i-- > 0;)
+			{
+				NN_PROFILE_LAYER_SCOPE("back_propagate", stage.first_layer + i);
+				stage.layers[i]->back_propagate(*stage.layers[i + 1], i > 0 ? *stage.layers[i - 1] : stage.input);
+			}
+			if (stage_index != 0)
+			{
+				stage.layers.front()->propagate_delta_to_previous_layer(this->stages_[stage_index - 1]->deltas[index]);
+			}
+			stage.busy_seconds += std::chrono::duration<double>(clock::now() - start).count();
+			if (stage_index != 0)
+			{
+				this->send(this->stages_[stage_index - 1]->backward_queue, index);
+			}
+		}
+
+		/// <summary>
+		/// Runs the steps of one stage until the feeding thread sends stop.
+		/// </summary>
+		void run_stage(const size_t stage_index)
+		{
+			Stage& stage = *this->stages_[stage_index];
+			const bool last = stage_index + 1 == this->stages_.size();
+			for (;;)
+			{
+				size_t index = this->receive(stage.forward_queue);
+				if (index == stop)
+				{
+					if (!last)
+					{
+						this->send(this->stages_[stage_index + 1]->forward_queue, stop);
+					}
+					return;
+				}
+
+				// Stage s of n keeps n - s micro batches in flight with 1F1B, all of them with GPipe
+				const size_t count = this->step_micro_batches_;
+				const float learning_rate = this->step_learning_rate_;
+				const size_t in_flight = this->schedule_ == nn::pipeline::Schedule::GPipe ? count : this->stages_.size() - stage_index;
+				size_t forwards = 0, backwards = 0;
+				while (backwards < count)
+				{
+					if (forwards < count && forwards - backwards < in_flight)
+					{
+						if (forwards != 0)
+						{
+							index = this->receive(stage.forward_queue);
+						}
+						this->forward(stage_index, index, false);
+						++forwards;
+					}
+					else
+					{
+						this->backward(stage_index, backwards++);
+					}
+				}
+
+				const auto start = clock::now();
+				for (size_t i = 0; i < stage.layers.size(); ++i)
+				{
+					NN_PROFILE_LAYER_SCOPE("update_weights_and_biases", stage.first_layer + i);
+					stage.layers[i]->update_weights_and_biases(learning_rate);
+				}
+				stage.busy_seconds += std::chrono::duration<double>(clock::now() - start).count();
+				if (stage_index == 0)
+				{
+					this->completed_steps_.fetch_add(1, std::memory_order_release);
+				}
+			}
+		}
+
+		void wait_for_steps(const size_t steps)
+		{
+			nn::pipeline::Backoff backoff;
+			while (this->completed_steps_.load(std::memory_order_acquire) != steps)
+			{
+				this->wait(backoff);
+			}
+		}
+
+		/// <summary>
+		/// Copies the batches of the data set into the buffers of the first and the last stage, one step at a time.
+		/// </summary>
+		void feed(nn::DataSet& data_set, const float learning_rate, nn::pipeline::Report& report)
+		{
+			Stage& first = *this->stages_.front();
+			size_t steps = 0;
+			while (!data_set.is_end())
+			{
+				this->wait_for_steps(steps);
+				size_t count = 0;
+				for (; count < this->micro_batches_ && !data_set.is_end(); ++count)
+				{
+					first.inputs[count] = data_set.get_batch_input();
+					this->targets_[count] = data_set.get_batch_output();
+					data_set.go_to_next_batch();
+				}
+
+				// A short last step: its gradients are the sum over count micro batches / micro_batches
+				this->step_micro_batches_ = count;
+				this->step_learning_rate_ = learning_rate * static_cast<float>(this->micro_batches_) / static_cast<float>(count);
+				report.samples += count * this->batch_size_;
+				for (size_t index = 0; index < count; ++index)
+				{
+					this->send(first.forward_queue, index);
+				}
+				++steps;
+			}
+			this->wait_for_steps(steps);
+			this->send(first.forward_queue, stop);
+		}
+
+	public:
+		Pipeline(const std::vector<nn::Layer*>& layers, const size_t micro_batches,
+		         const std::vector<size_t>& stage_first_layers, const nn::pipeline::Schedule schedule)
+			: schedule_(schedule), micro_batches_(micro_batches), batch_size_(layers.front()->get_batch_size())
+		{
+			for (size_t s = 0; s < stage_first_layers.size(); ++s)
+			{
+				const size_t first = std::max<size_t>(stage_first_layers[s], 1);
+				const size_t end = s + 1 < stage_first_layers.size() ? stage_first_layers[s + 1] : layers.size();
+				const size_t input_neurons = layers[first - 1]->get_neuron_count();
+				// The output boundary stands in for the first layer of the next stage
+				const size_t output_neurons = end != layers.size() ? layers[end]->get_neuron_count() : 0;
+				auto stage = std::make_unique<Stage>(input_neurons, output_neurons, this->batch_size_, micro_batches);
+				stage->first_layer = first;
+				stage->layers.assign(layers.begin() + static_cast<std::ptrdiff_t>(first), layers.begin() + static_cast<std::ptrdiff_t>(end));
+				for (size_t index = 0; index < micro_batches; ++index)
+				{
+					stage->inputs.emplace_back(input_neurons, this->batch_size_);
+					if (end != layers.size())
+					{
+						stage->deltas.emplace_back(layers[end - 1]->get_neuron_count(), this->batch_size_);
+					}
+				}
+				this->stages_.push_back(std::move(stage));
+			}
+			for (size_t index = 0; index < micro_batches; ++index)
+			{
+				this->targets_.emplace_back(layers.back()->get_neuron_count(), this->batch_size_);
+			}
+		}
+
+		nn::pipeline::Report run(nn::DataSet& data_set, const float learning_rate)
+		{
+			nn::pipeline::Report report;
+			report.micro_batches = this->micro_batches_;
+			const auto start = clock::now();
+
+			std::vector<std::thread> threads;
+			for (size_t s = 0; s < this->stages_.size(); ++s)
+			{
+				threads.emplace_back([this, s]()
+				{
+					try
+					{
+						nn::numa::pin_worker(s);
+						this->run_stage(s);
+					}
+					catch (const Aborted&)
+					{
+					}
+					catch (...)
+					{
+						this->record_error();
+					}
+				});
+			}
+			try
+			{
+				this->feed(data_set, learning_rate, report);
+			}
+			catch (const Aborted&)
+			{
+			}
+			catch (...)
+			{
+				this->record_error();
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+
+			report.seconds = std::chrono::duration<double>(clock::now() - start).count();
+			for (const auto& stage : this->stages_)
+			{
+				report.stage_first_layers.push_back(report.stage_first_layers.empty() ? 0 : stage->first_layer);
+				report.stage_busy_seconds.push_back(stage->busy_seconds);
+			}
+			if (this->error_)
+			{
+				std::rethrow_exception(this->error_);
+			}
+			return report;
+		}
+	};
+}
+
+void nn::pipeline::Backoff::wait()
+{
+	constexpr size_t yields = 64;
+	if (++this->attempts_ <= yields)
+	{
+		std::this_thread::yield();
+		return;
+	}
+	std::this_thread::sleep_for(std::chrono::microseconds(std::min<size_t>(this->attempts_ - yields, 50)));
+}
+
+double nn::pipeline::Report::get_bubble_fraction() const
+{
+	double busy = 0.0;
+	for (const double seconds : this->stage_busy_seconds)
+	{
+		busy += seconds;
+	}
+	const double total = static_cast<double>(this->stage_busy_seconds.size()) * this->seconds;
+	return total > 0.0 ? std::max(0.0, 1.0 - busy / total) : 0.0;
+}
+
+double nn::pipeline::Report::get_ideal_bubble_fraction() const
+{
+	const auto stages = static_cast<double>(this->stage_busy_seconds.size());
+	const auto micro_batches = static_cast<double>(this->micro_batches);
+	return stages > 0.0 ? (stages - 1.0) / (micro_batches + stages - 1.0) : 0.0;
+}
+
+double nn::pipeline::Report::get_samples_per_second() const
+{
+	return this->seconds > 0.0 ? static_cast<double>(this->samples) / this->seconds : 0.0;
+}
+
+std::vector<size_t> nn::pipeline::plan_stages(const std::vector<Layer*>& layers, const size_t batch_size, const size_t stage_count)
+{
+	if (stage_count == 0 || stage_count >= layers.size())
+	{
+		throw std::runtime_error("A pipeline needs between one stage and one stage per layer after the input layer.");
+	}
+
+	// Work of the layers after the input layer and its prefix sums
+	const size_t count = layers.size() - 1;
+	std::vector<double> prefix(count + 1, 0.0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const MemoryRequirements requirements = layers[i + 1]->get_memory_requirements();
+		prefix[i + 1] = prefix[i] + static_cast<double>(requirements.parameter_bytes) * static_cast<double>(batch_size) +
+			static_cast<double>(requirements.activation_bytes);
+	}
+
+	// cost[s][j]: smallest largest stage when the first j layers form s stages, split[s][j]: where the last one starts
+	constexpr double infinity = std::numeric_limits<double>::infinity();
+	std::vector<std::vector<double>> cost(stage_count + 1, std::vector<double>(count + 1, infinity));
+	std::vector<std::vector<size_t>> split(stage_count + 1, std::vector<size_t>(count + 1, 0));
+	cost[0][0] = 0.0;
+	for (size_t s = 1; s <= stage_count; ++s)
+	{
+		for (size_t j = s; j <= count; ++j)
+		{
+			for (size_t i = s - 1; i < j; ++i)
+			{
+				const double largest = std::max(cost[s - 1][i], prefix[j] - prefix[i]);
+				if (largest < cost[s][j])
+				{
+					cost[s][j] = largest;
+					split[s][j] = i;
+				}
+			}
+		}
+	}
+
+	std::vector<size_t> first_layers(stage_count, 0);
+	for (size_t s = stage_count, j = count; s > 1; --s)
+	{
+		j = split[s][j];
+		first_layers[s - 1] = j + 1;
+	}
+	return first_layers;
+}
+
+nn::pipeline::Report nn::pipeline::train_epoch(const std::vector<Layer*>& layers, DataSet& data_set, const float learning_rate,
+                                               const size_t micro_batches, const std::vector<size_t>& stage_first_layers,
+                                               const Schedule schedule)
+{
+	if (stage_first_layers.empty() || stage_first_layers.front() != 0 || micro_batches == 0)
+	{
+		throw std::runtime_error("Invalid pipeline stages.");
+	}
+	for (size_t s = 1; s < stage_first_layers.size(); ++s)
+	{
+		if (stage_first_layers[s] <= std::max<size_t>(stage_first_layers[s - 1], 1) || stage_first_layers[s] >= layers.size())
+		{
+			throw std::runtime_error("Invalid pipeline stages.");
+		}
+	}
+	for (size_t i = 1; i < layers.size(); ++i)
+	{
+		if (!layers[i]->is_recomputable())
+		{
+			throw std::logic_error("Pipeline training recomputes the forward pass of a stage, every layer must be recomputable.");
+		}
+	}
+
+	data_set.reset();
+	Pipeline pipeline(layers, micro_batches, stage_first_layers, schedule);
+	return pipeline.run(data_set, learning_rate);
+}
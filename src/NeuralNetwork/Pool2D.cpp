@@ -0,0 +1,248 @@
+// File: src/NeuralNetwork/Pool2D.cpp
+// Purpose: Source file for Pool2D class, a 2d max or average pooling layer.
+
+#include "NeuralNetwork/Pool2D.h"
+#include "NeuralNetwork/Profiler.h" // NN_PROFILE_SCOPE, NN_PROFILE_WORK
+
+#include <cstring> // std::memcpy, std::memset
+
+// Layout (see Conv2D.cpp): element (channel, y, x) of sample b is at ((channel * height + y) * width + x) * batch_size + b,
+// so a window element is a span of batch_size values and every kernel call covers the whole batch. With stride 1
+// the spans of one output row are back to back and a single call covers the row.
+
+nn::Pool2D::Pool2D(const PoolingMode mode, const size_t channels, const size_t input_height, const size_t input_width,
+                   const size_t pool_size, const size_t batch_size, const size_t stride)
+	: mode_(mode), channels_(channels), input_height_(input_height), input_width_(input_width), output_height_(0),
+	  output_width_(0), pool_size_(pool_size), stride_(stride == 0 ? pool_size : stride)
+{
+	if (channels == 0 || pool_size == 0 || batch_size == 0)
+	{
+		throw std::runtime_error("Invalid pooling parameters.");
+	}
+	// The positions in a window are stored in one byte
+	if (pool_size > 16)
+	{
+		throw std::runtime_error("Pooling windows are limited to 16x16.");
+	}
+	if (input_height < pool_size || input_width < pool_size)
+	{
+		throw std::runtime_error("Pooling window is larger than the input.");
+	}
+
+	this->output_height_ = (input_height - pool_size) / this->stride_ + 1;
+	this->output_width_ = (input_width - pool_size) / this->stride_ + 1;
+	this->neuron_count_ = channels * this->output_height_ * this->output_width_;
+	this->batch_size_ = batch_size;
+
+	// Initialize the matrices
+	this->activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+	this->delta_activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, batch_size);
+	if (mode == PoolingMode::Max)
+	{
+		this->argmax_ = std::make_unique<Matrix<uint8_t>>(this->neuron_count_, batch_size);
+	}
+}
+
+nn::PoolingMode nn::Pool2D::get_mode() const
+{
+	return this->mode_;
+}
+
+size_t nn::Pool2D::get_channels() const
+{
+	return this->channels_;
+}
+
+size_t nn::Pool2D::get_input_height() const
+{
+	return this->input_height_;
+}
+
+size_t nn::Pool2D::get_input_width() const
+{
+	return this->input_width_;
+}
+
+size_t nn::Pool2D::get_output_height() const
+{
+	return this->output_height_;
+}
+
+size_t nn::Pool2D::get_output_width() const
+{
+	return this->output_width_;
+}
+
+size_t nn::Pool2D::get_pool_size() const
+{
+	return this->pool_size_;
+}
+
+size_t nn::Pool2D::get_stride() const
+{
+	return this->stride_;
+}
+
+const nn::Matrix<uint8_t>& nn::Pool2D::get_argmax() const
+{
+	if (this->argmax_ == nullptr)
+	{
+		throw std::runtime_error("Only max pooling has argmax.");
+	}
+	return *this->argmax_;
+}
+
+void nn::Pool2D::feed_forward(const Layer& previous_layer)
+{
+	const Matrix<float>& input = previous_layer.get_activations();
+	if (input.get_rows() != this->channels_ * this->input_height_ * this->input_width_ || input.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the input of the pooling.");
+	}
+
+	// Allocate the matrices again after release_activations
+	if (this->activations_ == nullptr)
+	{
+		this->activations_ = std::make_unique<Matrix<float>>(this->neuron_count_, this->batch_size_);
+		if (this->mode_ == PoolingMode::Max)
+		{
+			this->argmax_ = std::make_unique<Matrix<uint8_t>>(this->neuron_count_, this->batch_size_);
+		}
+	}
+
+	NN_PROFILE_SCOPE("pool");
+	const size_t batch = this->batch_size_;
+	const size_t k = this->pool_size_;
+	// Output positions covered by one kernel call
+	const size_t run = this->stride_ == 1 ? this->output_width_ : 1;
+	const kernels::KernelTable& table = kernels::get_kernels();
+	const float scale = 1.0f / static_cast<float>(k * k);
+	NN_PROFILE_WORK(this->neuron_count_ * batch * k * k, sizeof(float) * (input.get_rows() + this->neuron_count_) * batch);
+
+	for (size_t c = 0; c < this->channels_; ++c)
+	{
+		for (size_t oy = 0; oy < this->output_height_; ++oy)
+		{
+			for (size_t ox = 0; ox < this->output_width_; ox += run)
+			{
+				const size_t offset = ((c * this->output_height_ + oy) * this->output_width_ + ox) * batch;
+				float* out = this->activations_->get_data() + offset;
+				const float* window = input.get_data() + ((c * this->input_height_ + oy * this->stride_) * this->input_width_ + ox * this->stride_) * batch;
+
+				if (this->mode_ == PoolingMode::Max)
+				{
+					// Start with the first element of the window, then keep the larger values and their positions
+					uint8_t* argmax = this->argmax_->get_data() + offset;
+					std::memcpy(out, window, run * batch * sizeof(float));
+					std::memset(argmax, 0, run * batch);
+					for (size_t position = 1; position < k * k; ++position)
+					{
+						const float* in = window + ((position / k) * this->input_width_ + position % k) * batch;
+						table.max_argmax(out, argmax, in, static_cast<uint8_t>(position), run * batch);
+					}
+				}
+				else
+				{
+					std::memset(out, 0, run * batch * sizeof(float));
+					for (size_t position = 0; position < k * k; ++position)
+					{
+						const float* in = window + ((position / k) * this->input_width_ + position % k) * batch;
+						table.axpy(out, in, scale, run * batch);
+					}
+				}
+			}
+		}
+	}
+}
+
+void nn::Pool2D::back_propagate(const Layer& next_layer, const Layer&)
+{
+	NN_PROFILE_SCOPE("delta_activations");
+	next_layer.propagate_delta_to_previous_layer(*this->delta_activations_);
+}
+
+void nn::Pool2D::back_propagate(const Matrix<float>& expected_activations, const Layer&)
+{
+	NN_PROFILE_SCOPE("delta_activations");
+	this->delta_activations_->calculate_delta_activation_from_expected_output(this->get_activations(), expected_activations);
+}
+
+void nn::Pool2D::propagate_delta_to_previous_layer(Matrix<float>& previous_delta_activations) const
+{
+	if (previous_delta_activations.get_rows() != this->channels_ * this->input_height_ * this->input_width_ ||
+		previous_delta_activations.get_cols() != this->batch_size_)
+	{
+		throw std::runtime_error("Previous layer does not match the input of the pooling.");
+	}
+
+	NN_PROFILE_SCOPE("unpool");
+	const size_t batch = this->batch_size_;
+	const size_t k = this->pool_size_;
+	const float* delta = this->delta_activations_->get_data();
+	float* previous_delta = previous_delta_activations.get_data();
+	std::memset(previous_delta, 0, previous_delta_activations.get_rows() * batch * sizeof(float));
+	NN_PROFILE_WORK(this->neuron_count_ * batch, sizeof(float) * (previous_delta_activations.get_rows() + 2 * this->neuron_count_) * batch);
+
+	if (this->mode_ == PoolingMode::Max)
+	{
+		// Offset of every window position from the start of the window
+		size_t position_offsets[16 * 16];
+		for (size_t position = 0; position < k * k; ++position)
+		{
+			position_offsets[position] = ((position / k) * this->input_width_ + position % k) * batch;
+		}
+
+		// Scatter every delta to the position of its maximum (added up where windows overlap)
+		const uint8_t* argmax = this->argmax_->get_data();
+		for (size_t c = 0; c < this->channels_; ++c)
+		{
+			for (size_t oy = 0; oy < this->output_height_; ++oy)
+			{
+				for (size_t ox = 0; ox < this->output_width_; ++ox)
+				{
+					const size_t offset = ((c * this->output_height_ + oy) * this->output_width_ + ox) * batch;
+					float* window = previous_delta + ((c * this->input_height_ + oy * this->stride_) * this->input_width_ + ox * this->stride_) * batch;
+					for (size_t b = 0; b < batch; ++b)
+					{
+						window[position_offsets[argmax[offset + b]] + b] += delta[offset + b];
+					}
+				}
+			}
+		}
+		return;
+	}
+
+	// Every element of a window gets the mean share of its delta
+	const size_t run = this->stride_ == 1 ? this->output_width_ : 1;
+	const kernels::KernelTable& table = kernels::get_kernels();
+	const float scale = 1.0f / static_cast<float>(k * k);
+	for (size_t c = 0; c < this->channels_; ++c)
+	{
+		for (size_t oy = 0; oy < this->output_height_; ++oy)
+		{
+			for (size_t ox = 0; ox < this->output_width_; ox += run)
+			{
+				const float* out = delta + ((c * this->output_height_ + oy) * this->output_width_ + ox) * batch;
+				float* window = previous_delta + ((c * this->input_height_ + oy * this->stride_) * this->input_width_ + ox * this->stride_) * batch;
+				for (size_t position = 0; position < k * k; ++position)
+				{
+					table.axpy(window + ((position / k) * this->input_width_ + position % k) * batch, out, scale, run * batch);
+				}
+			}
+		}
+	}
+}
+
+nn::MemoryRequirements nn::Pool2D::get_memory_requirements() const
+{
+	MemoryRequirements requirements;
+	requirements.activation_bytes = get_bytes(this->activations_) + get_bytes(this->argmax_);
+	requirements.workspace_bytes = get_bytes(this->delta_activations_);
+	return requirements;
+}
+
+void nn::Pool2D::release_activations()
+{
+	this->activations_.reset();
+	this->argmax_.reset();
+}
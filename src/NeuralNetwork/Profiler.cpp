@@ -0,0 +1,482 @@
+// File: src/NeuralNetwork/Profiler.cpp
+// Purpose: Implementation file for the scoped timing profiler.
+
+#include "NeuralNetwork/Profiler.h"
+#include "NeuralNetwork/Kernels.h" // nn::kernels::get_kernels
+
+#include <algorithm> // std::find_if, std::sort, std::stable_sort
+#include <atomic> // std::atomic
+#include <cstddef> // std::ptrdiff_t
+#include <cstring> // std::strcmp
+#include <iomanip> // std::setw, std::setprecision
+#include <iterator> // std::prev
+#include <limits> // std::numeric_limits
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex, std::lock_guard
+#include <string> // std::string
+
+namespace
+{
+	/// <summary>
+	/// Fixed size block of events. Only the owning thread appends; readers see the events before count.
+	/// </summary>
+	struct Chunk
+	{
+		static constexpr size_t capacity = 4096;
+
+		nn::profiler::Event events[capacity];
+		std::atomic<size_t> count{ 0 };
+		std::atomic<Chunk*> next{ nullptr };
+	};
+
+	/// <summary>
+	/// Events of one thread: a list of chunks that only grows while recording, so appending never moves an event.
+	/// </summary>
+	struct ThreadBuffer
+	{
+		uint32_t thread;
+		Chunk head;
+		Chunk* tail = &head;
+
+		explicit ThreadBuffer(const uint32_t thread)
+			: thread(thread)
+		{
+		}
+
+		ThreadBuffer(const ThreadBuffer&) = delete;
+		ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+		~ThreadBuffer()
+		{
+			this->clear();
+		}
+
+		void append(const nn::profiler::Event& event)
+		{
+			size_t count = this->tail->count.load(std::memory_order_relaxed);
+			if (count == Chunk::capacity)
+			{
+				Chunk* chunk = new Chunk();
+				this->tail->next.store(chunk, std::memory_order_release);
+				this->tail = chunk;
+				count = 0;
+			}
+			this->tail->events[count] = event;
+			this->tail->count.store(count + 1, std::memory_order_release);
+		}
+
+		void clear()
+		{
+			Chunk* chunk = this->head.next.load(std::memory_order_acquire);
+			while (chunk != nullptr)
+			{
+				Chunk* next = chunk->next.load(std::memory_order_acquire);
+				delete chunk;
+				chunk = next;
+			}
+			this->head.next.store(nullptr, std::memory_order_release);
+			this->head.count.store(0, std::memory_order_release);
+			this->tail = &this->head;
+		}
+	};
+
+	/// <summary>
+	/// Buffers of every thread that recorded an event. They outlive their threads, so events of finished threads
+	/// are kept until reset.
+	/// </summary>
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	};
+
+	Registry& get_registry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	/// <summary>
+	/// Time the event timestamps are relative to.
+	/// </summary>
+	nn::profiler::clock::time_point get_epoch()
+	{
+		static const nn::profiler::clock::time_point epoch = nn::profiler::clock::now();
+		return epoch;
+	}
+
+	thread_local ThreadBuffer* thread_buffer = nullptr;
+	thread_local int current_layer = -1;
+	thread_local uint32_t current_depth = 0;
+
+	// Work of all kernel calls of this thread so far (events record the difference between their start and end)
+	thread_local uint64_t thread_flop = 0;
+	thread_local uint64_t thread_bytes = 0;
+
+	ThreadBuffer& get_thread_buffer()
+	{
+		if (thread_buffer == nullptr)
+		{
+			Registry& registry = get_registry();
+			const std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(registry.buffers.size())));
+			thread_buffer = registry.buffers.back().get();
+		}
+		return *thread_buffer;
+	}
+
+	/// <summary>
+	/// Writes value as a JSON string (phase names are string literals of printable ASCII).
+	/// </summary>
+	void write_json_string(std::ostream& os, const char* value)
+	{
+		os << '"';
+		for (; *value != '\0'; ++value)
+		{
+			if (*value == '"' || *value == '\\')
+			{
+				os << '\\';
+			}
+			os << *value;
+		}
+		os << '"';
+	}
+}
+
+namespace
+{
+	/// <summary>
+	/// Events of one phase (same layer, name and enclosing phase) added up.
+	/// </summary>
+	struct Phase
+	{
+		const char* name;
+		const char* parent;
+		int layer;
+		uint32_t depth;
+		int64_t first_start;
+		size_t calls;
+		int64_t total;
+		uint64_t flop;
+		uint64_t bytes;
+	};
+
+	/// <summary>
+	/// Adds up the events per phase, ordered per layer by the time the phases first ran (enclosing phases before
+	/// the phases they contain). outermost_total is the total time of the events that are not nested.
+	/// </summary>
+	std::vector<Phase> aggregate_phases(const std::vector<nn::profiler::Event>& events, int64_t& outermost_total)
+	{
+		// Phases are told apart by layer, name and enclosing phase (a transpose of the weight gradient is not one of
+		// the delta activations). The events of a thread are ordered by start, so the enclosing scopes are a stack.
+		std::vector<Phase> phases;
+		std::vector<const nn::profiler::Event*> enclosing;
+		outermost_total = 0;
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			const nn::profiler::Event& event = events[i];
+			if (i == 0 || events[i - 1].thread != event.thread)
+			{
+				enclosing.clear();
+			}
+			while (enclosing.size() > event.depth)
+			{
+				enclosing.pop_back();
+			}
+			const char* parent = enclosing.empty() ? "" : enclosing.back()->name;
+			enclosing.push_back(&event);
+
+			if (event.depth == 0)
+			{
+				outermost_total += event.duration;
+			}
+
+			auto phase = std::find_if(phases.begin(), phases.end(), [&event, parent](const Phase& p)
+			{
+				return p.layer == event.layer && std::strcmp(p.name, event.name) == 0 && std::strcmp(p.parent, parent) == 0;
+			});
+			if (phase == phases.end())
+			{
+				phases.push_back({ event.name, parent, event.layer, event.depth, event.start, 0, 0, 0, 0 });
+				phase = std::prev(phases.end());
+			}
+			phase->first_start = std::min(phase->first_start, event.start);
+			++phase->calls;
+			phase->total += event.duration;
+			phase->flop += event.flop;
+			phase->bytes += event.bytes;
+		}
+
+		std::sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b)
+		{
+			return a.layer < b.layer || (a.layer == b.layer && (a.first_start < b.first_start || (a.first_start == b.first_start && a.depth < b.depth)));
+		});
+		return phases;
+	}
+
+	/// <summary>
+	/// Writes flop/byte, GFLOP/s, GB/s and the share of the roofline a phase (or epoch, or layer) achieved in calls calls.
+	/// </summary>
+	void write_roofline_row(std::ostream& os, const std::string& name, const std::string& layer, const double seconds,
+	                        const size_t calls, const uint64_t flop, const uint64_t bytes, const nn::profiler::MachinePeaks& peaks)
+	{
+		const bool cache_resident = bytes <= nn::profiler::cache_resident_bytes * calls;
+		const double bandwidth = cache_resident ? peaks.cache_bytes_per_second : peaks.bytes_per_second;
+
+		const double intensity = bytes > 0 ? static_cast<double>(flop) / static_cast<double>(bytes) : 0.0;
+		const double flops = seconds > 0.0 ? static_cast<double>(flop) / seconds : 0.0;
+		const double bytes_per_second = seconds > 0.0 ? static_cast<double>(bytes) / seconds : 0.0;
+		const double attainable = std::min(peaks.flops, intensity * bandwidth);
+		const bool compute_bound = intensity * bandwidth >= peaks.flops;
+		// Below the ridge point the share of the roof is the share of the bandwidth (also without any flop)
+		const double share = compute_bound ? flops / peaks.flops : bytes_per_second / bandwidth;
+
+		os << std::left << std::setw(36) << name << std::right << std::setw(7) << layer << std::fixed << std::setprecision(3)
+			<< std::setw(12) << seconds * 1e3 << std::setprecision(2) << std::setw(11) << intensity << std::setw(10) << flops * 1e-9
+			<< std::setw(10) << bytes_per_second * 1e-9 << std::setw(11) << attainable * 1e-9 << std::setprecision(1) << std::setw(8)
+			<< 100.0 * share << "%" << std::setw(9) << (compute_bound ? "compute" : cache_resident ? "cache" : "memory") << "\n";
+	}
+}
+
+nn::profiler::ScopedEvent::ScopedEvent(const char* name)
+	: name_(name), previous_layer_(current_layer), start_flop_(thread_flop), start_bytes_(thread_bytes)
+{
+	get_epoch();
+	++current_depth;
+	this->start_ = clock::now();
+}
+
+nn::profiler::ScopedEvent::ScopedEvent(const char* name, const int layer)
+	: name_(name), previous_layer_(current_layer), start_flop_(thread_flop), start_bytes_(thread_bytes)
+{
+	get_epoch();
+	current_layer = layer;
+	++current_depth;
+	this->start_ = clock::now();
+}
+
+nn::profiler::ScopedEvent::~ScopedEvent()
+{
+	const clock::time_point end = clock::now();
+	--current_depth;
+
+	ThreadBuffer& buffer = get_thread_buffer();
+	buffer.append({
+		this->name_, current_layer, current_depth, buffer.thread,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(this->start_ - get_epoch()).count(),
+		std::chrono::duration_cast<std::chrono::nanoseconds>(end - this->start_).count(),
+		thread_flop - this->start_flop_, thread_bytes - this->start_bytes_
+	});
+
+	current_layer = this->previous_layer_;
+}
+
+void nn::profiler::add_work(const uint64_t flop, const uint64_t bytes)
+{
+	thread_flop += flop;
+	thread_bytes += bytes;
+}
+
+std::vector<nn::profiler::Event> nn::profiler::get_events()
+{
+	std::vector<Event> events;
+
+	Registry& registry = get_registry();
+	const std::lock_guard<std::mutex> lock(registry.mutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		const size_t first = events.size();
+		for (const Chunk* chunk = &buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire))
+		{
+			const size_t count = chunk->count.load(std::memory_order_acquire);
+			events.insert(events.end(), chunk->events, chunk->events + count);
+		}
+
+		// Events are recorded when they end, so an enclosing scope comes after the scopes it contains
+		std::stable_sort(events.begin() + static_cast<std::ptrdiff_t>(first), events.end(), [](const Event& a, const Event& b)
+		{
+			return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+		});
+	}
+
+	return events;
+}
+
+void nn::profiler::reset()
+{
+	Registry& registry = get_registry();
+	const std::lock_guard<std::mutex> lock(registry.mutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+	{
+		buffer->clear();
+	}
+}
+
+void nn::profiler::write_chrome_trace(std::ostream& os)
+{
+	const std::vector<Event> events = get_events();
+
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	uint32_t threads = 0;
+	for (const Event& event : events)
+	{
+		threads = std::max(threads, event.thread + 1);
+	}
+	for (uint32_t thread = 0; thread < threads; ++thread)
+	{
+		os << (thread == 0 ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+			<< ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+	}
+
+	// Complete events ("X") with timestamps in microseconds
+	os << std::fixed << std::setprecision(3);
+	for (const Event& event : events)
+	{
+		os << ",\n{\"name\":";
+		write_json_string(os, event.name);
+		os << ",\"cat\":\"" << (event.layer < 0 ? "network" : "layer") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << static_cast<double>(event.start) * 1e-3 << ",\"dur\":" << static_cast<double>(event.duration) * 1e-3;
+		os << ",\"args\":{\"flop\":" << event.flop << ",\"bytes\":" << event.bytes;
+		if (event.layer >= 0)
+		{
+			os << ",\"layer\":" << event.layer;
+		}
+		os << "}}";
+	}
+	os << "\n]}\n";
+}
+
+void nn::profiler::write_summary(std::ostream& os)
+{
+	int64_t outermost_total;
+	const std::vector<Phase> phases = aggregate_phases(get_events(), outermost_total);
+
+	os << std::left << std::setw(40) << "phase" << std::right << std::setw(7) << "layer" << std::setw(10) << "calls"
+		<< std::setw(14) << "total [ms]" << std::setw(13) << "mean [us]" << std::setw(9) << "share" << "\n";
+	for (const Phase& phase : phases)
+	{
+		const std::string name = std::string(2 * phase.depth, ' ') + phase.name;
+		os << std::left << std::setw(40) << name << std::right << std::setw(7)
+			<< (phase.layer < 0 ? std::string("-") : std::to_string(phase.layer)) << std::setw(10) << phase.calls
+			<< std::fixed << std::setprecision(3) << std::setw(14) << static_cast<double>(phase.total) * 1e-6
+			<< std::setw(13) << static_cast<double>(phase.total) * 1e-3 / static_cast<double>(phase.calls)
+			<< std::setprecision(1) << std::setw(8)
+			<< (outermost_total > 0 ? 100.0 * static_cast<double>(phase.total) / static_cast<double>(outermost_total) : 0.0) << "%\n";
+	}
+}
+
+nn::profiler::MachinePeaks nn::profiler::measure_machine_peaks()
+{
+	const kernels::KernelTable& table = kernels::get_kernels();
+
+	// Runs function until min_seconds passed (after one warm up call), returns the seconds per call
+	const auto measure = [](const auto& function, const double min_seconds)
+	{
+		function();
+		size_t iterations = 0;
+		const clock::time_point start = clock::now();
+		double elapsed;
+		do
+		{
+			function();
+			++iterations;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		}
+		while (elapsed < min_seconds);
+		return elapsed / static_cast<double>(iterations);
+	};
+
+	MachinePeaks peaks{};
+
+	// Best matrix product rate of square and layer shaped operands that fit in the L2 cache
+	const size_t shapes[][3] = { { 128, 128, 128 }, { 256, 256, 256 }, { 64, 32, 784 } };
+	for (const auto& shape : shapes)
+	{
+		const size_t m = shape[0], n = shape[1], k = shape[2];
+		std::vector<float> a(m * k, 0.5f), b(k * n, 0.25f), c(m * n);
+		const double seconds = measure([&]()
+		{
+			table.sgemm(a.data(), b.data(), c.data(), m, n, k, k, n, n);
+		}, 0.2);
+		peaks.flops = std::max(peaks.flops, 2.0 * static_cast<double>(m * n * k) / seconds);
+	}
+
+	// y = y + alpha * x (2 loads and 1 store per element) over 2 x 64 KiB and over 2 x 64 MiB, far larger than the caches
+	for (const size_t count : { size_t(1) << 14, size_t(1) << 24 })
+	{
+		std::vector<float> x(count, 1.0f), y(count, 0.0f);
+		const double seconds = measure([&]()
+		{
+			table.axpy(y.data(), x.data(), 1e-6f, count);
+		}, 0.3);
+		(count < cache_resident_bytes ? peaks.cache_bytes_per_second : peaks.bytes_per_second) = 12.0 * static_cast<double>(count) / seconds;
+	}
+
+	return peaks;
+}
+
+void nn::profiler::write_roofline(std::ostream& os, const MachinePeaks& peaks)
+{
+	const std::vector<Event> events = get_events();
+	int64_t outermost_total;
+	const std::vector<Phase> phases = aggregate_phases(events, outermost_total);
+
+	os << "Peaks: " << std::fixed << std::setprecision(2) << peaks.flops * 1e-9 << " GFLOP/s, memory " << peaks.bytes_per_second * 1e-9
+		<< " GB/s (ridge point " << peaks.flops / peaks.bytes_per_second << " flop/byte), cache " << peaks.cache_bytes_per_second * 1e-9
+		<< " GB/s (ridge point " << peaks.flops / peaks.cache_bytes_per_second << " flop/byte)\n";
+	os << std::left << std::setw(36) << "" << std::right << std::setw(7) << "layer" << std::setw(12) << "time [ms]"
+		<< std::setw(11) << "flop/byte" << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(11) << "roof"
+		<< std::setw(9) << "of roof" << std::setw(9) << "bound" << "\n";
+
+	// Every epoch (NeuralNetwork::train_one_epoch)
+	size_t epoch = 0;
+	for (const Event& event : events)
+	{
+		if (std::strcmp(event.name, "epoch") == 0)
+		{
+			write_roofline_row(os, "epoch " + std::to_string(++epoch), "-", static_cast<double>(event.duration) * 1e-9, 1,
+				event.flop, event.bytes, peaks);
+		}
+	}
+
+	// Every layer (the phases of its outermost depth added up), then its phases that did work
+	for (auto layer_begin = phases.begin(); layer_begin != phases.end();)
+	{
+		const int layer = layer_begin->layer;
+		const auto layer_end = std::find_if(layer_begin, phases.end(), [layer](const Phase& phase) { return phase.layer != layer; });
+
+		uint32_t outermost_depth = std::numeric_limits<uint32_t>::max();
+		for (auto phase = layer_begin; phase != layer_end; ++phase)
+		{
+			outermost_depth = std::min(outermost_depth, phase->depth);
+		}
+		int64_t total = 0;
+		size_t calls = 0;
+		uint64_t flop = 0, bytes = 0;
+		for (auto phase = layer_begin; phase != layer_end; ++phase)
+		{
+			if (phase->depth == outermost_depth)
+			{
+				total += phase->total;
+				calls = std::max(calls, phase->calls);
+				flop += phase->flop;
+				bytes += phase->bytes;
+			}
+		}
+
+		if (layer >= 0 && bytes > 0)
+		{
+			write_roofline_row(os, "layer " + std::to_string(layer), std::to_string(layer), static_cast<double>(total) * 1e-9, calls,
+				flop, bytes, peaks);
+			for (auto phase = layer_begin; phase != layer_end; ++phase)
+			{
+				if (phase->bytes > 0)
+				{
+					write_roofline_row(os, std::string(2 * (phase->depth - outermost_depth + 1), ' ') + phase->name, std::to_string(layer),
+						static_cast<double>(phase->total) * 1e-9, phase->calls, phase->flop, phase->bytes, peaks);
+				}
+			}
+		}
+		layer_begin = layer_end;
+	}
+}
@@ -0,0 +1,456 @@
+// File: src/NeuralNetwork/Quantization.cpp
+// Purpose: Implementation file for int8 post-training quantization.
+
+#include "NeuralNetwork/Quantization.h"
+
+#include <algorithm> // std::min, std::max
+#include <cmath> // std::abs, std::exp, std::lrint
+#include <limits> // std::numeric_limits
+#include <stdexcept> // std::runtime_error
+
+namespace
+{
+	/// <summary>
+	/// Quantized rows are padded to a multiple of this many elements (one AVX-512 register of bytes).
+	/// </summary>
+	constexpr size_t row_padding = 64;
+
+	/// <summary>
+	/// Samples multiplied in one call of the int8 product: their int32 results stay in cache for the epilogue.
+	/// </summary>
+	constexpr size_t samples_per_block = 16;
+
+	size_t get_padded_size(const size_t size)
+	{
+		return (size + row_padding - 1) / row_padding * row_padding;
+	}
+
+	/// <summary>
+	/// Applies the activation function to a row of real valued activations.
+	/// </summary>
+	void apply_activation(const nn::activation_functions::ActivationType activation_type, float* values, const size_t count)
+	{
+		using nn::activation_functions::ActivationType;
+
+		switch (activation_type)
+		{
+		case ActivationType::Sigmoid:
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = 1.0f / (1.0f + std::exp(-values[i]));
+			}
+			break;
+		case ActivationType::ReLU:
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = std::max(values[i], 0.0f);
+			}
+			break;
+		case ActivationType::LeakyReLU:
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = values[i] > 0.0f ? values[i] : 0.01f * values[i];
+			}
+			break;
+		case ActivationType::Tanh:
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = std::tanh(values[i]);
+			}
+			break;
+		case ActivationType::SoftMax:
+			{
+				const float max_value = *std::max_element(values, values + count);
+				float sum = 0.0f;
+				for (size_t i = 0; i < count; ++i)
+				{
+					values[i] = std::exp(values[i] - max_value);
+					sum += values[i];
+				}
+				for (size_t i = 0; i < count; ++i)
+				{
+					values[i] /= sum;
+				}
+			}
+			break;
+		case ActivationType::Linear:
+			break;
+		case ActivationType::Custom:
+			throw std::runtime_error("Cannot quantize a layer with a custom activation function.");
+		}
+	}
+
+	/// <summary>
+	/// Returns the index of the largest element of the given column.
+	/// </summary>
+	size_t get_max_index(const nn::Matrix<float>& matrix, const size_t col)
+	{
+		size_t max_index = 0;
+		for (size_t i = 1; i < matrix.get_rows(); ++i)
+		{
+			if (matrix(i, col) > matrix(max_index, col))
+			{
+				max_index = i;
+			}
+		}
+
+		return max_index;
+	}
+}
+
+#pragma region ActivationQuantization
+
+nn::quantization::ActivationQuantization nn::quantization::ActivationQuantization::from_range(float min, float max)
+{
+	min = std::min(min, 0.0f);
+	max = std::max(max, 0.0f);
+
+	ActivationQuantization result;
+	result.scale = (max - min) / static_cast<float>(max_value);
+	if (result.scale == 0.0f)
+	{
+		result.scale = 1.0f;
+	}
+	result.zero_point = std::clamp(static_cast<int32_t>(std::lrint(-min / result.scale)), 0, max_value);
+
+	return result;
+}
+
+uint8_t nn::quantization::ActivationQuantization::quantize(const float value) const
+{
+	const auto quantized = static_cast<int32_t>(std::lrint(value / this->scale)) + this->zero_point;
+	return static_cast<uint8_t>(std::clamp(quantized, 0, max_value));
+}
+
+#pragma endregion
+
+#pragma region Calibration
+
+void nn::quantization::Calibration::calibrate(NeuralNetwork& network, DataSet& data_set, const size_t max_batches)
+{
+	data_set.reset();
+
+	size_t batches = 0;
+	while (!data_set.is_end() && (max_batches == 0 || batches < max_batches))
+	{
+		network.feed_forward_with_input(data_set.get_batch_input());
+		this->observe(network);
+
+		data_set.go_to_next_batch();
+		++batches;
+	}
+
+	data_set.reset();
+}
+
+void nn::quantization::Calibration::observe(NeuralNetwork& network)
+{
+	const auto& layers = network.get_layers();
+	if (this->min_.empty())
+	{
+		this->min_.assign(layers.size(), std::numeric_limits<float>::max());
+		this->max_.assign(layers.size(), std::numeric_limits<float>::lowest());
+	}
+	if (this->min_.size() != layers.size())
+	{
+		throw std::runtime_error("Cannot calibrate networks with different layer counts.");
+	}
+
+	size_t layer_index = 0;
+	for (const auto& layer : layers)
+	{
+		const auto& activations = layer->get_activations();
+		for (size_t i = 0; i < activations.get_rows() * activations.get_cols(); ++i)
+		{
+			this->min_[layer_index] = std::min(this->min_[layer_index], activations[i]);
+			this->max_[layer_index] = std::max(this->max_[layer_index], activations[i]);
+		}
+		++layer_index;
+	}
+}
+
+nn::quantization::ActivationQuantization nn::quantization::Calibration::get_activation_quantization(
+	const size_t layer_index) const
+{
+	if (layer_index >= this->min_.size())
+	{
+		throw std::runtime_error("Layer has not been calibrated.");
+	}
+
+	return ActivationQuantization::from_range(this->min_[layer_index], this->max_[layer_index]);
+}
+
+size_t nn::quantization::Calibration::get_layer_count() const
+{
+	return this->min_.size();
+}
+
+#pragma endregion
+
+#pragma region QuantizedLayer
+
+nn::quantization::QuantizedLayer::QuantizedLayer(const DenseLayer& layer, const ActivationQuantization& input_quantization,
+                                                 const ScaleGranularity granularity)
+	: neuron_count_(layer.get_neuron_count()), input_count_(layer.get_weights().get_cols()),
+	  weights_(layer.get_neuron_count(), get_padded_size(layer.get_weights().get_cols())),
+	  weight_row_sums_(layer.get_neuron_count(), 1), weight_scales_(layer.get_neuron_count(), 1),
+	  biases_(layer.get_biases()), accumulators_(samples_per_block, layer.get_neuron_count()),
+	  scratch_(layer.get_neuron_count(), 1),
+	  activation_type_(activation_functions::get_activation_type(*layer.get_activation_function())),
+	  input_quantization_(input_quantization)
+{
+	if (this->activation_type_ == activation_functions::ActivationType::Custom)
+	{
+		throw std::runtime_error("Cannot quantize a layer with a custom activation function.");
+	}
+
+	const auto& weights = layer.get_weights();
+
+	// Find the largest absolute weight of every row (or of the whole matrix).
+	float layer_max = 0.0f;
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		float row_max = 0.0f;
+		for (size_t j = 0; j < this->input_count_; ++j)
+		{
+			row_max = std::max(row_max, std::abs(weights(i, j)));
+		}
+		this->weight_scales_[i] = row_max;
+		layer_max = std::max(layer_max, row_max);
+	}
+
+	// Quantize the weights symmetrically to [-127, 127].
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		const float max_value = granularity == ScaleGranularity::PerLayer ? layer_max : this->weight_scales_[i];
+		const float scale = max_value > 0.0f ? max_value / 127.0f : 1.0f;
+		this->weight_scales_[i] = scale;
+
+		int32_t row_sum = 0;
+		for (size_t j = 0; j < this->weights_.get_cols(); ++j)
+		{
+			int8_t quantized = 0;
+			if (j < this->input_count_)
+			{
+				quantized = static_cast<int8_t>(std::clamp(static_cast<int32_t>(std::lrint(weights(i, j) / scale)), -127, 127));
+			}
+			this->weights_(i, j) = quantized;
+			row_sum += quantized;
+		}
+		this->weight_row_sums_[i] = row_sum;
+	}
+}
+
+size_t nn::quantization::QuantizedLayer::get_neuron_count() const
+{
+	return this->neuron_count_;
+}
+
+size_t nn::quantization::QuantizedLayer::get_input_stride() const
+{
+	return this->weights_.get_cols();
+}
+
+const nn::quantization::ActivationQuantization& nn::quantization::QuantizedLayer::get_input_quantization() const
+{
+	return this->input_quantization_;
+}
+
+void nn::quantization::QuantizedLayer::feed_forward(const Matrix<uint8_t>& input, Matrix<uint8_t>& output,
+                                                    const ActivationQuantization& output_quantization,
+                                                    const size_t output_stride)
+{
+	for (size_t first = 0; first < input.get_rows(); first += samples_per_block)
+	{
+		const size_t samples = std::min(samples_per_block, input.get_rows() - first);
+		this->multiply(input, first, samples);
+		for (size_t sample = 0; sample < samples; ++sample)
+		{
+			this->calculate_activations(sample);
+
+			// Requantize straight from the (cache resident) scratch row into the input row of the next layer.
+			uint8_t* output_row = output.get_data() + (first + sample) * output_stride;
+			for (size_t i = 0; i < this->neuron_count_; ++i)
+			{
+				output_row[i] = output_quantization.quantize(this->scratch_[i]);
+			}
+		}
+	}
+}
+
+void nn::quantization::QuantizedLayer::feed_forward(const Matrix<uint8_t>& input, Matrix<float>& output)
+{
+	for (size_t first = 0; first < input.get_rows(); first += samples_per_block)
+	{
+		const size_t samples = std::min(samples_per_block, input.get_rows() - first);
+		this->multiply(input, first, samples);
+		for (size_t sample = 0; sample < samples; ++sample)
+		{
+			this->calculate_activations(sample);
+
+			for (size_t i = 0; i < this->neuron_count_; ++i)
+			{
+				output(i, first + sample) = this->scratch_[i];
+			}
+		}
+	}
+}
+
+void nn::quantization::QuantizedLayer::multiply(const Matrix<uint8_t>& input, const size_t first, const size_t samples)
+{
+	// Blocks of samples x weight rows in registers, every weight row is loaded once per block of samples instead of
+	// once per sample (AVX-512 VNNI, AVX-512 BW, AVX2 or SSE4.2 u8 x s8 multiply-add, see Kernels.h)
+	kernels::get_kernels().gemm_u8s8(input.get_data() + first * input.get_cols(), this->weights_.get_data(),
+		this->accumulators_.get_data(), samples, this->neuron_count_, this->weights_.get_cols(), input.get_cols(),
+		this->weights_.get_cols(), this->neuron_count_);
+}
+
+void nn::quantization::QuantizedLayer::calculate_activations(const size_t sample)
+{
+	const float input_scale = this->input_quantization_.scale;
+	const int32_t input_zero_point = this->input_quantization_.zero_point;
+	const int32_t* accumulators = this->accumulators_.get_data() + sample * this->neuron_count_;
+
+	for (size_t i = 0; i < this->neuron_count_; ++i)
+	{
+		// sum((q_w * s_w) * (q_a - z_a) * s_a) = s_w * s_a * (sum(q_w * q_a) - z_a * sum(q_w))
+		const int32_t corrected = accumulators[i] - input_zero_point * this->weight_row_sums_[i];
+		this->scratch_[i] = this->weight_scales_[i] * input_scale * static_cast<float>(corrected) + this->biases_[i];
+	}
+
+	apply_activation(this->activation_type_, this->scratch_.get_data(), this->neuron_count_);
+}
+
+#pragma endregion
+
+#pragma region QuantizedNetwork
+
+nn::quantization::QuantizedNetwork::QuantizedNetwork()
+	: input_size_(0), batch_size_(0)
+{
+}
+
+void nn::quantization::QuantizedNetwork::quantize(NeuralNetwork& network, const Calibration& calibration,
+                                                  const ScaleGranularity granularity)
+{
+	const auto& layers = network.get_layers();
+	if (layers.size() < 2 || calibration.get_layer_count() != layers.size())
+	{
+		throw std::runtime_error("Network has not been calibrated.");
+	}
+
+	this->layers_.clear();
+	this->activations_.clear();
+	this->output_.reset();
+	this->batch_size_ = 0;
+	this->input_size_ = layers.front()->get_neuron_count();
+
+	size_t layer_index = 0;
+	for (auto it = std::next(layers.begin()); it != layers.end(); ++it, ++layer_index)
+	{
+		// The input of layer i + 1 is the activation of layer i.
+		this->layers_.push_back(std::make_unique<QuantizedLayer>(
+			as_dense_layer(**it), calibration.get_activation_quantization(layer_index), granularity));
+	}
+}
+
+const nn::Matrix<float>& nn::quantization::QuantizedNetwork::feed_forward(const Matrix<float>& input)
+{
+	if (this->layers_.empty())
+	{
+		throw std::runtime_error("Quantized network is not initialized.");
+	}
+	if (input.get_rows() != this->input_size_)
+	{
+		throw std::runtime_error("Invalid input size.");
+	}
+
+	this->allocate_activations(input.get_cols());
+
+	// Quantize the input, transposing it so every sample is a contiguous row.
+	const auto& input_quantization = this->layers_.front()->get_input_quantization();
+	auto& quantized_input = *this->activations_.front();
+	for (size_t i = 0; i < input.get_rows(); ++i)
+	{
+		for (size_t sample = 0; sample < input.get_cols(); ++sample)
+		{
+			quantized_input(sample, i) = input_quantization.quantize(input(i, sample));
+		}
+	}
+
+	for (size_t i = 0; i + 1 < this->layers_.size(); ++i)
+	{
+		const auto& next_layer = *this->layers_[i + 1];
+		this->layers_[i]->feed_forward(*this->activations_[i], *this->activations_[i + 1],
+		                               next_layer.get_input_quantization(), next_layer.get_input_stride());
+	}
+	this->layers_.back()->feed_forward(*this->activations_.back(), *this->output_);
+
+	return *this->output_;
+}
+
+float nn::quantization::QuantizedNetwork::calculate_accuracy(DataSet& data_set)
+{
+	data_set.reset();
+
+	size_t correct = 0;
+	while (!data_set.is_end())
+	{
+		const auto& output = this->feed_forward(data_set.get_batch_input());
+		const auto& expected = data_set.get_batch_output();
+
+		for (size_t i = 0; i < output.get_cols(); ++i)
+		{
+			if (expected(get_max_index(output, i), i) == 1.0f)
+			{
+				++correct;
+			}
+		}
+
+		data_set.go_to_next_batch();
+	}
+
+	data_set.reset();
+
+	return static_cast<float>(correct) / static_cast<float>(data_set.get_total_size());
+}
+
+const nn::Matrix<float>& nn::quantization::QuantizedNetwork::get_output() const
+{
+	if (this->output_ == nullptr)
+	{
+		throw std::runtime_error("Quantized network has no output.");
+	}
+
+	return *this->output_;
+}
+
+void nn::quantization::QuantizedNetwork::allocate_activations(const size_t batch_size)
+{
+	if (batch_size == this->batch_size_)
+	{
+		return;
+	}
+
+	this->batch_size_ = batch_size;
+	this->activations_.clear();
+	for (const auto& layer : this->layers_)
+	{
+		auto activations = std::make_unique<Matrix<uint8_t>>(batch_size, layer->get_input_stride());
+		// Padding only ever meets zero weights, but keep it initialized.
+		for (size_t i = 0; i < activations->get_rows() * activations->get_cols(); ++i)
+		{
+			(*activations)[i] = 0;
+		}
+		this->activations_.push_back(std::move(activations));
+	}
+	this->output_ = std::make_unique<Matrix<float>>(this->layers_.back()->get_neuron_count(), batch_size);
+}
+
+#pragma endregion
+
+int32_t nn::quantization::dot_product(const uint8_t* activations, const int8_t* weights, const size_t size)
+{
+	// AVX-512 VNNI, AVX-512 BW, AVX2 or SSE4.2 (u8 x s8 multiply-add) depending on the CPU, see Kernels.h
+	return kernels::get_kernels().dot_u8s8(activations, weights, size);
+}
@@ -0,0 +1,55 @@
+// File: test/ActivationFunctionTest.cpp
+// Purpose: Test file for ActivationFunction.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/ActivationFunction.h>
+
+#include <memory>
+#include <vector>
+
+// Test case for the fused backward of the built-in functions against the derivative times the delta
+TEST(ActivationFunctionTest, Backward)
+{
+	constexpr size_t rows = 7, cols = 5;
+	nn::Matrix<float> sums(rows, cols), delta_activations(rows, cols);
+	sums.randomize(-4.0f, 4.0f);
+	delta_activations.randomize(-1.0f, 1.0f);
+
+	std::vector<std::unique_ptr<nn::activation_functions::ActivationFunction>> functions;
+	functions.push_back(std::make_unique<nn::activation_functions::Sigmoid>());
+	functions.push_back(std::make_unique<nn::activation_functions::ReLU>());
+	functions.push_back(std::make_unique<nn::activation_functions::LeakyReLU>());
+	functions.push_back(std::make_unique<nn::activation_functions::Tanh>());
+	functions.push_back(std::make_unique<nn::activation_functions::SoftMax>());
+	functions.push_back(std::make_unique<nn::activation_functions::Linear>());
+
+	for (const auto& function : functions)
+	{
+		nn::Matrix<float> activations = sums;
+		function->activate(activations);
+
+		// The default of the interface: copy, derivative and hadamard product
+		nn::Matrix<float> expected(rows, cols), delta_sums(rows, cols);
+		function->ActivationFunction::backward(sums, activations, delta_activations, expected);
+		function->backward(sums, activations, delta_activations, delta_sums);
+
+		const auto type = static_cast<int>(nn::activation_functions::get_activation_type(*function));
+		for (size_t i = 0; i < rows * cols; ++i)
+		{
+			ASSERT_NEAR(delta_sums[i], expected[i], 1e-6f) << type << " " << sums[i];
+		}
+	}
+}
+
+// Test case for creating the built-in functions by type
+TEST(ActivationFunctionTest, CreateByType)
+{
+	using nn::activation_functions::ActivationType;
+	for (const auto type : { ActivationType::Sigmoid, ActivationType::ReLU, ActivationType::LeakyReLU, ActivationType::Tanh,
+		ActivationType::SoftMax, ActivationType::Linear })
+	{
+		const auto function = nn::activation_functions::create_activation_function(type);
+		EXPECT_EQ(nn::activation_functions::get_activation_type(*function), type);
+	}
+	EXPECT_THROW(static_cast<void>(nn::activation_functions::create_activation_function(ActivationType::Custom)), std::runtime_error);
+}
@@ -5,6 +5,8 @@
 
 #include <NeuralNetwork/AlignedMemoryAllocator.h>
 
+#include <cstdint>
+
 // Test case for default constructor
 TEST(AlignedMemoryAllocatorTest, DefaultConstructor) {
     nn::utils::AlignedMemoryAllocator<int, 32> allocator;
@@ -26,6 +28,25 @@ TEST(AlignedMemoryAllocatorTest, InitializationWithSize) {
     ASSERT_EQ(allocator.get_size(), 0);
 }
 
+// Test case for move constructor and move assignment
+TEST(AlignedMemoryAllocatorTest, Move) {
+    nn::utils::AlignedMemoryAllocator<int, 32> allocator(100);
+    int* data = allocator.get();
+
+    nn::utils::AlignedMemoryAllocator<int, 32> moved(std::move(allocator));
+    ASSERT_EQ(moved.get(), data);
+    ASSERT_EQ(moved.get_size(), 100);
+    ASSERT_FALSE(allocator.is_initialized());
+    ASSERT_EQ(allocator.get(), nullptr);
+
+    nn::utils::AlignedMemoryAllocator<int, 32> assigned(10);
+    assigned = std::move(moved);
+    ASSERT_EQ(assigned.get(), data);
+    ASSERT_EQ(assigned.get_size(), 100);
+    ASSERT_FALSE(moved.is_initialized());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(assigned.get()) % 32, 0u);
+}
+
 // Test case for copying data between two allocators of same alignment
 TEST(AlignedMemoryAllocatorTest, CopyDataBetweenSameAlignment) {
     nn::utils::AlignedMemoryAllocator<int, 32> source_allocator(100);
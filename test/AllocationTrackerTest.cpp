@@ -0,0 +1,124 @@
+// File: test/AllocationTrackerTest.cpp
+// Purpose: Test file for AllocationTracker.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/AllocationTracker.h>
+#include <NeuralNetwork/ActivationFunction.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+
+#include "TestDataSets.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	const nn::memory::TagStats* find_tag(const std::vector<nn::memory::TagStats>& tags, const char* name)
+	{
+		const auto tag = std::find_if(tags.begin(), tags.end(), [name](const nn::memory::TagStats& t)
+		{
+			return std::strcmp(t.tag, name) == 0;
+		});
+		return tag == tags.end() ? nullptr : &*tag;
+	}
+}
+
+// Test case for the live and peak bytes and the allocations per tag
+TEST(AllocationTrackerTest, LiveAndPeakBytes)
+{
+	nn::memory::reset();
+	const nn::memory::AllocationStats before = nn::memory::get_stats();
+	EXPECT_EQ(before.allocations, 0u);
+	EXPECT_EQ(before.peak_bytes, before.live_bytes);
+
+	{
+		const nn::Matrix<float> a(10, 10);
+		{
+			const nn::memory::ScopedTag tag("test/inner");
+			const nn::Matrix<float> b(20, 10);
+		}
+		const nn::Matrix<float> c(5, 10);
+
+		const nn::memory::AllocationStats during = nn::memory::get_stats();
+		EXPECT_EQ(during.live_bytes, before.live_bytes + (100 + 50) * sizeof(float));
+		EXPECT_EQ(during.peak_bytes, before.live_bytes + (100 + 200) * sizeof(float));
+		EXPECT_EQ(during.allocations, 3u);
+		EXPECT_EQ(during.deallocations, 1u);
+	}
+
+	const nn::memory::AllocationStats after = nn::memory::get_stats();
+	EXPECT_EQ(after.live_bytes, before.live_bytes);
+	EXPECT_EQ(after.deallocations, 3u);
+
+	const std::vector<nn::memory::TagStats> tags = nn::memory::get_tag_stats();
+	ASSERT_NE(find_tag(tags, "test/inner"), nullptr);
+	EXPECT_EQ(find_tag(tags, "test/inner")->allocations, 1u);
+	EXPECT_EQ(find_tag(tags, "test/inner")->bytes, 200 * sizeof(float));
+	ASSERT_NE(find_tag(tags, nn::memory::untagged), nullptr);
+	EXPECT_EQ(find_tag(tags, nn::memory::untagged)->allocations, 2u);
+
+	// The transpose is attributed to its call site
+	const nn::Matrix<float> d(3, 4);
+	const nn::Matrix<float> e = d.transpose();
+	ASSERT_NE(find_tag(nn::memory::get_tag_stats(), "Matrix::transpose"), nullptr);
+
+	std::ostringstream report;
+	nn::memory::write_report(report);
+	EXPECT_NE(report.str().find("peak bytes"), std::string::npos);
+	EXPECT_NE(report.str().find("test/inner"), std::string::npos);
+
+	nn::memory::reset();
+	EXPECT_TRUE(nn::memory::get_tag_stats().empty());
+}
+
+// Test case for the guard and the steady state of training
+TEST(AllocationTrackerTest, NoAllocationGuard)
+{
+	{
+		const nn::memory::NoAllocationGuard guard;
+		EXPECT_THROW(nn::Matrix<float>(2, 2), std::logic_error);
+	}
+	EXPECT_NO_THROW(nn::Matrix<float>(2, 2));
+
+	nn::NeuralNetwork network(0.1f, 2);
+	network.add_layer(std::make_unique<nn::DenseLayer>(4, 2));
+	network.add_layer(std::make_unique<nn::DenseLayer>(3, 2, 4));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, 2, 3));
+	auto data_set = std::make_unique<nn::test::InMemoryDataSet>(4, 2, 3, nn::test::fill_constant);
+	data_set->initialize(2);
+	network.set_data_set(std::move(data_set));
+
+	// Inference and evaluation work in the layer buffers
+	{
+		const nn::memory::NoAllocationGuard guard;
+		EXPECT_NO_THROW(static_cast<void>(network.get_loss()));
+		EXPECT_NO_THROW(static_cast<void>(network.calculate_accuracy()));
+	}
+
+	// Back propagation multiplies by the transposed operands in place, with or without a BLAS backend
+	network.set_allocation_guard(true);
+	EXPECT_NO_THROW(network.train_one_epoch());
+
+	network.set_allocation_guard(false);
+	EXPECT_NO_THROW(network.train_one_epoch());
+}
+
+// Test case for the steady state of training a classifier with a softmax output
+TEST(AllocationTrackerTest, NoAllocationGuardSoftMax)
+{
+	nn::NeuralNetwork network(0.1f, 2);
+	network.add_layer(std::make_unique<nn::DenseLayer>(4, 2));
+	network.add_layer(std::make_unique<nn::DenseLayer>(3, 2, 4));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, 2, 3, std::make_unique<nn::activation_functions::SoftMax>()));
+	auto data_set = std::make_unique<nn::test::InMemoryDataSet>(4, 2, 3, nn::test::fill_constant);
+	data_set->initialize(2);
+	network.set_data_set(std::move(data_set));
+
+	network.set_allocation_guard(true);
+	EXPECT_NO_THROW(network.train_one_epoch());
+	EXPECT_NO_THROW(network.train_one_epoch());
+}
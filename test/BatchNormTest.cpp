@@ -0,0 +1,233 @@
+// File: test/BatchNormTest.cpp
+// Purpose: Test file for BatchNorm.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/BatchNorm.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	constexpr size_t neurons = 5, batch = 12;
+
+	std::unique_ptr<nn::DenseLayer> make_input(const size_t neuron_count)
+	{
+		auto input = std::make_unique<nn::DenseLayer>(neuron_count, batch);
+		nn::Matrix<float> activations(neuron_count, batch);
+		activations.randomize(-2.0f, 3.0f);
+		input->set_activations(activations);
+		return input;
+	}
+
+	double loss(const nn::Layer& layer, const nn::Matrix<float>& expected)
+	{
+		double result = 0.0;
+		for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+		{
+			const double difference = layer.get_activations()[i] - expected[i];
+			result += difference * difference;
+		}
+		return result;
+	}
+}
+
+// Test case for the batch statistics, the running statistics and inference
+TEST(BatchNormTest, FeedForward)
+{
+	const auto input_layer = make_input(neurons);
+	const nn::Matrix<float>& input = input_layer->get_activations();
+	nn::BatchNorm batch_norm(neurons, batch);
+	ASSERT_TRUE(batch_norm.is_training());
+	batch_norm.feed_forward(*input_layer);
+
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		double mean = 0.0, variance = 0.0, output_mean = 0.0, output_variance = 0.0;
+		for (size_t b = 0; b < batch; ++b)
+		{
+			mean += input(i, b) / batch;
+			output_mean += batch_norm.get_activations()(i, b) / batch;
+		}
+		for (size_t b = 0; b < batch; ++b)
+		{
+			variance += (input(i, b) - mean) * (input(i, b) - mean) / batch;
+			output_variance += (batch_norm.get_activations()(i, b) - output_mean) * (batch_norm.get_activations()(i, b) - output_mean) / batch;
+		}
+		EXPECT_NEAR(output_mean, 0.0, 1e-5);
+		EXPECT_NEAR(output_variance, variance / (variance + 1e-5), 1e-4);
+
+		// One step of momentum 0.1 from mean 0 and variance 1, the variance unbiased
+		EXPECT_NEAR(batch_norm.get_running_mean()[i], 0.1 * mean, 1e-5);
+		EXPECT_NEAR(batch_norm.get_running_variance()[i], 0.9 + 0.1 * variance * batch / (batch - 1), 1e-4);
+	}
+
+	// Inference normalizes with the running statistics
+	nn::Matrix<float> gamma(neurons, 1), beta(neurons, 1), mean(neurons, 1), variance(neurons, 1);
+	gamma.randomize(0.5f, 2.0f);
+	beta.randomize(-1.0f, 1.0f);
+	mean.randomize(-1.0f, 1.0f);
+	variance.randomize(0.5f, 2.0f);
+	batch_norm.set_gamma(gamma);
+	batch_norm.set_beta(beta);
+	batch_norm.set_running_statistics(mean, variance);
+	batch_norm.set_training(false);
+	batch_norm.feed_forward(*input_layer);
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		for (size_t b = 0; b < batch; ++b)
+		{
+			const float expected = gamma[i] * (input(i, b) - mean[i]) / std::sqrt(variance[i] + 1e-5f) + beta[i];
+			EXPECT_NEAR(batch_norm.get_activations()(i, b), expected, 1e-5f);
+		}
+		EXPECT_EQ(batch_norm.get_running_mean()[i], mean[i]);
+	}
+
+	EXPECT_THROW(batch_norm.feed_forward(*make_input(neurons + 1)), std::runtime_error);
+}
+
+// Test case for the gradients against finite differences, through the batch statistics
+TEST(BatchNormTest, Gradients)
+{
+	const auto input_layer = make_input(neurons);
+	nn::DenseLayer& input = *input_layer;
+	nn::BatchNorm batch_norm(neurons, batch, std::make_unique<nn::activation_functions::Tanh>());
+	nn::Matrix<float> gamma(neurons, 1), beta(neurons, 1);
+	gamma.randomize(0.5f, 1.5f);
+	beta.randomize(-0.5f, 0.5f);
+	batch_norm.set_gamma(gamma);
+	batch_norm.set_beta(beta);
+	nn::Matrix<float> expected(neurons, batch);
+	expected.randomize(-0.5f, 0.5f);
+
+	batch_norm.feed_forward(input);
+	batch_norm.back_propagate(expected, input);
+	nn::Matrix<float> input_delta(neurons, batch);
+	batch_norm.propagate_delta_to_previous_layer(input_delta);
+
+	// The delta gamma and beta are the gradient of the loss divided by the batch size
+	constexpr float epsilon = 1e-2f;
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		for (nn::Matrix<float>* parameter : { &gamma, &beta })
+		{
+			const float value = (*parameter)[i];
+			(*parameter)[i] = value + epsilon;
+			batch_norm.set_gamma(gamma);
+			batch_norm.set_beta(beta);
+			batch_norm.feed_forward(input);
+			const double loss_plus = loss(batch_norm, expected);
+			(*parameter)[i] = value - epsilon;
+			batch_norm.set_gamma(gamma);
+			batch_norm.set_beta(beta);
+			batch_norm.feed_forward(input);
+			const double loss_minus = loss(batch_norm, expected);
+			(*parameter)[i] = value;
+			batch_norm.set_gamma(gamma);
+			batch_norm.set_beta(beta);
+
+			const double gradient = (loss_plus - loss_minus) / (2.0 * epsilon) / batch;
+			const nn::Matrix<float>& delta = parameter == &gamma ? batch_norm.get_delta_gamma() : batch_norm.get_delta_beta();
+			EXPECT_NEAR(delta[i], gradient, 2e-3);
+		}
+	}
+
+	// The delta activations of the previous layer are the gradient of the loss
+	nn::Matrix<float> activations = input.get_activations();
+	for (size_t i = 0; i < neurons * batch; i += 3)
+	{
+		const float activation = activations[i];
+		activations[i] = activation + epsilon;
+		input.set_activations(activations);
+		batch_norm.feed_forward(input);
+		const double loss_plus = loss(batch_norm, expected);
+		activations[i] = activation - epsilon;
+		input.set_activations(activations);
+		batch_norm.feed_forward(input);
+		const double loss_minus = loss(batch_norm, expected);
+		activations[i] = activation;
+		input.set_activations(activations);
+
+		const double gradient = (loss_plus - loss_minus) / (2.0 * epsilon);
+		EXPECT_NEAR(input_delta[i], gradient, 5e-3);
+	}
+}
+
+// Test case for a trained dense layer and batch normalization folded into the dense layer for inference
+TEST(BatchNormTest, FoldIntoDenseLayer)
+{
+	constexpr size_t inputs = 8;
+	const auto input_layer = make_input(inputs);
+	nn::DenseLayer dense(neurons, batch, inputs, std::make_unique<nn::activation_functions::Linear>());
+	nn::BatchNorm batch_norm(neurons, batch, std::make_unique<nn::activation_functions::Sigmoid>());
+	nn::Matrix<float> expected(neurons, batch);
+	expected.randomize(0.2f, 0.8f);
+
+	// Training moves gamma, beta and the running statistics away from the identity
+	float initial_loss = 0.0f, final_loss = 0.0f;
+	for (int step = 0; step < 200; ++step)
+	{
+		dense.feed_forward(*input_layer);
+		batch_norm.feed_forward(dense);
+		final_loss = static_cast<float>(loss(batch_norm, expected));
+		initial_loss = step == 0 ? final_loss : initial_loss;
+		batch_norm.back_propagate(expected, dense);
+		dense.back_propagate(batch_norm, *input_layer);
+		batch_norm.update_weights_and_biases(0.5f);
+		dense.update_weights_and_biases(0.5f);
+	}
+	EXPECT_LT(final_loss, 0.5f * initial_loss);
+
+	// Inference output with the separate layers
+	batch_norm.set_training(false);
+	dense.feed_forward(*input_layer);
+	batch_norm.feed_forward(dense);
+	const nn::Matrix<float> reference = batch_norm.get_activations();
+
+	batch_norm.fold_into(dense);
+	EXPECT_EQ(nn::activation_functions::get_activation_type(*dense.get_activation_function()),
+		nn::activation_functions::ActivationType::Sigmoid);
+	dense.feed_forward(*input_layer);
+	for (size_t i = 0; i < neurons * batch; ++i)
+	{
+		EXPECT_NEAR(dense.get_activations()[i], reference[i], 1e-5f);
+	}
+	EXPECT_THROW(batch_norm.fold_into(dense), std::runtime_error);
+
+	// Only a linear layer can take the batch normalization
+	nn::BatchNorm other(neurons, batch);
+	EXPECT_THROW(other.fold_into(dense), std::runtime_error);
+}
+
+// Test case for the network switching the training mode and folding its batch normalizations
+TEST(BatchNormTest, NetworkFolding)
+{
+	constexpr size_t inputs = 6;
+	nn::NeuralNetwork network(0.1f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(inputs, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(neurons, batch, inputs, std::make_unique<nn::activation_functions::Linear>()));
+	auto batch_norm = std::make_unique<nn::BatchNorm>(neurons, batch, std::make_unique<nn::activation_functions::ReLU>());
+	nn::Matrix<float> mean(neurons, 1), variance(neurons, 1);
+	mean.randomize(-1.0f, 1.0f);
+	variance.randomize(0.5f, 2.0f);
+	batch_norm->set_running_statistics(mean, variance);
+	network.add_layer(std::move(batch_norm));
+	network.add_layer(std::make_unique<nn::DenseLayer>(3, batch, neurons));
+	network.set_training(false);
+
+	nn::Matrix<float> input(inputs, batch);
+	input.randomize(-1.0f, 1.0f);
+	network.feed_forward_with_input(input);
+	const nn::Matrix<float> reference = network.get_output();
+
+	EXPECT_EQ(network.fold_batch_norms(), 1u);
+	EXPECT_EQ(network.get_layers().size(), 3u);
+	network.feed_forward_with_input(input);
+	for (size_t i = 0; i < 3 * batch; ++i)
+	{
+		EXPECT_NEAR(network.get_output()[i], reference[i], 1e-5f);
+	}
+	EXPECT_EQ(network.fold_batch_norms(), 0u);
+}
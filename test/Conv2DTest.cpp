@@ -0,0 +1,232 @@
+// File: test/Conv2DTest.cpp
+// Purpose: Test file for Conv2D.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/DenseLayer.h>
+
+#include <cmath>
+#include <memory>
+
+namespace
+{
+	constexpr size_t channels = 2, height = 6, width = 5, kernels = 3, batch = 3;
+
+	/// <summary>
+	/// Input layer with random images.
+	/// </summary>
+	std::unique_ptr<nn::Layer> make_input(const size_t neuron_count)
+	{
+		auto input = std::make_unique<nn::DenseLayer>(neuron_count, batch);
+		nn::Matrix<float> activations(neuron_count, batch);
+		activations.randomize(-1.0f, 1.0f);
+		input->set_activations(activations);
+		return input;
+	}
+
+	/// <summary>
+	/// Sums of the convolution computed from the definition.
+	/// </summary>
+	nn::Matrix<float> reference_sums(const nn::Conv2D& conv, const nn::Matrix<float>& input)
+	{
+		const size_t k = conv.get_kernel_size(), s = conv.get_stride(), p = conv.get_padding();
+		const size_t oh = conv.get_output_height(), ow = conv.get_output_width();
+		nn::Matrix<float> sums(conv.get_neuron_count(), batch);
+		for (size_t o = 0; o < conv.get_output_channels(); ++o)
+		for (size_t oy = 0; oy < oh; ++oy)
+		for (size_t ox = 0; ox < ow; ++ox)
+		for (size_t b = 0; b < batch; ++b)
+		{
+			double sum = conv.get_biases()[o];
+			for (size_t c = 0; c < channels; ++c)
+			for (size_t ky = 0; ky < k; ++ky)
+			for (size_t kx = 0; kx < k; ++kx)
+			{
+				const long iy = static_cast<long>(oy * s + ky) - static_cast<long>(p);
+				const long ix = static_cast<long>(ox * s + kx) - static_cast<long>(p);
+				if (iy < 0 || ix < 0 || iy >= static_cast<long>(height) || ix >= static_cast<long>(width))
+				{
+					continue;
+				}
+				sum += conv.get_weights()(o, (c * k + ky) * k + kx) * input((c * height + iy) * width + ix, b);
+			}
+			sums((o * oh + oy) * ow + ox, b) = static_cast<float>(sum);
+		}
+		return sums;
+	}
+
+	/// <summary>
+	/// sum of (activations - expected)^2
+	/// </summary>
+	double loss(const nn::Layer& layer, const nn::Matrix<float>& expected)
+	{
+		double result = 0.0;
+		for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+		{
+			const double difference = layer.get_activations()[i] - expected[i];
+			result += difference * difference;
+		}
+		return result;
+	}
+}
+
+// Test case for the output size and the algorithm selection
+TEST(Conv2DTest, Shapes)
+{
+	const nn::Conv2D conv(channels, height, width, kernels, 3, batch);
+	EXPECT_EQ(conv.get_output_height(), 4u);
+	EXPECT_EQ(conv.get_output_width(), 3u);
+	EXPECT_EQ(conv.get_neuron_count(), kernels * 4u * 3u);
+	EXPECT_EQ(conv.get_weights().get_rows(), kernels);
+	EXPECT_EQ(conv.get_weights().get_cols(), channels * 9u);
+	EXPECT_EQ(conv.get_algorithm(), nn::ConvolutionAlgorithm::Direct);
+
+	nn::Conv2D strided(channels, height, width, kernels, 3, batch, 2, 1);
+	EXPECT_EQ(strided.get_output_height(), 3u);
+	EXPECT_EQ(strided.get_output_width(), 3u);
+	EXPECT_EQ(strided.get_algorithm(), nn::ConvolutionAlgorithm::Im2col);
+	EXPECT_THROW(strided.set_algorithm(nn::ConvolutionAlgorithm::Direct), std::runtime_error);
+
+	EXPECT_THROW(nn::Conv2D(channels, 2, 2, kernels, 3, batch), std::runtime_error);
+}
+
+// Test case for both algorithms against the definition, with stride and padding
+TEST(Conv2DTest, FeedForward)
+{
+	const auto input_layer = make_input(channels * height * width);
+	const nn::Layer& input = *input_layer;
+
+	for (const size_t stride : { 1u, 2u })
+	{
+		for (const size_t padding : { 0u, 1u, 2u })
+		{
+			nn::Conv2D conv(channels, height, width, kernels, 3, batch, stride, padding, nullptr, nn::ConvolutionAlgorithm::Im2col);
+			const nn::Matrix<float> expected = reference_sums(conv, input.get_activations());
+
+			conv.feed_forward(input);
+			for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+			{
+				EXPECT_NEAR(conv.get_sums()[i], expected[i], 1e-5f);
+			}
+
+			if (stride == 1)
+			{
+				conv.set_algorithm(nn::ConvolutionAlgorithm::Direct);
+				conv.feed_forward(input);
+				for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+				{
+					EXPECT_NEAR(conv.get_sums()[i], expected[i], 1e-5f);
+				}
+			}
+		}
+	}
+}
+
+// Test case for the gradients of both algorithms against finite differences
+TEST(Conv2DTest, Gradients)
+{
+	for (const nn::ConvolutionAlgorithm algorithm : { nn::ConvolutionAlgorithm::Im2col, nn::ConvolutionAlgorithm::Direct })
+	{
+		const auto input_layer = make_input(channels * height * width);
+		nn::Layer& input = *input_layer;
+		nn::Conv2D conv(channels, height, width, kernels, 3, batch, 1, 1, std::make_unique<nn::activation_functions::Tanh>(), algorithm);
+		nn::Matrix<float> expected(conv.get_neuron_count(), batch);
+		expected.randomize(-0.5f, 0.5f);
+
+		conv.feed_forward(input);
+		conv.back_propagate(expected, input);
+		nn::Matrix<float> input_delta(channels * height * width, batch);
+		conv.propagate_delta_to_previous_layer(input_delta);
+
+		// The delta weights and biases are the gradient of the loss divided by the batch size
+		constexpr float epsilon = 1e-2f;
+		nn::Matrix<float> weights = conv.get_weights();
+		for (size_t i = 0; i < weights.get_rows() * weights.get_cols(); i += 5)
+		{
+			const float weight = weights[i];
+			weights[i] = weight + epsilon;
+			conv.set_weights(weights);
+			conv.feed_forward(input);
+			const double loss_plus = loss(conv, expected);
+			weights[i] = weight - epsilon;
+			conv.set_weights(weights);
+			conv.feed_forward(input);
+			const double loss_minus = loss(conv, expected);
+			weights[i] = weight;
+			conv.set_weights(weights);
+
+			const double gradient = (loss_plus - loss_minus) / (2.0 * epsilon) / batch;
+			EXPECT_NEAR(conv.get_delta_weights()[i], gradient, 2e-3);
+		}
+
+		nn::Matrix<float> biases = conv.get_biases();
+		for (size_t i = 0; i < kernels; ++i)
+		{
+			const float bias = biases[i];
+			biases[i] = bias + epsilon;
+			conv.set_biases(biases);
+			conv.feed_forward(input);
+			const double loss_plus = loss(conv, expected);
+			biases[i] = bias - epsilon;
+			conv.set_biases(biases);
+			conv.feed_forward(input);
+			const double loss_minus = loss(conv, expected);
+			biases[i] = bias;
+			conv.set_biases(biases);
+
+			const double gradient = (loss_plus - loss_minus) / (2.0 * epsilon) / batch;
+			EXPECT_NEAR(conv.get_delta_biases()[i], gradient, 2e-3);
+		}
+
+		// The delta activations of the previous layer are the gradient of the loss
+		nn::Matrix<float> activations = input.get_activations();
+		for (size_t i = 0; i < activations.get_rows() * activations.get_cols(); i += 7)
+		{
+			const float activation = activations[i];
+			activations[i] = activation + epsilon;
+			input.set_activations(activations);
+			conv.feed_forward(input);
+			const double loss_plus = loss(conv, expected);
+			activations[i] = activation - epsilon;
+			input.set_activations(activations);
+			conv.feed_forward(input);
+			const double loss_minus = loss(conv, expected);
+			activations[i] = activation;
+			input.set_activations(activations);
+
+			const double gradient = (loss_plus - loss_minus) / (2.0 * epsilon);
+			EXPECT_NEAR(input_delta[i], gradient, 5e-3);
+		}
+	}
+}
+
+// Test case for a convolution followed by a dense layer learning a fixed target
+TEST(Conv2DTest, TrainsInChain)
+{
+	const auto input_layer = make_input(channels * height * width);
+	const nn::Layer& input = *input_layer;
+	nn::Conv2D conv(channels, height, width, kernels, 3, batch, 1, 1);
+	nn::DenseLayer output(2, batch, conv.get_neuron_count());
+	nn::Matrix<float> expected(2, batch);
+	expected.randomize(0.2f, 0.8f);
+
+	const auto step = [&]()
+	{
+		conv.feed_forward(input);
+		output.feed_forward(conv);
+		const double result = loss(output, expected);
+		output.back_propagate(expected, conv);
+		conv.back_propagate(output, input);
+		conv.update_weights_and_biases(0.5f);
+		output.update_weights_and_biases(0.5f);
+		return result;
+	};
+
+	const double initial_loss = step();
+	double final_loss = initial_loss;
+	for (int i = 0; i < 100; ++i)
+	{
+		final_loss = step();
+	}
+	EXPECT_LT(final_loss, 0.1 * initial_loss);
+}
@@ -0,0 +1,212 @@
+// File: test/DistributedTest.cpp
+// Purpose: Test file for Distributed.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+
+#include "TestDataSets.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+	constexpr size_t height = 6, width = 6, batch = 4, batch_count = 8;
+
+	/// <summary>
+	/// Data set with batch_count batches of random images, the output is one-hot on the brighter half of the image.
+	/// </summary>
+	std::unique_ptr<nn::test::InMemoryDataSet> make_data_set()
+	{
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(height * width, 2, batch_count, nn::test::fill_halves);
+		data_set->initialize(batch);
+		return data_set;
+	}
+
+	/// <summary>
+	/// Dense network on a data set (new random weights every time).
+	/// </summary>
+	std::unique_ptr<nn::NeuralNetwork> make_network(std::unique_ptr<nn::DataSet> data_set)
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.5f, batch);
+		network->add_layer(std::make_unique<nn::DenseLayer>(height * width, batch));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, height * width));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 16));
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 16));
+		network->set_data_set(std::move(data_set));
+		return network;
+	}
+
+	/// <summary>
+	/// Values of all the parameters of a network, one after the other.
+	/// </summary>
+	std::vector<float> get_parameter_values(nn::NeuralNetwork& network)
+	{
+		std::vector<float> values;
+		for (const auto& layer : network.get_layers())
+		{
+			for (const nn::Parameter& parameter : layer->get_parameters())
+			{
+				values.insert(values.end(), parameter.value->get_data(),
+					parameter.value->get_data() + parameter.value->get_rows() * parameter.value->get_cols());
+			}
+		}
+		return values;
+	}
+
+	/// <summary>
+	/// Socket paths of the ranks of one test in the temporary directory.
+	/// </summary>
+	std::vector<std::string> get_unix_addresses(const std::string& name, const size_t ranks)
+	{
+		return nn::distributed::get_local_addresses(nn::distributed::Transport::Unix,
+			"/tmp/nn_" + name + "_" + std::to_string(getpid()), ranks);
+	}
+
+	/// <summary>
+	/// Runs body(communicator) on one thread per rank, every rank connected to the ring of the addresses.
+	/// </summary>
+	template <typename Body>
+	void run_ranks(const nn::distributed::Transport transport, const std::vector<std::string>& addresses, Body body)
+	{
+		std::vector<std::thread> threads;
+		for (size_t rank = 0; rank < addresses.size(); ++rank)
+		{
+			threads.emplace_back([&, rank]()
+			{
+				nn::distributed::Communicator communicator(transport, addresses, rank);
+				body(communicator);
+			});
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+// Test case for the addresses of the ranks on one host
+TEST(DistributedTest, LocalAddresses)
+{
+	EXPECT_EQ(nn::distributed::get_local_addresses(nn::distributed::Transport::Tcp, "127.0.0.1:4000", 3),
+		(std::vector<std::string>{ "127.0.0.1:4000", "127.0.0.1:4001", "127.0.0.1:4002" }));
+	EXPECT_EQ(nn::distributed::get_local_addresses(nn::distributed::Transport::Unix, "/tmp/nn", 2),
+		(std::vector<std::string>{ "/tmp/nn.0", "/tmp/nn.1" }));
+	EXPECT_THROW(static_cast<void>(nn::distributed::get_local_addresses(nn::distributed::Transport::Tcp, "localhost", 2)), std::runtime_error);
+}
+
+// Test case for the ring all-reduce and broadcast: sizes smaller than, equal to and not divisible by the ranks
+TEST(DistributedTest, AllReduce)
+{
+	constexpr size_t ranks = 3;
+	for (const size_t size : { size_t{ 2 }, size_t{ 3 }, size_t{ 1000 } })
+	{
+		run_ranks(nn::distributed::Transport::Unix, get_unix_addresses("all_reduce", ranks), [size](nn::distributed::Communicator& communicator)
+		{
+			std::vector<float> data(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				data[i] = static_cast<float>(communicator.get_rank() * 1000 + i);
+			}
+			communicator.all_reduce(data.data(), size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				// 0 + 1000 + 2000 + 3 * i
+				EXPECT_EQ(data[i], static_cast<float>(3000 + ranks * i));
+			}
+			// Every rank sends 2 * (ranks - 1) chunks of about size / ranks
+			EXPECT_LE(communicator.get_bytes_sent(), 2 * (ranks - 1) * ((size + ranks - 1) / ranks) * sizeof(float));
+
+			std::vector<float> broadcast(size, static_cast<float>(communicator.get_rank()));
+			communicator.broadcast(broadcast.data(), size);
+			EXPECT_EQ(broadcast, std::vector<float>(size, 0.0f));
+		});
+	}
+
+	// A single rank needs no connection
+	nn::distributed::Communicator single(nn::distributed::Transport::Tcp, { "127.0.0.1:1" }, 0);
+	std::vector<float> data{ 1.0f, 2.0f };
+	single.all_reduce(data.data(), data.size());
+	EXPECT_EQ(data, (std::vector<float>{ 1.0f, 2.0f }));
+}
+
+// Test case for data parallel training over TCP: the ranks update like gradient accumulation over their batches
+TEST(DistributedTest, MatchesGradientAccumulation)
+{
+	constexpr size_t ranks = 2;
+	const auto data = make_data_set();
+
+	// The reference accumulates batches 0 and 1, 2 and 3, ...: the batches of rank 0 and rank 1 in each step
+	const auto reference = make_network(data->get_shard(0, 1));
+	reference->set_accumulation_steps(ranks);
+
+	std::vector<std::unique_ptr<nn::NeuralNetwork>> networks;
+	for (size_t rank = 0; rank < ranks; ++rank)
+	{
+		networks.push_back(make_network(data->get_shard(rank, ranks)));
+	}
+	// Rank 0 starts from the weights of the reference, the other ranks from their own until the broadcast
+	for (auto it = reference->get_layers().begin(), other = networks[0]->get_layers().begin(); it != reference->get_layers().end(); ++it, ++other)
+	{
+		const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+		const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+		for (size_t i = 0; i < parameters.size(); ++i)
+		{
+			*other_parameters[i].value = *parameters[i].value;
+		}
+	}
+
+	// Below the ephemeral ports (32768 and up on Linux), which the connecting sockets take
+	const auto addresses = nn::distributed::get_local_addresses(nn::distributed::Transport::Tcp,
+		"127.0.0.1:" + std::to_string(20000 + getpid() % 10000), ranks);
+	run_ranks(nn::distributed::Transport::Tcp, addresses, [&networks](nn::distributed::Communicator& communicator)
+	{
+		for (int epoch = 0; epoch < 2; ++epoch)
+		{
+			const nn::distributed::Report report = networks[communicator.get_rank()]->train_distributed(communicator);
+			EXPECT_EQ(report.steps, batch_count / ranks);
+			EXPECT_EQ(report.samples, batch_count / ranks * batch);
+			EXPECT_GT(report.bytes_sent, 0u);
+			EXPECT_GE(report.get_overlap_fraction(), 0.0);
+			EXPECT_LE(report.get_overlap_fraction(), 1.0);
+		}
+	});
+	reference->train_one_epoch();
+	reference->train_one_epoch();
+
+	const std::vector<float> expected = get_parameter_values(*reference);
+	for (size_t rank = 0; rank < ranks; ++rank)
+	{
+		const std::vector<float> values = get_parameter_values(*networks[rank]);
+		ASSERT_EQ(values.size(), expected.size());
+		// All ranks hold the same bits, the sums differ from the accumulation in rounding only
+		EXPECT_EQ(values, get_parameter_values(*networks[0]));
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			ASSERT_NEAR(values[i], expected[i], 1e-5f);
+		}
+	}
+}
+
+// Test case for the settings and addresses distributed training does not support
+TEST(DistributedTest, Unsupported)
+{
+	const auto data = make_data_set();
+	const auto network = make_network(data->get_shard(0, 1));
+	nn::distributed::Communicator single(nn::distributed::Transport::Unix, { "/tmp/nn_unused" }, 0);
+	network->set_accumulation_steps(2);
+	EXPECT_THROW(static_cast<void>(network->train_distributed(single)), std::logic_error);
+	network->set_accumulation_steps(1);
+	EXPECT_EQ(network->train_distributed(single).steps, batch_count);
+
+	EXPECT_THROW(nn::distributed::Communicator(nn::distributed::Transport::Unix, { "/tmp/nn_a", "/tmp/nn_b" }, 2), std::runtime_error);
+	EXPECT_THROW(nn::distributed::Communicator(nn::distributed::Transport::Tcp, { "no port", "127.0.0.1:1" }, 0), std::runtime_error);
+	// Nobody listens on the next address
+	EXPECT_THROW(nn::distributed::Communicator(nn::distributed::Transport::Unix,
+		get_unix_addresses("missing", 2), 0, std::chrono::milliseconds(100)), std::runtime_error);
+}
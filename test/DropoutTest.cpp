@@ -0,0 +1,147 @@
+// File: test/DropoutTest.cpp
+// Purpose: Test file for Dropout.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Dropout.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+
+#include <memory>
+
+namespace
+{
+	constexpr size_t neurons = 37, batch = 16;
+
+	std::unique_ptr<nn::DenseLayer> make_input()
+	{
+		auto input = std::make_unique<nn::DenseLayer>(neurons, batch);
+		nn::Matrix<float> activations(neurons, batch);
+		activations.randomize(0.5f, 1.0f);
+		input->set_activations(activations);
+		return input;
+	}
+
+	bool is_kept(const nn::Dropout& dropout, const size_t i)
+	{
+		return (dropout.get_mask()[i / 64] >> (i % 64)) & 1;
+	}
+}
+
+// Test case for the dropped and scaled activations, the masks of consecutive batches and the seed
+TEST(DropoutTest, FeedForward)
+{
+	const auto input_layer = make_input();
+	const nn::Matrix<float>& input = input_layer->get_activations();
+	nn::Dropout dropout(neurons, batch, 0.25f, 42);
+	ASSERT_TRUE(dropout.is_training());
+	ASSERT_EQ(dropout.get_mask().get_rows(), (neurons * batch + 63) / 64);
+
+	dropout.feed_forward(*input_layer);
+	size_t kept = 0;
+	for (size_t i = 0; i < neurons * batch; ++i)
+	{
+		const float expected = is_kept(dropout, i) ? input[i] / 0.75f : 0.0f;
+		ASSERT_FLOAT_EQ(dropout.get_activations()[i], expected);
+		kept += is_kept(dropout, i);
+	}
+	EXPECT_NEAR(static_cast<double>(kept) / (neurons * batch), 0.75, 0.05);
+
+	// Every batch draws a new mask, the same seed draws the same masks
+	const nn::Matrix<uint64_t> first_mask = dropout.get_mask();
+	dropout.feed_forward(*input_layer);
+	nn::Dropout same_seed(neurons, batch, 0.25f, 42);
+	same_seed.feed_forward(*input_layer);
+	size_t same_bits = 0;
+	for (size_t i = 0; i < first_mask.get_rows(); ++i)
+	{
+		EXPECT_EQ(same_seed.get_mask()[i], first_mask[i]);
+		same_bits += dropout.get_mask()[i] == first_mask[i];
+	}
+	EXPECT_LT(same_bits, first_mask.get_rows());
+
+	EXPECT_THROW(nn::Dropout(neurons, batch, 1.0f), std::runtime_error);
+}
+
+// Test case for the delta of the previous layer and the pass through of inference
+TEST(DropoutTest, BackPropagateAndInference)
+{
+	const auto input_layer = make_input();
+	nn::Dropout dropout(neurons, batch, 0.5f);
+	nn::Matrix<float> expected(neurons, batch);
+	expected.randomize(0.0f, 1.0f);
+
+	dropout.feed_forward(*input_layer);
+	dropout.back_propagate(expected, *input_layer);
+	nn::Matrix<float> previous_delta(neurons, batch);
+	dropout.propagate_delta_to_previous_layer(previous_delta);
+	for (size_t i = 0; i < neurons * batch; ++i)
+	{
+		const float delta = 2.0f * (dropout.get_activations()[i] - expected[i]);
+		ASSERT_FLOAT_EQ(previous_delta[i], is_kept(dropout, i) ? 2.0f * delta : 0.0f);
+	}
+
+	// Inference returns the activations of the previous layer without copying them
+	dropout.set_training(false);
+	dropout.feed_forward(*input_layer);
+	EXPECT_EQ(&dropout.get_activations(), &input_layer->get_activations());
+	dropout.back_propagate(expected, *input_layer);
+	dropout.propagate_delta_to_previous_layer(previous_delta);
+	for (size_t i = 0; i < neurons * batch; ++i)
+	{
+		ASSERT_FLOAT_EQ(previous_delta[i], 2.0f * (input_layer->get_activations()[i] - expected[i]));
+	}
+
+	// Back in training mode the layer has its own activations again
+	dropout.set_training(true);
+	EXPECT_NE(&dropout.get_activations(), &input_layer->get_activations());
+}
+
+// Test case for dropout between dense layers trained by the network (switched to inference after every epoch)
+TEST(DropoutTest, TrainsInNetwork)
+{
+	nn::NeuralNetwork network(0.5f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(neurons, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(64, batch, neurons));
+	network.add_layer(std::make_unique<nn::Dropout>(64, batch, 0.2f, 7));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, batch, 64));
+	auto& dropout = dynamic_cast<nn::Dropout&>(*std::next(network.get_layers().begin(), 2)->get());
+
+	nn::Matrix<float> input(neurons, batch), output(2, batch);
+	input.randomize(0.0f, 1.0f);
+	for (size_t b = 0; b < batch; ++b)
+	{
+		output(0, b) = b % 2 == 0 ? 0.9f : 0.1f;
+		output(1, b) = b % 2 == 0 ? 0.1f : 0.9f;
+	}
+
+	const auto loss = [&]()
+	{
+		network.set_training(false);
+		network.feed_forward_with_input(input);
+		float result = 0.0f;
+		for (size_t i = 0; i < 2 * batch; ++i)
+		{
+			result += (network.get_output()[i] - output[i]) * (network.get_output()[i] - output[i]);
+		}
+		return result;
+	};
+
+	const float initial_loss = loss();
+	EXPECT_FALSE(dropout.is_training());
+	network.set_training(true);
+	for (int step = 0; step < 300; ++step)
+	{
+		network.feed_forward_with_input(input);
+		auto& layers = network.get_layers();
+		layers.back()->back_propagate(output, **std::prev(layers.end(), 2));
+		for (auto it = std::prev(layers.end(), 2); it != layers.begin(); --it)
+		{
+			(*it)->back_propagate(**std::next(it), **std::prev(it));
+		}
+		for (auto it = std::next(layers.begin()); it != layers.end(); ++it)
+		{
+			(*it)->update_weights_and_biases(0.5f);
+		}
+	}
+	EXPECT_LT(loss(), 0.25f * initial_loss);
+}
@@ -0,0 +1,95 @@
+// File: test/ExpressionTest.cpp
+// Purpose: Test file for Expression.h.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/AllocationTracker.h>
+#include <NeuralNetwork/Matrix.h>
+
+#include <cmath>
+
+namespace
+{
+	nn::Matrix<float> make_matrix(const size_t rows, const size_t cols)
+	{
+		nn::Matrix<float> matrix(rows, cols);
+		matrix.randomize(-1.0f, 1.0f);
+		return matrix;
+	}
+}
+
+// Test case for the arithmetic operators, scalars and functions against element by element results
+TEST(ExpressionTest, Arithmetic)
+{
+	const nn::Matrix<float> a = make_matrix(5, 7);
+	const nn::Matrix<float> b = make_matrix(5, 7);
+	nn::Matrix<float> result(5, 7);
+
+	// The whole expression is evaluated into result, nothing else is allocated
+	nn::memory::reset();
+	result = 2 * (a - b) / 4.0 + -a * b - nn::expressions::max(a, 0.0f);
+	EXPECT_EQ(nn::memory::get_stats().allocations, 0u);
+	for (size_t i = 0; i < 35; ++i)
+	{
+		ASSERT_FLOAT_EQ(result[i], 2.0f * (a[i] - b[i]) / 4.0f + -a[i] * b[i] - std::max(a[i], 0.0f));
+	}
+
+	const nn::Matrix<float> functions = nn::expressions::exp(a) + nn::expressions::tanh(b) + nn::expressions::sigmoid(a) +
+		nn::expressions::sqrt(nn::expressions::abs(b)) + nn::expressions::log(nn::expressions::square(a) + 1);
+	ASSERT_EQ(functions.get_rows(), 5u);
+	ASSERT_EQ(functions.get_cols(), 7u);
+	for (size_t i = 0; i < 35; ++i)
+	{
+		ASSERT_NEAR(functions[i], std::exp(a[i]) + std::tanh(b[i]) + 1.0f / (1.0f + std::exp(-a[i])) +
+			std::sqrt(std::abs(b[i])) + std::log(a[i] * a[i] + 1.0f), 1e-5);
+	}
+
+	EXPECT_NEAR(nn::expressions::sum(a - b), [&]()
+	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < 35; ++i) sum += a[i] - b[i];
+		return sum;
+	}(), 1e-4);
+
+	const nn::Matrix<float> wrong_size(7, 5);
+	EXPECT_THROW(static_cast<void>(a + wrong_size), std::runtime_error);
+	EXPECT_THROW(result = wrong_size * 2, std::runtime_error);
+}
+
+// Test case for in place updates, views and broadcasting
+TEST(ExpressionTest, UpdatesViewsAndBroadcast)
+{
+	nn::Matrix<float> weights = make_matrix(4, 6);
+	const nn::Matrix<float> before = weights;
+	const nn::Matrix<float> delta = make_matrix(4, 6);
+
+	// The destination is an operand
+	weights = weights - 0.1f * delta;
+	for (size_t i = 0; i < 24; ++i)
+	{
+		ASSERT_FLOAT_EQ(weights[i], before[i] - 0.1f * delta[i]);
+	}
+
+	// Column windows of the same matrix and a column vector repeated for every column
+	const nn::Matrix<float> biases = make_matrix(4, 1);
+	nn::Matrix<float> sums = make_matrix(4, 6);
+	const nn::Matrix<float> sums_before = sums;
+	nn::expressions::evaluate(sums.view().slice_cols(0, 3) + nn::expressions::broadcast(biases, 4, 3) - weights.view().slice_cols(3, 3),
+		sums.view().slice_cols(3, 3));
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (size_t j = 0; j < 3; ++j)
+		{
+			ASSERT_FLOAT_EQ(sums(i, j + 3), sums_before(i, j) + biases(i, 0) - weights(i, j + 3));
+			ASSERT_EQ(sums(i, j), sums_before(i, j));
+		}
+	}
+
+	// A row vector repeated for every row, and a scalar fills the destination
+	const nn::Matrix<float> row = make_matrix(1, 6);
+	const nn::Matrix<float> scaled = nn::expressions::broadcast(row, 4, 6) * delta;
+	ASSERT_FLOAT_EQ(scaled(3, 5), row(0, 5) * delta(3, 5));
+	EXPECT_THROW(static_cast<void>(nn::expressions::broadcast(row, 6, 4)), std::runtime_error);
+
+	nn::expressions::evaluate(nn::expressions::Scalar<float>(3.0f), sums.view());
+	ASSERT_EQ(sums(2, 2), 3.0f);
+}
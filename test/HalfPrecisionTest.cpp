@@ -0,0 +1,104 @@
+// File: test/HalfPrecisionTest.cpp
+// Purpose: Test file for HalfPrecision.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/HalfPrecision.h>
+#include <NeuralNetwork/DenseLayer.h>
+
+#include <cmath>
+#include <limits>
+
+// Test case for bfloat16 conversions
+TEST(HalfPrecisionTest, BFloat16Conversion)
+{
+	ASSERT_EQ(static_cast<float>(nn::bfloat16(1.0f)), 1.0f);
+	ASSERT_EQ(static_cast<float>(nn::bfloat16(-2.5f)), -2.5f);
+	ASSERT_EQ(nn::bfloat16(1.0f).bits, 0x3f80);
+	// 1 + 2^-8 is halfway between two bfloat16 values and rounds to the even one (1.0)
+	ASSERT_EQ(static_cast<float>(nn::bfloat16(1.00390625f)), 1.0f);
+	ASSERT_TRUE(std::isinf(static_cast<float>(nn::bfloat16(std::numeric_limits<float>::infinity()))));
+	ASSERT_TRUE(std::isnan(static_cast<float>(nn::bfloat16(std::numeric_limits<float>::quiet_NaN()))));
+	ASSERT_NEAR(static_cast<float>(nn::bfloat16(3.14159f)), 3.14159f, 3.14159f / 128.0f);
+}
+
+// Test case for half precision conversions
+TEST(HalfPrecisionTest, Float16Conversion)
+{
+	ASSERT_EQ(nn::float16(1.0f).bits, 0x3c00);
+	ASSERT_EQ(nn::float16(-2.0f).bits, 0xc000);
+	ASSERT_EQ(nn::float16(65504.0f).bits, 0x7bff);
+	ASSERT_EQ(nn::float16(100000.0f).bits, 0x7c00);
+	// Smallest subnormal half (2^-24)
+	ASSERT_EQ(nn::float16(5.9604645e-8f).bits, 0x0001);
+	ASSERT_EQ(static_cast<float>(nn::float16(0.5f)), 0.5f);
+	ASSERT_NEAR(static_cast<float>(nn::float16(3.14159f)), 3.14159f, 3.14159f / 1024.0f);
+	ASSERT_TRUE(std::isnan(static_cast<float>(nn::float16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+// Test case for the 16 bit weight multiplication (single column and wide batch paths)
+TEST(HalfPrecisionTest, Multiply)
+{
+	for (const size_t cols : { static_cast<size_t>(1), static_cast<size_t>(19) })
+	{
+		nn::Matrix<float> weights(13, 21);
+		nn::Matrix<float> input(21, cols);
+		weights.randomize(-1.0f, 1.0f);
+		input.randomize(-1.0f, 1.0f);
+
+		nn::Matrix<nn::bfloat16> weights_bf16(13, 21);
+		nn::Matrix<nn::float16> weights_fp16(13, 21);
+		nn::half_precision::convert(weights, weights_bf16);
+		nn::half_precision::convert(weights, weights_fp16);
+
+		// Reference: float multiplication with the rounded weights
+		nn::Matrix<float> rounded_bf16(13, 21);
+		nn::Matrix<float> rounded_fp16(13, 21);
+		nn::half_precision::convert(weights_bf16, rounded_bf16);
+		nn::half_precision::convert(weights_fp16, rounded_fp16);
+
+		nn::Matrix<float> expected_bf16(13, cols);
+		nn::Matrix<float> expected_fp16(13, cols);
+		nn::Matrix<float>::multiply_without_avx(rounded_bf16, input, expected_bf16);
+		nn::Matrix<float>::multiply_without_avx(rounded_fp16, input, expected_fp16);
+
+		nn::Matrix<float> result(13, cols);
+		nn::half_precision::multiply(weights_bf16, input, result);
+		for (size_t i = 0; i < 13 * cols; ++i)
+		{
+			ASSERT_NEAR(result[i], expected_bf16[i], 1e-4f);
+		}
+		nn::half_precision::multiply(weights_fp16, input, result);
+		for (size_t i = 0; i < 13 * cols; ++i)
+		{
+			ASSERT_NEAR(result[i], expected_fp16[i], 1e-4f);
+		}
+	}
+}
+
+// Test case for forward propagation with reduced precision weights
+TEST(HalfPrecisionTest, LayerWeightPrecision)
+{
+	nn::DenseLayer input_layer(16, 4);
+	nn::DenseLayer layer(8, 4, 16);
+
+	nn::Matrix<float> input(16, 4);
+	input.randomize(0.0f, 1.0f);
+	input_layer.set_activations(input);
+
+	layer.feed_forward(input_layer);
+	const nn::Matrix<float> expected = layer.get_activations();
+
+	for (const auto precision : { nn::Precision::BFloat16, nn::Precision::Float16 })
+	{
+		layer.set_weight_precision(precision);
+		ASSERT_EQ(layer.get_weight_precision(), precision);
+
+		layer.feed_forward(input_layer);
+		for (size_t i = 0; i < 8 * 4; ++i)
+		{
+			ASSERT_NEAR(layer.get_activations()[i], expected[i], 0.02f);
+		}
+	}
+
+	ASSERT_THROW(input_layer.set_weight_precision(nn::Precision::BFloat16), std::runtime_error);
+}
@@ -0,0 +1,135 @@
+// File: test/HogwildTest.cpp
+// Purpose: Test file for Hogwild.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Conv2D.h>
+
+#include "TestDataSets.h"
+
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+	constexpr size_t height = 6, width = 6, batch = 4, batch_count = 8;
+
+	/// <summary>
+	/// Data set with 8 batches of random images, the output is one-hot on the brighter half of the image.
+	/// </summary>
+	std::unique_ptr<nn::test::InMemoryDataSet> make_data_set()
+	{
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(height * width, 2, batch_count, nn::test::fill_halves);
+		data_set->initialize(batch);
+		return data_set;
+	}
+
+	/// <summary>
+	/// Dense network of the given data set, with the parameters of the reference network if there is one.
+	/// </summary>
+	std::unique_ptr<nn::NeuralNetwork> make_network(const nn::test::InMemoryDataSet& data, nn::NeuralNetwork* reference)
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.5f, batch);
+		network->add_layer(std::make_unique<nn::DenseLayer>(height * width, batch));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, height * width));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 16));
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 16));
+
+		network->set_data_set(data.get_shard());
+
+		if (reference != nullptr)
+		{
+			for (auto it = reference->get_layers().begin(), other = network->get_layers().begin(); it != reference->get_layers().end(); ++it, ++other)
+			{
+				const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+				const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+				for (size_t i = 0; i < parameters.size(); ++i)
+				{
+					const nn::Matrix<float>& value = *parameters[i].value;
+					std::memcpy(other_parameters[i].value->get_data(), value.get_data(), value.get_rows() * value.get_cols() * sizeof(float));
+				}
+			}
+		}
+		return network;
+	}
+}
+
+// Test case for the segments of the parameters: whole cache lines, at most one per thread
+TEST(HogwildTest, SegmentSize)
+{
+	EXPECT_EQ(nn::hogwild::get_segment_size(1000, 4), 256u);
+	EXPECT_EQ(nn::hogwild::get_segment_size(1000, 1), 1008u);
+	EXPECT_EQ(nn::hogwild::get_segment_size(10, 4), 16u);
+	EXPECT_EQ(nn::hogwild::get_segment_size(64, 4), 16u);
+	EXPECT_EQ(nn::hogwild::get_segment_size(65, 4), 32u);
+}
+
+// Test case for one thread: the same updates as sequential training
+TEST(HogwildTest, OneThreadMatchesSequential)
+{
+	const auto data = make_data_set();
+	const auto reference = make_network(*data, nullptr);
+	const auto network = make_network(*data, reference.get());
+
+	for (int epoch = 0; epoch < 2; ++epoch)
+	{
+		const nn::hogwild::Report report = network->train_hogwild(1);
+		reference->train_one_epoch();
+		ASSERT_EQ(report.thread_batches, std::vector<size_t>{ batch_count });
+		EXPECT_EQ(report.samples, batch_count * batch);
+		EXPECT_GT(report.get_samples_per_second(), 0.0);
+	}
+
+	for (auto it = network->get_layers().begin(), other = reference->get_layers().begin(); it != network->get_layers().end(); ++it, ++other)
+	{
+		const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+		const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+		for (size_t i = 0; i < parameters.size(); ++i)
+		{
+			for (size_t j = 0; j < parameters[i].value->get_rows() * parameters[i].value->get_cols(); ++j)
+			{
+				ASSERT_FLOAT_EQ((*parameters[i].value)[j], (*other_parameters[i].value)[j]);
+			}
+		}
+	}
+}
+
+// Test case for several threads: every batch is trained once and the shared weights converge like synchronous training
+TEST(HogwildTest, Converges)
+{
+	const auto data = make_data_set();
+	const auto reference = make_network(*data, nullptr);
+	const auto network = make_network(*data, reference.get());
+	const float initial_loss = network->get_loss();
+
+	for (int epoch = 0; epoch < 20; ++epoch)
+	{
+		const nn::hogwild::Report report = network->train_hogwild(4);
+		reference->train_one_epoch();
+		ASSERT_EQ(report.thread_batches.size(), 4u);
+		EXPECT_EQ(std::accumulate(report.thread_batches.begin(), report.thread_batches.end(), size_t{ 0 }), batch_count);
+		EXPECT_EQ(report.samples, batch_count * batch);
+	}
+
+	const float loss = network->get_loss();
+	EXPECT_LT(loss, 0.5f * initial_loss);
+	EXPECT_LT(loss, 2.0f * reference->get_loss() + 0.01f);
+	EXPECT_GT(network->calculate_accuracy(), 0.9f);
+}
+
+// Test case for the networks and settings Hogwild training does not support
+TEST(HogwildTest, Unsupported)
+{
+	const auto data = make_data_set();
+	const auto network = make_network(*data, nullptr);
+	EXPECT_THROW(static_cast<void>(network->train_hogwild(0)), std::runtime_error);
+	network->set_accumulation_steps(2);
+	EXPECT_THROW(static_cast<void>(network->train_hogwild(2)), std::logic_error);
+	network->set_accumulation_steps(1);
+
+	network->get_layers().insert(std::next(network->get_layers().begin()), std::make_unique<nn::Conv2D>(1, height, width, 1, 3, batch, 1, 1));
+	EXPECT_THROW(static_cast<void>(network->train_hogwild(2)), std::runtime_error);
+}
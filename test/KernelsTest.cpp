@@ -0,0 +1,511 @@
+// File: test/KernelsTest.cpp
+// Purpose: Test file for Kernels.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/Kernels.h>
+#include <NeuralNetwork/HalfPrecision.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	std::vector<float> random_vector(const size_t size)
+	{
+		static std::mt19937 generator(42);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		std::vector<float> values(size);
+		for (float& value : values)
+		{
+			value = distribution(generator);
+		}
+		return values;
+	}
+
+	/// <summary>
+	/// Returns the built-in tables of every level this CPU supports (the scalar table first), then the BLAS table if
+	/// the library was built with one.
+	/// </summary>
+	std::vector<nn::kernels::KernelTable> get_available_tables()
+	{
+		std::vector<nn::kernels::KernelTable> tables;
+		for (int level = 0; level <= static_cast<int>(nn::kernels::detect_isa_level()); ++level)
+		{
+			tables.push_back(nn::kernels::create_kernel_table(static_cast<nn::kernels::IsaLevel>(level), false));
+		}
+		if (nn::kernels::get_blas_name() != nullptr)
+		{
+			tables.push_back(nn::kernels::create_kernel_table(nn::kernels::detect_isa_level()));
+		}
+		return tables;
+	}
+
+	const char* get_table_name(const nn::kernels::KernelTable& table)
+	{
+		return table.blas != nullptr ? table.blas : nn::kernels::get_isa_level_name(table.level);
+	}
+}
+
+// Test case for the selected table
+TEST(KernelsTest, Dispatch)
+{
+	const nn::kernels::KernelTable& kernels = nn::kernels::get_kernels();
+	ASSERT_LE(kernels.level, nn::kernels::detect_isa_level());
+	ASSERT_NE(kernels.sgemm, nullptr);
+	ASSERT_NE(kernels.sgemm_bf16, nullptr);
+	ASSERT_NE(kernels.sgemm_fp16, nullptr);
+	ASSERT_NE(kernels.hadamard, nullptr);
+	ASSERT_NE(kernels.axpy, nullptr);
+	ASSERT_NE(kernels.max_argmax, nullptr);
+	ASSERT_NE(kernels.random_mask, nullptr);
+	ASSERT_NE(kernels.masked_scale, nullptr);
+	ASSERT_NE(kernels.sigmoid, nullptr);
+	ASSERT_NE(kernels.tanh, nullptr);
+	ASSERT_NE(kernels.leaky_relu, nullptr);
+	ASSERT_NE(kernels.sigmoid_backward, nullptr);
+	ASSERT_NE(kernels.tanh_backward, nullptr);
+	ASSERT_NE(kernels.leaky_relu_backward, nullptr);
+	ASSERT_NE(kernels.dot_u8s8, nullptr);
+	ASSERT_NE(kernels.gemm_u8s8, nullptr);
+
+	ASSERT_NE(kernels.row_sums, nullptr);
+	ASSERT_NE(kernels.sgemm_nt_row_sums, nullptr);
+	ASSERT_EQ(kernels.blas == nullptr, nn::kernels::get_blas_name() == nullptr);
+	ASSERT_EQ(kernels.sgemm_tn == nullptr, kernels.blas == nullptr);
+
+	// Levels above the detected one are clamped
+	ASSERT_EQ(nn::kernels::create_kernel_table(nn::kernels::IsaLevel::AVX512).level, nn::kernels::detect_isa_level());
+	ASSERT_EQ(nn::kernels::create_kernel_table(nn::kernels::IsaLevel::Scalar, false).blas, nullptr);
+}
+
+// Test case for the float matrix multiplication of every level (sizes with tails and padded rows, narrow b,
+// several row/column/depth blocks)
+TEST(KernelsTest, Sgemm)
+{
+	const size_t shapes[][3] = { { 7, 37, 19 }, { 13, 3, 1500 }, { 20, 70, 600 }, { 1, 1, 1 }, { 5, 9, 0 } };
+	for (const auto& shape : shapes)
+	{
+		const size_t m = shape[0], n = shape[1], k = shape[2];
+		const size_t lda = k + 3, ldb = n + 5, ldc = n + 1;
+		const std::vector<float> a = random_vector(m * lda);
+		const std::vector<float> b = random_vector(k * ldb);
+
+		std::vector<float> expected(m * ldc, -1.0f);
+		for (size_t i = 0; i < m; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				double sum = 0.0;
+				for (size_t p = 0; p < k; ++p)
+				{
+					sum += static_cast<double>(a[i * lda + p]) * b[p * ldb + j];
+				}
+				expected[i * ldc + j] = static_cast<float>(sum);
+			}
+		}
+
+		for (const nn::kernels::KernelTable& kernels : get_available_tables())
+		{
+			std::vector<float> c(m * ldc, -1.0f);
+			kernels.sgemm(a.data(), b.data(), c.data(), m, n, k, lda, ldb, ldc);
+			for (size_t i = 0; i < c.size(); ++i)
+			{
+				ASSERT_NEAR(c[i], expected[i], 1e-3f) << get_table_name(kernels) << " " << m << "x" << n << "x" << k << " at " << i;
+			}
+
+			if (kernels.sgemm_tn != nullptr)
+			{
+				// The same product from transposed copies of a and b
+				std::vector<float> a_transposed(k * m), b_transposed(n * k);
+				for (size_t i = 0; i < m; ++i)
+				{
+					for (size_t p = 0; p < k; ++p)
+					{
+						a_transposed[p * m + i] = a[i * lda + p];
+					}
+				}
+				for (size_t p = 0; p < k; ++p)
+				{
+					for (size_t j = 0; j < n; ++j)
+					{
+						b_transposed[j * k + p] = b[p * ldb + j];
+					}
+				}
+
+				std::vector<float> c_tn(m * ldc, -1.0f), c_nt(m * ldc, -1.0f);
+				kernels.sgemm_tn(a_transposed.data(), b.data(), c_tn.data(), m, n, k, 2.0f, 0.0f, m, ldb, ldc);
+				kernels.sgemm_nt(a.data(), b_transposed.data(), c_nt.data(), m, n, k, 2.0f, 0.0f, lda, k, ldc);
+				for (size_t i = 0; i < m; ++i)
+				{
+					for (size_t j = 0; j < n; ++j)
+					{
+						ASSERT_NEAR(c_tn[i * ldc + j], 2.0f * expected[i * ldc + j], 2e-3f) << get_table_name(kernels);
+						ASSERT_NEAR(c_nt[i * ldc + j], 2.0f * expected[i * ldc + j], 2e-3f) << get_table_name(kernels);
+					}
+				}
+
+				// beta = 1 adds the product to c
+				kernels.sgemm_nt(a.data(), b_transposed.data(), c_nt.data(), m, n, k, 1.0f, 1.0f, lda, k, ldc);
+				for (size_t i = 0; i < m; ++i)
+				{
+					for (size_t j = 0; j < n; ++j)
+					{
+						ASSERT_NEAR(c_nt[i * ldc + j], 3.0f * expected[i * ldc + j], 3e-3f) << get_table_name(kernels);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Test case for the 16 bit weight multiplication of every level (single column and wide batch paths)
+TEST(KernelsTest, SgemmHalf)
+{
+	constexpr size_t m = 5, k = 27;
+	for (const size_t n : { static_cast<size_t>(1), static_cast<size_t>(3), static_cast<size_t>(21) })
+	{
+		const std::vector<float> a = random_vector(m * k);
+		const std::vector<float> b = random_vector(k * n);
+		std::vector<nn::bfloat16> a_bf16;
+		std::vector<nn::float16> a_fp16;
+		for (const float value : a)
+		{
+			a_bf16.emplace_back(value);
+			a_fp16.emplace_back(value);
+		}
+
+		std::vector<float> expected_bf16(m * n), expected_fp16(m * n);
+		for (size_t i = 0; i < m; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				for (size_t p = 0; p < k; ++p)
+				{
+					expected_bf16[i * n + j] += static_cast<float>(a_bf16[i * k + p]) * b[p * n + j];
+					expected_fp16[i * n + j] += static_cast<float>(a_fp16[i * k + p]) * b[p * n + j];
+				}
+			}
+		}
+
+		for (const nn::kernels::KernelTable& kernels : get_available_tables())
+		{
+			std::vector<float> c_bf16(m * n, -1.0f), c_fp16(m * n, -1.0f);
+			kernels.sgemm_bf16(a_bf16.data(), b.data(), c_bf16.data(), m, n, k);
+			kernels.sgemm_fp16(a_fp16.data(), b.data(), c_fp16.data(), m, n, k);
+			for (size_t i = 0; i < m * n; ++i)
+			{
+				ASSERT_NEAR(c_bf16[i], expected_bf16[i], 1e-4f) << get_table_name(kernels);
+				ASSERT_NEAR(c_fp16[i], expected_fp16[i], 1e-4f) << get_table_name(kernels);
+			}
+		}
+	}
+}
+
+// Test case for the element wise kernels of every level
+TEST(KernelsTest, ElementWise)
+{
+	constexpr size_t size = 53;
+	const std::vector<float> x = random_vector(size);
+	const std::vector<float> y = random_vector(size);
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<float> product = x;
+		kernels.hadamard(product.data(), y.data(), size);
+		std::vector<float> sum = x;
+		kernels.axpy(sum.data(), y.data(), -0.5f, size);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			ASSERT_FLOAT_EQ(product[i], x[i] * y[i]) << get_table_name(kernels);
+			ASSERT_NEAR(sum[i], x[i] - 0.5f * y[i], 1e-6f) << get_table_name(kernels);
+		}
+	}
+}
+
+// Test case for the max pooling step of every level
+TEST(KernelsTest, MaxArgmax)
+{
+	constexpr size_t size = 53;
+	const std::vector<float> x = random_vector(size);
+	const std::vector<float> y = random_vector(size);
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<float> max = x;
+		std::vector<uint8_t> argmax(size + 1, 0);
+		argmax[size] = 99;
+		kernels.max_argmax(max.data(), argmax.data(), y.data(), 7, size);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			ASSERT_EQ(max[i], std::max(x[i], y[i])) << get_table_name(kernels);
+			ASSERT_EQ(argmax[i], y[i] > x[i] ? 7 : 0) << get_table_name(kernels);
+		}
+		// Nothing is written past the end
+		ASSERT_EQ(argmax[size], 99) << get_table_name(kernels);
+	}
+}
+
+// Test case for the random bit masks and the masked scaling of every level (same bits at every level)
+TEST(KernelsTest, RandomMask)
+{
+	constexpr size_t size = 203, words = (size + 63) / 64;
+	constexpr uint32_t key = 0x1234567u, counter = 0xfffffff0u, threshold = 0x40000000u;
+	const std::vector<float> x = random_vector(size);
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<uint64_t> mask(words + 1, 0);
+		mask[words] = 99;
+		kernels.random_mask(mask.data(), key, counter, threshold, size);
+
+		size_t kept = 0;
+		for (size_t i = 0; i < words * 64; ++i)
+		{
+			// The counter wraps around
+			const bool expected = i < size && nn::kernels::random_bits(key ^ (counter + static_cast<uint32_t>(i))) >= threshold;
+			ASSERT_EQ((mask[i / 64] >> (i % 64)) & 1, expected ? 1u : 0u) << get_table_name(kernels) << " bit " << i;
+			kept += expected;
+		}
+		ASSERT_EQ(mask[words], 99u) << get_table_name(kernels);
+		// A quarter is dropped
+		ASSERT_NEAR(static_cast<double>(kept) / size, 0.75, 0.1);
+
+		std::vector<float> y(size + 1, 5.0f);
+		kernels.masked_scale(y.data(), x.data(), mask.data(), 2.0f, size);
+		for (size_t i = 0; i < size; ++i)
+		{
+			ASSERT_EQ(y[i], (mask[i / 64] >> (i % 64)) & 1 ? 2.0f * x[i] : 0.0f) << get_table_name(kernels);
+		}
+		ASSERT_EQ(y[size], 5.0f) << get_table_name(kernels);
+	}
+}
+
+// Test case for the row sums of every level
+TEST(KernelsTest, RowSums)
+{
+	constexpr size_t m = 9, n = 21, lda = 24;
+	const std::vector<float> a = random_vector(m * lda);
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<float> result(m, -1.0f);
+		kernels.row_sums(a.data(), result.data(), m, n, 0.5f, lda);
+		for (size_t i = 0; i < m; ++i)
+		{
+			float expected = 0.0f;
+			for (size_t j = 0; j < n; ++j)
+			{
+				expected += a[i * lda + j];
+			}
+			ASSERT_NEAR(result[i], 0.5f * expected, 1e-5f) << get_table_name(kernels);
+		}
+	}
+}
+
+// Test case for the fused weight and bias gradient of every level (tails, several row/column/depth blocks, no columns)
+TEST(KernelsTest, SgemmNtRowSums)
+{
+	const size_t shapes[][3] = { { 7, 37, 19 }, { 13, 3, 600 }, { 5, 0, 9 }, { 1, 1, 1 }, { 5, 9, 0 } };
+	for (const auto& shape : shapes)
+	{
+		const size_t m = shape[0], n = shape[1], k = shape[2];
+		const size_t lda = k + 3, ldb = k + 5, ldc = n + 1;
+		const std::vector<float> a = random_vector(m * lda);
+		const std::vector<float> b = random_vector(n * ldb);
+
+		std::vector<float> expected(m * ldc, -1.0f), expected_sums(m);
+		for (size_t i = 0; i < m; ++i)
+		{
+			double sum = 0.0;
+			for (size_t p = 0; p < k; ++p)
+			{
+				sum += a[i * lda + p];
+			}
+			expected_sums[i] = static_cast<float>(sum);
+			for (size_t j = 0; j < n; ++j)
+			{
+				double dot = 0.0;
+				for (size_t p = 0; p < k; ++p)
+				{
+					dot += static_cast<double>(a[i * lda + p]) * b[j * ldb + p];
+				}
+				expected[i * ldc + j] = static_cast<float>(dot);
+			}
+		}
+
+		for (const nn::kernels::KernelTable& kernels : get_available_tables())
+		{
+			const char* name = get_table_name(kernels);
+			std::vector<float> c(m * ldc, -1.0f), sums(m, -1.0f);
+			kernels.sgemm_nt_row_sums(a.data(), b.data(), c.data(), sums.data(), m, n, k, 0.5f, 0.0f, lda, ldb, ldc);
+			for (size_t i = 0; i < m; ++i)
+			{
+				ASSERT_NEAR(sums[i], 0.5f * expected_sums[i], 1e-3f) << name << " " << m << "x" << n << "x" << k;
+				for (size_t j = 0; j < ldc; ++j)
+				{
+					// The padding after n is left alone
+					ASSERT_NEAR(c[i * ldc + j], j < n ? 0.5f * expected[i * ldc + j] : -1.0f, 1e-3f) << name << " " << m << "x"
+						<< n << "x" << k << " at " << i << ", " << j;
+				}
+			}
+
+			// beta = 1 adds to c and the sums
+			kernels.sgemm_nt_row_sums(a.data(), b.data(), c.data(), sums.data(), m, n, k, 1.0f, 1.0f, lda, ldb, ldc);
+			for (size_t i = 0; i < m; ++i)
+			{
+				ASSERT_NEAR(sums[i], 1.5f * expected_sums[i], 2e-3f) << name;
+				for (size_t j = 0; j < n; ++j)
+				{
+					ASSERT_NEAR(c[i * ldc + j], 1.5f * expected[i * ldc + j], 2e-3f) << name;
+				}
+			}
+		}
+	}
+}
+
+// Test case for the activation kernels of every level (tails and saturated inputs included)
+TEST(KernelsTest, Activations)
+{
+	std::vector<float> x = random_vector(45);
+	for (float& value : x)
+	{
+		value *= 8.0f;
+	}
+	x[0] = 0.0f;
+	x[1] = -100.0f;
+	x[2] = 100.0f;
+	x[3] = 1e-6f;
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<float> sigmoid = x, sigmoid_derivative = x, tanh = x, tanh_derivative = x;
+		std::vector<float> relu = x, relu_derivative = x, leaky_relu = x, leaky_relu_derivative = x;
+		kernels.sigmoid(sigmoid.data(), x.size());
+		kernels.sigmoid_derivative(sigmoid_derivative.data(), x.size());
+		kernels.tanh(tanh.data(), x.size());
+		kernels.tanh_derivative(tanh_derivative.data(), x.size());
+		kernels.leaky_relu(relu.data(), 0.0f, x.size());
+		kernels.leaky_relu_derivative(relu_derivative.data(), 0.0f, x.size());
+		kernels.leaky_relu(leaky_relu.data(), 0.01f, x.size());
+		kernels.leaky_relu_derivative(leaky_relu_derivative.data(), 0.01f, x.size());
+
+		for (size_t i = 0; i < x.size(); ++i)
+		{
+			const float expected_sigmoid = 1.0f / (1.0f + std::exp(-x[i]));
+			const float expected_tanh = std::tanh(x[i]);
+			const char* name = get_table_name(kernels);
+			ASSERT_NEAR(sigmoid[i], expected_sigmoid, 1e-6f) << name << " " << x[i];
+			ASSERT_NEAR(sigmoid_derivative[i], expected_sigmoid * (1.0f - expected_sigmoid), 1e-6f) << name << " " << x[i];
+			ASSERT_NEAR(tanh[i], expected_tanh, 1e-6f) << name << " " << x[i];
+			ASSERT_NEAR(tanh_derivative[i], 1.0f - expected_tanh * expected_tanh, 1e-6f) << name << " " << x[i];
+			ASSERT_EQ(relu[i], x[i] > 0.0f ? x[i] : 0.0f) << name;
+			ASSERT_EQ(relu_derivative[i], x[i] > 0.0f ? 1.0f : 0.0f) << name;
+			ASSERT_FLOAT_EQ(leaky_relu[i], x[i] > 0.0f ? x[i] : 0.01f * x[i]) << name;
+			ASSERT_EQ(leaky_relu_derivative[i], x[i] > 0.0f ? 1.0f : 0.01f) << name;
+		}
+	}
+}
+
+// Test case for the fused backward kernels of every level (tails included): the derivative times the delta
+TEST(KernelsTest, ActivationBackward)
+{
+	std::vector<float> x = random_vector(45);
+	for (float& value : x)
+	{
+		value *= 4.0f;
+	}
+	x[0] = 0.0f;
+	const std::vector<float> delta = random_vector(x.size());
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		std::vector<float> sigmoid = x, tanh = x, relu = x;
+		kernels.sigmoid(sigmoid.data(), x.size());
+		kernels.tanh(tanh.data(), x.size());
+		kernels.leaky_relu(relu.data(), 0.0f, x.size());
+
+		std::vector<float> sigmoid_backward(x.size()), tanh_backward(x.size());
+		std::vector<float> relu_backward(x.size()), leaky_relu_backward(x.size());
+		kernels.sigmoid_backward(sigmoid_backward.data(), sigmoid.data(), delta.data(), x.size());
+		kernels.tanh_backward(tanh_backward.data(), tanh.data(), delta.data(), x.size());
+		kernels.leaky_relu_backward(relu_backward.data(), relu.data(), delta.data(), 0.0f, x.size());
+		kernels.leaky_relu_backward(leaky_relu_backward.data(), x.data(), delta.data(), 0.01f, x.size());
+
+		for (size_t i = 0; i < x.size(); ++i)
+		{
+			const float expected_sigmoid = 1.0f / (1.0f + std::exp(-x[i]));
+			const float expected_tanh = std::tanh(x[i]);
+			const char* name = get_table_name(kernels);
+			ASSERT_NEAR(sigmoid_backward[i], delta[i] * expected_sigmoid * (1.0f - expected_sigmoid), 1e-6f) << name << " " << x[i];
+			ASSERT_NEAR(tanh_backward[i], delta[i] * (1.0f - expected_tanh * expected_tanh), 1e-6f) << name << " " << x[i];
+			ASSERT_EQ(relu_backward[i], x[i] > 0.0f ? delta[i] : 0.0f) << name;
+			ASSERT_FLOAT_EQ(leaky_relu_backward[i], x[i] > 0.0f ? delta[i] : 0.01f * delta[i]) << name;
+		}
+	}
+}
+
+// Test case for the int8 dot product of every level (extreme values included)
+TEST(KernelsTest, DotProduct)
+{
+	constexpr size_t size = 192;
+	std::vector<uint8_t> activations(size);
+	std::vector<int8_t> weights(size);
+	int32_t expected = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		activations[i] = static_cast<uint8_t>(i % 3 == 0 ? 127 : (i * 37) % 128);
+		weights[i] = static_cast<int8_t>(i % 5 == 0 ? -127 : static_cast<int>((i * 53) % 255) - 127);
+		expected += static_cast<int32_t>(activations[i]) * static_cast<int32_t>(weights[i]);
+	}
+
+	for (const nn::kernels::KernelTable& kernels : get_available_tables())
+	{
+		ASSERT_EQ(kernels.dot_u8s8(activations.data(), weights.data(), size), expected) << get_table_name(kernels);
+	}
+}
+
+// Test case for the blocked int8 product of every level (partial sample and row blocks, padded rows)
+TEST(KernelsTest, GemmU8S8)
+{
+	const size_t shapes[][3] = { { 1, 1, 64 }, { 7, 5, 128 }, { 16, 33, 192 }, { 3, 10, 64 } };
+	for (const auto& shape : shapes)
+	{
+		const size_t m = shape[0], n = shape[1], k = shape[2];
+		const size_t lda = k + 64, ldb = k, ldc = n + 3;
+		std::vector<uint8_t> a(m * lda);
+		std::vector<int8_t> b(n * ldb);
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			a[i] = static_cast<uint8_t>(i % 7 == 0 ? 127 : (i * 37) % 128);
+		}
+		for (size_t i = 0; i < b.size(); ++i)
+		{
+			b[i] = static_cast<int8_t>(i % 5 == 0 ? -127 : static_cast<int>((i * 53) % 255) - 127);
+		}
+
+		std::vector<int32_t> expected(m * ldc, -1);
+		for (size_t i = 0; i < m; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				int32_t sum = 0;
+				for (size_t p = 0; p < k; ++p)
+				{
+					sum += static_cast<int32_t>(a[i * lda + p]) * static_cast<int32_t>(b[j * ldb + p]);
+				}
+				expected[i * ldc + j] = sum;
+			}
+		}
+
+		for (const nn::kernels::KernelTable& kernels : get_available_tables())
+		{
+			std::vector<int32_t> c(m * ldc, -1);
+			kernels.gemm_u8s8(a.data(), b.data(), c.data(), m, n, k, lda, ldb, ldc);
+			ASSERT_EQ(c, expected) << get_table_name(kernels) << " " << m << "x" << n << "x" << k;
+		}
+	}
+}
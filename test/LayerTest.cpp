@@ -0,0 +1,249 @@
+// File: test/LayerTest.cpp
+// Purpose: Test file for Layer.cpp, the layer interface shared by DenseLayer, Conv2D and Pool2D.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/Pool2D.h>
+
+#include "TestDataSets.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr size_t channels = 1, height = 6, width = 6, batch = 4;
+
+	/// <summary>
+	/// Data set with 2 batches of random images, the output is one-hot on the brighter half of the image.
+	/// </summary>
+	std::unique_ptr<nn::test::InMemoryDataSet> make_data_set()
+	{
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(channels * height * width, 2, 2, nn::test::fill_halves);
+		data_set->initialize(batch);
+		return data_set;
+	}
+}
+
+// Test case for the parameters every type of layer exposes
+TEST(LayerTest, Parameters)
+{
+	nn::DenseLayer input(16, batch);
+	nn::DenseLayer dense(8, batch, 16);
+	nn::Conv2D conv(1, 4, 4, 3, 3, batch, 1, 1);
+	nn::Pool2D pool(nn::PoolingMode::Max, 3, 4, 4, 2, batch);
+
+	EXPECT_TRUE(input.get_parameters().empty());
+	EXPECT_TRUE(pool.get_parameters().empty());
+
+	const std::vector<nn::Parameter> dense_parameters = dense.get_parameters();
+	ASSERT_EQ(dense_parameters.size(), 2u);
+	EXPECT_STREQ(dense_parameters[0].name, "weights");
+	EXPECT_EQ(dense_parameters[0].value, &dense.get_weights());
+	EXPECT_EQ(dense_parameters[0].gradient, &dense.get_delta_weights());
+	EXPECT_STREQ(dense_parameters[1].name, "biases");
+	EXPECT_EQ(dense_parameters[1].value, &dense.get_biases());
+
+	const std::vector<nn::Parameter> conv_parameters = conv.get_parameters();
+	ASSERT_EQ(conv_parameters.size(), 2u);
+	EXPECT_EQ(conv_parameters[0].value->get_rows(), 3u);
+	EXPECT_EQ(conv_parameters[0].value->get_cols(), 9u);
+	for (const nn::Parameter& parameter : conv_parameters)
+	{
+		EXPECT_EQ(parameter.value->get_rows(), parameter.gradient->get_rows());
+		EXPECT_EQ(parameter.value->get_cols(), parameter.gradient->get_cols());
+	}
+}
+
+// Test case for the memory requirements of the layers and of a network
+TEST(LayerTest, MemoryRequirements)
+{
+	nn::DenseLayer input(16, batch);
+	nn::DenseLayer dense(8, batch, 16);
+	nn::Pool2D pool(nn::PoolingMode::Max, 2, 4, 4, 2, batch);
+
+	const nn::MemoryRequirements input_requirements = input.get_memory_requirements();
+	EXPECT_EQ(input_requirements.parameter_bytes, 0u);
+	EXPECT_EQ(input_requirements.activation_bytes, 16 * batch * sizeof(float));
+
+	// Weights, biases and their gradients; activations and sums; delta activations and delta sums
+	const nn::MemoryRequirements dense_requirements = dense.get_memory_requirements();
+	EXPECT_EQ(dense_requirements.parameter_bytes, 2 * (8 * 16 + 8) * sizeof(float));
+	EXPECT_EQ(dense_requirements.activation_bytes, 2 * 8 * batch * sizeof(float));
+	EXPECT_EQ(dense_requirements.workspace_bytes, 2 * 8 * batch * sizeof(float));
+	EXPECT_EQ(dense_requirements.get_total_bytes(),
+		dense_requirements.parameter_bytes + dense_requirements.activation_bytes + dense_requirements.workspace_bytes);
+
+	// Half precision copies count as parameters
+	dense.set_weight_precision(nn::Precision::BFloat16);
+	EXPECT_EQ(dense.get_memory_requirements().parameter_bytes, dense_requirements.parameter_bytes + 8 * 16 * 2);
+
+	// Activations and one byte of argmax per output
+	const nn::MemoryRequirements pool_requirements = pool.get_memory_requirements();
+	EXPECT_EQ(pool_requirements.parameter_bytes, 0u);
+	EXPECT_EQ(pool_requirements.activation_bytes, 8 * batch * (sizeof(float) + 1));
+	EXPECT_EQ(pool_requirements.workspace_bytes, 8 * batch * sizeof(float));
+
+	// The im2col buffers only exist for the im2col algorithm
+	nn::Conv2D conv(2, 5, 5, 4, 3, batch, 2);
+	ASSERT_EQ(conv.get_algorithm(), nn::ConvolutionAlgorithm::Im2col);
+	const size_t column_bytes = 2 * 9 * conv.get_output_height() * conv.get_output_width() * batch * sizeof(float);
+	EXPECT_GE(conv.get_memory_requirements().activation_bytes, column_bytes);
+
+	nn::NeuralNetwork network(0.1f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(16, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 16));
+	EXPECT_EQ(network.get_memory_requirements().get_total_bytes(),
+		input_requirements.get_total_bytes() + dense_requirements.get_total_bytes());
+}
+
+// Test case for the default update of the parameters
+TEST(LayerTest, UpdateParameters)
+{
+	nn::Conv2D conv(1, 4, 4, 2, 3, batch, 1, 1);
+	const nn::Matrix<float> weights = conv.get_weights();
+	nn::Matrix<float> gradient(weights.get_rows(), weights.get_cols());
+	gradient.randomize(-1.0f, 1.0f);
+	std::memcpy(conv.get_parameters()[0].gradient->get_data(), gradient.get_data(), weights.get_rows() * weights.get_cols() * sizeof(float));
+
+	conv.update_weights_and_biases(0.5f);
+	for (size_t i = 0; i < weights.get_rows() * weights.get_cols(); ++i)
+	{
+		EXPECT_NEAR(conv.get_weights()[i], weights[i] - 0.5f * gradient[i], 1e-6f);
+	}
+}
+
+// Test case for dense layers that share their weights and biases
+TEST(LayerTest, ShareParameters)
+{
+	nn::DenseLayer layer(3, batch, 5), replica(3, batch, 5);
+	replica.share_parameters(layer);
+	EXPECT_EQ(&replica.get_weights(), &layer.get_weights());
+	EXPECT_EQ(&replica.get_biases(), &layer.get_biases());
+
+	// An update through the replica changes both, the gradients stay per layer
+	const nn::Matrix<float> weights = layer.get_weights();
+	replica.get_parameters()[0].gradient->randomize(-1.0f, 1.0f);
+	replica.update_weights_and_biases(0.5f);
+	for (size_t i = 0; i < weights.get_rows() * weights.get_cols(); ++i)
+	{
+		EXPECT_FLOAT_EQ(layer.get_weights()[i], weights[i] - 0.5f * replica.get_delta_weights()[i]);
+	}
+	EXPECT_NE(&replica.get_delta_weights(), &layer.get_delta_weights());
+
+	// Owning weights again
+	replica.set_weights(std::make_unique<nn::Matrix<float>>(weights));
+	EXPECT_NE(&replica.get_weights(), &layer.get_weights());
+	nn::DenseLayer other(3, batch, 4);
+	EXPECT_THROW(other.share_parameters(layer), std::runtime_error);
+
+	// A replica shares without randomizing and has the same activation function
+	layer.set_activation_function(std::make_unique<nn::activation_functions::ReLU>());
+	const std::unique_ptr<nn::DenseLayer> copy = layer.create_replica();
+	EXPECT_EQ(&copy->get_weights(), &layer.get_weights());
+	EXPECT_NE(&copy->get_delta_weights(), &layer.get_delta_weights());
+	EXPECT_EQ(copy->get_neuron_count(), 3u);
+	EXPECT_EQ(nn::activation_functions::get_activation_type(*copy->get_activation_function()), nn::activation_functions::ActivationType::ReLU);
+	EXPECT_EQ(nn::DenseLayer(5, batch).create_replica()->get_parameters().size(), 0u);
+}
+
+// Test case for a network of different layer types trained by the NeuralNetwork loops
+TEST(LayerTest, HeterogeneousNetwork)
+{
+	nn::NeuralNetwork network(0.5f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(channels * height * width, batch));
+	network.add_layer(std::make_unique<nn::Conv2D>(channels, height, width, 4, 3, batch, 1, 1));
+	network.add_layer(std::make_unique<nn::Pool2D>(nn::PoolingMode::Max, 4, height, width, 2, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, batch, 4 * (height / 2) * (width / 2)));
+	network.set_data_set(make_data_set());
+	ASSERT_TRUE(network.is_ready());
+
+	const float initial_loss = network.get_loss();
+	network.train(100);
+	EXPECT_LT(network.get_loss(), 0.5f * initial_loss);
+	EXPECT_FLOAT_EQ(network.calculate_accuracy(), 1.0f);
+
+	// Serialization only supports dense layers
+	EXPECT_THROW(network.save_to_file("heterogeneous_network.txt"), std::runtime_error);
+}
+
+// Test case for gradients accumulated over micro batches: the same update as one batch of all their samples
+TEST(LayerTest, GradientAccumulation)
+{
+	const auto make_network = [](const size_t batch_size)
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.5f, batch_size);
+		network->add_layer(std::make_unique<nn::DenseLayer>(channels * height * width, batch_size));
+		network->add_layer(std::make_unique<nn::Conv2D>(channels, height, width, 4, 3, batch_size, 1, 1));
+		network->add_layer(std::make_unique<nn::Pool2D>(nn::PoolingMode::Max, 4, height, width, 2, batch_size));
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch_size, 4 * (height / 2) * (width / 2)));
+		return network;
+	};
+	const auto for_each_parameter = [](nn::NeuralNetwork& first, nn::NeuralNetwork& second, const auto& function)
+	{
+		for (auto it = first.get_layers().begin(), other = second.get_layers().begin(); it != first.get_layers().end(); ++it, ++other)
+		{
+			const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+			const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+			for (size_t i = 0; i < parameters.size(); ++i)
+			{
+				function(*parameters[i].value, *other_parameters[i].value);
+			}
+		}
+	};
+	const auto copy = [](const nn::Matrix<float>& source, nn::Matrix<float>& destination)
+	{
+		std::memcpy(destination.get_data(), source.get_data(), source.get_rows() * source.get_cols() * sizeof(float));
+	};
+
+	// One epoch of the 2 micro batches side by side in one batch
+	const auto micro_batches = make_data_set();
+	const auto initial = make_network(batch);
+	const auto reference = make_network(2 * batch);
+	for_each_parameter(*initial, *reference, copy);
+	auto large_batch = std::make_unique<nn::test::InMemoryDataSet>(channels * height * width, 2, 1,
+		[&micro_batches](size_t, nn::Matrix<float>& input, nn::Matrix<float>& output)
+	{
+		for (size_t index = 0; index < 2; ++index)
+		{
+			for (size_t b = 0; b < batch; ++b)
+			{
+				for (size_t i = 0; i < channels * height * width; ++i)
+				{
+					input(i, index * batch + b) = (*micro_batches->inputs[index])(i, b);
+				}
+				for (size_t i = 0; i < 2; ++i)
+				{
+					output(i, index * batch + b) = (*micro_batches->outputs[index])(i, b);
+				}
+			}
+		}
+	});
+	large_batch->initialize(2 * batch);
+	reference->set_data_set(std::move(large_batch));
+	reference->train_one_epoch();
+
+	// With 3 steps the last group of the epoch is short: the update still uses the mean of its 2 batches
+	for (const size_t steps : { size_t{ 2 }, size_t{ 3 } })
+	{
+		const auto network = make_network(batch);
+		for_each_parameter(*initial, *network, copy);
+		network->set_data_set(micro_batches->get_shard());
+		network->set_accumulation_steps(steps);
+		EXPECT_EQ(network->get_accumulation_steps(), steps);
+		network->train_one_epoch();
+
+		for_each_parameter(*reference, *network, [](const nn::Matrix<float>& expected, const nn::Matrix<float>& actual)
+		{
+			for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+			{
+				ASSERT_NEAR(actual[i], expected[i], 1e-5f);
+			}
+		});
+	}
+
+	EXPECT_THROW(initial->set_accumulation_steps(0), std::runtime_error);
+}
@@ -3,6 +3,7 @@
 
 #include <gtest/gtest.h>
 #include <NeuralNetwork/Matrix.h>
+#include <NeuralNetwork/AllocationTracker.h>
 
 #include <vector>
 #include <iostream>
@@ -50,6 +51,47 @@ TEST(MatrixTest, CopyConstructor)
 	}
 }
 
+// Test case for move constructor and move assignment
+TEST(MatrixTest, MoveConstructorAndAssignment)
+{
+	nn::Matrix<int> matrix1(2, 3);
+	for (size_t i = 0; i < 6; ++i)
+	{
+		matrix1[i] = static_cast<int>(i) + 1;
+	}
+	const int* data = matrix1.get_data();
+
+	// The data changes owner, it is not copied
+	nn::Matrix<int> matrix2(std::move(matrix1));
+	ASSERT_EQ(matrix2.get_data(), data);
+	ASSERT_EQ(matrix2.get_rows(), 2);
+	ASSERT_EQ(matrix2.get_cols(), 3);
+	ASSERT_EQ(matrix1.get_data(), nullptr);
+	ASSERT_EQ(matrix1.get_rows(), 0);
+
+	// Move assignment takes the size of other as well
+	nn::Matrix<int> matrix3(4, 4);
+	matrix3 = std::move(matrix2);
+	ASSERT_EQ(matrix3.get_data(), data);
+	ASSERT_EQ(matrix3.get_rows(), 2);
+	ASSERT_EQ(matrix3.get_cols(), 3);
+	ASSERT_EQ(matrix3(1, 2), 6);
+	ASSERT_EQ(matrix2.get_data(), nullptr);
+
+	// The moved from matrix can be initialized again
+	ASSERT_NO_THROW(matrix1.init(1, 1));
+
+	// Growing a vector of matrices moves them
+	std::vector<nn::Matrix<int>> matrices;
+	matrices.emplace_back(2, 2);
+	const int* first = matrices.front().get_data();
+	for (int i = 0; i < 16; ++i)
+	{
+		matrices.emplace_back(2, 2);
+	}
+	ASSERT_EQ(matrices.front().get_data(), first);
+}
+
 // Test case for element access using () operator
 TEST(MatrixTest, ElementAccessOperator)
 {
@@ -106,3 +148,68 @@ TEST(MatrixTest, MatrixMultiplication) {
 		}
 	}
 }
+
+// Test case for the float back propagation products (kernels or BLAS) against the generic implementation
+TEST(MatrixTest, BackPropagationProducts)
+{
+	constexpr size_t neurons = 11, inputs = 23, batch_size = 7;
+	nn::Matrix<float> weights(neurons, inputs), delta_sums(neurons, batch_size), previous_activations(inputs, batch_size);
+	weights.randomize(-1.0f, 1.0f);
+	delta_sums.randomize(-1.0f, 1.0f);
+	previous_activations.randomize(-1.0f, 1.0f);
+
+	nn::Matrix<double> weights_d(neurons, inputs), delta_sums_d(neurons, batch_size), previous_activations_d(inputs, batch_size);
+	for (size_t i = 0; i < neurons * inputs; ++i) weights_d[i] = weights[i];
+	for (size_t i = 0; i < neurons * batch_size; ++i) delta_sums_d[i] = delta_sums[i];
+	for (size_t i = 0; i < inputs * batch_size; ++i) previous_activations_d[i] = previous_activations[i];
+
+	nn::Matrix<float> delta_activations(inputs, batch_size), delta_weights(neurons, inputs), delta_biases(neurons, 1);
+	nn::Matrix<double> delta_activations_d(inputs, batch_size), delta_weights_d(neurons, inputs), delta_biases_d(neurons, 1);
+	delta_activations.calculate_delta_activation_for_back_propagation(weights, delta_sums);
+	delta_activations_d.calculate_delta_activation_for_back_propagation(weights_d, delta_sums_d);
+	delta_weights.calculate_delta_weights_for_back_propagation(previous_activations, delta_sums);
+	delta_weights_d.calculate_delta_weights_for_back_propagation(previous_activations_d, delta_sums_d);
+	delta_biases.calculate_delta_biases_for_back_propagation(delta_sums);
+	delta_biases_d.calculate_delta_biases_for_back_propagation(delta_sums_d);
+
+	for (size_t i = 0; i < inputs * batch_size; ++i)
+	{
+		ASSERT_NEAR(delta_activations[i], delta_activations_d[i], 1e-5);
+	}
+	for (size_t i = 0; i < neurons * inputs; ++i)
+	{
+		ASSERT_NEAR(delta_weights[i], delta_weights_d[i], 1e-5);
+	}
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		ASSERT_NEAR(delta_biases[i], delta_biases_d[i], 1e-5);
+	}
+
+	// Both gradients in one sweep, overwritten and then accumulated with half the weight
+	nn::Matrix<float> fused_weights(neurons, inputs), fused_biases(neurons, 1);
+	fused_weights.calculate_delta_weights_and_biases_for_back_propagation(fused_biases, previous_activations, delta_sums);
+	for (size_t i = 0; i < neurons * inputs; ++i)
+	{
+		ASSERT_NEAR(fused_weights[i], delta_weights_d[i], 1e-5);
+	}
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		ASSERT_NEAR(fused_biases[i], delta_biases_d[i], 1e-5);
+	}
+	fused_weights.calculate_delta_weights_and_biases_for_back_propagation(fused_biases, previous_activations, delta_sums, 0.5f,
+		true);
+	{
+		// The generic implementation accumulates in place
+		const nn::memory::NoAllocationGuard guard;
+		delta_weights_d.calculate_delta_weights_and_biases_for_back_propagation(delta_biases_d, previous_activations_d, delta_sums_d,
+			0.5, true);
+	}
+	for (size_t i = 0; i < neurons * inputs; ++i)
+	{
+		ASSERT_NEAR(fused_weights[i], delta_weights_d[i], 1e-5);
+	}
+	for (size_t i = 0; i < neurons; ++i)
+	{
+		ASSERT_NEAR(fused_biases[i], delta_biases_d[i], 1e-5);
+	}
+}
@@ -0,0 +1,133 @@
+// File: test/MatrixViewTest.cpp
+// Purpose: Test file for MatrixView.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/AllocationTracker.h>
+#include <NeuralNetwork/Matrix.h>
+
+namespace
+{
+	nn::Matrix<float> make_matrix(const size_t rows, const size_t cols)
+	{
+		nn::Matrix<float> matrix(rows, cols);
+		matrix.randomize(-1.0f, 1.0f);
+		return matrix;
+	}
+}
+
+// Test case for blocks, row slices and column windows
+TEST(MatrixViewTest, Slices)
+{
+	nn::Matrix<float> matrix(4, 6);
+	for (size_t i = 0; i < 24; ++i)
+	{
+		matrix[i] = static_cast<float>(i);
+	}
+
+	const nn::MatrixView<float> view = matrix.view();
+	EXPECT_TRUE(view.is_contiguous());
+	EXPECT_EQ(view(2, 3), 15.0f);
+
+	const nn::MatrixView<float> window = view.slice_cols(2, 3);
+	EXPECT_EQ(window.get_rows(), 4u);
+	EXPECT_EQ(window.get_cols(), 3u);
+	EXPECT_EQ(window.get_stride(), 6u);
+	EXPECT_FALSE(window.is_contiguous());
+	EXPECT_EQ(window(1, 0), 8.0f);
+
+	const nn::MatrixView<const float> block = window.slice_rows(1, 2).block(1, 1, 1, 2);
+	EXPECT_EQ(block(0, 0), 15.0f);
+	EXPECT_EQ(block(0, 1), 16.0f);
+
+	// Views write to the matrix
+	window(3, 2) = -1.0f;
+	EXPECT_EQ(matrix(3, 4), -1.0f);
+
+	EXPECT_THROW(static_cast<void>(view.slice_cols(4, 3)), std::runtime_error);
+	EXPECT_THROW(nn::MatrixView<float>(matrix.get_data(), 2, 6, 5), std::runtime_error);
+}
+
+// Test case for the kernels on strided views against the same products of copies
+TEST(MatrixViewTest, KernelsOnViews)
+{
+	constexpr size_t m = 5, n = 7, k = 9;
+	const nn::Matrix<float> a = make_matrix(m + 2, k + 3);
+	const nn::Matrix<float> b = make_matrix(k + 1, n + 4);
+	nn::Matrix<float> c(m + 1, n + 2);
+	for (size_t i = 0; i < (m + 1) * (n + 2); ++i)
+	{
+		c[i] = 42.0f;
+	}
+
+	const nn::MatrixView<const float> a_view = a.view().block(1, 2, m, k);
+	const nn::MatrixView<const float> b_view = b.view().block(1, 3, k, n);
+	const nn::MatrixView<float> c_view = c.view().block(1, 1, m, n);
+
+	// Reference products of contiguous copies
+	nn::Matrix<double> a_copy(m, k), b_copy(k, n);
+	for (size_t i = 0; i < m; ++i) for (size_t p = 0; p < k; ++p) a_copy(i, p) = a_view(i, p);
+	for (size_t p = 0; p < k; ++p) for (size_t j = 0; j < n; ++j) b_copy(p, j) = b_view(p, j);
+	nn::Matrix<double> expected(m, n);
+	expected.multiply(a_copy, b_copy);
+
+	// No copies are made
+	nn::memory::reset();
+	nn::multiply(a_view, b_view, c_view);
+	EXPECT_EQ(nn::memory::get_stats().allocations, 0u);
+	for (size_t i = 0; i < m; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			ASSERT_NEAR(c_view(i, j), expected(i, j), 1e-5);
+		}
+	}
+	// The rest of c is not written
+	EXPECT_EQ(c(0, 0), 42.0f);
+	EXPECT_EQ(c(1, 0), 42.0f);
+	EXPECT_EQ(c(1, n + 1), 42.0f);
+
+	// transpose(transpose(b) * transpose(a)) == a * b, with the transposes as operands of the other products
+	nn::Matrix<float> a_transposed = a.transpose();
+	nn::Matrix<float> b_transposed = b.transpose();
+	nn::Matrix<float> result_tn(m, n), result_nt(m, n);
+	nn::multiply_transposed_a(a_transposed.view().block(2, 1, k, m), b_view, result_tn, 2.0f);
+	nn::multiply_transposed_b(a_view, b_transposed.view().block(3, 1, n, k), result_nt, 0.5f);
+	for (size_t i = 0; i < m; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			ASSERT_NEAR(result_tn(i, j), 2.0 * expected(i, j), 1e-5);
+			ASSERT_NEAR(result_nt(i, j), 0.5 * expected(i, j), 1e-5);
+		}
+	}
+
+	// Row sums into a column of a wider matrix
+	nn::Matrix<float> sums(m, 3);
+	nn::sum_rows(a_view, sums.view().slice_cols(1, 1), 0.5f);
+	for (size_t i = 0; i < m; ++i)
+	{
+		double expected_sum = 0.0;
+		for (size_t p = 0; p < k; ++p) expected_sum += a_view(i, p);
+		ASSERT_NEAR(sums(i, 1), 0.5 * expected_sum, 1e-5);
+	}
+
+	// Element wise kernels on column windows
+	nn::Matrix<float> x = make_matrix(3, 8);
+	const nn::Matrix<float> x_before = x;
+	const nn::Matrix<float> y = make_matrix(3, 8);
+	nn::hadamard_product(x.view().slice_cols(0, 4), y.view().slice_cols(4, 4));
+	nn::add_scaled(x.view().slice_cols(4, 4), y.view().slice_cols(0, 4), -2.0f);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		for (size_t j = 0; j < 4; ++j)
+		{
+			ASSERT_FLOAT_EQ(x(i, j), x_before(i, j) * y(i, j + 4));
+			ASSERT_FLOAT_EQ(x(i, j + 4), x_before(i, j + 4) - 2.0f * y(i, j));
+		}
+	}
+
+	nn::copy(y.view().slice_rows(1, 2), x.view().slice_rows(0, 2));
+	EXPECT_EQ(x(1, 7), y(2, 7));
+	EXPECT_THROW(nn::copy(y, x.view().slice_rows(0, 2)), std::runtime_error);
+	EXPECT_THROW(nn::multiply(a, b, c), std::runtime_error);
+}
@@ -0,0 +1,176 @@
+// File: test/NeuralNetworkTest.cpp
+// Purpose: Test file for NeuralNetwork.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/Pool2D.h>
+#include <NeuralNetwork/Dropout.h>
+
+#include "TestDataSets.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr size_t height = 6, width = 6, batch = 4;
+
+	/// <summary>
+	/// Data set with 3 batches of random images and random one-hot outputs.
+	/// </summary>
+	std::unique_ptr<nn::test::InMemoryDataSet> make_data_set()
+	{
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(height * width, 2, 3, nn::test::fill_random);
+		data_set->initialize(batch);
+		return data_set;
+	}
+
+	/// <summary>
+	/// Convolution, pooling and a stack of dense layers (9 layers).
+	/// </summary>
+	std::unique_ptr<nn::NeuralNetwork> make_network()
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.1f, batch);
+		network->add_layer(std::make_unique<nn::DenseLayer>(height * width, batch));
+		network->add_layer(std::make_unique<nn::Conv2D>(1, height, width, 2, 3, batch, 1, 1));
+		network->add_layer(std::make_unique<nn::Pool2D>(nn::PoolingMode::Max, 2, height, width, 2, batch));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 2 * (height / 2) * (width / 2)));
+		for (int i = 0; i < 4; ++i)
+		{
+			network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 16));
+		}
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 16));
+		return network;
+	}
+}
+
+// Test case for the checkpoints of a uniform stack and of layers that cannot be recomputed
+TEST(NeuralNetworkTest, CheckpointPlan)
+{
+	// Input and 16 dense layers: 5 segments of 3 layers between the checkpoints 0, 4, 8, 12 and 16
+	nn::NeuralNetwork network(0.1f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(8, batch));
+	for (int i = 0; i < 16; ++i)
+	{
+		network.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 8));
+	}
+	const size_t layer_bytes = network.get_layers().back()->get_memory_requirements().activation_bytes;
+	const size_t input_bytes = network.get_layers().front()->get_memory_requirements().activation_bytes;
+
+	const nn::CheckpointPlan plan = network.plan_checkpoints();
+	ASSERT_EQ(plan.checkpoints.size(), 17u);
+	EXPECT_EQ(plan.get_checkpoint_count(), 5u);
+	for (size_t i = 0; i < 17; ++i)
+	{
+		EXPECT_EQ(plan.checkpoints[i], i % 4 == 0) << i;
+	}
+	EXPECT_EQ(plan.activation_bytes, network.get_memory_requirements().activation_bytes);
+	// The checkpoints, a segment of 3 and the first layer after it
+	EXPECT_EQ(plan.peak_activation_bytes, input_bytes + 8 * layer_bytes);
+	EXPECT_EQ(plan.recomputed_layers, 12u);
+	EXPECT_TRUE(network.get_checkpoint_plan().checkpoints.empty());
+
+	// A dropout draws a new mask every feed_forward, so it is always a checkpoint, and so is the layer it passes through
+	network.add_layer(std::make_unique<nn::Dropout>(8, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 8));
+	const nn::CheckpointPlan dropout_plan = network.plan_checkpoints();
+	EXPECT_TRUE(dropout_plan.checkpoints[16]);
+	EXPECT_TRUE(dropout_plan.checkpoints[17]);
+}
+
+// Test case for a dropout with gradient checkpointing: outside training it passes the activations of the layer before
+// it through, which must not be released
+TEST(NeuralNetworkTest, GradientCheckpointingDropout)
+{
+	nn::NeuralNetwork network(0.1f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(height * width, batch));
+	for (int i = 0; i < 3; ++i)
+	{
+		network.add_layer(std::make_unique<nn::DenseLayer>(height * width, batch, height * width));
+	}
+	network.add_layer(std::make_unique<nn::Dropout>(height * width, batch));
+	network.add_layer(std::make_unique<nn::DenseLayer>(16, batch, height * width));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, batch, 16));
+	network.set_data_set(make_data_set());
+	network.set_gradient_checkpointing(true);
+	EXPECT_TRUE(network.get_checkpoint_plan().checkpoints[3]);
+
+	// Training leaves the dropout outside training
+	network.train(1);
+	const float loss = network.get_loss();
+	EXPECT_TRUE(std::isfinite(loss));
+	const nn::Matrix<float> expected = network.get_output();
+
+	// The same outputs as without checkpointing
+	network.set_gradient_checkpointing(false);
+	EXPECT_FLOAT_EQ(network.get_loss(), loss);
+	const nn::Matrix<float>& output = network.get_output();
+	for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+	{
+		EXPECT_FLOAT_EQ(output[i], expected[i]);
+	}
+}
+
+// Test case for training with gradient checkpointing: the same parameters with less activation memory
+TEST(NeuralNetworkTest, GradientCheckpointing)
+{
+	auto data_set = make_data_set();
+	auto reference_data_set = data_set->get_shard();
+
+	const auto network = make_network();
+	const auto reference = make_network();
+	for (auto it = network->get_layers().begin(), other = reference->get_layers().begin(); it != network->get_layers().end(); ++it, ++other)
+	{
+		const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+		const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+		for (size_t i = 0; i < parameters.size(); ++i)
+		{
+			const nn::Matrix<float>& value = *parameters[i].value;
+			std::memcpy(other_parameters[i].value->get_data(), value.get_data(), value.get_rows() * value.get_cols() * sizeof(float));
+		}
+	}
+	network->set_data_set(std::move(data_set));
+	reference->set_data_set(std::move(reference_data_set));
+
+	const size_t activation_bytes = network->get_memory_requirements().activation_bytes;
+	network->set_gradient_checkpointing(true);
+	const nn::CheckpointPlan& plan = network->get_checkpoint_plan();
+	EXPECT_EQ(plan.get_checkpoint_count(), 3u);
+	EXPECT_GT(plan.recomputed_layers, 0u);
+	EXPECT_LT(plan.peak_activation_bytes, plan.activation_bytes);
+
+	// The layers between the checkpoints give their activations back after feed_forward
+	network->feed_forward();
+	EXPECT_LT(network->get_memory_requirements().activation_bytes, activation_bytes);
+
+	// Recomputing allocates in every step
+	EXPECT_THROW(network->set_allocation_guard(true), std::logic_error);
+
+	network->train(3);
+	reference->train(3);
+	for (auto it = network->get_layers().begin(), other = reference->get_layers().begin(); it != network->get_layers().end(); ++it, ++other)
+	{
+		const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+		const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+		for (size_t i = 0; i < parameters.size(); ++i)
+		{
+			for (size_t j = 0; j < parameters[i].value->get_rows() * parameters[i].value->get_cols(); ++j)
+			{
+				ASSERT_FLOAT_EQ((*parameters[i].value)[j], (*other_parameters[i].value)[j]);
+			}
+		}
+	}
+	EXPECT_FLOAT_EQ(network->get_loss(), reference->get_loss());
+
+	// The plan is made for the layers it was enabled with
+	network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 2));
+	EXPECT_THROW(network->feed_forward(), std::logic_error);
+	network->set_gradient_checkpointing(false);
+	EXPECT_TRUE(network->get_checkpoint_plan().checkpoints.empty());
+	network->set_allocation_guard(true);
+	EXPECT_THROW(network->set_gradient_checkpointing(true), std::logic_error);
+}
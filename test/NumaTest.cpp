@@ -0,0 +1,120 @@
+// File: test/NumaTest.cpp
+// Purpose: Test file for Numa.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/Numa.h>
+
+#include "TestDataSets.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr size_t inputs = 12, batch = 4;
+
+	std::unique_ptr<nn::NeuralNetwork> make_network()
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.5f, batch);
+		network->add_layer(std::make_unique<nn::DenseLayer>(inputs, batch));
+		network->add_layer(std::make_unique<nn::DenseLayer>(8, batch, inputs));
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 8));
+		// Two batches of random inputs and one-hot outputs
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(inputs, 2, 2, nn::test::fill_random);
+		data_set->initialize(batch);
+		network->set_data_set(std::move(data_set));
+		return network;
+	}
+}
+
+// Test case for the Linux CPU lists of the nodes
+TEST(NumaTest, CpuList)
+{
+	EXPECT_EQ(nn::numa::parse_cpu_list("0-3,8,10-11\n"), (std::vector<size_t>{ 0, 1, 2, 3, 8, 10, 11 }));
+	EXPECT_EQ(nn::numa::parse_cpu_list("5"), std::vector<size_t>{ 5 });
+	EXPECT_TRUE(nn::numa::parse_cpu_list("").empty());
+	EXPECT_THROW(static_cast<void>(nn::numa::parse_cpu_list("a-b")), std::runtime_error);
+}
+
+// Test case for the nodes of this machine and the CPUs the workers are pinned to
+TEST(NumaTest, TopologyAndPinning)
+{
+	const nn::numa::Topology& topology = nn::numa::get_topology();
+	ASSERT_GE(topology.get_node_count(), 1u);
+	for (size_t node = 0; node < topology.get_node_count(); ++node)
+	{
+		ASSERT_FALSE(topology.node_cpus[node].empty());
+		EXPECT_EQ(topology.get_node_of_cpu(topology.node_cpus[node].front()), node);
+	}
+	EXPECT_LT(nn::numa::get_current_node(), topology.get_node_count());
+
+	// Compact fills node 0 first, scatter takes the nodes in turn
+	EXPECT_EQ(nn::numa::get_worker_cpu(0, nn::numa::Pinning::Compact), topology.node_cpus[0][0]);
+	for (size_t worker = 0; worker < 2 * topology.get_node_count(); ++worker)
+	{
+		EXPECT_EQ(topology.get_node_of_cpu(nn::numa::get_worker_cpu(worker, nn::numa::Pinning::Scatter)),
+			worker % topology.get_node_count());
+	}
+	EXPECT_THROW(static_cast<void>(nn::numa::get_worker_cpu(0, nn::numa::Pinning::None)), std::logic_error);
+
+	// Pinned Hogwild and pipeline threads train as before
+	const nn::numa::Pinning pinning = nn::numa::get_pinning();
+	nn::numa::set_pinning(nn::numa::Pinning::Compact);
+	EXPECT_EQ(nn::numa::get_pinning(), nn::numa::Pinning::Compact);
+	const auto network = make_network();
+	EXPECT_EQ(network->train_hogwild(2).samples, 2 * batch);
+	network->set_accumulation_steps(2);
+	EXPECT_EQ(network->train_pipelined(2).samples, 2 * batch);
+	nn::numa::set_pinning(pinning);
+}
+
+// Test case for moving memory to a node and finding the node of a page
+TEST(NumaTest, Placement)
+{
+	nn::Matrix<float> matrix(64, 1024);
+	std::fill_n(matrix.get_data(), 64 * 1024, 1.0f);
+	const bool placed = matrix.place_on_node(0);
+#ifdef __linux__
+	EXPECT_TRUE(placed);
+	EXPECT_EQ(nn::numa::get_memory_node(matrix.get_data() + 32 * 1024), 0u);
+#else
+	static_cast<void>(placed);
+#endif
+	EXPECT_EQ(matrix[0], 1.0f);
+	nn::utils::AlignedMemoryAllocator<float, 64> empty;
+	EXPECT_FALSE(empty.place_on_node(0));
+}
+
+// Test case for the per node copies of the weights: same outputs as the network, own memory
+TEST(NumaTest, NodeReplicas)
+{
+	const auto network = make_network();
+	network->get_data_set()->reset();
+	const nn::Matrix<float>& input = network->get_data_set()->get_batch_input();
+	network->feed_forward_with_input(input);
+	const nn::Matrix<float> expected = network->get_output();
+
+	const nn::numa::NodeReplicas replicas = network->create_node_replicas();
+	ASSERT_EQ(replicas.get_node_count(), nn::numa::get_topology().get_node_count());
+	const nn::DenseLayer& layer = nn::as_dense_layer(**std::next(network->get_layers().begin()));
+	for (size_t node = 0; node < replicas.get_node_count(); ++node)
+	{
+		const nn::DenseLayer& copy = *replicas.get_layers(node)[1];
+		EXPECT_NE(&copy.get_weights(), &layer.get_weights());
+		EXPECT_EQ(copy.get_weights()[5], layer.get_weights()[5]);
+	}
+
+	const std::vector<std::unique_ptr<nn::DenseLayer>> thread_layers = replicas.create_thread_layers();
+	const nn::Matrix<float>& output = nn::numa::feed_forward(thread_layers, input);
+	for (size_t i = 0; i < expected.get_rows() * expected.get_cols(); ++i)
+	{
+		EXPECT_FLOAT_EQ(output[i], expected[i]);
+	}
+
+	network->get_layers().insert(std::next(network->get_layers().begin()), std::make_unique<nn::Conv2D>(1, 3, 4, 1, 3, batch, 1, 1));
+	EXPECT_THROW(static_cast<void>(network->create_node_replicas()), std::runtime_error);
+}
@@ -0,0 +1,199 @@
+// File: test/PipelineTest.cpp
+// Purpose: Test file for Pipeline.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/Pool2D.h>
+#include <NeuralNetwork/Dropout.h>
+
+#include "TestDataSets.h"
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t height = 6, width = 6, batch = 4, batch_count = 5;
+
+	/// <summary>
+	/// Data set with 5 batches of random images and random one-hot outputs.
+	/// </summary>
+	std::unique_ptr<nn::test::InMemoryDataSet> make_data_set()
+	{
+		auto data_set = std::make_unique<nn::test::InMemoryDataSet>(height * width, 2, batch_count, nn::test::fill_random);
+		data_set->initialize(batch);
+		return data_set;
+	}
+
+	/// <summary>
+	/// Convolution, pooling and a stack of dense layers (9 layers).
+	/// </summary>
+	std::unique_ptr<nn::NeuralNetwork> make_network()
+	{
+		auto network = std::make_unique<nn::NeuralNetwork>(0.1f, batch);
+		network->add_layer(std::make_unique<nn::DenseLayer>(height * width, batch));
+		network->add_layer(std::make_unique<nn::Conv2D>(1, height, width, 2, 3, batch, 1, 1));
+		network->add_layer(std::make_unique<nn::Pool2D>(nn::PoolingMode::Max, 2, height, width, 2, batch));
+		network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 2 * (height / 2) * (width / 2)));
+		for (int i = 0; i < 4; ++i)
+		{
+			network->add_layer(std::make_unique<nn::DenseLayer>(16, batch, 16));
+		}
+		network->add_layer(std::make_unique<nn::DenseLayer>(2, batch, 16));
+		return network;
+	}
+
+	/// <summary>
+	/// Copies the parameters of one network into another of the same layers.
+	/// </summary>
+	void copy_parameters(nn::NeuralNetwork& from, nn::NeuralNetwork& to)
+	{
+		for (auto it = from.get_layers().begin(), other = to.get_layers().begin(); it != from.get_layers().end(); ++it, ++other)
+		{
+			const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+			const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+			for (size_t i = 0; i < parameters.size(); ++i)
+			{
+				const nn::Matrix<float>& value = *parameters[i].value;
+				std::memcpy(other_parameters[i].value->get_data(), value.get_data(), value.get_rows() * value.get_cols() * sizeof(float));
+			}
+		}
+	}
+}
+
+// Test case for the capacity, the full and empty queue and the order of the items between two threads
+TEST(PipelineTest, SpscQueue)
+{
+	nn::pipeline::SpscQueue<size_t> queue(5);
+	ASSERT_EQ(queue.get_capacity(), 8u);
+	size_t item = 0;
+	EXPECT_FALSE(queue.try_pop(item));
+	for (size_t i = 0; i < 8; ++i)
+	{
+		EXPECT_TRUE(queue.try_push(i));
+	}
+	EXPECT_FALSE(queue.try_push(8));
+	ASSERT_TRUE(queue.try_pop(item));
+	EXPECT_EQ(item, 0u);
+	EXPECT_TRUE(queue.try_push(8));
+	for (size_t i = 1; i <= 8; ++i)
+	{
+		ASSERT_TRUE(queue.try_pop(item));
+		EXPECT_EQ(item, i);
+	}
+
+	constexpr size_t count = 100000;
+	std::thread producer([&queue]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			while (!queue.try_push(i))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+	for (size_t i = 0; i < count; ++i)
+	{
+		while (!queue.try_pop(item))
+		{
+			std::this_thread::yield();
+		}
+		ASSERT_EQ(item, i);
+	}
+	producer.join();
+}
+
+// Test case for the stages of a uniform stack and the invalid stage counts
+TEST(PipelineTest, StagePlan)
+{
+	// Input and 16 dense layers: 4 stages of 4 layers
+	nn::NeuralNetwork network(0.1f, batch);
+	network.add_layer(std::make_unique<nn::DenseLayer>(8, batch));
+	for (int i = 0; i < 16; ++i)
+	{
+		network.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 8));
+	}
+	EXPECT_EQ(network.plan_pipeline_stages(4), (std::vector<size_t>{ 0, 5, 9, 13 }));
+	EXPECT_EQ(network.plan_pipeline_stages(1), (std::vector<size_t>{ 0 }));
+	EXPECT_EQ(network.plan_pipeline_stages(16).back(), 16u);
+	EXPECT_THROW(static_cast<void>(network.plan_pipeline_stages(0)), std::runtime_error);
+	EXPECT_THROW(static_cast<void>(network.plan_pipeline_stages(17)), std::runtime_error);
+
+	// A wide layer gets a stage of its own
+	nn::NeuralNetwork wide(0.1f, batch);
+	wide.add_layer(std::make_unique<nn::DenseLayer>(8, batch));
+	wide.add_layer(std::make_unique<nn::DenseLayer>(256, batch, 8));
+	wide.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 256));
+	for (int i = 0; i < 4; ++i)
+	{
+		wide.add_layer(std::make_unique<nn::DenseLayer>(8, batch, 8));
+	}
+	EXPECT_EQ(wide.plan_pipeline_stages(3), (std::vector<size_t>{ 0, 2, 3 }));
+}
+
+// Test case for pipelined training: the same parameters as sequential gradient accumulation for both schedules
+TEST(PipelineTest, MatchesGradientAccumulation)
+{
+	for (const auto schedule : { nn::pipeline::Schedule::GPipe, nn::pipeline::Schedule::OneForwardOneBackward })
+	{
+		for (const size_t stage_count : { 1, 3, 8 })
+		{
+			auto data_set = make_data_set();
+			auto reference_data_set = data_set->get_shard();
+
+			const auto network = make_network();
+			const auto reference = make_network();
+			copy_parameters(*network, *reference);
+			network->set_data_set(std::move(data_set));
+			reference->set_data_set(std::move(reference_data_set));
+			// 5 batches: two steps of 2 micro batches and a short one
+			network->set_accumulation_steps(2);
+			reference->set_accumulation_steps(2);
+
+			for (int epoch = 0; epoch < 2; ++epoch)
+			{
+				const nn::pipeline::Report report = network->train_pipelined(stage_count, schedule);
+				reference->train_one_epoch();
+
+				ASSERT_EQ(report.stage_first_layers.size(), stage_count);
+				ASSERT_EQ(report.stage_busy_seconds.size(), stage_count);
+				EXPECT_EQ(report.stage_first_layers.front(), 0u);
+				EXPECT_EQ(report.micro_batches, 2u);
+				EXPECT_EQ(report.samples, batch_count * batch);
+				EXPECT_GT(report.seconds, 0.0);
+				EXPECT_GT(report.get_samples_per_second(), 0.0);
+				EXPECT_GE(report.get_bubble_fraction(), 0.0);
+				EXPECT_LT(report.get_bubble_fraction(), 1.0);
+				EXPECT_DOUBLE_EQ(report.get_ideal_bubble_fraction(), static_cast<double>(stage_count - 1) / static_cast<double>(stage_count + 1));
+			}
+
+			for (auto it = network->get_layers().begin(), other = reference->get_layers().begin(); it != network->get_layers().end(); ++it, ++other)
+			{
+				const std::vector<nn::Parameter> parameters = (*it)->get_parameters();
+				const std::vector<nn::Parameter> other_parameters = (*other)->get_parameters();
+				for (size_t i = 0; i < parameters.size(); ++i)
+				{
+					for (size_t j = 0; j < parameters[i].value->get_rows() * parameters[i].value->get_cols(); ++j)
+					{
+						ASSERT_FLOAT_EQ((*parameters[i].value)[j], (*other_parameters[i].value)[j]) << stage_count;
+					}
+				}
+			}
+			EXPECT_FLOAT_EQ(network->get_loss(), reference->get_loss());
+		}
+	}
+}
+
+// Test case for the layers pipelined training cannot recompute
+TEST(PipelineTest, RequiresRecomputableLayers)
+{
+	const auto network = make_network();
+	network->set_data_set(make_data_set());
+	network->get_layers().insert(std::prev(network->get_layers().end()), std::make_unique<nn::Dropout>(16, batch));
+	EXPECT_THROW(static_cast<void>(network->train_pipelined(2)), std::logic_error);
+}
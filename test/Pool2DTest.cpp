@@ -0,0 +1,169 @@
+// File: test/Pool2DTest.cpp
+// Purpose: Test file for Pool2D.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/Conv2D.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Pool2D.h>
+
+#include <memory>
+
+namespace
+{
+	constexpr size_t channels = 2, height = 7, width = 6, batch = 5;
+
+	std::unique_ptr<nn::Layer> make_input()
+	{
+		auto input = std::make_unique<nn::DenseLayer>(channels * height * width, batch);
+		nn::Matrix<float> activations(channels * height * width, batch);
+		activations.randomize(-1.0f, 1.0f);
+		input->set_activations(activations);
+		return input;
+	}
+
+	float input_at(const nn::Matrix<float>& input, const size_t c, const size_t y, const size_t x, const size_t b)
+	{
+		return input((c * height + y) * width + x, b);
+	}
+}
+
+// Test case for max and average pooling against the definition, with and without overlapping windows
+TEST(Pool2DTest, FeedForward)
+{
+	const auto input_layer = make_input();
+	const nn::Matrix<float>& input = input_layer->get_activations();
+
+	for (const size_t stride : { 1u, 2u, 3u })
+	{
+		nn::Pool2D max_pool(nn::PoolingMode::Max, channels, height, width, 3, batch, stride);
+		nn::Pool2D average_pool(nn::PoolingMode::Average, channels, height, width, 3, batch, stride);
+		ASSERT_EQ(max_pool.get_output_height(), (height - 3) / stride + 1);
+		ASSERT_EQ(max_pool.get_output_width(), (width - 3) / stride + 1);
+		max_pool.feed_forward(*input_layer);
+		average_pool.feed_forward(*input_layer);
+
+		const size_t oh = max_pool.get_output_height(), ow = max_pool.get_output_width();
+		for (size_t c = 0; c < channels; ++c)
+		for (size_t oy = 0; oy < oh; ++oy)
+		for (size_t ox = 0; ox < ow; ++ox)
+		for (size_t b = 0; b < batch; ++b)
+		{
+			float max = input_at(input, c, oy * stride, ox * stride, b);
+			size_t argmax = 0;
+			float sum = 0.0f;
+			for (size_t position = 0; position < 9; ++position)
+			{
+				const float value = input_at(input, c, oy * stride + position / 3, ox * stride + position % 3, b);
+				sum += value;
+				if (value > max)
+				{
+					max = value;
+					argmax = position;
+				}
+			}
+
+			const size_t row = (c * oh + oy) * ow + ox;
+			EXPECT_EQ(max_pool.get_activations()(row, b), max);
+			EXPECT_EQ(max_pool.get_argmax()(row, b), argmax);
+			EXPECT_NEAR(average_pool.get_activations()(row, b), sum / 9.0f, 1e-6f);
+		}
+	}
+
+	EXPECT_THROW(static_cast<void>(nn::Pool2D(nn::PoolingMode::Average, channels, height, width, 3, batch).get_argmax()), std::runtime_error);
+	EXPECT_THROW(nn::Pool2D(nn::PoolingMode::Max, channels, 2, 2, 3, batch), std::runtime_error);
+}
+
+// Test case for the delta routed back through max pooling and spread back through average pooling
+TEST(Pool2DTest, BackPropagate)
+{
+	const auto input_layer = make_input();
+	const nn::Matrix<float>& input = input_layer->get_activations();
+
+	for (const size_t stride : { 1u, 2u })
+	{
+		for (const nn::PoolingMode mode : { nn::PoolingMode::Max, nn::PoolingMode::Average })
+		{
+			nn::Pool2D pool(mode, channels, height, width, 2, batch, stride);
+			pool.feed_forward(*input_layer);
+			nn::Matrix<float> expected(pool.get_neuron_count(), batch);
+			expected.randomize(-1.0f, 1.0f);
+			pool.back_propagate(expected, *input_layer);
+
+			nn::Matrix<float> previous_delta(channels * height * width, batch);
+			pool.propagate_delta_to_previous_layer(previous_delta);
+
+			// Reference: d activation / d input of every window
+			nn::Matrix<float> reference(channels * height * width, batch);
+			for (size_t i = 0; i < reference.get_rows() * reference.get_cols(); ++i)
+			{
+				reference[i] = 0.0f;
+			}
+			const size_t oh = pool.get_output_height(), ow = pool.get_output_width();
+			for (size_t c = 0; c < channels; ++c)
+			for (size_t oy = 0; oy < oh; ++oy)
+			for (size_t ox = 0; ox < ow; ++ox)
+			for (size_t b = 0; b < batch; ++b)
+			{
+				const float delta = pool.get_delta_activations()((c * oh + oy) * ow + ox, b);
+				const float activation = pool.get_activations()((c * oh + oy) * ow + ox, b);
+				bool routed = false;
+				for (size_t position = 0; position < 4; ++position)
+				{
+					const size_t y = oy * stride + position / 2, x = ox * stride + position % 2;
+					if (mode == nn::PoolingMode::Average)
+					{
+						reference((c * height + y) * width + x, b) += delta / 4.0f;
+					}
+					else if (!routed && input_at(input, c, y, x, b) == activation)
+					{
+						reference((c * height + y) * width + x, b) += delta;
+						routed = true;
+					}
+				}
+			}
+
+			for (size_t i = 0; i < reference.get_rows() * reference.get_cols(); ++i)
+			{
+				EXPECT_NEAR(previous_delta[i], reference[i], 1e-5f);
+			}
+		}
+	}
+}
+
+// Test case for a convolution, max pooling and a dense layer learning a fixed target
+TEST(Pool2DTest, TrainsInChain)
+{
+	const auto input_layer = make_input();
+	nn::Conv2D conv(channels, height, width, 4, 3, batch, 1, 1);
+	nn::Pool2D pool(nn::PoolingMode::Max, 4, conv.get_output_height(), conv.get_output_width(), 2, batch);
+	nn::DenseLayer output(2, batch, pool.get_neuron_count());
+	nn::Matrix<float> expected(2, batch);
+	expected.randomize(0.2f, 0.8f);
+
+	const auto step = [&]()
+	{
+		conv.feed_forward(*input_layer);
+		pool.feed_forward(conv);
+		output.feed_forward(pool);
+		float loss = 0.0f;
+		for (size_t i = 0; i < 2 * batch; ++i)
+		{
+			loss += (output.get_activations()[i] - expected[i]) * (output.get_activations()[i] - expected[i]);
+		}
+		output.back_propagate(expected, pool);
+		pool.back_propagate(output, conv);
+		conv.back_propagate(pool, *input_layer);
+		output.update_weights_and_biases(0.5f);
+		pool.update_weights_and_biases(0.5f);
+		conv.update_weights_and_biases(0.5f);
+		return loss;
+	};
+
+	const float initial_loss = step();
+	float final_loss = initial_loss;
+	for (int i = 0; i < 100; ++i)
+	{
+		final_loss = step();
+	}
+	EXPECT_LT(final_loss, 0.1f * initial_loss);
+}
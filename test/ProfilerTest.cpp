@@ -0,0 +1,150 @@
+// File: test/ProfilerTest.cpp
+// Purpose: Test file for Profiler.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/NeuralNetwork.h>
+#include <NeuralNetwork/DenseLayer.h>
+#include <NeuralNetwork/Profiler.h>
+
+#include "TestDataSets.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	size_t count_events(const std::vector<nn::profiler::Event>& events, const char* name, const int layer)
+	{
+		return static_cast<size_t>(std::count_if(events.begin(), events.end(), [name, layer](const nn::profiler::Event& event)
+		{
+			return std::strcmp(event.name, name) == 0 && event.layer == layer;
+		}));
+	}
+}
+
+// Test case for nesting, layers, work counters and the per thread buffers
+TEST(ProfilerTest, ScopedEvents)
+{
+	nn::profiler::reset();
+
+	{
+		const nn::profiler::ScopedEvent outer("outer", 3);
+		nn::profiler::add_work(1, 2);
+		{
+			const nn::profiler::ScopedEvent inner("inner");
+			nn::profiler::add_work(10, 20);
+		}
+	}
+	{
+		const nn::profiler::ScopedEvent outside("outside");
+	}
+
+	// More events than fit in one chunk, on several threads
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([]()
+		{
+			for (int i = 0; i < 5000; ++i)
+			{
+				const nn::profiler::ScopedEvent event("worker", 7);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	const std::vector<nn::profiler::Event> events = nn::profiler::get_events();
+	ASSERT_EQ(events.size(), 3u + 4u * 5000u);
+	EXPECT_EQ(count_events(events, "worker", 7), 4u * 5000u);
+
+	// The enclosing scope comes first and the inner scope inherits its layer
+	const auto outer = std::find_if(events.begin(), events.end(), [](const nn::profiler::Event& e) { return std::strcmp(e.name, "outer") == 0; });
+	ASSERT_NE(outer, events.end());
+	const auto inner = std::next(outer);
+	EXPECT_STREQ(inner->name, "inner");
+	EXPECT_EQ(outer->layer, 3);
+	EXPECT_EQ(outer->depth, 0u);
+	EXPECT_EQ(inner->layer, 3);
+	EXPECT_EQ(inner->depth, 1u);
+	EXPECT_GE(inner->start, outer->start);
+	EXPECT_LE(inner->start + inner->duration, outer->start + outer->duration);
+	EXPECT_EQ(inner->flop, 10u);
+	EXPECT_EQ(inner->bytes, 20u);
+	EXPECT_EQ(outer->flop, 11u);
+	EXPECT_EQ(outer->bytes, 22u);
+	EXPECT_EQ(count_events(events, "outside", -1), 1u);
+
+	std::ostringstream trace;
+	nn::profiler::write_chrome_trace(trace);
+	EXPECT_NE(trace.str().find("\"traceEvents\""), std::string::npos);
+	EXPECT_NE(trace.str().find("{\"name\":\"inner\",\"cat\":\"layer\",\"ph\":\"X\""), std::string::npos);
+
+	std::ostringstream summary;
+	nn::profiler::write_summary(summary);
+	EXPECT_NE(summary.str().find("worker"), std::string::npos);
+	EXPECT_NE(summary.str().find("  inner"), std::string::npos);
+
+	nn::profiler::reset();
+	EXPECT_TRUE(nn::profiler::get_events().empty());
+}
+
+// Test case for the instrumentation of training and the roofline report (only recorded when built with NN_ENABLE_PROFILER)
+TEST(ProfilerTest, TrainingInstrumentation)
+{
+	nn::profiler::reset();
+
+	nn::NeuralNetwork network(0.1f, 2);
+	network.add_layer(std::make_unique<nn::DenseLayer>(4, 2));
+	network.add_layer(std::make_unique<nn::DenseLayer>(3, 2, 4));
+	network.add_layer(std::make_unique<nn::DenseLayer>(2, 2, 3));
+	auto data_set = std::make_unique<nn::test::InMemoryDataSet>(4, 2, 2, nn::test::fill_constant);
+	data_set->initialize(2);
+	network.set_data_set(std::move(data_set));
+	network.train_one_epoch();
+
+	const std::vector<nn::profiler::Event> events = nn::profiler::get_events();
+	if (!nn::profiler::enabled)
+	{
+		EXPECT_TRUE(events.empty());
+		return;
+	}
+
+	EXPECT_EQ(count_events(events, "epoch", -1), 1u);
+	EXPECT_EQ(count_events(events, "batch", -1), 2u);
+	EXPECT_EQ(count_events(events, "data_set/get_batch_input", 0), 2u);
+	EXPECT_EQ(count_events(events, "data_set/get_batch_output", 2), 2u);
+	for (int layer = 1; layer <= 2; ++layer)
+	{
+		EXPECT_EQ(count_events(events, "feed_forward", layer), 2u);
+		EXPECT_EQ(count_events(events, "sums", layer), 2u);
+		EXPECT_EQ(count_events(events, "activation", layer), 2u);
+		EXPECT_EQ(count_events(events, "back_propagate", layer), 2u);
+		EXPECT_EQ(count_events(events, "delta_weights", layer), 2u);
+		EXPECT_EQ(count_events(events, "update_weights_and_biases", layer), 2u);
+	}
+
+	// sums = weights * input + biases of the 3 x 4 layer for 2 samples
+	for (const nn::profiler::Event& event : events)
+	{
+		if (std::strcmp(event.name, "sums") == 0 && event.layer == 1)
+		{
+			EXPECT_EQ(event.flop, 2u * 3u * 4u * 2u + 3u * 2u);
+		}
+	}
+
+	const nn::profiler::MachinePeaks peaks{ 1e10, 1e9, 1e10 };
+	std::ostringstream roofline;
+	nn::profiler::write_roofline(roofline, peaks);
+	EXPECT_NE(roofline.str().find("epoch 1"), std::string::npos);
+	EXPECT_NE(roofline.str().find("layer 2"), std::string::npos);
+	EXPECT_NE(roofline.str().find("delta_weights"), std::string::npos);
+
+	nn::profiler::reset();
+}
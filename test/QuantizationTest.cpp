@@ -0,0 +1,95 @@
+// File: test/QuantizationTest.cpp
+// Purpose: Test file for Quantization.cpp.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/Quantization.h>
+
+#include "TestDataSets.h"
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Test case for the SIMD dot product against a scalar reference
+TEST(QuantizationTest, DotProduct)
+{
+	std::mt19937 engine(7);
+	std::uniform_int_distribution<int> activation_distribution(0, 127);
+	std::uniform_int_distribution<int> weight_distribution(-127, 127);
+
+	std::vector<uint8_t> activations(192);
+	std::vector<int8_t> weights(192);
+	int32_t expected = 0;
+	for (size_t i = 0; i < activations.size(); ++i)
+	{
+		activations[i] = static_cast<uint8_t>(activation_distribution(engine));
+		weights[i] = static_cast<int8_t>(weight_distribution(engine));
+		expected += activations[i] * weights[i];
+	}
+
+	ASSERT_EQ(nn::quantization::dot_product(activations.data(), weights.data(), activations.size()), expected);
+}
+
+// Test case for the activation quantization parameters
+TEST(QuantizationTest, ActivationQuantization)
+{
+	const auto quantization = nn::quantization::ActivationQuantization::from_range(-1.0f, 3.0f);
+
+	ASSERT_NEAR(quantization.scale, 4.0f / 127.0f, 1e-6f);
+	ASSERT_EQ(quantization.quantize(-5.0f), 0);
+	ASSERT_EQ(quantization.quantize(5.0f), 127);
+	ASSERT_EQ(quantization.quantize(0.0f), quantization.zero_point);
+	ASSERT_NEAR(quantization.scale * (quantization.quantize(1.5f) - quantization.zero_point), 1.5f, quantization.scale);
+}
+
+// Test case for the quantized network matching the float network
+TEST(QuantizationTest, MatchesFloatNetwork)
+{
+	constexpr size_t batch_size = 8;
+
+	nn::NeuralNetwork network(0.1f, batch_size);
+	network.add_layer(std::make_unique<nn::DenseLayer>(100, batch_size));
+	network.add_layer(std::make_unique<nn::DenseLayer>(32, batch_size, 100, std::make_unique<nn::activation_functions::ReLU>()));
+	network.add_layer(std::make_unique<nn::DenseLayer>(10, batch_size, 32));
+
+	// Random inputs in [0, 1] and one-hot outputs
+	nn::test::InMemoryDataSet data_set(100, 10, 4, nn::test::make_seeded_generator(42));
+	data_set.initialize(batch_size);
+
+	nn::quantization::Calibration calibration;
+	calibration.calibrate(network, data_set);
+	ASSERT_EQ(calibration.get_layer_count(), 3);
+
+	for (const auto granularity : { nn::quantization::ScaleGranularity::PerLayer, nn::quantization::ScaleGranularity::PerRow })
+	{
+		nn::quantization::QuantizedNetwork quantized_network;
+		quantized_network.quantize(network, calibration, granularity);
+
+		float total_error = 0.0f;
+		size_t count = 0;
+
+		data_set.reset();
+		while (!data_set.is_end())
+		{
+			network.feed_forward_with_input(data_set.get_batch_input());
+			const auto& output = quantized_network.feed_forward(data_set.get_batch_input());
+
+			ASSERT_EQ(output.get_rows(), 10);
+			ASSERT_EQ(output.get_cols(), batch_size);
+			for (size_t i = 0; i < output.get_rows() * output.get_cols(); ++i)
+			{
+				// Untrained weights in [-1, 1] give wide activation ranges, so allow a few quantization steps per output.
+				ASSERT_NEAR(output[i], network.get_output()[i], 0.2f);
+				total_error += std::abs(output[i] - network.get_output()[i]);
+				++count;
+			}
+			data_set.go_to_next_batch();
+		}
+		ASSERT_LT(total_error / static_cast<float>(count), 0.02f);
+
+		const float accuracy = quantized_network.calculate_accuracy(data_set);
+		ASSERT_GE(accuracy, 0.0f);
+		ASSERT_LE(accuracy, 1.0f);
+	}
+}
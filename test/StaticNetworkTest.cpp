@@ -0,0 +1,144 @@
+// File: test/StaticNetworkTest.cpp
+// Purpose: Test file for StaticNetwork.h.
+
+#include <gtest/gtest.h>
+#include <NeuralNetwork/StaticNetwork.h>
+
+#include <array>
+#include <type_traits>
+#include <memory>
+#include <vector>
+
+// Builds a dynamic 4-8-3 network with batch size 1
+static void setup_dynamic_network(nn::NeuralNetwork& network)
+{
+	network.add_layer(std::make_unique<nn::DenseLayer>(4, 1));
+	network.add_layer(std::make_unique<nn::DenseLayer>(8, 1, 4, std::make_unique<nn::activation_functions::Tanh>()));
+	network.add_layer(std::make_unique<nn::DenseLayer>(3, 1, 8, std::make_unique<nn::activation_functions::SoftMax>()));
+}
+
+// Test case for the compile time sizes of the network
+TEST(StaticNetworkTest, CompileTimeSizes)
+{
+	using Network = nn::StaticNetwork<784, 64, 64, 10>;
+
+	static_assert(Network::layer_count == 4);
+	static_assert(Network::input_size == 784);
+	static_assert(Network::output_size == 10);
+	static_assert(std::is_same_v<Network::layer_type<0>, nn::StaticLayer<64, 784>>);
+	static_assert(std::is_same_v<Network::layer_type<2>, nn::StaticLayer<10, 64>>);
+	SUCCEED();
+}
+
+// Test case for inference matching the dynamic network
+TEST(StaticNetworkTest, MatchesDynamicNetwork)
+{
+	nn::NeuralNetwork dynamic_network(0.1f, 1);
+	setup_dynamic_network(dynamic_network);
+
+	auto static_network = std::make_unique<nn::StaticNetwork<4, 8, 3>>();
+	ASSERT_NO_THROW(static_network->load_from(dynamic_network));
+
+	const std::array<float, 4> input = { 0.1f, -0.5f, 0.25f, 0.9f };
+	dynamic_network.feed_forward_with_input(nn::Matrix<float>(std::vector<float>(input.begin(), input.end()), 4, 1));
+	const auto& output = static_network->feed_forward(input);
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		ASSERT_NEAR(output[i], dynamic_network.get_output()(i, 0), 1e-5f);
+	}
+	ASSERT_EQ(static_network->get_layer<1>().get_activation_type(), nn::activation_functions::ActivationType::SoftMax);
+}
+
+// Test case for storing the parameters back into a dynamic network
+TEST(StaticNetworkTest, StoreToDynamicNetwork)
+{
+	nn::NeuralNetwork source(0.1f, 1);
+	setup_dynamic_network(source);
+	nn::NeuralNetwork destination(0.1f, 1);
+	setup_dynamic_network(destination);
+
+	nn::StaticNetwork<4, 8, 3> static_network;
+	static_network.load_from(source);
+	static_network.store_to(destination);
+
+	auto source_it = source.get_layers().begin();
+	auto destination_it = destination.get_layers().begin();
+	for (++source_it, ++destination_it; source_it != source.get_layers().end(); ++source_it, ++destination_it)
+	{
+		const nn::DenseLayer& source_layer = nn::as_dense_layer(**source_it);
+		const nn::DenseLayer& destination_layer = nn::as_dense_layer(**destination_it);
+		const auto& source_weights = source_layer.get_weights();
+		const auto& destination_weights = destination_layer.get_weights();
+		for (size_t i = 0; i < source_weights.get_rows() * source_weights.get_cols(); ++i)
+		{
+			ASSERT_EQ(source_weights[i], destination_weights[i]);
+		}
+		for (size_t i = 0; i < source_weights.get_rows(); ++i)
+		{
+			ASSERT_EQ(source_layer.get_biases()[i], destination_layer.get_biases()[i]);
+		}
+	}
+}
+
+// Test case for a round trip through a static network into a network with the default activation functions
+TEST(StaticNetworkTest, StoreRoundTripActivations)
+{
+	nn::NeuralNetwork source(0.1f, 1);
+	setup_dynamic_network(source);
+	nn::NeuralNetwork destination(0.1f, 1);
+	destination.add_layer(std::make_unique<nn::DenseLayer>(4, 1));
+	destination.add_layer(std::make_unique<nn::DenseLayer>(8, 1, 4));
+	destination.add_layer(std::make_unique<nn::DenseLayer>(3, 1, 8));
+
+	nn::StaticNetwork<4, 8, 3> static_network;
+	static_network.load_from(source);
+	static_network.store_to(destination);
+	const nn::DenseLayer& hidden = nn::as_dense_layer(**std::next(destination.get_layers().begin()));
+	const nn::DenseLayer& output = nn::as_dense_layer(*destination.get_layers().back());
+	EXPECT_EQ(nn::activation_functions::get_activation_type(*hidden.get_activation_function()),
+		nn::activation_functions::ActivationType::Tanh);
+	EXPECT_EQ(nn::activation_functions::get_activation_type(*output.get_activation_function()),
+		nn::activation_functions::ActivationType::SoftMax);
+
+	const nn::Matrix<float> input(std::vector<float>{ 0.1f, -0.5f, 0.25f, 0.9f }, 4, 1);
+	source.feed_forward_with_input(input);
+	destination.feed_forward_with_input(input);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		ASSERT_EQ(destination.get_output()(i, 0), source.get_output()(i, 0));
+	}
+}
+
+// Test case for storing into a network whose last layer differs: nothing is written
+TEST(StaticNetworkTest, StoreToMismatchedNetwork)
+{
+	nn::NeuralNetwork source(0.1f, 1);
+	setup_dynamic_network(source);
+	nn::NeuralNetwork destination(0.1f, 1);
+	destination.add_layer(std::make_unique<nn::DenseLayer>(4, 1));
+	destination.add_layer(std::make_unique<nn::DenseLayer>(8, 1, 4));
+	destination.add_layer(std::make_unique<nn::DenseLayer>(5, 1, 8));
+	const nn::DenseLayer& hidden = nn::as_dense_layer(**std::next(destination.get_layers().begin()));
+	const nn::Matrix<float> weights = hidden.get_weights();
+
+	nn::StaticNetwork<4, 8, 3> static_network;
+	static_network.load_from(source);
+	ASSERT_THROW(static_network.store_to(destination), std::runtime_error);
+	for (size_t i = 0; i < weights.get_rows() * weights.get_cols(); ++i)
+	{
+		ASSERT_EQ(hidden.get_weights()[i], weights[i]);
+	}
+	EXPECT_EQ(nn::activation_functions::get_activation_type(*hidden.get_activation_function()),
+		nn::activation_functions::ActivationType::Sigmoid);
+}
+
+// Test case for loading from a network with a different topology
+TEST(StaticNetworkTest, LoadFromMismatchedNetwork)
+{
+	nn::NeuralNetwork dynamic_network(0.1f, 1);
+	setup_dynamic_network(dynamic_network);
+
+	nn::StaticNetwork<4, 6, 3> static_network;
+	ASSERT_THROW(static_network.load_from(dynamic_network), std::runtime_error);
+}
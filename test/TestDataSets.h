@@ -0,0 +1,153 @@
+// File: test/TestDataSets.h
+// Purpose: In-memory data sets shared by the tests.
+
+#pragma once
+
+#include <NeuralNetwork/DataSet.h>
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace nn::test
+{
+	/// <summary>
+	/// Fills the input and output of batch index (input size x batch size and output size x batch size).
+	/// </summary>
+	using BatchGenerator = std::function<void(size_t index, nn::Matrix<float>& input, nn::Matrix<float>& output)>;
+
+	/// <summary>
+	/// Data set of batch_count batches held in memory, filled by a generator when it is initialized. The batches are
+	///	shared, so copies and shards of a data set cost no copy of the data.
+	/// </summary>
+	class InMemoryDataSet final : public nn::DataSet
+	{
+	public:
+		std::vector<std::shared_ptr<nn::Matrix<float>>> inputs;
+		std::vector<std::shared_ptr<nn::Matrix<float>>> outputs;
+
+		InMemoryDataSet(const size_t input_size, const size_t output_size, const size_t batch_count, BatchGenerator generator)
+			: input_size_(input_size), output_size_(output_size), batch_count_(batch_count), generator_(std::move(generator))
+		{
+		}
+
+		void initialize(const size_t batch_size) override
+		{
+			for (size_t index = 0; index < this->batch_count_; ++index)
+			{
+				auto input = std::make_shared<nn::Matrix<float>>(this->input_size_, batch_size);
+				auto output = std::make_shared<nn::Matrix<float>>(this->output_size_, batch_size);
+				this->generator_(index, *input, *output);
+				this->inputs.push_back(std::move(input));
+				this->outputs.push_back(std::move(output));
+			}
+		}
+
+		nn::Matrix<float>& get_batch_input() override { return *this->inputs[current_index_]; }
+		nn::Matrix<float>& get_batch_output() override { return *this->outputs[current_index_]; }
+		[[nodiscard]] bool is_end() const override { return current_index_ >= this->inputs.size(); }
+		[[nodiscard]] bool is_ready() const override { return !this->inputs.empty(); }
+		void reset() override { current_index_ = 0; }
+		[[nodiscard]] size_t get_input_size() const override { return this->input_size_; }
+		[[nodiscard]] size_t get_output_size() const override { return this->output_size_; }
+
+		[[nodiscard]] size_t get_total_size() const override
+		{
+			return this->inputs.empty() ? 0 : this->inputs.size() * this->inputs.front()->get_cols();
+		}
+
+		/// <summary>
+		/// Data set of batches rank, rank + ranks, ... of this one (the same batches by default).
+		/// </summary>
+		[[nodiscard]] std::unique_ptr<InMemoryDataSet> get_shard(const size_t rank = 0, const size_t ranks = 1) const
+		{
+			auto shard = std::make_unique<InMemoryDataSet>(this->input_size_, this->output_size_, 0, this->generator_);
+			for (size_t index = rank; index < this->inputs.size(); index += ranks)
+			{
+				shard->inputs.push_back(this->inputs[index]);
+				shard->outputs.push_back(this->outputs[index]);
+			}
+			return shard;
+		}
+
+	private:
+		size_t input_size_;
+		size_t output_size_;
+		size_t batch_count_;
+		BatchGenerator generator_;
+	};
+
+	/// <summary>
+	/// Random inputs in [0, 1] and random one-hot outputs of two classes.
+	/// </summary>
+	inline void fill_random(size_t, nn::Matrix<float>& input, nn::Matrix<float>& output)
+	{
+		input.randomize(0.0f, 1.0f);
+		output.randomize(0.0f, 1.0f);
+		for (size_t b = 0; b < output.get_cols(); ++b)
+		{
+			output(0, b) = output(0, b) < 0.5f ? 1.0f : 0.0f;
+			output(1, b) = 1.0f - output(0, b);
+		}
+	}
+
+	/// <summary>
+	/// Random images with one half brighter, the output is one-hot on the brighter half: the top half (the first half
+	///	of the rows) for even samples of even batches and odd samples of odd batches, the bottom half otherwise.
+	/// </summary>
+	inline void fill_halves(const size_t index, nn::Matrix<float>& input, nn::Matrix<float>& output)
+	{
+		const size_t half = input.get_rows() / 2;
+		input.randomize(0.0f, 0.5f);
+		for (size_t b = 0; b < input.get_cols(); ++b)
+		{
+			const size_t bright = (b + index) % 2;
+			for (size_t i = bright * half; i < (bright + 1) * half; ++i)
+			{
+				input(i, b) += 0.5f;
+			}
+			output(0, b) = bright == 0 ? 1.0f : 0.0f;
+			output(1, b) = bright == 1 ? 1.0f : 0.0f;
+		}
+	}
+
+	/// <summary>
+	/// Inputs of 0.5 and outputs alternating between 1 and 0.
+	/// </summary>
+	inline void fill_constant(size_t, nn::Matrix<float>& input, nn::Matrix<float>& output)
+	{
+		for (size_t i = 0; i < input.get_rows() * input.get_cols(); ++i)
+		{
+			input[i] = 0.5f;
+		}
+		for (size_t i = 0; i < output.get_rows() * output.get_cols(); ++i)
+		{
+			output[i] = i % 2 == 0 ? 1.0f : 0.0f;
+		}
+	}
+
+	/// <summary>
+	/// Inputs in [0, 1] from a generator seeded with seed, sample j of every batch is of class j % output size.
+	/// </summary>
+	inline BatchGenerator make_seeded_generator(const unsigned seed)
+	{
+		return [engine = std::mt19937(seed)](size_t, nn::Matrix<float>& input, nn::Matrix<float>& output) mutable
+		{
+			std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+			for (size_t i = 0; i < input.get_rows() * input.get_cols(); ++i)
+			{
+				input[i] = distribution(engine);
+			}
+			for (size_t i = 0; i < output.get_rows() * output.get_cols(); ++i)
+			{
+				output[i] = 0.0f;
+			}
+			for (size_t j = 0; j < output.get_cols(); ++j)
+			{
+				output(j % output.get_rows(), j) = 1.0f;
+			}
+		};
+	}
+}